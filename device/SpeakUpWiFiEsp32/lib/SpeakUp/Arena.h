@@ -0,0 +1,67 @@
+// Arena
+// Bump allocator for many small long-lived objects - memory is taken from large
+// blocks so objects allocated together are adjacent and it is all released at once
+// Objects constructed in the arena must be destroyed by the owner before the arena
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class Arena
+{
+private:
+	std::vector<uint8_t*> _blocks;
+	size_t _blockSize;
+	size_t _blockUsed;
+
+public:
+	static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+	Arena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+	{
+		_blockSize = blockSize;
+		_blockUsed = blockSize;
+	}
+
+	~Arena()
+	{
+		for (size_t i = 0; i < _blocks.size(); i++)
+			delete[] _blocks[i];
+	}
+
+	// Allocate memory aligned to align bytes (a power of 2) - returns NULL if
+	// the size is more than a block
+	void* allocate(size_t size, size_t align = sizeof(void*))
+	{
+		// Blocks are allocated with new[] which aligns for any standard type
+		size_t pos = (_blockUsed + align - 1) & ~(align - 1);
+		if (pos + size > _blockSize)
+		{
+			if (size > _blockSize)
+				return NULL;
+			_blocks.push_back(new uint8_t[_blockSize]);
+			pos = 0;
+		}
+		_blockUsed = pos + size;
+		return _blocks.back() + pos;
+	}
+
+	// Allocate an array of a type (not constructed)
+	template<typename T>
+	T* allocateArray(size_t count)
+	{
+		return (T*)allocate(count * sizeof(T), alignof(T));
+	}
+
+	// Total memory held
+	size_t getBytesReserved()
+	{
+		return _blocks.size() * _blockSize;
+	}
+
+private:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
@@ -0,0 +1,40 @@
+// AudioIO
+// Interfaces for moving blocks of audio samples in and out of the modem
+// Samples are 16 bit - signed and centred on 0 except where an implementation
+// documents otherwise (e.g. raw ADC readings) - see SampleFormat for conversion
+// from compact formats
+// Implementations are in AudioIOEsp32 (ESP32) and AudioIOHost (Linux)
+
+#pragma once
+
+#include <stdint.h>
+
+class AudioSource
+{
+public:
+	virtual ~AudioSource()
+	{
+	}
+
+	// Read up to maxSamples - returns the number read (0 if none are available yet)
+	// or -1 at the end of the stream
+	virtual int read(int16_t* pSamples, int maxSamples) = 0;
+
+	// Sample rate of the audio
+	virtual int getSampleRate() = 0;
+};
+
+class AudioSink
+{
+public:
+	virtual ~AudioSink()
+	{
+	}
+
+	// Write samples - returns the number accepted (fewer than numSamples if the
+	// sink is full) or -1 on error
+	virtual int write(const int16_t* pSamples, int numSamples) = 0;
+
+	// Sample rate of the audio
+	virtual int getSampleRate() = 0;
+};
@@ -0,0 +1,140 @@
+// AudioIOEsp32
+// Audio source and sink for the ESP32 using I2S DMA with the built-in ADC and DAC
+
+#ifdef ESP32
+
+#include "AudioIOEsp32.h"
+#include <string.h>
+
+Esp32AdcAudioSource::Esp32AdcAudioSource(adc1_channel_t adcChannel, int sampleRate)
+{
+	_adcChannel = adcChannel;
+	_sampleRate = sampleRate;
+	_running = false;
+}
+
+Esp32AdcAudioSource::~Esp32AdcAudioSource()
+{
+	end();
+}
+
+bool Esp32AdcAudioSource::begin()
+{
+	if (_running)
+		return true;
+
+	// Configure ADC1
+	adc1_config_width(ADC_WIDTH_12Bit);
+	adc1_config_channel_atten(_adcChannel, ADC_ATTEN_11db);
+
+	// I2S reads the ADC into DMA buffers
+	i2s_config_t i2sConfig;
+	memset(&i2sConfig, 0, sizeof(i2sConfig));
+	i2sConfig.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+	i2sConfig.sample_rate = _sampleRate;
+	i2sConfig.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+	i2sConfig.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+	i2sConfig.communication_format = I2S_COMM_FORMAT_I2S_MSB;
+	i2sConfig.dma_buf_count = DMA_BUF_COUNT;
+	i2sConfig.dma_buf_len = DMA_BUF_LEN;
+	if (i2s_driver_install(I2S_NUM_0, &i2sConfig, 0, NULL) != ESP_OK)
+		return false;
+	i2s_set_adc_mode(ADC_UNIT_1, _adcChannel);
+	i2s_adc_enable(I2S_NUM_0);
+	_running = true;
+	return true;
+}
+
+void Esp32AdcAudioSource::end()
+{
+	if (!_running)
+		return;
+	i2s_adc_disable(I2S_NUM_0);
+	i2s_driver_uninstall(I2S_NUM_0);
+	_running = false;
+}
+
+int Esp32AdcAudioSource::read(int16_t* pSamples, int maxSamples)
+{
+	if (!_running)
+		return -1;
+
+	// Read whole pairs of samples
+	if (maxSamples > READ_BLOCK_LEN)
+		maxSamples = READ_BLOCK_LEN;
+	maxSamples &= ~1;
+	size_t bytesRead = 0;
+	i2s_read(I2S_NUM_0, _readBuf, maxSamples * sizeof(uint16_t), &bytesRead, 0);
+	int numSamples = (bytesRead / sizeof(uint16_t)) & ~1;
+
+	// The ADC puts each pair of samples in the buffer in reverse order and the
+	// channel number in the top 4 bits
+	for (int i = 0; i < numSamples; i++)
+		pSamples[i] = _readBuf[i ^ 1] & 0x0fff;
+	return numSamples;
+}
+
+Esp32DacAudioSink::Esp32DacAudioSink(int sampleRate)
+{
+	_sampleRate = sampleRate;
+	_running = false;
+}
+
+Esp32DacAudioSink::~Esp32DacAudioSink()
+{
+	end();
+}
+
+bool Esp32DacAudioSink::begin()
+{
+	if (_running)
+		return true;
+
+	// I2S writes DMA buffers to the DAC
+	i2s_config_t i2sConfig;
+	memset(&i2sConfig, 0, sizeof(i2sConfig));
+	i2sConfig.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
+	i2sConfig.sample_rate = _sampleRate;
+	i2sConfig.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+	i2sConfig.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+	i2sConfig.communication_format = I2S_COMM_FORMAT_I2S_MSB;
+	i2sConfig.dma_buf_count = DMA_BUF_COUNT;
+	i2sConfig.dma_buf_len = DMA_BUF_LEN;
+	if (i2s_driver_install(I2S_NUM_0, &i2sConfig, 0, NULL) != ESP_OK)
+		return false;
+	i2s_set_pin(I2S_NUM_0, NULL);
+	i2s_set_dac_mode(I2S_DAC_CHANNEL_RIGHT_EN);
+	_running = true;
+	return true;
+}
+
+void Esp32DacAudioSink::end()
+{
+	if (!_running)
+		return;
+	i2s_zero_dma_buffer(I2S_NUM_0);
+	i2s_set_dac_mode(I2S_DAC_CHANNEL_DISABLE);
+	i2s_driver_uninstall(I2S_NUM_0);
+	_running = false;
+}
+
+int Esp32DacAudioSink::write(const int16_t* pSamples, int numSamples)
+{
+	if (!_running)
+		return -1;
+
+	// The DAC takes unsigned values in the top 8 bits - each sample is sent on both channels
+	if (numSamples > WRITE_BLOCK_LEN)
+		numSamples = WRITE_BLOCK_LEN;
+	for (int i = 0; i < numSamples; i++)
+	{
+		uint16_t dacVal = (pSamples[i] + 32768) & 0xff00;
+		_writeBuf[i * 2] = dacVal;
+		_writeBuf[i * 2 + 1] = dacVal;
+	}
+	size_t bytesWritten = 0;
+	i2s_write(I2S_NUM_0, _writeBuf, numSamples * 2 * sizeof(uint16_t), &bytesWritten, 0);
+	return bytesWritten / (2 * sizeof(uint16_t));
+}
+
+#endif
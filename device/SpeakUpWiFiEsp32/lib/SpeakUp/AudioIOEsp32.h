@@ -0,0 +1,73 @@
+// AudioIOEsp32
+// Audio source and sink for the ESP32 using the I2S peripheral with the built-in
+// ADC and DAC - samples are moved by DMA into a pair of buffers so the CPU only
+// handles whole blocks and no timer interrupt is needed
+// The built-in ADC and DAC can only be used with I2S0 so only one of these can be
+// running at a time
+
+#pragma once
+
+#ifdef ESP32
+
+#include <stdint.h>
+#include <driver/i2s.h>
+#include <driver/adc.h>
+#include "AudioIO.h"
+
+// ADC1 input - samples are raw 12 bit ADC readings (0..4095) for InputConditioner
+class Esp32AdcAudioSource : public AudioSource
+{
+private:
+	// DMA double buffering - each buffer is 64ms at 8KHz
+	static const int DMA_BUF_COUNT = 2;
+	static const int DMA_BUF_LEN = 512;
+	static const int READ_BLOCK_LEN = 128;
+	adc1_channel_t _adcChannel;
+	int _sampleRate;
+	bool _running;
+	uint16_t _readBuf[READ_BLOCK_LEN];
+
+public:
+	Esp32AdcAudioSource(adc1_channel_t adcChannel, int sampleRate);
+	virtual ~Esp32AdcAudioSource();
+
+	// Start and stop sampling
+	bool begin();
+	void end();
+
+	// Doesn't wait - returns 0 if no samples are ready
+	virtual int read(int16_t* pSamples, int maxSamples);
+	virtual int getSampleRate()
+	{
+		return _sampleRate;
+	}
+};
+
+// DAC output on GPIO25 - only the top 8 bits of each sample are output
+class Esp32DacAudioSink : public AudioSink
+{
+private:
+	static const int DMA_BUF_COUNT = 2;
+	static const int DMA_BUF_LEN = 512;
+	static const int WRITE_BLOCK_LEN = 128;
+	int _sampleRate;
+	bool _running;
+	uint16_t _writeBuf[WRITE_BLOCK_LEN * 2];
+
+public:
+	Esp32DacAudioSink(int sampleRate);
+	virtual ~Esp32DacAudioSink();
+
+	// Start and stop output
+	bool begin();
+	void end();
+
+	// Doesn't wait - returns the number of samples that fitted in the DMA buffers
+	virtual int write(const int16_t* pSamples, int numSamples);
+	virtual int getSampleRate()
+	{
+		return _sampleRate;
+	}
+};
+
+#endif
@@ -0,0 +1,182 @@
+// AudioIOHost
+// Audio sources and sinks for running the modem on a Linux host
+
+#ifndef ARDUINO
+
+#include "AudioIOHost.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+// Bytes per sample in a file
+static int bytesPerSample(AudioFileFormat format)
+{
+	return (format == AUDIO_FORMAT_S16LE) ? 2 : 1;
+}
+
+// Convert from file format
+static int16_t sampleFromBytes(const uint8_t* pBytes, AudioFileFormat format)
+{
+	if (format == AUDIO_FORMAT_U8)
+		return u8ToS16(pBytes[0]);
+	if (format == AUDIO_FORMAT_ULAW)
+		return ulawToS16(pBytes[0]);
+	return (int16_t)(pBytes[0] | (pBytes[1] << 8));
+}
+
+// Convert to file format - returns the number of bytes
+static int sampleToBytes(int16_t val, uint8_t* pBytes, AudioFileFormat format)
+{
+	if (format == AUDIO_FORMAT_U8)
+	{
+		pBytes[0] = s16ToU8(val);
+		return 1;
+	}
+	if (format == AUDIO_FORMAT_ULAW)
+	{
+		pBytes[0] = s16ToUlaw(val);
+		return 1;
+	}
+	pBytes[0] = val & 0xff;
+	pBytes[1] = (val >> 8) & 0xff;
+	return 2;
+}
+
+FileAudioSource::FileAudioSource(FILE* pFile, int sampleRate, AudioFileFormat format)
+{
+	_pFile = pFile;
+	_ownFile = false;
+	_sampleRate = sampleRate;
+	_format = format;
+	_partialBytes = 0;
+}
+
+FileAudioSource::FileAudioSource(const char* pFileName, int sampleRate, AudioFileFormat format)
+{
+	_ownFile = strcmp(pFileName, "-") != 0;
+	_pFile = _ownFile ? fopen(pFileName, "rb") : stdin;
+	_sampleRate = sampleRate;
+	_format = format;
+	_partialBytes = 0;
+}
+
+FileAudioSource::~FileAudioSource()
+{
+	if (_ownFile && _pFile)
+		fclose(_pFile);
+}
+
+int FileAudioSource::read(int16_t* pSamples, int maxSamples)
+{
+	if (!_pFile)
+		return -1;
+	if (maxSamples > READ_BLOCK_LEN)
+		maxSamples = READ_BLOCK_LEN;
+	int sampleBytes = bytesPerSample(_format);
+
+	// Wait for at least one whole sample - a partial sample is kept for next time
+	int numBytes = _partialBytes;
+	while (numBytes < sampleBytes)
+	{
+		int numRead = ::read(fileno(_pFile), _readBuf + numBytes, maxSamples * sampleBytes - numBytes);
+		if ((numRead < 0) && (errno == EINTR))
+			continue;
+		if (numRead <= 0)
+			return -1;
+		numBytes += numRead;
+	}
+
+	// Convert
+	int numSamples = numBytes / sampleBytes;
+	for (int i = 0; i < numSamples; i++)
+		pSamples[i] = sampleFromBytes(_readBuf + i * sampleBytes, _format);
+	_partialBytes = numBytes - numSamples * sampleBytes;
+	if (_partialBytes > 0)
+		memmove(_readBuf, _readBuf + numSamples * sampleBytes, _partialBytes);
+	return numSamples;
+}
+
+FileAudioSink::FileAudioSink(FILE* pFile, int sampleRate, AudioFileFormat format)
+{
+	_pFile = pFile;
+	_ownFile = false;
+	_sampleRate = sampleRate;
+	_format = format;
+}
+
+FileAudioSink::FileAudioSink(const char* pFileName, int sampleRate, AudioFileFormat format)
+{
+	_ownFile = strcmp(pFileName, "-") != 0;
+	_pFile = _ownFile ? fopen(pFileName, "wb") : stdout;
+	_sampleRate = sampleRate;
+	_format = format;
+}
+
+FileAudioSink::~FileAudioSink()
+{
+	if (!_pFile)
+		return;
+	if (_ownFile)
+		fclose(_pFile);
+	else
+		fflush(_pFile);
+}
+
+int FileAudioSink::write(const int16_t* pSamples, int numSamples)
+{
+	if (!_pFile)
+		return -1;
+	int numWritten = 0;
+	while (numWritten < numSamples)
+	{
+		int blockLen = numSamples - numWritten;
+		if (blockLen > WRITE_BLOCK_LEN)
+			blockLen = WRITE_BLOCK_LEN;
+		int numBytes = 0;
+		for (int i = 0; i < blockLen; i++)
+			numBytes += sampleToBytes(pSamples[numWritten + i], _writeBuf + numBytes, _format);
+		if ((int)fwrite(_writeBuf, 1, numBytes, _pFile) != numBytes)
+			return -1;
+		numWritten += blockLen;
+	}
+	return numWritten;
+}
+
+LoopbackAudio::LoopbackAudio(int maxSamples, int sampleRate) : _posn(maxSamples + 1)
+{
+	_buffer.resize(maxSamples + 1);
+	_sampleRate = sampleRate;
+	_closed = false;
+}
+
+int LoopbackAudio::read(int16_t* pSamples, int maxSamples)
+{
+	int numSamples = _posn.count();
+	if ((numSamples == 0) && _closed)
+		return -1;
+	if (numSamples > maxSamples)
+		numSamples = maxSamples;
+	for (int i = 0; i < numSamples; i++)
+	{
+		pSamples[i] = _buffer[_posn.posToGet()];
+		_posn.hasGot();
+	}
+	return numSamples;
+}
+
+int LoopbackAudio::write(const int16_t* pSamples, int numSamples)
+{
+	if (_closed)
+		return -1;
+	int space = _posn.space();
+	if (numSamples > space)
+		numSamples = space;
+	for (int i = 0; i < numSamples; i++)
+	{
+		_buffer[_posn.posToPut()] = pSamples[i];
+		_posn.hasPut();
+	}
+	return numSamples;
+}
+
+#endif
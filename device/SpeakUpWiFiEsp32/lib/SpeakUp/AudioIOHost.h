@@ -0,0 +1,124 @@
+// AudioIOHost
+// Audio sources and sinks for running the modem on a Linux host
+// Files and pipes carry raw mono samples - signed 16 bit little-endian (as used by
+// e.g. "arecord -t raw -f S16_LE -c 1" and "aplay -t raw -f S16_LE -c 1"),
+// unsigned 8 bit or G.711 mu-law (see SampleFormat)
+// The loopback links a modulator directly to a demodulator in memory
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "AudioIO.h"
+#include "SampleFormat.h"
+#include "RingBufferPosn.h"
+
+// Sample formats for files and pipes
+enum AudioFileFormat
+{
+	AUDIO_FORMAT_S16LE,
+	AUDIO_FORMAT_U8,
+	AUDIO_FORMAT_ULAW
+};
+
+// Read samples from a file, stdin or a pipe
+// Reads return as soon as any samples are available (rather than waiting for a
+// full block) so that a pipe is decoded with low latency
+class FileAudioSource : public AudioSource
+{
+private:
+	FILE* _pFile;
+	bool _ownFile;
+	int _sampleRate;
+	AudioFileFormat _format;
+	static const int READ_BLOCK_LEN = 256;
+	uint8_t _readBuf[READ_BLOCK_LEN * 2];
+	int _partialBytes;
+
+public:
+	// Use an open file (e.g. from popen()) - it isn't closed by this object
+	// The file is read directly (not through the stdio buffer)
+	FileAudioSource(FILE* pFile, int sampleRate, AudioFileFormat format = AUDIO_FORMAT_S16LE);
+
+	// Open a file by name - "-" is stdin
+	FileAudioSource(const char* pFileName, int sampleRate, AudioFileFormat format = AUDIO_FORMAT_S16LE);
+	virtual ~FileAudioSource();
+
+	// Check the file opened ok
+	bool isOpen()
+	{
+		return _pFile != NULL;
+	}
+
+	// Waits until at least one sample is available
+	virtual int read(int16_t* pSamples, int maxSamples);
+	virtual int getSampleRate()
+	{
+		return _sampleRate;
+	}
+};
+
+// Write samples to a file, stdout or a pipe
+class FileAudioSink : public AudioSink
+{
+private:
+	FILE* _pFile;
+	bool _ownFile;
+	int _sampleRate;
+	AudioFileFormat _format;
+	static const int WRITE_BLOCK_LEN = 256;
+	uint8_t _writeBuf[WRITE_BLOCK_LEN * 2];
+
+public:
+	// Use an open file (e.g. from popen()) - it isn't closed by this object
+	FileAudioSink(FILE* pFile, int sampleRate, AudioFileFormat format = AUDIO_FORMAT_S16LE);
+
+	// Create a file by name - "-" is stdout
+	FileAudioSink(const char* pFileName, int sampleRate, AudioFileFormat format = AUDIO_FORMAT_S16LE);
+	virtual ~FileAudioSink();
+
+	// Check the file opened ok
+	bool isOpen()
+	{
+		return _pFile != NULL;
+	}
+
+	// Samples use the top 8 bits for AUDIO_FORMAT_U8
+	virtual int write(const int16_t* pSamples, int numSamples);
+	virtual int getSampleRate()
+	{
+		return _sampleRate;
+	}
+};
+
+// In-memory loopback - samples written are read back in order
+// Once closed the reader gets the remaining samples and then end of stream
+class LoopbackAudio : public AudioSource, public AudioSink
+{
+private:
+	std::vector<int16_t> _buffer;
+	RingBufferPosn _posn;
+	int _sampleRate;
+	bool _closed;
+
+public:
+	LoopbackAudio(int maxSamples, int sampleRate);
+
+	// Mark the end of the stream
+	void close()
+	{
+		_closed = true;
+	}
+
+	virtual int read(int16_t* pSamples, int maxSamples);
+	virtual int write(const int16_t* pSamples, int numSamples);
+	virtual int getSampleRate()
+	{
+		return _sampleRate;
+	}
+};
+
+#endif
@@ -0,0 +1,145 @@
+// ChannelSimulator
+// Impairments of an acoustic channel applied to modem audio - for host test systems
+
+#ifndef ARDUINO
+
+#include "ChannelSimulator.h"
+#include <math.h>
+#include <string.h>
+
+// Echo delays are a few ms in a small room and the tail is longer in larger rooms
+// (tens of ms here as only the first part of a real tail causes much intersymbol
+// interference) - a phone speaker rolls off at the top of the band
+// The delays are chosen so that the two FSK tones get much the same gain - the
+// profiles are for the smearing of symbols rather than a notch on one tone
+static const ChannelSimulator::MultipathProfile MULTIPATH_PROFILES[] = {
+	{ "desk", 2, { 0.35, 0.85 }, { 0.5, -0.3 }, 0.05, 15, 3500 },
+	{ "room", 4, { 0.85, 1.8, 3.3, 5.15 }, { 0.45, -0.3, 0.2, -0.12 }, 0.08, 40, 3200 },
+	{ "hall", 3, { 1.35, 3.85, 7.35 }, { 0.35, -0.25, 0.15 }, 0.06, 60, 3000 },
+};
+static const int NUM_MULTIPATH_PROFILES = sizeof(MULTIPATH_PROFILES) / sizeof(MULTIPATH_PROFILES[0]);
+
+ChannelSimulator::ChannelSimulator(int sampleRate, uint32_t seed) : _rng(seed)
+{
+	_sampleRate = sampleRate;
+}
+
+const ChannelSimulator::MultipathProfile* ChannelSimulator::getMultipathProfile(const char* pName)
+{
+	for (int i = 0; i < NUM_MULTIPATH_PROFILES; i++)
+		if (strcmp(MULTIPATH_PROFILES[i].pName, pName) == 0)
+			return &MULTIPATH_PROFILES[i];
+	return NULL;
+}
+
+void ChannelSimulator::setup(const Settings& settings)
+{
+	_settings = settings;
+	_pathDelays.clear();
+	_pathGains.clear();
+	const MultipathProfile* pProfile = settings.pMultipath;
+	if (!pProfile)
+		return;
+	for (int i = 0; i < pProfile->numEchoes; i++)
+	{
+		_pathDelays.push_back((int)lround(pProfile->echoDelayMs[i] * _sampleRate / 1000));
+		_pathGains.push_back(pProfile->echoGain[i]);
+	}
+
+	// Tail - Gaussian taps with an exponential envelope starting after the echoes
+	if ((pProfile->tailEnergy <= 0) || (pProfile->tailDecayMs <= 0))
+		return;
+	double decaySamples = pProfile->tailDecayMs * _sampleRate / 1000;
+	int startDelay = _pathDelays.empty() ? 1 : _pathDelays.back() + 1;
+	int tailLen = (int)(decaySamples * 5);
+	double envelopeEnergy = 0;
+	for (int i = 0; i < tailLen; i++)
+		envelopeEnergy += exp(-2 * i / decaySamples);
+	double scale = sqrt(pProfile->tailEnergy / envelopeEnergy);
+	std::normal_distribution<double> tapDist(0, 1);
+	for (int i = 0; i < tailLen; i++)
+	{
+		_pathDelays.push_back(startDelay + i);
+		_pathGains.push_back(scale * exp(-i / decaySamples) * tapDist(_rng));
+	}
+}
+
+double ChannelSimulator::signalRms(const std::vector<int>& samples)
+{
+	double sumSquares = 0;
+	int numSamples = 0;
+	for (int sampleVal : samples)
+	{
+		if (sampleVal == 0)
+			continue;
+		sumSquares += (double)sampleVal * sampleVal;
+		numSamples++;
+	}
+	return (numSamples > 0) ? sqrt(sumSquares / numSamples) : 0;
+}
+
+void ChannelSimulator::process(const std::vector<int>& in, std::vector<int>& out)
+{
+	out.clear();
+	if (in.empty())
+		return;
+
+	// Multipath
+	std::vector<int> received;
+	applyMultipath(in, received);
+
+	// Noise level from the direct path signal after the gain
+	double noiseRms = signalRms(in) * fabs(_settings.gain) * pow(10, -_settings.snrDb / 20);
+	std::normal_distribution<double> noise(0, (noiseRms > 0) ? noiseRms : 1e-9);
+
+	// Each output sample is taken from this far through the input (interpolated)
+	double step = 1 + _settings.clockOffsetPpm * 1e-6;
+	int numOut = (int)((received.size() - 1) / step) + 1;
+	out.reserve(numOut);
+	for (int outIdx = 0; outIdx < numOut; outIdx++)
+	{
+		double inPos = outIdx * step;
+		int inIdx = (int)inPos;
+		double frac = inPos - inIdx;
+		double val = received[inIdx];
+		if (inIdx + 1 < (int)received.size())
+			val += (received[inIdx + 1] - received[inIdx]) * frac;
+
+		// Fading, gain, noise, hum and DC
+		double secs = (double)outIdx / _sampleRate;
+		if (_settings.fadeDepth > 0)
+			val *= 1 - _settings.fadeDepth * (0.5 - 0.5 * cos(2 * M_PI * secs / _settings.fadePeriodSecs));
+		val *= _settings.gain;
+		val += noise(_rng);
+		val += _settings.humLevel * sin(2 * M_PI * _settings.humFreqHz * secs);
+		val += _settings.dcOffset;
+		if (val > 32767)
+			val = 32767;
+		else if (val < -32768)
+			val = -32768;
+		out.push_back((int)lround(val));
+	}
+}
+
+void ChannelSimulator::applyMultipath(const std::vector<int>& in, std::vector<int>& out)
+{
+	const MultipathProfile* pProfile = _settings.pMultipath;
+	if (!pProfile)
+	{
+		out = in;
+		return;
+	}
+	double lowpassCoeff = (pProfile->lowpassHz > 0) ? 1 - exp(-2 * M_PI * pProfile->lowpassHz / _sampleRate) : 1;
+	double lowpassVal = 0;
+	out.resize(in.size());
+	for (size_t i = 0; i < in.size(); i++)
+	{
+		double val = in[i];
+		for (size_t pathIdx = 0; (pathIdx < _pathDelays.size()) && (_pathDelays[pathIdx] <= (int)i); pathIdx++)
+			val += in[i - _pathDelays[pathIdx]] * _pathGains[pathIdx];
+		lowpassVal += (val - lowpassVal) * lowpassCoeff;
+		out[i] = (int)lround(lowpassVal);
+	}
+}
+
+#endif
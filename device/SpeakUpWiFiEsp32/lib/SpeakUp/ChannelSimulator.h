@@ -0,0 +1,90 @@
+// ChannelSimulator
+// Impairments of an acoustic channel applied to modem audio - for host test systems
+// Applied in order: multipath (a room's echoes and reverberation and a phone speaker's
+// response - see MultipathProfile), sample clock offset (the receiver's clock runs
+// fast or slow), slow fading, gain, white noise at an SNR (relative to the signal
+// of the direct path while it is present), mains hum and a DC offset - finally
+// clipped to 16 bits
+// Noise is from a seeded generator so a simulation can be repeated exactly
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <vector>
+#include <random>
+
+class ChannelSimulator
+{
+public:
+	// Multipath - discrete echoes (in order of delay with gains relative to the direct
+	// path) and a diffuse reverberant tail that decays exponentially (tailEnergy is its
+	// energy relative to the direct path) followed by a one-pole lowpass (0 for none)
+	static const int MAX_ECHOES = 6;
+	struct MultipathProfile
+	{
+		const char* pName;
+		int numEchoes;
+		double echoDelayMs[MAX_ECHOES];
+		double echoGain[MAX_ECHOES];
+		double tailEnergy;
+		double tailDecayMs;
+		double lowpassHz;
+	};
+
+	// Named profiles - "desk", "room" and "hall" - NULL if not found
+	static const MultipathProfile* getMultipathProfile(const char* pName);
+
+	struct Settings
+	{
+		const MultipathProfile* pMultipath;
+		double gain;
+		double snrDb;
+		double clockOffsetPpm;
+		double fadeDepth;
+		double fadePeriodSecs;
+		double humLevel;
+		int humFreqHz;
+		int dcOffset;
+		Settings()
+		{
+			pMultipath = NULL;
+			gain = 1;
+			snrDb = 100;
+			clockOffsetPpm = 0;
+			fadeDepth = 0;
+			fadePeriodSecs = 1;
+			humLevel = 0;
+			humFreqHz = 50;
+			dcOffset = 0;
+		}
+	};
+
+private:
+	int _sampleRate;
+	Settings _settings;
+	std::mt19937 _rng;
+
+	// Impulse response of the multipath (excluding the direct path)
+	std::vector<int> _pathDelays;
+	std::vector<double> _pathGains;
+
+public:
+	ChannelSimulator(int sampleRate, uint32_t seed = 1);
+
+	// The reverberant tail is drawn from the noise generator
+	void setup(const Settings& settings);
+
+	// Pass a block of audio through the channel - with a clock offset the output
+	// has a different number of samples
+	void process(const std::vector<int>& in, std::vector<int>& out);
+
+	// RMS of the non-zero samples (the signal while it is present)
+	static double signalRms(const std::vector<int>& samples);
+
+private:
+	void applyMultipath(const std::vector<int>& in, std::vector<int>& out);
+};
+
+#endif
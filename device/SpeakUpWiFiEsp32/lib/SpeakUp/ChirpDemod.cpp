@@ -0,0 +1,268 @@
+// ChirpDemod
+// Chirp spread spectrum demodulator
+
+#include "ChirpDemod.h"
+#include "ChirpMod.h"
+#include "FixedFFT.h"
+#include "SinTable.h"
+#include <cmath>
+
+ChirpDemod::ChirpDemod(int rxFifoLen, uint32_t* pFifoStorage, int32_t* pWorkStorage, int workStorageLen) :
+			_rxBitFifo(rxFifoLen, 1, pFifoStorage)
+{
+	_pWorkStorage = pWorkStorage;
+	_workStorageLen = workStorageLen;
+	_numTaps = 0;
+	_firTaps = _histRe = _histIm = NULL;
+	_fftRe = _fftIm = NULL;
+	_spreadingFactor = 0;
+	_numBins = 0;
+	_samplesPerChip = 1;
+	_samplesPerSymbol = 0;
+	_mixInc = 0;
+	_mixPhase = 0;
+	_histPos = 0;
+	_lockCount = 0;
+	restartSearch();
+}
+
+bool ChirpDemod::setup(int sampleRate, int freqLow, int bandwidth, int spreadingFactor)
+{
+	if ((spreadingFactor < ChirpMod::MIN_SPREADING_FACTOR) || (spreadingFactor > ChirpMod::MAX_SPREADING_FACTOR) ||
+				(spreadingFactor > FixedFFT::MAX_LOG2_SIZE))
+		return false;
+	if ((bandwidth <= 0) || (sampleRate % bandwidth != 0) || (freqLow + bandwidth > sampleRate / 2))
+		return false;
+	int workLen = workStorageLenFor(sampleRate, bandwidth, spreadingFactor);
+	if (_pWorkStorage && (workLen > _workStorageLen))
+		return false;
+	_spreadingFactor = spreadingFactor;
+	_numBins = 1 << spreadingFactor;
+	_samplesPerChip = sampleRate / bandwidth;
+	_samplesPerSymbol = _samplesPerChip << spreadingFactor;
+	_mixInc = (uint32_t)(((uint64_t)(freqLow * 2 + bandwidth) << 31) / sampleRate);
+	_mixPhase = 0;
+
+	// Storage - taps, I and Q history (twice the taps each) and the FFT
+	int32_t* pWork = _pWorkStorage;
+	if (!pWork)
+	{
+		_ownWork.resize(workLen);
+		pWork = _ownWork.data();
+	}
+	for (int i = 0; i < workLen; i++)
+		pWork[i] = 0;
+	_numTaps = FIR_TAPS_PER_CHIP * _samplesPerChip;
+	_firTaps = pWork;
+	_histRe = _firTaps + _numTaps;
+	_histIm = _histRe + _numTaps * 2;
+	_fftRe = _histIm + _numTaps * 2;
+	_fftIm = _fftRe + _numBins;
+	_histPos = 0;
+
+	// Low pass filter (windowed sinc) - flat to the band edge at half the bandwidth
+	// and cutting off well before the chip rate
+	double cutoff = 0.7 * bandwidth / sampleRate;
+	double tapSum = 0;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < _numTaps; i++)
+		{
+			double t = i - (_numTaps - 1) / 2.0;
+			double sincVal = (t == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+			double tap = sincVal * (0.54 - 0.46 * cos(2 * M_PI * i / (_numTaps - 1)));
+			if (pass == 0)
+				tapSum += tap;
+			else
+				_firTaps[i] = (int32_t)lround(tap / tapSum * (1 << FIR_TAP_BITS));
+		}
+	}
+	restartSearch();
+	return true;
+}
+
+void ChirpDemod::restartSearch()
+{
+	_decimCount = 0;
+	_chipIdx = 0;
+	_skipSamples = 0;
+	_locked = false;
+	_matchCount = 0;
+	_lastPeakBin = 0;
+	_preambleOffset = 0;
+	_preambleWeight = 0;
+	_weakCount = 0;
+	_timingError = 0;
+}
+
+void ChirpDemod::processSample(int sampleVal)
+{
+	if (_numBins == 0)
+		return;
+
+	// Mix to baseband
+	if (sampleVal > 32767)
+		sampleVal = 32767;
+	else if (sampleVal < -32768)
+		sampleVal = -32768;
+	int mixIdx = _mixPhase >> (32 - SinTable::CYCLE_BITS);
+	_mixPhase += _mixInc;
+	int numTaps = _numTaps;
+	_histRe[_histPos] = _histRe[_histPos + numTaps] = (sampleVal * SinTable::cos(mixIdx)) >> MIX_SHIFT;
+	_histIm[_histPos] = _histIm[_histPos + numTaps] = -(sampleVal * SinTable::sin(mixIdx)) >> MIX_SHIFT;
+	if (++_histPos >= numTaps)
+		_histPos = 0;
+
+	// Samples are skipped to align windows with symbols
+	if (_skipSamples > 0)
+	{
+		_skipSamples--;
+		return;
+	}
+
+	// Filter once per chip
+	if (++_decimCount < _samplesPerChip)
+		return;
+	_decimCount = 0;
+	const int32_t* pRe = &_histRe[_histPos];
+	const int32_t* pIm = &_histIm[_histPos];
+	int32_t chipRe = 0;
+	int32_t chipIm = 0;
+	for (int i = 0; i < numTaps; i++)
+	{
+		chipRe += pRe[i] * _firTaps[i];
+		chipIm += pIm[i] * _firTaps[i];
+	}
+	chipRe >>= FIR_TAP_BITS;
+	chipIm >>= FIR_TAP_BITS;
+
+	// Dechirp - the unshifted chirp sweeps from -1/2 to +1/2 cycles per chip
+	// so its phase is n^2/2M - n/2 cycles
+	int n = _chipIdx;
+	int chirpIdx = (int)(((int64_t)n * n * SinTable::CYCLE_LEN) >> (_spreadingFactor + 1)) - n * (SinTable::CYCLE_LEN / 2);
+	int64_t chirpCos = SinTable::cos(chirpIdx);
+	int64_t chirpSin = SinTable::sin(chirpIdx);
+	_fftRe[n] = (int32_t)((chipRe * chirpCos + chipIm * chirpSin) >> DECHIRP_SHIFT);
+	_fftIm[n] = (int32_t)((chipIm * chirpCos - chipRe * chirpSin) >> DECHIRP_SHIFT);
+
+	// End of window
+	if (++_chipIdx < _numBins)
+		return;
+	_chipIdx = 0;
+	processWindow();
+}
+
+void ChirpDemod::processWindow()
+{
+	// Find the peak bin
+	FixedFFT::transform(_fftRe, _fftIm, _spreadingFactor);
+	int peakBin = 0;
+	int64_t peakPower = 0;
+	int64_t totalPower = 0;
+	for (int i = 0; i < _numBins; i++)
+	{
+		int64_t power = FixedFFT::power(_fftRe[i], _fftIm[i]);
+		totalPower += power;
+		if (power > peakPower)
+		{
+			peakPower = power;
+			peakBin = i;
+		}
+	}
+	int64_t meanOthers = (totalPower - peakPower) / (_numBins - 1);
+	bool isPeak = (peakPower > 0) && (peakPower > meanOthers * (_spreadingFactor + PEAK_RATIO_MARGIN));
+
+	// Search for the preamble
+	if (!_locked)
+	{
+		// The offset in bins (including the fraction) is averaged over the matching windows
+		// weighted by power as the first window usually only partly overlaps the preamble
+		if (!isPeak)
+		{
+			_matchCount = 0;
+			return;
+		}
+		float offset = peakBin + peakFraction(peakBin, peakPower);
+		if ((_matchCount > 0) && (binDistance(peakBin, _lastPeakBin) <= 1))
+		{
+			if (offset - _preambleOffset > _numBins / 2)
+				offset -= _numBins;
+			else if (_preambleOffset - offset > _numBins / 2)
+				offset += _numBins;
+			_matchCount++;
+			_preambleWeight += (float)peakPower;
+			_preambleOffset += (offset - _preambleOffset) * (float)peakPower / _preambleWeight;
+		}
+		else
+		{
+			_matchCount = 1;
+			_preambleOffset = offset;
+			_preambleWeight = (float)peakPower;
+		}
+		_lastPeakBin = peakBin;
+		if (_matchCount < PREAMBLE_MATCH_WINDOWS)
+			return;
+
+		// The window started this many samples after a symbol edge
+		int edgeOffset = (int)lround(_preambleOffset * _samplesPerChip);
+		_skipSamples = (_samplesPerSymbol - edgeOffset) % _samplesPerSymbol;
+		if (_skipSamples < 0)
+			_skipSamples += _samplesPerSymbol;
+		_locked = true;
+		_weakCount = 0;
+		_timingError = 0;
+		_lockCount++;
+		return;
+	}
+
+	// Lost signal
+	if (isPeak)
+		_weakCount = 0;
+	else if (++_weakCount >= LOCK_LOST_SYMBOLS)
+	{
+		restartSearch();
+		return;
+	}
+
+	// Track timing - a peak above the bin means the window is late so the next
+	// one is started a sample early (and vice versa)
+	if (isPeak)
+	{
+		_timingError += (peakFraction(peakBin, peakPower) * _samplesPerChip - _timingError) / TIMING_AVERAGE_SYMBOLS;
+		if (_timingError > 0.5f)
+		{
+			_decimCount = 1;
+			_timingError -= 1;
+		}
+		else if (_timingError < -0.5f)
+		{
+			_skipSamples = 1;
+			_timingError += 1;
+		}
+	}
+
+	// Output the bits - first in the LSB
+	int symbolVal = ChirpMod::grayEncode(peakBin);
+	for (int i = 0; i < _spreadingFactor; i++)
+		_rxBitFifo.put((symbolVal >> i) & 0x01);
+}
+
+// Fraction of a bin (+/-0.5) by which a tone is off the peak bin - for a tone a fraction d
+// above a bin the magnitudes of the bin and the one above are in the ratio 1 - d : d
+float ChirpDemod::peakFraction(int peakBin, int64_t peakPower)
+{
+	int belowBin = (peakBin + _numBins - 1) % _numBins;
+	int aboveBin = (peakBin + 1) % _numBins;
+	float belowMag = sqrtf((float)FixedFFT::power(_fftRe[belowBin], _fftIm[belowBin]));
+	float aboveMag = sqrtf((float)FixedFFT::power(_fftRe[aboveBin], _fftIm[aboveBin]));
+	float peakMag = sqrtf((float)peakPower);
+	if (aboveMag > belowMag)
+		return aboveMag / (peakMag + aboveMag);
+	return -belowMag / (peakMag + belowMag);
+}
+
+int ChirpDemod::binDistance(int bin1, int bin2)
+{
+	int dist = bin1 > bin2 ? bin1 - bin2 : bin2 - bin1;
+	return dist > _numBins / 2 ? _numBins - dist : dist;
+}
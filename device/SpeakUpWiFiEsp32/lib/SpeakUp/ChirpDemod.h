@@ -0,0 +1,125 @@
+// ChirpDemod
+// Chirp spread spectrum demodulator (for signals from ChirpMod)
+// The input is mixed down to complex baseband, low pass filtered and sampled once per
+// chip - each symbol period of chips is then multiplied by the conjugate of an
+// unshifted chirp (dechirped) which turns a shifted chirp into a tone whose frequency
+// is the symbol value and an FFT of the 2^SF chips finds it
+// All the energy of a symbol ends up in one FFT bin so symbols can be found when
+// the signal is well below the noise in the audio band
+// Timing is found from the preamble - with windows not aligned to symbols each
+// preamble chirp gives the same peak bin and that bin is the misalignment in chips
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "SymbolFifo.h"
+
+class ChirpDemod
+{
+private:
+	// Settings
+	int _spreadingFactor;
+	int _numBins;
+	int _samplesPerChip;
+	int _samplesPerSymbol;
+
+	// Mixer to baseband (centre of the band) - 2^32 per cycle
+	static const int MIX_SHIFT = 14;
+	uint32_t _mixInc;
+	uint32_t _mixPhase;
+
+	// Low pass filter - taps (FIR_TAP_BITS fraction bits) and history of I and Q
+	// (held twice so the taps can run over it without wrapping)
+	static const int FIR_TAPS_PER_CHIP = 8;
+	static const int FIR_TAP_BITS = 12;
+	int _numTaps;
+	int32_t* _firTaps;
+	int32_t* _histRe;
+	int32_t* _histIm;
+	int _histPos;
+	int _decimCount;
+
+	// Dechirped chips - shifted to fit the FFT input range
+	static const int DECHIRP_SHIFT = 9;
+	int _chipIdx;
+	int32_t* _fftRe;
+	int32_t* _fftIm;
+	int _skipSamples;
+
+	// Storage for the filter and FFT - either owned or supplied externally
+	std::vector<int32_t> _ownWork;
+	int32_t* _pWorkStorage;
+	int _workStorageLen;
+
+	// The peak bin must exceed the mean of the other bins by SF + PEAK_RATIO_MARGIN
+	// times (the largest of 2^SF noise bins is about SF * ln(2) times the mean)
+	static const int PEAK_RATIO_MARGIN = 4;
+
+	// Preamble search - the same peak bin (+/-1) in this many windows in a row
+	static const int PREAMBLE_MATCH_WINDOWS = 3;
+
+	// Lock is lost after this many symbols in a row without a peak
+	static const int LOCK_LOST_SYMBOLS = 3;
+
+	// Timing is tracked from the fraction of a bin by which symbol peaks are off -
+	// averaged over about TIMING_AVERAGE_SYMBOLS and corrected a sample at a time
+	static const int TIMING_AVERAGE_SYMBOLS = 16;
+	float _timingError;
+
+	// State
+	bool _locked;
+	int _matchCount;
+	int _lastPeakBin;
+	float _preambleOffset;
+	float _preambleWeight;
+	int _weakCount;
+	int _lockCount;
+
+	// Output bits
+	SymbolFifo _rxBitFifo;
+
+public:
+	// Constructor - the received bit FIFO can use external storage
+	// (SymbolFifo::storageWordsFor(rxFifoLen, 1) words) and so can the filter and FFT
+	// in which case setup() fails for settings that need more than workStorageLen
+	ChirpDemod(int rxFifoLen, uint32_t* pFifoStorage = NULL,
+				int32_t* pWorkStorage = NULL, int workStorageLen = 0);
+
+	// Work storage needed (in int32s) for a sample rate, bandwidth and spreading factor
+	static constexpr int workStorageLenFor(int sampleRate, int bandwidth, int spreadingFactor)
+	{
+		return FIR_TAPS_PER_CHIP * (sampleRate / bandwidth) * 5 + (2 << spreadingFactor);
+	}
+
+	// Setup - must match the modulator - returns false if not supported
+	bool setup(int sampleRate, int freqLow, int bandwidth, int spreadingFactor);
+
+	// Search for a new preamble (e.g. once a complete frame has been received)
+	void restartSearch();
+
+	// Process a single sample
+	void processSample(int sampleVal);
+
+	// Get up to maxBits (at most 32) received bits - the first received is in the LSB
+	// Returns the number of bits got
+	int getRxBits(uint32_t& bits, int maxBits)
+	{
+		return _rxBitFifo.getSymbols(bits, maxBits);
+	}
+
+	// Status
+	bool isLocked()
+	{
+		return _locked;
+	}
+	int getLockCount()
+	{
+		return _lockCount;
+	}
+
+private:
+	void processWindow();
+	float peakFraction(int peakBin, int64_t peakPower);
+	int binDistance(int bin1, int bin2);
+};
@@ -0,0 +1,108 @@
+// ChirpMod
+// Chirp spread spectrum modulator
+
+#include "ChirpMod.h"
+#include "SinTable.h"
+
+ChirpMod::ChirpMod()
+{
+	_spreadingFactor = 0;
+	_samplesPerChip = 1;
+	_samplesPerSymbol = 0;
+	_preambleSymbols = DEFAULT_PREAMBLE_SYMBOLS;
+	_baseInc = 0;
+	_sweepInc = 0;
+	_generatorBusy = false;
+	_phase = 0;
+	_sweepPos = 0;
+	_samplesLeft = 0;
+	_streamPreambleLeft = 0;
+	_streamSourceActive = false;
+}
+
+bool ChirpMod::setup(int sampleRate, int freqLow, int bandwidth, int spreadingFactor)
+{
+	if ((spreadingFactor < MIN_SPREADING_FACTOR) || (spreadingFactor > MAX_SPREADING_FACTOR))
+		return false;
+	if ((bandwidth <= 0) || (sampleRate % bandwidth != 0) || (freqLow + bandwidth > sampleRate / 2))
+		return false;
+	_spreadingFactor = spreadingFactor;
+	_samplesPerChip = sampleRate / bandwidth;
+	_samplesPerSymbol = _samplesPerChip << spreadingFactor;
+	_baseInc = (uint32_t)(((uint64_t)freqLow << 32) / sampleRate);
+	_sweepInc = (uint32_t)(((uint64_t)bandwidth << 32) / sampleRate / _samplesPerSymbol);
+	clear();
+	return true;
+}
+
+void ChirpMod::startStream()
+{
+	_streamPreambleLeft = _preambleSymbols;
+	_streamSourceActive = true;
+}
+
+void ChirpMod::clear()
+{
+	_streamPreambleLeft = 0;
+	_streamSourceActive = false;
+	_generatorBusy = false;
+}
+
+bool ChirpMod::getSample(int& sampleValue)
+{
+	// Start a symbol - the sweep starts part way through the band and wraps
+	if (!_generatorBusy)
+	{
+		int symbol = 0;
+		if (!getNextSymbol(symbol))
+		{
+			_phase = 0;
+			return false;
+		}
+		_sweepPos = symbol * _samplesPerChip;
+		_samplesLeft = _samplesPerSymbol;
+		_generatorBusy = true;
+	}
+
+	// Generate
+	sampleValue = SinTable::sin(_phase >> (32 - SinTable::CYCLE_BITS));
+	_phase += _baseInc + _sweepInc * _sweepPos;
+	if (++_sweepPos >= _samplesPerSymbol)
+		_sweepPos = 0;
+	if (--_samplesLeft <= 0)
+		_generatorBusy = false;
+	return true;
+}
+
+bool ChirpMod::getNextSymbol(int& symbol)
+{
+	// Preamble
+	if (_streamPreambleLeft > 0)
+	{
+		symbol = 0;
+		_streamPreambleLeft--;
+		return true;
+	}
+	if (!_streamSourceActive)
+		return false;
+
+	// Bits from the source - first bit in the LSB
+	int symbolVal = 0;
+	int numBits = 0;
+	for (; numBits < _spreadingFactor; numBits++)
+	{
+		int bitVal = 0;
+		if (!_bitSourceFn || !_bitSourceFn(bitVal))
+			break;
+		symbolVal |= (bitVal & 0x01) << numBits;
+	}
+	if (numBits == 0)
+	{
+		_streamSourceActive = false;
+		return false;
+	}
+	if (numBits < _spreadingFactor)
+		_streamSourceActive = false;
+	symbol = grayDecode(symbolVal);
+	return true;
+}
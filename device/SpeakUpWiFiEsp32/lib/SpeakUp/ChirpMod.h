@@ -0,0 +1,91 @@
+// ChirpMod
+// Chirp spread spectrum modulator
+// Each symbol is an up-chirp sweeping the band from freqLow to freqLow + bandwidth
+// cyclically shifted by the symbol value - a spreading factor of SF sends SF bits
+// per symbol in 2^SF chips (a chip is 1/bandwidth seconds)
+// Symbol values are Gray coded so that an error of one FFT bin (including between the
+// first and last bins) is one bit error
+// The preamble is unshifted chirps (symbol 0) which the receiver uses for timing
+
+#pragma once
+
+#include <stdint.h>
+#include "FSKMod.h"
+
+class ChirpMod
+{
+public:
+	static const int MIN_SPREADING_FACTOR = 6;
+	static const int MAX_SPREADING_FACTOR = 10;
+	static const int DEFAULT_PREAMBLE_SYMBOLS = 6;
+
+private:
+	// Settings
+	int _spreadingFactor;
+	int _samplesPerChip;
+	int _samplesPerSymbol;
+	int _preambleSymbols;
+
+	// Phase increments (2^32 per cycle) at the bottom of the band and per sample of the sweep
+	uint32_t _baseInc;
+	uint32_t _sweepInc;
+
+	// Generator
+	bool _generatorBusy;
+	uint32_t _phase;
+	int _sweepPos;
+	int _samplesLeft;
+
+	// Bits are pulled from the source a symbol at a time
+	FSKModSymbolSourceFnType _bitSourceFn;
+	int _streamPreambleLeft;
+	bool _streamSourceActive;
+
+public:
+	ChirpMod();
+
+	// Setup - the sample rate must be a multiple of the bandwidth
+	bool setup(int sampleRate, int freqLow, int bandwidth, int spreadingFactor);
+
+	// Set preamble length in symbols
+	void setPreamble(int lenInSymbols)
+	{
+		_preambleSymbols = lenInSymbols;
+	}
+
+	// Source of bits to send
+	void setBitSource(FSKModSymbolSourceFnType bitSourceFn)
+	{
+		_bitSourceFn = bitSourceFn;
+	}
+
+	// Start streaming - the preamble then symbols until the source has no more bits
+	// (the last symbol is padded with 0s)
+	void startStream();
+
+	// Stop
+	void clear();
+
+	// Get a sample from the modulated output
+	bool getSample(int& sampleValue);
+
+	int getSamplesPerSymbol()
+	{
+		return _samplesPerSymbol;
+	}
+
+	// Gray coding - the bits of a symbol are grayEncode(shift)
+	static int grayEncode(int val)
+	{
+		return val ^ (val >> 1);
+	}
+	static int grayDecode(int val)
+	{
+		for (int shift = val >> 1; shift != 0; shift >>= 1)
+			val ^= shift;
+		return val;
+	}
+
+private:
+	bool getNextSymbol(int& symbol);
+};
@@ -33,7 +33,7 @@ ClockRecovery::~ClockRecovery()
 {
 }
 
-void ClockRecovery::setup(int samplesPerSymbol, bool manchesterEncoding)
+void ClockRecovery::setup(int samplesPerSymbol, bool manchesterEncoding, const FSKDemodParams& params)
 {
 	// Store settings
 	_samplesPerSymbol = samplesPerSymbol;
@@ -41,16 +41,20 @@ void ClockRecovery::setup(int samplesPerSymbol, bool manchesterEncoding)
 	_manchesterEncoding = manchesterEncoding;
 	_lastTransitionValid = false;
 	_adjustedSymbolEdgeOffset = -1;
+	setWindows(params);
+}
 
+void ClockRecovery::setWindows(const FSKDemodParams& params)
+{
 	// Calculate acceptable transition periods
-	if (manchesterEncoding)
+	if (_manchesterEncoding)
 	{
 		// Only adjust timing based on long transitions (alternating 1s and 0s)
 		// As these transitions identify the centre of the manchester symbol
-		_transitionMinValid = int(_samplesPerSymbol * 0.9);
-		_transitionMaxValid = int(_samplesPerSymbol * 1.1);
-		_transitionCentreMin = int(_samplesPerSymbol * 0.25);
-		_transitionCentreMax = int(_samplesPerSymbol * 0.75);
+		_transitionMinValid = _samplesPerSymbol * params.transitionMinPercent / 100;
+		_transitionMaxValid = _samplesPerSymbol * params.transitionMaxPercent / 100;
+		_transitionCentreMin = _samplesPerSymbol * params.centreMinPercent / 100;
+		_transitionCentreMax = _samplesPerSymbol * params.centreMaxPercent / 100;
 	}
 }
 
@@ -174,6 +178,17 @@ bool ClockRecovery::newSample(int sampleLevel, ClockDebugVals* pDebugVals)
 	return bitSamplePoint;
 }
 
+void ClockRecovery::setSymbolTiming(uint32_t symbolEdgeSampleCount)
+{
+	// Restart adjustment stats from the new timing
+	_transitionBufGetPos = 0;
+	_transitionBufCount = 0;
+	_transitionAccum = 0;
+	_modCentreAccum = 0;
+	_adjustedSamplesPerSymbol = _samplesPerSymbol;
+	_adjustedSymbolEdgeOffset = symbolEdgeSampleCount % _adjustedSamplesPerSymbol;
+}
+
 void ClockRecovery::handleManchesterAdjustments(uint32_t sampleCount, int transitionSamples)
 {
 	// Check the data falls into the acceptable ranges
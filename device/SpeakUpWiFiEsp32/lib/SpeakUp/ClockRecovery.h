@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <limits.h>
+#include "FSKDemodParams.h"
 
 class ClockRecovery
 {
@@ -60,9 +61,21 @@ public:
 
 	ClockRecovery();
 	~ClockRecovery();
-	void setup(int samplesPerSymbol, bool manchesterEncoding);
+	void setup(int samplesPerSymbol, bool manchesterEncoding, const FSKDemodParams& params = FSKDemodParams());
+
+	// Change the timing windows (from the demodulator params) without restarting
+	void setWindows(const FSKDemodParams& params);
 	bool newSample(int sampleLevel, ClockDebugVals* pDebugVals = NULL);
 
+	// Count of the sample that will be passed to the next call to newSample()
+	uint32_t getSampleCount()
+	{
+		return _curSampleCount;
+	}
+
+	// Set symbol timing directly (e.g. from a preamble detector)
+	void setSymbolTiming(uint32_t symbolEdgeSampleCount);
+
 private:
 	void handleManchesterAdjustments(uint32_t sampleCount, int transitionSamples);
 };
@@ -0,0 +1,261 @@
+// CredentialParser
+// Compact binary (TLV) format for WiFi credentials
+
+#include "CredentialParser.h"
+#include <string.h>
+
+// Parse the binary format
+bool CredentialParser::parse(const uint8_t* pFrame, int frameLen, WiFiCredentials& creds)
+{
+	creds.clear();
+	if (!isBinaryFormat(pFrame, frameLen))
+		return false;
+
+	// Fields
+	int pos = 1;
+	while (pos < frameLen)
+	{
+		// Type and length
+		if (pos + 2 > frameLen)
+			return false;
+		uint8_t fieldType = pFrame[pos];
+		int fieldLen = pFrame[pos + 1];
+		pos += 2;
+
+		// Packed text has 6 bits per character
+		bool packed = (fieldType & CRED_PACKED_FLAG) != 0;
+		int valLen = packed ? (fieldLen * 6 + 7) / 8 : fieldLen;
+		if (pos + valLen > frameLen)
+			return false;
+		const uint8_t* pVal = pFrame + pos;
+		pos += valLen;
+
+		// Handle field
+		switch (fieldType & ~CRED_PACKED_FLAG)
+		{
+			case CRED_TYPE_SSID:
+				if (!parseText(pVal, valLen, fieldLen, packed, creds.ssid, WiFiCredentials::MAX_SSID_LEN))
+					return false;
+				break;
+			case CRED_TYPE_PASSWORD:
+				if (!parseText(pVal, valLen, fieldLen, packed, creds.password, WiFiCredentials::MAX_PASSWORD_LEN))
+					return false;
+				break;
+			case CRED_TYPE_BSSID:
+				if (packed || (fieldLen != WiFiCredentials::BSSID_LEN))
+					return false;
+				memcpy(creds.bssid, pVal, WiFiCredentials::BSSID_LEN);
+				creds.bssidValid = true;
+				break;
+			case CRED_TYPE_CHANNEL:
+				if (packed || (fieldLen != 1))
+					return false;
+				creds.channel = pVal[0];
+				break;
+			case CRED_TYPE_SECURITY:
+				if (packed || (fieldLen != 1))
+					return false;
+				creds.security = pVal[0];
+				break;
+			default:
+				// Skip unknown fields
+				break;
+		}
+	}
+	return creds.ssid[0] != 0;
+}
+
+// Parse the original JSON text format
+bool CredentialParser::parseJson(const uint8_t* pFrame, int frameLen, WiFiCredentials& creds)
+{
+	creds.clear();
+	if (!findJsonString(pFrame, frameLen, "\"s\":\"", creds.ssid, WiFiCredentials::MAX_SSID_LEN))
+		return false;
+	findJsonString(pFrame, frameLen, "\"p\":\"", creds.password, WiFiCredentials::MAX_PASSWORD_LEN);
+	return creds.ssid[0] != 0;
+}
+
+// Encode credentials in the binary format
+int CredentialParser::encode(const WiFiCredentials& creds, uint8_t* pBuf, int bufLen)
+{
+	if (bufLen < 1)
+		return 0;
+	int pos = 0;
+	pBuf[pos++] = CREDENTIAL_FORMAT_VERSION;
+
+	// Text fields
+	int fieldLen = encodeText(CRED_TYPE_SSID, creds.ssid, pBuf + pos, bufLen - pos);
+	if (fieldLen == 0)
+		return 0;
+	pos += fieldLen;
+	if (creds.password[0])
+	{
+		fieldLen = encodeText(CRED_TYPE_PASSWORD, creds.password, pBuf + pos, bufLen - pos);
+		if (fieldLen == 0)
+			return 0;
+		pos += fieldLen;
+	}
+
+	// Optional fields
+	if (creds.bssidValid)
+	{
+		if (pos + 2 + WiFiCredentials::BSSID_LEN > bufLen)
+			return 0;
+		pBuf[pos++] = CRED_TYPE_BSSID;
+		pBuf[pos++] = WiFiCredentials::BSSID_LEN;
+		memcpy(pBuf + pos, creds.bssid, WiFiCredentials::BSSID_LEN);
+		pos += WiFiCredentials::BSSID_LEN;
+	}
+	if (creds.channel > 0)
+	{
+		if (pos + 3 > bufLen)
+			return 0;
+		pBuf[pos++] = CRED_TYPE_CHANNEL;
+		pBuf[pos++] = 1;
+		pBuf[pos++] = creds.channel;
+	}
+	if (creds.security >= 0)
+	{
+		if (pos + 3 > bufLen)
+			return 0;
+		pBuf[pos++] = CRED_TYPE_SECURITY;
+		pBuf[pos++] = 1;
+		pBuf[pos++] = creds.security;
+	}
+	return pos;
+}
+
+// Extract a text field (null terminated)
+bool CredentialParser::parseText(const uint8_t* pVal, int valLen, int textLen, bool packed,
+			char* pOut, int maxLen)
+{
+	if (textLen > maxLen)
+		return false;
+	if (packed)
+	{
+		// 6 bit characters with the first in the LSBs
+		uint32_t bitAccum = 0;
+		int bitsInAccum = 0;
+		int inPos = 0;
+		for (int i = 0; i < textLen; i++)
+		{
+			if (bitsInAccum < 6)
+			{
+				bitAccum |= pVal[inPos++] << bitsInAccum;
+				bitsInAccum += 8;
+			}
+			pOut[i] = sixBitToChar(bitAccum & 0x3f);
+			bitAccum >>= 6;
+			bitsInAccum -= 6;
+		}
+	}
+	else
+	{
+		// Nulls would truncate the string
+		if (memchr(pVal, 0, valLen))
+			return false;
+		memcpy(pOut, pVal, valLen);
+	}
+	pOut[textLen] = 0;
+	return true;
+}
+
+// Encode a text field - packed if all characters are in the alphabet
+int CredentialParser::encodeText(uint8_t type, const char* pText, uint8_t* pBuf, int bufLen)
+{
+	int textLen = strlen(pText);
+	if (textLen > 255)
+		return 0;
+	bool canPack = true;
+	for (int i = 0; i < textLen; i++)
+	{
+		if (charToSixBit(pText[i]) < 0)
+		{
+			canPack = false;
+			break;
+		}
+	}
+	int valLen = canPack ? (textLen * 6 + 7) / 8 : textLen;
+	if (2 + valLen > bufLen)
+		return 0;
+	pBuf[0] = canPack ? (type | CRED_PACKED_FLAG) : type;
+	pBuf[1] = textLen;
+	if (!canPack)
+	{
+		memcpy(pBuf + 2, pText, textLen);
+		return 2 + valLen;
+	}
+
+	// Pack 6 bits per character with the first in the LSBs
+	uint32_t bitAccum = 0;
+	int bitsInAccum = 0;
+	int outPos = 2;
+	for (int i = 0; i < textLen; i++)
+	{
+		bitAccum |= charToSixBit(pText[i]) << bitsInAccum;
+		bitsInAccum += 6;
+		while (bitsInAccum >= 8)
+		{
+			pBuf[outPos++] = bitAccum & 0xff;
+			bitAccum >>= 8;
+			bitsInAccum -= 8;
+		}
+	}
+	if (bitsInAccum > 0)
+		pBuf[outPos++] = bitAccum & 0xff;
+	return outPos;
+}
+
+// Find "key":"value" and copy the value (which mustn't contain a quote)
+bool CredentialParser::findJsonString(const uint8_t* pFrame, int frameLen, const char* pKey,
+			char* pOut, int maxLen)
+{
+	pOut[0] = 0;
+	int keyLen = strlen(pKey);
+	for (int startPos = 0; startPos + keyLen <= frameLen; startPos++)
+	{
+		if (memcmp(pFrame + startPos, pKey, keyLen) != 0)
+			continue;
+
+		// Find the closing quote
+		const uint8_t* pVal = pFrame + startPos + keyLen;
+		int valMaxLen = frameLen - startPos - keyLen;
+		const uint8_t* pEnd = (const uint8_t*)memchr(pVal, '"', valMaxLen);
+		if (!pEnd)
+			return false;
+		int valLen = pEnd - pVal;
+		if ((valLen > maxLen) || memchr(pVal, 0, valLen))
+			return false;
+		memcpy(pOut, pVal, valLen);
+		pOut[valLen] = 0;
+		return true;
+	}
+	return false;
+}
+
+// 6 bit alphabet is a-z A-Z 0-9 - _
+int CredentialParser::charToSixBit(char ch)
+{
+	if ((ch >= 'a') && (ch <= 'z'))
+		return ch - 'a';
+	if ((ch >= 'A') && (ch <= 'Z'))
+		return ch - 'A' + 26;
+	if ((ch >= '0') && (ch <= '9'))
+		return ch - '0' + 52;
+	if (ch == '-')
+		return 62;
+	if (ch == '_')
+		return 63;
+	return -1;
+}
+
+char CredentialParser::sixBitToChar(int val)
+{
+	if (val < 26)
+		return 'a' + val;
+	if (val < 52)
+		return 'A' + val - 26;
+	if (val < 62)
+		return '0' + val - 52;
+	return (val == 62) ? '-' : '_';
+}
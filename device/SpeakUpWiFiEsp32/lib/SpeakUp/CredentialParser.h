@@ -0,0 +1,98 @@
+// CredentialParser
+// Compact binary (TLV) format for WiFi credentials
+//
+// Format:
+//   Version byte (CREDENTIAL_FORMAT_VERSION)
+//   Then a sequence of TLV fields - type byte, length byte, value
+// Fields:
+//   SSID (required, up to 32 bytes), passphrase (up to 64 bytes),
+//   BSSID (6 bytes), channel (1 byte), security type (1 byte)
+// Text fields whose characters are all in the 64 character alphabet (a-z A-Z 0-9 - _)
+// can be sent packed at 6 bits per character - the type has CRED_PACKED_FLAG set
+// and the length is the number of characters (not bytes)
+//
+// Parsing works directly on the received frame and doesn't allocate
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+class WiFiCredentials
+{
+public:
+	static const int MAX_SSID_LEN = 32;
+	static const int MAX_PASSWORD_LEN = 64;
+	static const int BSSID_LEN = 6;
+
+	// Security types - values match the ESP32 wifi_auth_mode_t
+	static const int SECURITY_UNKNOWN = -1;
+	static const int SECURITY_OPEN = 0;
+	static const int SECURITY_WEP = 1;
+	static const int SECURITY_WPA_PSK = 2;
+	static const int SECURITY_WPA2_PSK = 3;
+	static const int SECURITY_WPA_WPA2_PSK = 4;
+
+	char ssid[MAX_SSID_LEN + 1];
+	char password[MAX_PASSWORD_LEN + 1];
+	uint8_t bssid[BSSID_LEN];
+	bool bssidValid;
+	int channel;
+	int security;
+
+	WiFiCredentials()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		ssid[0] = 0;
+		password[0] = 0;
+		for (int i = 0; i < BSSID_LEN; i++)
+			bssid[i] = 0;
+		bssidValid = false;
+		channel = 0;
+		security = SECURITY_UNKNOWN;
+	}
+};
+
+class CredentialParser
+{
+public:
+	static const uint8_t CREDENTIAL_FORMAT_VERSION = 0x01;
+
+	// Field types
+	static const uint8_t CRED_TYPE_SSID = 0x01;
+	static const uint8_t CRED_TYPE_PASSWORD = 0x02;
+	static const uint8_t CRED_TYPE_BSSID = 0x03;
+	static const uint8_t CRED_TYPE_CHANNEL = 0x04;
+	static const uint8_t CRED_TYPE_SECURITY = 0x05;
+	static const uint8_t CRED_PACKED_FLAG = 0x80;
+
+	// Check if a frame is in the binary format (rather than JSON text)
+	static bool isBinaryFormat(const uint8_t* pFrame, int frameLen)
+	{
+		return (frameLen > 0) && (pFrame[0] == CREDENTIAL_FORMAT_VERSION);
+	}
+
+	// Parse the binary format - returns false if the frame is invalid or has no SSID
+	// Unknown field types are skipped
+	static bool parse(const uint8_t* pFrame, int frameLen, WiFiCredentials& creds);
+
+	// Parse the original JSON text format {"s":"...","p":"..."}
+	static bool parseJson(const uint8_t* pFrame, int frameLen, WiFiCredentials& creds);
+
+	// Encode credentials in the binary format - text fields are packed where possible
+	// Returns the length or 0 if the buffer is too small
+	static int encode(const WiFiCredentials& creds, uint8_t* pBuf, int bufLen);
+
+private:
+	static bool parseText(const uint8_t* pVal, int valLen, int textLen, bool packed,
+				char* pOut, int maxLen);
+	static int encodeText(uint8_t type, const char* pText, uint8_t* pBuf, int bufLen);
+	static bool findJsonString(const uint8_t* pFrame, int frameLen, const char* pKey,
+				char* pOut, int maxLen);
+	static int charToSixBit(char ch);
+	static char sixBitToChar(int val);
+};
@@ -0,0 +1,89 @@
+// EnergySquelch
+// Cheap energy detector that gates the demodulator when no signal is present
+
+#include "EnergySquelch.h"
+
+void EnergySquelch::clear()
+{
+	_state = SQUELCH_CLOSED;
+	_prevSamples[0] = 0;
+	_prevSamples[1] = 0;
+	_energy = 0;
+	_noiseFloor = 0;
+	_settleCount = 0;
+	_hangCount = 0;
+	_lookbackPutPos = 0;
+	_lookbackCount = 0;
+}
+
+// Process a sample
+bool EnergySquelch::processSample(int sampleVal)
+{
+	// Update energy
+	int diff = sampleVal - _prevSamples[1];
+	_prevSamples[1] = _prevSamples[0];
+	_prevSamples[0] = sampleVal;
+	int absDiff = (diff < 0) ? -diff : diff;
+	_energy += (absDiff - _energy) >> ENERGY_SMOOTH_SHIFT;
+
+	// Add to lookback - the oldest sample is discarded if full
+	_lookbackBuf[_lookbackPutPos] = saturateS16(sampleVal);
+	if (++_lookbackPutPos >= _lookbackLen)
+		_lookbackPutPos = 0;
+	if (_lookbackCount < _lookbackLen)
+		_lookbackCount++;
+
+	// Update state
+	int noiseFloor = _noiseFloor >> NOISE_FLOOR_FRAC_BITS;
+	int floorDiff = (_energy << NOISE_FLOOR_FRAC_BITS) - _noiseFloor;
+	if (_state == SQUELCH_OPEN)
+	{
+		// Noise floor creeps up while open - close after the hang time
+		if (floorDiff > 0)
+			_noiseFloor += floorDiff >> NOISE_FLOOR_OPEN_RISE_SHIFT;
+		if (_energy * 16 < noiseFloor * _closeRatio16)
+		{
+			if (++_hangCount >= _hangSamples)
+				_state = SQUELCH_DRAINING;
+		}
+		else
+		{
+			_hangCount = 0;
+		}
+	}
+	else
+	{
+		// Check for carrier (once the noise floor estimate has settled)
+		if ((_settleCount >= NOISE_FLOOR_SETTLE_SAMPLES) &&
+				(_energy * 16 > noiseFloor * _openRatio16) && (_energy > _minOpenLevel))
+		{
+			_state = SQUELCH_OPEN;
+			_hangCount = 0;
+		}
+		else
+		{
+			// Track noise floor - rises slowly and falls quickly
+			if (_settleCount < NOISE_FLOOR_SETTLE_SAMPLES)
+				_settleCount++;
+			_noiseFloor += floorDiff >> ((floorDiff > 0) ? NOISE_FLOOR_RISE_SHIFT : NOISE_FLOOR_FALL_SHIFT);
+		}
+	}
+	return _state != SQUELCH_CLOSED;
+}
+
+// Get a buffered sample
+bool EnergySquelch::getSample(int& sampleVal)
+{
+	if ((_state == SQUELCH_CLOSED) || (_lookbackCount == 0))
+		return false;
+	int getPos = _lookbackPutPos - _lookbackCount;
+	if (getPos < 0)
+		getPos += _lookbackLen;
+	sampleVal = _lookbackBuf[getPos];
+	_lookbackCount--;
+
+	// Fully closed once drained
+	if ((_state == SQUELCH_DRAINING) && (_lookbackCount == 0))
+		_state = SQUELCH_CLOSED;
+	return true;
+}
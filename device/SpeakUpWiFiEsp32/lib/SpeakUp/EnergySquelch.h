@@ -0,0 +1,119 @@
+// EnergySquelch
+// Cheap in-band energy detector that gates the demodulator when no signal is present
+// Samples are held in a short lookback buffer while the squelch is closed so that
+// the start of a transmission (the preamble) is not lost when it opens
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "SampleFormat.h"
+
+class EnergySquelch
+{
+public:
+	enum SquelchState
+	{
+		SQUELCH_CLOSED,
+		SQUELCH_OPEN,
+		SQUELCH_DRAINING
+	};
+
+private:
+	// State
+	SquelchState _state;
+
+	// Energy detector - x[n] - x[n-2] is a cheap bandpass that rejects DC
+	// and Nyquist and peaks at a quarter of the sample rate (2KHz at 8KHz)
+	int _prevSamples[2];
+	int _energy;
+	static const int ENERGY_SMOOTH_SHIFT = 5;
+
+	// Noise floor (held with NOISE_FLOOR_FRAC_BITS extra bits of precision)
+	// While open the floor rises very slowly so that a persistent change in
+	// background noise cannot hold the squelch open indefinitely
+	static const int NOISE_FLOOR_FRAC_BITS = 12;
+	static const int NOISE_FLOOR_RISE_SHIFT = 10;
+	static const int NOISE_FLOOR_FALL_SHIFT = 5;
+	static const int NOISE_FLOOR_OPEN_RISE_SHIFT = 17;
+	static const int NOISE_FLOOR_SETTLE_SAMPLES = 1024;
+	int _noiseFloor;
+	int _settleCount;
+
+	// Thresholds relative to the noise floor (in 16ths) and absolute minimum
+	int _openRatio16;
+	int _closeRatio16;
+	int _minOpenLevel;
+
+	// Hang time
+	int _hangSamples;
+	int _hangCount;
+
+	// Lookback buffer (external or owned) - only used from one context so simple
+	// positions suffice
+	int16_t* _lookbackBuf;
+	std::vector<int16_t> _ownLookbackBuf;
+	int _lookbackLen;
+	int _lookbackPutPos;
+	int _lookbackCount;
+
+public:
+	static const int DEFAULT_OPEN_RATIO_16 = 40;
+	static const int DEFAULT_CLOSE_RATIO_16 = 24;
+	static const int DEFAULT_MIN_OPEN_LEVEL = 200;
+
+	// Constructor - the lookback buffer should cover the detection delay - if
+	// pLookbackStorage is supplied it must hold lookbackLen samples and remain valid
+	EnergySquelch(int lookbackLen, int hangSamples, int16_t* pLookbackStorage = NULL)
+	{
+		if (pLookbackStorage)
+		{
+			_lookbackBuf = pLookbackStorage;
+		}
+		else
+		{
+			_ownLookbackBuf.resize(lookbackLen);
+			_lookbackBuf = _ownLookbackBuf.data();
+		}
+		_lookbackLen = lookbackLen;
+		_hangSamples = hangSamples;
+		_openRatio16 = DEFAULT_OPEN_RATIO_16;
+		_closeRatio16 = DEFAULT_CLOSE_RATIO_16;
+		_minOpenLevel = DEFAULT_MIN_OPEN_LEVEL;
+		clear();
+	}
+
+	// Set thresholds - ratios are relative to the noise floor in 16ths
+	void setThresholds(int openRatio16, int closeRatio16, int minOpenLevel)
+	{
+		_openRatio16 = openRatio16;
+		_closeRatio16 = closeRatio16;
+		_minOpenLevel = minOpenLevel;
+	}
+
+	// Clear state
+	void clear();
+
+	// Process a sample - it is added to the lookback buffer (saturated to 16 bits)
+	// Returns true if the squelch is open (or still draining)
+	bool processSample(int sampleVal);
+
+	// Get a buffered sample for the full demodulator chain
+	// Samples are only available while the squelch is open or draining
+	bool getSample(int& sampleVal);
+
+	// State
+	SquelchState getState()
+	{
+		return _state;
+	}
+	int getEnergy()
+	{
+		return _energy;
+	}
+	int getNoiseFloor()
+	{
+		return _noiseFloor >> NOISE_FLOOR_FRAC_BITS;
+	}
+};
@@ -7,16 +7,63 @@
 
 // Setup - defining sample rate, etc
 void FSKDemod::setup(int sampleRate, int symbolRate, int symbolFreqHigh,
-                    int symbolFreqLow, bool manchesterCodec)
+                    int symbolFreqLow, bool manchesterCodec, const FSKDemodParams& params)
 {
+    if (params.isValid())
+        _params = params;
+    _voteMask = (1 << _params.numVotingSamples) - 1;
     _sampleRate = sampleRate;
     _symbolRate = symbolRate;
-    _numSymbols = 2;
-    _symbolFreqs.resize(_numSymbols);
+    _numSymbols = NUM_SYMBOLS;
     _symbolFreqs[0] = symbolFreqLow;
     _symbolFreqs[1] = symbolFreqHigh;
     _manchesterCodec = manchesterCodec;
-    _clockRecovery.setup(sampleRate / symbolRate, _manchesterCodec);
+    _clockRecovery.setup(sampleRate / symbolRate, _manchesterCodec, _params);
+}
+
+// Change tracking constants and timing windows
+bool FSKDemod::setParams(const FSKDemodParams& params)
+{
+    if (!params.isValid())
+        return false;
+    _params = params;
+    _voteMask = (1 << _params.numVotingSamples) - 1;
+    _clockRecovery.setWindows(_params);
+    return true;
+}
+
+// Enable preamble/sync word detector
+void FSKDemod::enableSyncDetector(uint32_t syncWord, int syncWordBits, int preambleBits)
+{
+    _preambleDetector.setup(_sampleRate / _symbolRate, syncTemplateBits(syncWord, preambleBits),
+                preambleBits + syncWordBits, syncWordBits);
+    _syncWord = syncWord;
+    _syncWordBits = syncWordBits;
+    _preambleBits = preambleBits;
+    _syncDetectEnabled = true;
+    if (_pEqualiser)
+        _pEqualiser->setTrainingBits(syncTemplateBits(syncWord, preambleBits), preambleBits + syncWordBits);
+}
+
+// Attach equaliser
+void FSKDemod::setEqualiser(FSKEqualiser* pEqualiser)
+{
+    _pEqualiser = pEqualiser;
+    _preambleDetector.setMinContrast(_pEqualiser ? FSKEqualiser::SYNC_MIN_CONTRAST_16 :
+                PreambleDetector::DEFAULT_MIN_CONTRAST_16);
+    if (_pEqualiser && _syncDetectEnabled)
+        _pEqualiser->setTrainingBits(syncTemplateBits(_syncWord, _preambleBits), _preambleBits + _syncWordBits);
+}
+
+// Template bits for the preamble detector
+uint32_t FSKDemod::syncTemplateBits(uint32_t syncWord, int preambleBits)
+{
+    // Preamble is alternating 0s and 1s ending with a 1
+    uint32_t templateBits = 0;
+    for (int i = 0; i < preambleBits; i++)
+        templateBits |= ((preambleBits - 1 - i) % 2 == 0 ? 1 : 0) << i;
+    templateBits |= syncWord << preambleBits;
+    return templateBits;
 }
 
 // Process a single sample
@@ -41,34 +88,41 @@ void FSKDemod::processSample(int currentSample, FSKDebugVals *pDebugVals)
     // Envelope detect
     updateSignalHigh(outVal);
     updateSignalLow(outVal);
-    _curEnvelopeVal = _curEnvelopeVal + ((outVal - _curEnvelopeVal) * _envelopePercent) / FILTER_INT_MULT;
-    uint8_t _signalInstantaneous = _curEnvelopeVal > (_signalHigh + _signalLow) / 2;
+    _curEnvelopeVal = _curEnvelopeVal + ((outVal - _curEnvelopeVal) * _params.envelopePercent) / FILTER_INT_MULT;
+
+    // Equalise
+    _curSlicerVal = _curEnvelopeVal;
+    if (_pEqualiser)
+        _curSlicerVal = _pEqualiser->process(_curEnvelopeVal, _signalHigh, _signalLow);
+
+    // Check for preamble and sync word
+    if (_syncDetectEnabled)
+    {
+        PreambleDetector::DetectResult detectResult;
+        if (_preambleDetector.processSample(_curSlicerVal, _clockRecovery.getSampleCount(), detectResult) &&
+                    !_syncDetectHold)
+            handleSyncDetected(detectResult);
+    }
+
+    // Slice
+    uint8_t _signalInstantaneous = _curSlicerVal > (_signalHigh + _signalLow) / 2;
 
     // Debug
     if (pDebugVals)
     {
         pDebugVals->symbolVal = -1;
         pDebugVals->inputValue = currentSample;
-        pDebugVals->envelopeValue = _curEnvelopeVal;
+        pDebugVals->envelopeValue = _curSlicerVal;
         pDebugVals->signalInstantaneous = _signalInstantaneous;
         pDebugVals->signalLow = _signalLow;
         pDebugVals->signalHigh = _signalHigh;
     }
 
-    // Voting on the bit value
-    int oneCount = 0;
-    for (int i = 0; i < NUM_SAMPLES_VOTING - 1; i++)
-    {
-        _sampleVoting[i] = _sampleVoting[i + 1];
-        oneCount += _sampleVoting[i] ? 1 : 0;
-    }
-    _sampleVoting[NUM_SAMPLES_VOTING - 1] = _signalInstantaneous;
-
-    // Count ones in sequence length
-    oneCount += _signalInstantaneous ? 1 : 0;
-    if (oneCount == 0)
+    // Voting on the bit value - the level changes when all the recent samples agree
+    _voteHistory = ((_voteHistory << 1) | _signalInstantaneous) & _voteMask;
+    if (_voteHistory == 0)
         _curSignalLevel = 0;
-    else if (oneCount == NUM_SAMPLES_VOTING)
+    else if (_voteHistory == _voteMask)
         _curSignalLevel = 1;
     if (pDebugVals)
         pDebugVals->curSignalLevel = _curSignalLevel;
@@ -85,11 +139,7 @@ void FSKDemod::processSample(int currentSample, FSKDebugVals *pDebugVals)
             symbolValue = symbolValue ? 0 : 1;
 
         // Put value into output buffer
-        if (_rxSymbolFifoPos.canPut())
-        {
-            _rxSymbolFifoBuf[_rxSymbolFifoPos.posToPut()] = symbolValue;
-            _rxSymbolFifoPos.hasPut();
-        }
+        putRxBit(symbolValue);
 
         // Debug
         if (pDebugVals)
@@ -102,24 +152,43 @@ void FSKDemod::processSample(int currentSample, FSKDebugVals *pDebugVals)
 // Get a received bit (if available)
 bool FSKDemod::getRxBit(int &bitVal)
 {
-    if (!_rxSymbolFifoPos.canGet())
-        return false;
-    bitVal = _rxSymbolFifoBuf[_rxSymbolFifoPos.posToGet()];
-    _rxSymbolFifoPos.hasGot();
-    return true;
+    return _rxSymbolFifo.get(bitVal);
 }
 
 // Helper functions
-int FSKDemod::updateSignalHigh(int curVal)
+void FSKDemod::putRxBit(int bitVal)
+{
+    _rxSymbolFifo.put(bitVal);
+}
+
+void FSKDemod::handleSyncDetected(PreambleDetector::DetectResult& detectResult)
+{
+    // Set slicer thresholds and symbol timing
+    _signalHigh = detectResult.signalHigh;
+    _signalLow = detectResult.signalLow;
+    _clockRecovery.setSymbolTiming(detectResult.symbolEdgeSampleCount);
+    _syncDetectCount++;
+
+    // Train the equaliser on the preamble and sync word that were found
+    if (_pEqualiser)
+        _pEqualiser->train(_clockRecovery.getSampleCount() + 1 - detectResult.symbolEdgeSampleCount,
+                    _signalHigh, _signalLow);
+
+    // Regenerate the sync word
+    for (int i = 0; i < _syncWordBits; i++)
+        putRxBit((_syncWord >> i) & 0x01);
+}
+
+int FSKDemod::updateSignalHigh(int)
 {
-    int curDiff = _curEnvelopeVal - _signalHigh;
-    _signalHigh += (curDiff > 0) ? ((curDiff * _peakFollowPer10K) / 10000) : ((curDiff * _peakRestPer10K) / 10000);
+    int curDiff = _curSlicerVal - _signalHigh;
+    _signalHigh += (curDiff > 0) ? ((curDiff * _params.peakFollowPer10K) / 10000) : ((curDiff * _params.peakRestPer10K) / 10000);
     return _signalHigh;
 }
 
-int FSKDemod::updateSignalLow(int curVal)
+int FSKDemod::updateSignalLow(int)
 {
-    int curDiff = _curEnvelopeVal - _signalLow;
-    _signalLow += (curDiff < 0) ? ((curDiff * _peakFollowPer10K) / 10000) : ((curDiff * _peakRestPer10K) / 10000);
+    int curDiff = _curSlicerVal - _signalLow;
+    _signalLow += (curDiff < 0) ? ((curDiff * _params.peakFollowPer10K) / 10000) : ((curDiff * _params.peakRestPer10K) / 10000);
     return _signalLow;
 }
@@ -6,9 +6,11 @@
 
 #include <stdint.h>
 #include <limits.h>
-#include <vector>
-#include "RingBufferPosn.h"
+#include "SymbolFifo.h"
 #include "ClockRecovery.h"
+#include "PreambleDetector.h"
+#include "FSKDemodParams.h"
+#include "FSKEqualiser.h"
 
 class FSKDemod
 {
@@ -16,8 +18,9 @@ private:
 	// Sample rate, bit rate and symbols
 	int _sampleRate;
 	int _symbolRate;
+	static const int NUM_SYMBOLS = 2;
 	int _numSymbols;
-	std::vector<int> _symbolFreqs;
+	int _symbolFreqs[NUM_SYMBOLS];
 	bool _manchesterCodec;
 
 	// Butterworth 3 pole low-pass filter
@@ -32,21 +35,22 @@ private:
 	static const int FILTER_PARAM_2 = int(-0.4217 * FILTER_INT_MULT + 0.5);
 	static const int FILTER_PARAM_3 = int(0.5772 * FILTER_INT_MULT + 0.5);
 
-	// Previous sample levels
-	static const int NUM_SAMPLES_VOTING = 3;
-	int _sampleVoting[NUM_SAMPLES_VOTING];
+	// Tracking constants and timing windows
+	FSKDemodParams _params;
+
+	// Previous slicer outputs (bit 0 is the latest) - the level changes when all
+	// those in the mask agree
+	uint8_t _voteHistory;
+	uint8_t _voteMask;
 
 	// Output bit buffer
-	RingBufferPosn _rxSymbolFifoPos;
-	std::vector<uint8_t> _rxSymbolFifoBuf;
+	SymbolFifo _rxSymbolFifo;
 
 	// Smoothing filters for discrimination
 	int _curEnvelopeVal;
-	int _envelopePercent;
+	int _curSlicerVal;
 	int _signalHigh;
 	int _signalLow;
-	int _peakFollowPer10K;
-	int _peakRestPer10K;
 
 	// Current signal level
 	int _curSignalLevel;
@@ -54,6 +58,18 @@ private:
 	// Clock recovery
 	ClockRecovery _clockRecovery;
 
+	// Preamble/sync word detector
+	PreambleDetector _preambleDetector;
+	bool _syncDetectEnabled;
+	uint32_t _syncWord;
+	int _syncWordBits;
+	int _preambleBits;
+	int _syncDetectCount;
+	bool _syncDetectHold;
+
+	// Optional equaliser between the envelope and the slicer (and sync detector)
+	FSKEqualiser* _pEqualiser;
+
 public:
 
 	class FSKDebugVals
@@ -79,24 +95,72 @@ public:
 		}
 	};
 
-	// Constructor
-	FSKDemod(int rxFifoLen) : _rxSymbolFifoPos(rxFifoLen)
+	// Constructor - the received symbol FIFO can use external storage
+	// (SymbolFifo::storageWordsFor(rxFifoLen, 1) words) and so can the sync
+	// detector (PreambleDetector::STORAGE_LEN ints)
+	FSKDemod(int rxFifoLen, uint32_t* pFifoStorage = NULL, int* pSyncDetectStorage = NULL) :
+				_rxSymbolFifo(rxFifoLen, 1, pFifoStorage),
+				_preambleDetector(pSyncDetectStorage)
 	{
 		// Clear
-		_rxSymbolFifoBuf.resize(rxFifoLen);
 		_curEnvelopeVal = 0;
-		_envelopePercent = 20;
-		_peakFollowPer10K = 500;
-		_peakRestPer10K = 10;
+		_curSlicerVal = 0;
 		_signalHigh = 0;
 		_signalLow = 32767;
 		_manchesterCodec = true;
 		_curSignalLevel = 0;
+		_syncDetectEnabled = false;
+		_syncWord = 0;
+		_syncWordBits = 0;
+		_preambleBits = 0;
+		_syncDetectCount = 0;
+		_syncDetectHold = false;
+		_pEqualiser = NULL;
+		_numSymbols = NUM_SYMBOLS;
+		_symbolFreqs[0] = 1000;
+		_symbolFreqs[1] = 2000;
+		for (int i = 0; i <= NUM_FILTER_POLES; i++)
+			xv[i] = yv[i] = 0;
+		_voteHistory = 0;
+		_voteMask = (1 << _params.numVotingSamples) - 1;
 	}
 
 	// Setup
 	void setup(int sampleRate, int symbolRate, int symbolFreqHigh, 
-				int symbolFreqLow, bool manchesterCodec);
+				int symbolFreqLow, bool manchesterCodec, const FSKDemodParams& params = FSKDemodParams());
+
+	// Change the tracking constants and timing windows - returns false (and
+	// leaves them unchanged) if the params are out of range
+	bool setParams(const FSKDemodParams& params);
+	const FSKDemodParams& getParams()
+	{
+		return _params;
+	}
+
+	// Enable detection of the end of the preamble and the sync word (bits sent LSB first)
+	// When found the symbol timing and slicer thresholds are set and the sync word bits
+	// are output so that the data link layer sees the complete sync word
+	void enableSyncDetector(uint32_t syncWord, int syncWordBits, int preambleBits);
+
+	// Bits (in transmission order) of the preamble end and sync word that the detector looks for
+	static uint32_t syncTemplateBits(uint32_t syncWord, int preambleBits);
+
+	// Hold the sync detector - detections are ignored while held (used while
+	// receiving a frame whose data may contain the sync word)
+	void holdSyncDetector(bool hold)
+	{
+		_syncDetectHold = hold;
+	}
+
+	// Attach an equaliser (set up for the symbol rate) or NULL to remove it - it is
+	// trained when the sync word is detected so sync detection should be enabled
+	void setEqualiser(FSKEqualiser* pEqualiser);
+
+	// Number of times the sync word has been detected
+	int getSyncDetectCount()
+	{
+		return _syncDetectCount;
+	}
 
 	// Process a single sample
 	void processSample(int currentSample, FSKDebugVals* pDebugVals = NULL);
@@ -104,9 +168,18 @@ public:
 	// Get a received bit
 	bool getRxBit(int& bitVal);
 
+	// Get up to maxBits (at most 32) received bits - the first received is in the LSB
+	// Returns the number of bits got
+	int getRxBits(uint32_t& bits, int maxBits)
+	{
+		return _rxSymbolFifo.getSymbols(bits, maxBits);
+	}
+
 private:
 	// Helpers
 	int updateSignalHigh(int curVal);
 	int updateSignalLow(int curVal);
+	void handleSyncDetected(PreambleDetector::DetectResult& detectResult);
+	void putRxBit(int bitVal);
 
 };
@@ -0,0 +1,347 @@
+// FSKDemodBank
+// N binary FSK demodulators advanced together a sample at a time
+// State is held as structure-of-arrays (one array entry per channel) so the filter,
+// envelope, slicer and voting stages are simple loops across the channels that the
+// compiler can vectorise - data dependent choices are selects rather than branches
+// Clock recovery only does work on a signal transition so the transition flags are
+// computed for all channels and then just the channels that have one are updated
+// Output bits are the same as N separate FSKDemod instances given the same samples
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "FSKDemod.h"
+#include "SymbolFifo.h"
+#include "PreambleDetector.h"
+#include "FSKDemodParams.h"
+
+template<int N>
+class FSKDemodBank
+{
+private:
+	// Filter - same as FSKDemod
+	static const int FILTER_INT_MULT = 100;
+	static const int FILTER_GAIN = 4;
+	static const int FILTER_PARAM_1 = int(0.0562 * FILTER_INT_MULT + 0.5);
+	static const int FILTER_PARAM_2 = int(-0.4217 * FILTER_INT_MULT + 0.5);
+	static const int FILTER_PARAM_3 = int(0.5772 * FILTER_INT_MULT + 0.5);
+	int _xv0[N], _xv1[N], _xv2[N];
+	int _yv0[N], _yv1[N], _yv2[N];
+
+	// Envelope and slicer thresholds
+	int _envelope[N];
+	int _signalHigh[N];
+	int _signalLow[N];
+	FSKDemodParams _params;
+
+	// Voting on the last numVotingSamples slicer outputs (bit 0 is the latest)
+	uint8_t _voteHistory[N];
+	uint8_t _voteMask;
+	uint8_t _signalLevel[N];
+
+	// Clock recovery - the sample count is common to all channels
+	static const int MAX_TRANSITION_TIMES_TO_STORE = 5;
+	uint32_t _curSampleCount;
+	int _samplesPerSymbol;
+	int _transitionMinValid;
+	int _transitionMaxValid;
+	int _transitionCentreMin;
+	int _transitionCentreMax;
+	uint8_t _transition[N];
+	uint32_t _lastTransitionSampleCount[N];
+	int _transitionSamples[MAX_TRANSITION_TIMES_TO_STORE][N];
+	int _modCentrePos[MAX_TRANSITION_TIMES_TO_STORE][N];
+	int _transitionBufGetPos[N];
+	int _transitionBufCount[N];
+	int _transitionAccum[N];
+	int _modCentreAccum[N];
+	int _symbolEdgeOffset[N];
+	bool _manchesterCodec;
+
+	// Sync word detection - run per channel as detections are rare and their
+	// evaluation is mostly branches
+	std::vector<PreambleDetector> _preambleDetectors;
+	bool _syncDetectEnabled;
+	uint32_t _syncWord;
+	int _syncWordBits;
+	int _syncDetectCount[N];
+	bool _syncDetectHold[N];
+
+	// Output bits - the FIFOs share one block of storage
+	std::vector<uint32_t> _rxFifoStorage;
+	std::vector<SymbolFifo> _rxSymbolFifos;
+
+public:
+	static const int NUM_CHANNELS = N;
+
+	FSKDemodBank(int rxFifoLen)
+	{
+		int fifoWords = SymbolFifo::storageWordsFor(rxFifoLen, 1);
+		_rxFifoStorage.resize(N * fifoWords);
+		_rxSymbolFifos.reserve(N);
+		for (int c = 0; c < N; c++)
+			_rxSymbolFifos.push_back(SymbolFifo(rxFifoLen, 1, &_rxFifoStorage[c * fifoWords]));
+		_voteMask = (1 << _params.numVotingSamples) - 1;
+		_curSampleCount = 0;
+		_samplesPerSymbol = 1;
+		_transitionMinValid = 0;
+		_transitionMaxValid = 0;
+		_transitionCentreMin = 0;
+		_transitionCentreMax = 0;
+		_manchesterCodec = true;
+		_syncDetectEnabled = false;
+		_syncWord = 0;
+		_syncWordBits = 0;
+		for (int c = 0; c < N; c++)
+		{
+			_xv0[c] = _xv1[c] = _xv2[c] = 0;
+			_yv0[c] = _yv1[c] = _yv2[c] = 0;
+			_envelope[c] = 0;
+			_signalHigh[c] = 0;
+			_signalLow[c] = 32767;
+			_voteHistory[c] = 0;
+			_signalLevel[c] = 0;
+			_transition[c] = 0;
+			_lastTransitionSampleCount[c] = 0;
+			_transitionBufGetPos[c] = 0;
+			_transitionBufCount[c] = 0;
+			_transitionAccum[c] = 0;
+			_modCentreAccum[c] = 0;
+			_symbolEdgeOffset[c] = -1;
+			_syncDetectCount[c] = 0;
+			_syncDetectHold[c] = false;
+		}
+	}
+
+	// Setup - as FSKDemod::setup() - clock recovery only supports Manchester coding
+	// The tone frequencies are taken so SpeakUp::setupDemod() can set up either type but
+	// aren't used - the filter (as FSKDemod's) is fixed for the SpeakUp tones
+	void setup(int sampleRate, int symbolRate, int, int, bool manchesterCodec,
+				const FSKDemodParams& params = FSKDemodParams())
+	{
+		_manchesterCodec = manchesterCodec;
+		_samplesPerSymbol = sampleRate / symbolRate;
+		if (params.isValid())
+			_params = params;
+		applyParams();
+		for (int c = 0; c < N; c++)
+			_symbolEdgeOffset[c] = -1;
+	}
+
+	// As FSKDemod::setParams() - applies to all channels
+	bool setParams(const FSKDemodParams& params)
+	{
+		if (!params.isValid())
+			return false;
+		_params = params;
+		applyParams();
+		return true;
+	}
+	const FSKDemodParams& getParams()
+	{
+		return _params;
+	}
+
+	// Enable sync word detection on all channels - as FSKDemod::enableSyncDetector()
+	void enableSyncDetector(uint32_t syncWord, int syncWordBits, int preambleBits)
+	{
+		_preambleDetectors.resize(N);
+		for (int c = 0; c < N; c++)
+			_preambleDetectors[c].setup(_samplesPerSymbol, FSKDemod::syncTemplateBits(syncWord, preambleBits),
+						preambleBits + syncWordBits, syncWordBits);
+		_syncWord = syncWord;
+		_syncWordBits = syncWordBits;
+		_syncDetectEnabled = true;
+	}
+
+	void holdSyncDetector(int channel, bool hold)
+	{
+		_syncDetectHold[channel] = hold;
+	}
+
+	int getSyncDetectCount(int channel)
+	{
+		return _syncDetectCount[channel];
+	}
+
+	// Process numSteps samples on every channel - samples are interleaved so
+	// pSamples[step * N + channel] is the sample for a channel
+	// Samples can be int16_t (as from the audio interfaces) or int
+	template<typename SampleT>
+	void processSamples(const SampleT* pSamples, int numSteps)
+	{
+		for (int step = 0; step < numSteps; step++)
+			processStep(pSamples + step * N);
+	}
+
+	// Get up to maxBits (at most 32) received bits for a channel - the first received
+	// is in the LSB - returns the number of bits got
+	int getRxBits(int channel, uint32_t& bits, int maxBits)
+	{
+		return _rxSymbolFifos[channel].getSymbols(bits, maxBits);
+	}
+
+private:
+	// Voting mask and clock recovery windows - as ClockRecovery::setWindows()
+	void applyParams()
+	{
+		_voteMask = (1 << _params.numVotingSamples) - 1;
+		_transitionMinValid = _samplesPerSymbol * _params.transitionMinPercent / 100;
+		_transitionMaxValid = _samplesPerSymbol * _params.transitionMaxPercent / 100;
+		_transitionCentreMin = _samplesPerSymbol * _params.centreMinPercent / 100;
+		_transitionCentreMax = _samplesPerSymbol * _params.centreMaxPercent / 100;
+	}
+
+	template<typename SampleT>
+	void processStep(const SampleT* pSamples)
+	{
+		// Filter, rectify and follow the envelope - as FSKDemod::processSample()
+		int envelopePercent = _params.envelopePercent;
+		int peakFollowPer10K = _params.peakFollowPer10K;
+		int peakRestPer10K = _params.peakRestPer10K;
+		for (int c = 0; c < N; c++)
+		{
+			int xv3 = (pSamples[c] * FILTER_INT_MULT) / FILTER_GAIN;
+			int yv3 = (xv3 - _xv0[c]) + 3 * (_xv1[c] - _xv2[c]) +
+						(FILTER_PARAM_1 * _yv0[c]) + (FILTER_PARAM_2 * _yv1[c]) + (FILTER_PARAM_3 * _yv2[c]);
+			yv3 = yv3 / FILTER_INT_MULT;
+			_xv0[c] = _xv1[c];
+			_xv1[c] = _xv2[c];
+			_xv2[c] = xv3;
+			_yv0[c] = _yv1[c];
+			_yv1[c] = _yv2[c];
+			_yv2[c] = yv3;
+			int outVal = yv3 < 0 ? -yv3 : yv3;
+
+			// Peak followers use the envelope before this sample
+			int envelope = _envelope[c];
+			int highDiff = envelope - _signalHigh[c];
+			int highRate = highDiff > 0 ? peakFollowPer10K : peakRestPer10K;
+			_signalHigh[c] += (highDiff * highRate) / 10000;
+			int lowDiff = envelope - _signalLow[c];
+			int lowRate = lowDiff < 0 ? peakFollowPer10K : peakRestPer10K;
+			_signalLow[c] += (lowDiff * lowRate) / 10000;
+			_envelope[c] = envelope + ((outVal - envelope) * envelopePercent) / FILTER_INT_MULT;
+		}
+
+		// Sync word
+		if (_syncDetectEnabled)
+		{
+			for (int c = 0; c < N; c++)
+			{
+				PreambleDetector::DetectResult detectResult;
+				if (_preambleDetectors[c].processSample(_envelope[c], _curSampleCount, detectResult) &&
+							!_syncDetectHold[c])
+					handleSyncDetected(c, detectResult);
+			}
+		}
+
+		// Slice, vote and flag transitions
+		uint8_t voteMask = _voteMask;
+		for (int c = 0; c < N; c++)
+		{
+			uint8_t instVal = _envelope[c] > (_signalHigh[c] + _signalLow[c]) / 2;
+			uint8_t history = ((_voteHistory[c] << 1) | instVal) & voteMask;
+			_voteHistory[c] = history;
+			uint8_t prevLevel = _signalLevel[c];
+			uint8_t level = history == 0 ? 0 : (history == voteMask ? 1 : prevLevel);
+			_transition[c] = level != prevLevel;
+			_signalLevel[c] = level;
+		}
+
+		// Clock recovery for channels with a transition
+		if (_manchesterCodec)
+		{
+			for (int c = 0; c < N; c++)
+			{
+				if (_transition[c])
+					handleTransition(c);
+			}
+		}
+
+		// Bump the sample count - on wrap the symbol edges are recalculated as in ClockRecovery
+		uint32_t prevCount = _curSampleCount;
+		_curSampleCount++;
+		if (_curSampleCount < prevCount)
+		{
+			for (int c = 0; c < N; c++)
+				_symbolEdgeOffset[c] = -1;
+		}
+	}
+
+	// As ClockRecovery::newSample() when a transition occurs
+	void handleTransition(int c)
+	{
+		int transitionInterval = _curSampleCount - _lastTransitionSampleCount[c];
+		if (transitionInterval < 0)
+			transitionInterval = INT_MAX - _lastTransitionSampleCount[c] + _curSampleCount;
+		handleManchesterAdjustments(c, _curSampleCount, transitionInterval);
+		if (_symbolEdgeOffset[c] >= 0)
+		{
+			int posOfTransition = (_curSampleCount - _symbolEdgeOffset[c]) % _samplesPerSymbol;
+			if ((posOfTransition >= _transitionCentreMin) && (posOfTransition <= _transitionCentreMax))
+			{
+				// Just beyond the centre-symbol transition so the level is inverted
+				_rxSymbolFifos[c].put(_signalLevel[c] ? 0 : 1);
+			}
+		}
+		_lastTransitionSampleCount[c] = _curSampleCount;
+	}
+
+	// As ClockRecovery::handleManchesterAdjustments()
+	void handleManchesterAdjustments(int c, uint32_t sampleCount, int transitionSamples)
+	{
+		if ((transitionSamples < _transitionMinValid) || (transitionSamples > _transitionMaxValid))
+			return;
+		int modCentrePos = _samplesPerSymbol / 2;
+		if (_symbolEdgeOffset[c] > 0)
+			modCentrePos = (sampleCount - _symbolEdgeOffset[c]) % _samplesPerSymbol;
+		_transitionAccum[c] += transitionSamples;
+		_modCentreAccum[c] += modCentrePos;
+		if (_transitionBufCount[c] >= MAX_TRANSITION_TIMES_TO_STORE)
+		{
+			int getPos = _transitionBufGetPos[c];
+			_transitionAccum[c] -= _transitionSamples[getPos][c];
+			_modCentreAccum[c] -= _modCentrePos[getPos][c];
+			_transitionBufGetPos[c] = (getPos + 1) % MAX_TRANSITION_TIMES_TO_STORE;
+			_transitionBufCount[c]--;
+		}
+		int putPos = (_transitionBufGetPos[c] + _transitionBufCount[c]) % MAX_TRANSITION_TIMES_TO_STORE;
+		_transitionSamples[putPos][c] = transitionSamples;
+		_modCentrePos[putPos][c] = modCentrePos;
+		_transitionBufCount[c]++;
+
+		// Symbol edge
+		if (_symbolEdgeOffset[c] < 0)
+		{
+			_symbolEdgeOffset[c] = sampleCount + (transitionSamples / 2);
+			if (_symbolEdgeOffset[c] > _samplesPerSymbol)
+				_symbolEdgeOffset[c] -= _samplesPerSymbol;
+		}
+		else if (_transitionBufCount[c] == MAX_TRANSITION_TIMES_TO_STORE)
+		{
+			_symbolEdgeOffset[c] = sampleCount + (_modCentreAccum[c] / MAX_TRANSITION_TIMES_TO_STORE);
+			if (_symbolEdgeOffset[c] > _samplesPerSymbol)
+				_symbolEdgeOffset[c] -= _samplesPerSymbol;
+		}
+	}
+
+	// As FSKDemod::handleSyncDetected() and ClockRecovery::setSymbolTiming()
+	void handleSyncDetected(int c, PreambleDetector::DetectResult& detectResult)
+	{
+		_signalHigh[c] = detectResult.signalHigh;
+		_signalLow[c] = detectResult.signalLow;
+		_transitionBufGetPos[c] = 0;
+		_transitionBufCount[c] = 0;
+		_transitionAccum[c] = 0;
+		_modCentreAccum[c] = 0;
+		_symbolEdgeOffset[c] = detectResult.symbolEdgeSampleCount % _samplesPerSymbol;
+		_syncDetectCount[c]++;
+		for (int i = 0; i < _syncWordBits; i++)
+			_rxSymbolFifos[c].put((_syncWord >> i) & 0x01);
+	}
+
+	FSKDemodBank(const FSKDemodBank&);
+	FSKDemodBank& operator=(const FSKDemodBank&);
+};
@@ -0,0 +1,48 @@
+// FSKDemodParams
+// Presets of the FSK demodulator tracking constants and timing windows
+
+#include "FSKDemodParams.h"
+
+// Presets by samples per symbol - from tools/DemodAutotune
+struct FSKDemodPreset
+{
+	int samplesPerSymbol;
+	int envelopePercent;
+	int peakFollowPer10K;
+	int peakRestPer10K;
+	int numVotingSamples;
+	int transitionMinPercent;
+	int transitionMaxPercent;
+	int centreMinPercent;
+	int centreMaxPercent;
+};
+static const FSKDemodPreset FSK_DEMOD_PRESETS[] = {
+	{ 160, 5, 276, 31, 6, 96, 111, 23, 71 },
+	{ 80, 6, 425, 82, 6, 97, 109, 31, 78 },
+	{ 40, 17, 902, 70, 2, 96, 113, 32, 69 },
+};
+static const int NUM_FSK_DEMOD_PRESETS = sizeof(FSK_DEMOD_PRESETS) / sizeof(FSK_DEMOD_PRESETS[0]);
+
+FSKDemodParams FSKDemodParams::forSymbolRate(int sampleRate, int symbolRate)
+{
+	FSKDemodParams params;
+	if (symbolRate <= 0)
+		return params;
+	int samplesPerSymbol = sampleRate / symbolRate;
+	for (int i = 0; i < NUM_FSK_DEMOD_PRESETS; i++)
+	{
+		const FSKDemodPreset& preset = FSK_DEMOD_PRESETS[i];
+		if (preset.samplesPerSymbol != samplesPerSymbol)
+			continue;
+		params.envelopePercent = preset.envelopePercent;
+		params.peakFollowPer10K = preset.peakFollowPer10K;
+		params.peakRestPer10K = preset.peakRestPer10K;
+		params.numVotingSamples = preset.numVotingSamples;
+		params.transitionMinPercent = preset.transitionMinPercent;
+		params.transitionMaxPercent = preset.transitionMaxPercent;
+		params.centreMinPercent = preset.centreMinPercent;
+		params.centreMaxPercent = preset.centreMaxPercent;
+		break;
+	}
+	return params;
+}
@@ -0,0 +1,61 @@
+// FSKDemodParams
+// Tracking constants of the FSK demodulator (FSKDemod and FSKDemodBank) and the
+// Manchester timing windows of its clock recovery
+// The defaults are the values the demodulator was written with - presets for
+// other symbol rates come from tools/DemodAutotune (a search over simulated
+// channels and recordings for the set that receives the most frames)
+
+#pragma once
+
+#include <stdint.h>
+
+struct FSKDemodParams
+{
+	static const int MAX_VOTING_SAMPLES = 8;
+
+	// Envelope follower - percent of the difference taken each sample
+	int envelopePercent;
+
+	// Slicer peak followers - rate (per 10000 per sample) towards a new peak and
+	// back towards the envelope when there isn't one
+	int peakFollowPer10K;
+	int peakRestPer10K;
+
+	// Slicer outputs that must agree before the signal level changes
+	int numVotingSamples;
+
+	// Clock recovery - transition intervals (percent of a symbol) used to adjust
+	// the timing and the part of a symbol where a transition is its centre
+	int transitionMinPercent;
+	int transitionMaxPercent;
+	int centreMinPercent;
+	int centreMaxPercent;
+
+	FSKDemodParams()
+	{
+		envelopePercent = 20;
+		peakFollowPer10K = 500;
+		peakRestPer10K = 10;
+		numVotingSamples = 3;
+		transitionMinPercent = 90;
+		transitionMaxPercent = 110;
+		centreMinPercent = 25;
+		centreMaxPercent = 75;
+	}
+
+	// Check the values are in range
+	bool isValid() const
+	{
+		return (envelopePercent >= 1) && (envelopePercent <= 100) &&
+					(peakFollowPer10K >= 1) && (peakFollowPer10K <= 10000) &&
+					(peakRestPer10K >= 0) && (peakRestPer10K <= peakFollowPer10K) &&
+					(numVotingSamples >= 1) && (numVotingSamples <= MAX_VOTING_SAMPLES) &&
+					(transitionMinPercent >= 50) && (transitionMinPercent <= 100) &&
+					(transitionMaxPercent >= 100) && (transitionMaxPercent <= 150) &&
+					(centreMinPercent >= 0) && (centreMinPercent < centreMaxPercent) &&
+					(centreMaxPercent <= 100);
+	}
+
+	// Preset for a symbol rate - the defaults if none has been tuned for it
+	static FSKDemodParams forSymbolRate(int sampleRate, int symbolRate);
+};
@@ -0,0 +1,214 @@
+// FSKEqualiser
+// Decision feedback equaliser for the FSK demodulator envelope
+
+#include "FSKEqualiser.h"
+#include <stdlib.h>
+
+FSKEqualiser::FSKEqualiser()
+{
+	_numTaps = DEFAULT_TAPS;
+	_delay = 1;
+	_stepPer256 = DEFAULT_STEP_PER_256;
+	_adaptSamples = 0;
+	_numTrainChips = 0;
+	_samplesPerSymbol = 2;
+	clear();
+}
+
+bool FSKEqualiser::setup(int samplesPerSymbol, int numTaps, int stepPer256, int adaptSymbols)
+{
+	// Feedback starts a chip back - the delay and taps must fit in the decision history
+	int delay = samplesPerSymbol / 2;
+	if ((delay < 1) || (numTaps < 1) || (numTaps > MAX_TAPS) || (delay + numTaps > HISTORY_LEN) ||
+				(stepPer256 < 1) || (stepPer256 > 256) || (adaptSymbols < 0))
+		return false;
+	_samplesPerSymbol = samplesPerSymbol;
+	_delay = delay;
+	_numTaps = numTaps;
+	_stepPer256 = stepPer256;
+	_adaptSamples = adaptSymbols * samplesPerSymbol;
+	clear();
+	return true;
+}
+
+void FSKEqualiser::setTrainingBits(uint32_t templateBits, int numTemplateBits)
+{
+	// Manchester - a 1 is sent as high tone then low tone and a 0 the reverse
+	if (numTemplateBits * 2 > MAX_TRAIN_CHIPS)
+		numTemplateBits = MAX_TRAIN_CHIPS / 2;
+	_numTrainChips = numTemplateBits * 2;
+	for (int i = 0; i < numTemplateBits; i++)
+	{
+		int bitVal = (templateBits >> i) & 0x01;
+		_trainChips[i * 2] = bitVal;
+		_trainChips[i * 2 + 1] = 1 - bitVal;
+	}
+}
+
+void FSKEqualiser::clear()
+{
+	for (int i = 0; i < MAX_TAPS; i++)
+		_taps[i] = 0;
+	for (int i = 0; i < HISTORY_LEN * 2; i++)
+		_decisions[i] = 0;
+	for (int i = 0; i < TRAIN_LEN; i++)
+		_envelopeHistory[i] = 0;
+	_levels[0] = _levels[1] = 0;
+	_decisionPos = 0;
+	_envelopePos = 0;
+	_adaptSamplesLeft = 0;
+	_applied = false;
+	_trainCount = 0;
+	_appliedCount = 0;
+	_fallbackCount = 0;
+}
+
+int FSKEqualiser::process(int envelopeVal, int& signalHigh, int& signalLow)
+{
+	_envelopeHistory[_envelopePos] = (int16_t)envelopeVal;
+	_envelopePos = (_envelopePos + 1) & TRAIN_MASK;
+	if (!_applied)
+		return envelopeVal;
+	bool adapt = _adaptSamplesLeft > 0;
+	if (adapt)
+		_adaptSamplesLeft--;
+	int equalisedVal = equalise(envelopeVal, -1, (signalHigh + signalLow) / 2, adapt);
+
+	// Error of each envelope from the level of its own decision
+	int equalisedDecision = _decisions[(_decisionPos - 1) & HISTORY_MASK];
+	_equalisedErrorSum += abs(equalisedVal - (_levels[equalisedDecision] >> TAP_FRACTION_BITS));
+	int plainDecision = (envelopeVal << TAP_FRACTION_BITS) > ((_plainLevels[0] + _plainLevels[1]) >> 1);
+	int plainError = (envelopeVal << TAP_FRACTION_BITS) - _plainLevels[plainDecision];
+	_plainLevels[plainDecision] += plainError >> LEVEL_STEP_SHIFT;
+	_plainErrorSum += abs(plainError >> TAP_FRACTION_BITS);
+	if (--_checkSamplesLeft > 0)
+		return equalisedVal;
+	_checkSamplesLeft = CHECK_SYMBOLS * _samplesPerSymbol;
+	if (_equalisedErrorSum < _plainErrorSum)
+		return equalisedVal;
+
+	// Hand the slicer back (with the plain levels) until the next training
+	_applied = false;
+	_fallbackCount++;
+	signalLow = _plainLevels[0] >> TAP_FRACTION_BITS;
+	signalHigh = _plainLevels[1] >> TAP_FRACTION_BITS;
+	return envelopeVal;
+}
+
+// Train on the preamble and sync word - the envelope since the start of the chips is
+// replayed with the known chips as the decisions (those after the last chip are decided
+// as usual) - the replay is repeated as a single pass is short
+// The eye on the known chips in the last pass (the middle half of each chip) is compared
+// with that of the plain envelope against the sync detector's levels to decide whether
+// to apply it
+void FSKEqualiser::train(int chipsEndAgo, int& signalHigh, int& signalLow)
+{
+	static const int TRAIN_PASSES = 3;
+	_applied = false;
+	if ((_numTrainChips == 0) || (chipsEndAgo < 0) || (chipsEndAgo >= TRAIN_LEN))
+		return;
+	_trainCount++;
+	int chipsLen = _numTrainChips * _samplesPerSymbol / 2;
+	int replayLen = chipsEndAgo + chipsLen;
+	if (replayLen > TRAIN_LEN)
+		replayLen = TRAIN_LEN;
+
+	// Levels start from those the sync detector measured
+	_levels[0] = signalLow << TAP_FRACTION_BITS;
+	_levels[1] = signalHigh << TAP_FRACTION_BITS;
+	int plainMid = (signalHigh + signalLow) / 2;
+	int chipLen = _samplesPerSymbol / 2;
+	int plainMargins[MAX_TRAIN_CHIPS];
+	int equalisedMargins[MAX_TRAIN_CHIPS];
+	bool replayed[MAX_TRAIN_CHIPS];
+	for (int i = 0; i < _numTrainChips; i++)
+	{
+		plainMargins[i] = equalisedMargins[i] = 0;
+		replayed[i] = false;
+	}
+	for (int pass = 0; pass < TRAIN_PASSES; pass++)
+	{
+		// Decisions before the replay are unknown
+		for (int i = 0; i < HISTORY_LEN * 2; i++)
+			_decisions[i] = 0;
+		for (int ago = replayLen; ago > 0; ago--)
+		{
+			int decision = -1;
+			int chipIdx = -1;
+			int chipPos = 0;
+			if (ago > chipsEndAgo)
+			{
+				int chipsSample = chipsLen - (ago - chipsEndAgo);
+				chipIdx = chipsSample / chipLen;
+				chipPos = chipsSample % chipLen;
+				if (chipIdx >= _numTrainChips)
+					chipIdx = _numTrainChips - 1;
+				decision = _trainChips[chipIdx];
+			}
+			int envelopeVal = _envelopeHistory[(_envelopePos - ago) & TRAIN_MASK];
+			int midLevel = (_levels[0] + _levels[1]) >> (TAP_FRACTION_BITS + 1);
+			int equalisedVal = equalise(envelopeVal, decision, midLevel, true);
+			if ((chipIdx >= 0) && (pass == TRAIN_PASSES - 1) && (chipPos >= chipLen / 4) &&
+						(chipPos < chipLen * 3 / 4))
+			{
+				int sign = decision ? 1 : -1;
+				plainMargins[chipIdx] += sign * (envelopeVal - plainMid);
+				equalisedMargins[chipIdx] += sign * (equalisedVal - midLevel);
+				replayed[chipIdx] = true;
+			}
+		}
+	}
+	int halfSwing = (signalHigh - signalLow) / 2 * (chipLen * 3 / 4 - chipLen / 4);
+	int plainEye = halfSwing;
+	int equalisedEye = halfSwing;
+	for (int i = 0; i < _numTrainChips; i++)
+	{
+		if (!replayed[i])
+			continue;
+		plainEye = (plainMargins[i] < plainEye) ? plainMargins[i] : plainEye;
+		equalisedEye = (equalisedMargins[i] < equalisedEye) ? equalisedMargins[i] : equalisedEye;
+	}
+
+	// Apply it only if the plain envelope's eye is partly closed and equalising opens it
+	if ((plainEye * 16 >= halfSwing * MAX_PLAIN_EYE_16) || (equalisedEye < plainEye))
+		return;
+	_applied = true;
+	_appliedCount++;
+	_plainLevels[0] = signalLow << TAP_FRACTION_BITS;
+	_plainLevels[1] = signalHigh << TAP_FRACTION_BITS;
+	_plainErrorSum = 0;
+	_equalisedErrorSum = 0;
+	_checkSamplesLeft = CHECK_SYMBOLS * _samplesPerSymbol;
+
+	// The slicer levels are those of the equalised envelope
+	signalLow = _levels[0] >> TAP_FRACTION_BITS;
+	signalHigh = _levels[1] >> TAP_FRACTION_BITS;
+	_adaptSamplesLeft = _adaptSamples;
+}
+
+// Equalise a sample and add a decision (1 for the high tone) to the history - a known
+// decision is used in place of the slicer decision if given (otherwise -1)
+int FSKEqualiser::equalise(int envelopeVal, int decision, int midLevel, bool adapt)
+{
+	// Subtract the echoes of earlier high tone chips
+	const int8_t* pDecisions = &_decisions[(_decisionPos - _delay - _numTaps + 1) & HISTORY_MASK];
+	int feedback = 0;
+	for (int i = 0; i < _numTaps; i++)
+		feedback += _taps[i] * pDecisions[i];
+	int equalisedVal = envelopeVal - (feedback >> TAP_FRACTION_BITS);
+	if (decision < 0)
+		decision = (equalisedVal > midLevel) ? 1 : 0;
+
+	// NLMS towards the level of the decision (which also adapts)
+	if (adapt)
+	{
+		int error = (equalisedVal << TAP_FRACTION_BITS) - _levels[decision];
+		int step = (error >> 8) * _stepPer256 / _numTaps;
+		for (int i = 0; i < _numTaps; i++)
+			_taps[i] += step * pDecisions[i];
+		_levels[decision] += error >> LEVEL_STEP_SHIFT;
+	}
+	_decisions[_decisionPos] = _decisions[_decisionPos + HISTORY_LEN] = decision;
+	_decisionPos = (_decisionPos + 1) & HISTORY_MASK;
+	return equalisedVal;
+}
@@ -0,0 +1,140 @@
+// FSKEqualiser
+// Decision feedback equaliser for the FSK demodulator envelope
+// In a reverberant room the envelope of each chip carries the echoes of the chips
+// before it - at higher symbol rates this closes the eye the slicer works on
+// The equaliser subtracts an estimate of that energy made from its own earlier
+// decisions (feedback taps from a chip back) - the taps are trained by LMS on the
+// known chips of the preamble and sync word when the sync detector finds them and
+// then adapt from the decisions (decision-directed) while a frame is received
+// It is only applied when training finds the plain envelope's eye on the known chips
+// partly closed and the equalised one more open - and it hands the slicer back (until
+// the next training) if its decisions stop fitting their levels better than the plain
+// envelope's - so on a clean channel or one with only short echoes the slicer sees the
+// plain envelope as it would without it
+// Fixed point throughout - the cost is two passes over the taps per sample while it
+// is applied
+
+#pragma once
+
+#include <stdint.h>
+
+class FSKEqualiser
+{
+public:
+	static const int MAX_TAPS = 64;
+	static const int DEFAULT_TAPS = 64;
+	static const int DEFAULT_STEP_PER_256 = 6;
+	static const int DEFAULT_ADAPT_SYMBOLS = 1024;
+
+	// Reverberation fills the low tone chips so the sync detector can't demand as much
+	// contrast before the equaliser has been trained (the chips must still match)
+	static const int SYNC_MIN_CONTRAST_16 = 18;
+
+	// Applied only if the plain eye (the least margin of a known chip from the mid
+	// level) is below MAX_PLAIN_EYE_16 (in 16ths) of the half swing - above that it
+	// cost bits at 400 and 500 baud (see tools/EqualiserBench)
+	static const int MAX_PLAIN_EYE_16 = 9;
+
+	// Every CHECK_SYMBOLS the summed error from the decision levels of the equalised
+	// envelope must be below that of the plain envelope
+	static const int CHECK_SYMBOLS = 8;
+
+private:
+	// Taps (in 1024ths of an envelope unit) applied to the decisions from _delay samples
+	// back and earlier - the first tap is for the oldest decision
+	static const int TAP_FRACTION_BITS = 10;
+	int _taps[MAX_TAPS];
+	int _numTaps;
+	int _delay;
+
+	// NLMS step (in 256ths) and the number of samples after sync that the taps adapt for
+	int _stepPer256;
+	int _adaptSamples;
+	int _adaptSamplesLeft;
+
+	// Applied to the slicer input since the last training
+	bool _applied;
+
+	// Levels (in 1024ths) of the plain envelope and the errors of both since training
+	int _plainLevels[2];
+	int64_t _plainErrorSum;
+	int64_t _equalisedErrorSum;
+	int _checkSamplesLeft;
+
+	// Stats
+	int _trainCount;
+	int _appliedCount;
+	int _fallbackCount;
+
+	// Levels of the equalised low and high tone chips (in 1024ths) - adapted with the taps
+	static const int LEVEL_STEP_SHIFT = 7;
+	int _levels[2];
+
+	// Decisions (1 for the high tone) in a ring long enough for the delay and the taps -
+	// each is written twice (HISTORY_LEN apart) so the taps' decisions are contiguous
+	static const int HISTORY_LEN = 256;
+	static const int HISTORY_MASK = HISTORY_LEN - 1;
+	int8_t _decisions[HISTORY_LEN * 2];
+	int _decisionPos;
+
+	// Unequalised envelope of the latest samples - the preamble and sync word are
+	// replayed from this to train the taps
+	static const int TRAIN_LEN = 512;
+	static const int TRAIN_MASK = TRAIN_LEN - 1;
+	int16_t _envelopeHistory[TRAIN_LEN];
+	int _envelopePos;
+
+	// Chips of the preamble and sync word (1 for the high tone) and samples per chip
+	static const int MAX_TRAIN_CHIPS = 32;
+	int8_t _trainChips[MAX_TRAIN_CHIPS];
+	int _numTrainChips;
+	int _samplesPerSymbol;
+
+public:
+	FSKEqualiser();
+
+	// Setup for a symbol rate - numTaps feedback taps start a chip back
+	// Returns false (leaving it unchanged) if the values are out of range
+	bool setup(int samplesPerSymbol, int numTaps = DEFAULT_TAPS, int stepPer256 = DEFAULT_STEP_PER_256,
+				int adaptSymbols = DEFAULT_ADAPT_SYMBOLS);
+
+	// Bits (in transmission order) of the preamble end and sync word - as the
+	// sync detector - these are sent Manchester coded
+	void setTrainingBits(uint32_t templateBits, int numTemplateBits);
+
+	// Clear the taps and history
+	void clear();
+
+	// Equalise an envelope sample - returns the value for the slicer - signalHigh and
+	// signalLow are the slicer levels (set when the equaliser takes over or hands back)
+	int process(int envelopeVal, int& signalHigh, int& signalLow);
+
+	// Train on the preamble and sync word found by the sync detector (with the levels
+	// it measured) - chipsEndAgo is the number of samples since the end of the last
+	// chip - the taps then adapt from decisions for the set number of symbols
+	// Training that closes the eye of the known chips leaves the envelope passed through
+	void train(int chipsEndAgo, int& signalHigh, int& signalLow);
+
+	// Check if the equaliser is applied to the slicer input
+	bool isApplied()
+	{
+		return _applied;
+	}
+
+	// Number of trainings, times it took over the slicer and times it handed it back
+	int getTrainCount()
+	{
+		return _trainCount;
+	}
+	int getAppliedCount()
+	{
+		return _appliedCount;
+	}
+	int getFallbackCount()
+	{
+		return _fallbackCount;
+	}
+
+private:
+	int equalise(int envelopeVal, int decision, int midLevel, bool adapt);
+};
@@ -10,8 +10,7 @@ void FSKMod::setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbo
 	{
 		_sampleRate = sampleRate;
 		_symbolRate = symbolRate;
-		_numSymbols = 2;
-		_symbolFreqs.resize(_numSymbols);
+		_numSymbols = NUM_SYMBOLS;
 		_symbolFreqs[0] = symbolFreqLow;
 		_symbolFreqs[1] = symbolFreqHigh;
 		_manchesterCodec = manchesterCodec;
@@ -21,7 +20,10 @@ void FSKMod::setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbo
 
 	void FSKMod::clear()
 	{
-		_txSymbolFifoPos.clear();
+		_txSymbolFifo.clear();
+		_streamPreambleLeft = 0;
+		_streamSourceActive = false;
+		_streamPostambleLeft = 0;
 		_generatorCount = 0;
 		_generatorBusy = false;
 	}
@@ -52,26 +54,23 @@ void FSKMod::setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbo
 
 	bool FSKMod::addSymbol(int symbol)
 	{
-		// Check if space in FIFO
-		if (_txSymbolFifoPos.canPut())
-		{
-			// Add symbol
-			symbol = symbol % _numSymbols;
-			_txSymbolFifoBuf[_txSymbolFifoPos.posToPut()] = symbol;
-			_txSymbolFifoPos.hasPut();
-			return true;
-		}
-		return false;
+		// Add symbol if space in FIFO
+		return _txSymbolFifo.put(symbol % _numSymbols);
+	}
+
+	void FSKMod::startStream()
+	{
+		_streamPreambleLeft = _preambleSymbols;
+		_streamSourceActive = true;
+		_streamPostambleLeft = _postambleSymbols;
 	}
 
 	bool FSKMod::getSample(int& sampleValue)
 	{
 		// See if we need to start processing another bit
-		if (!_generatorBusy && _txSymbolFifoPos.canGet())
+		int symbolVal = 0;
+		if (!_generatorBusy && getNextSymbol(symbolVal))
 		{
-			// Get the symbol and start generating
-			int symbolVal = _txSymbolFifoBuf[_txSymbolFifoPos.posToGet()];
-			_txSymbolFifoPos.hasGot();
 			// Start generating
 			startSymbol(symbolVal);
 		}
@@ -80,10 +79,10 @@ void FSKMod::setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbo
 		if (_generatorBusy)
 		{
 			// Generate next sample
-			int phaseIdx = _generatorCount % (_sinTableLen * 4);
-			int lookupIdx = phaseIdx % (_sinTableLen * 2);
-			lookupIdx = (lookupIdx >= _sinTableLen) ? (_sinTableLen * 2) - lookupIdx - 1 : lookupIdx;
-			sampleValue = _sinTable[lookupIdx] * ((phaseIdx > _sinTableLen * 2) ? -1 : 1);
+			int phaseIdx = _generatorCount % (SinTable::QUARTER_LEN * 4);
+			int lookupIdx = phaseIdx % (SinTable::QUARTER_LEN * 2);
+			lookupIdx = (lookupIdx >= SinTable::QUARTER_LEN) ? (SinTable::QUARTER_LEN * 2) - lookupIdx - 1 : lookupIdx;
+			sampleValue = SinTable::QUARTER_WAVE[lookupIdx] * ((phaseIdx > SinTable::QUARTER_LEN * 2) ? -1 : 1);
 
 			// Next
 			_generatorCount += _generatorInc;
@@ -109,6 +108,41 @@ void FSKMod::setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbo
 		return false;
 	}
 
+	bool FSKMod::getNextSymbol(int& symbol)
+	{
+		// Symbols added to the buffer go first
+		if (_txSymbolFifo.get(symbol))
+			return true;
+
+		// Streaming - preamble is alternating 1s and 0s
+		if (_streamPreambleLeft > 0)
+		{
+			symbol = (_preambleSymbols - _streamPreambleLeft) % 2;
+			_streamPreambleLeft--;
+			return true;
+		}
+
+		// Symbols from the source
+		if (_streamSourceActive)
+		{
+			if (_symbolSourceFn && _symbolSourceFn(symbol))
+			{
+				symbol = symbol % _numSymbols;
+				return true;
+			}
+			_streamSourceActive = false;
+		}
+
+		// Postamble is a string of 0s
+		if (_streamPostambleLeft > 0)
+		{
+			symbol = 0;
+			_streamPostambleLeft--;
+			return true;
+		}
+		return false;
+	}
+
 	void FSKMod::startSymbol(int symbolValue)
 	{
 		// Initialse generator
@@ -124,7 +158,7 @@ void FSKMod::setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbo
 	{
 		// Calculate phase increment
 		_curFrequency = freqInHz;
-		_generatorInc = (_sinTableLen * 4) / (_sampleRate / _curFrequency);
+		_generatorInc = (SinTable::QUARTER_LEN * 4) / (_sampleRate / _curFrequency);
 
 		// Calculate samples to generate before next change
 		_samplesToNextChange = _sampleRate / _symbolRate;
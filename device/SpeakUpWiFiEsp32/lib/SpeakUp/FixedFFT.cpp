@@ -0,0 +1,52 @@
+// FixedFFT
+// In-place radix-2 complex FFT on 32 bit integers
+
+#include "FixedFFT.h"
+#include "SinTable.h"
+
+bool FixedFFT::transform(int32_t* pRe, int32_t* pIm, int log2Size, bool inverse)
+{
+	if ((log2Size < 1) || (log2Size > MAX_LOG2_SIZE))
+		return false;
+	int size = 1 << log2Size;
+
+	// Bit reversed order
+	for (int i = 1, j = 0; i < size; i++)
+	{
+		int bit = size >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j |= bit;
+		if (i < j)
+		{
+			int32_t tmp = pRe[i];
+			pRe[i] = pRe[j];
+			pRe[j] = tmp;
+			tmp = pIm[i];
+			pIm[i] = pIm[j];
+			pIm[j] = tmp;
+		}
+	}
+
+	// Butterflies - e^(-j*theta) forward and e^(j*theta) inverse
+	for (int half = 1; half < size; half *= 2)
+	{
+		int phaseStep = SinTable::CYCLE_LEN / (half * 2);
+		for (int k = 0; k < half; k++)
+		{
+			int64_t twRe = SinTable::cos(k * phaseStep);
+			int64_t twIm = inverse ? SinTable::sin(k * phaseStep) : -SinTable::sin(k * phaseStep);
+			for (int i = k; i < size; i += half * 2)
+			{
+				int j = i + half;
+				int32_t tRe = (int32_t)((pRe[j] * twRe - pIm[j] * twIm) >> 15);
+				int32_t tIm = (int32_t)((pRe[j] * twIm + pIm[j] * twRe) >> 15);
+				pRe[j] = (pRe[i] - tRe) >> 1;
+				pIm[j] = (pIm[i] - tIm) >> 1;
+				pRe[i] = (pRe[i] + tRe) >> 1;
+				pIm[i] = (pIm[i] + tIm) >> 1;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,24 @@
+// FixedFFT
+// In-place radix-2 complex FFT on 32 bit integers
+// Every stage halves the values so the result is the DFT divided by the size and
+// can't overflow - inputs with magnitudes up to 2^29 are safe
+// Twiddle factors come from the shared sine table so sizes up to SinTable::CYCLE_LEN
+
+#pragma once
+
+#include <stdint.h>
+
+class FixedFFT
+{
+public:
+	static const int MAX_LOG2_SIZE = 10;
+
+	// Transform 2^log2Size points - returns false if the size is not supported
+	static bool transform(int32_t* pRe, int32_t* pIm, int log2Size, bool inverse = false);
+
+	// Squared magnitude of a point
+	static int64_t power(int32_t re, int32_t im)
+	{
+		return (int64_t)re * re + (int64_t)im * im;
+	}
+};
@@ -0,0 +1,133 @@
+// FountainDecoder
+// Decodes a payload from the packets of a FountainEncoder carousel
+
+#include "FountainDecoder.h"
+#include <string.h>
+
+FountainDecoder::FountainDecoder(int maxPayloadLen, uint8_t* pStorage)
+{
+	if ((maxPayloadLen <= 0) || (maxPayloadLen > FountainEncoder::MAX_PAYLOAD_LEN))
+		maxPayloadLen = FountainEncoder::MAX_PAYLOAD_LEN;
+	_maxPayloadLen = maxPayloadLen;
+	if (pStorage)
+	{
+		_rows = pStorage;
+	}
+	else
+	{
+		_ownRows.resize(storageLenFor(maxPayloadLen));
+		_rows = _ownRows.data();
+	}
+	clear();
+}
+
+void FountainDecoder::clear()
+{
+	_started = false;
+	_complete = false;
+	_messageId = 0;
+	_payloadLen = 0;
+	_blockLen = 0;
+	_numBlocks = 0;
+	_rowsPresent = 0;
+	_rank = 0;
+	_packetsReceived = 0;
+	_packetsDiscarded = 0;
+}
+
+void FountainDecoder::startMessage(uint8_t messageId, int payloadLen, int blockLen)
+{
+	clear();
+	_started = true;
+	_messageId = messageId;
+	_payloadLen = payloadLen;
+	_blockLen = blockLen;
+	_numBlocks = FountainEncoder::getNumBlocks(payloadLen, blockLen);
+}
+
+bool FountainDecoder::handlePacket(const uint8_t* pPacket, int len)
+{
+	// Header
+	if (!isFountainPacket(pPacket, len))
+		return false;
+	uint8_t messageId = pPacket[1];
+	int payloadLen = pPacket[2] | (pPacket[3] << 8);
+	int blockLen = pPacket[4];
+	uint16_t seq = pPacket[5] | (pPacket[6] << 8);
+	if ((blockLen == 0) || (blockLen > FountainEncoder::MAX_BLOCK_LEN) ||
+				(len != FountainEncoder::HEADER_LEN + blockLen) ||
+				(payloadLen <= 0) || (payloadLen > _maxPayloadLen) ||
+				(FountainEncoder::getNumBlocks(payloadLen, blockLen) > FountainEncoder::MAX_SOURCE_BLOCKS))
+		return false;
+
+	// A different message starts again - more of a completed one are ignored
+	if (!_started || (messageId != _messageId) || (payloadLen != _payloadLen) || (blockLen != _blockLen))
+		startMessage(messageId, payloadLen, blockLen);
+	else if (_complete)
+		return false;
+	_packetsReceived++;
+
+	// Reduce by the rows held until it has a new leading block or nothing is left
+	uint32_t blockMask = FountainEncoder::getBlockMask(seq, messageId, _numBlocks);
+	memcpy(_work, pPacket + FountainEncoder::HEADER_LEN, _blockLen);
+	while (blockMask != 0)
+	{
+		int leadBlock = __builtin_ctz(blockMask);
+		if ((_rowsPresent & (1ul << leadBlock)) == 0)
+		{
+			memcpy(_rows + leadBlock * _blockLen, _work, _blockLen);
+			_rowMasks[leadBlock] = blockMask;
+			_rowsPresent |= 1ul << leadBlock;
+			_rank++;
+			break;
+		}
+		blockMask ^= _rowMasks[leadBlock];
+		xorBlock(_work, _rows + leadBlock * _blockLen);
+	}
+	if (blockMask == 0)
+	{
+		_packetsDiscarded++;
+		return false;
+	}
+	if (_rank < _numBlocks)
+		return false;
+
+	// All blocks present - the payload is null terminated (in the padding of the last
+	// block) so it can be used as a string
+	backSubstitute();
+	_rows[_payloadLen] = 0;
+	_complete = true;
+	return true;
+}
+
+bool FountainDecoder::getPayload(const uint8_t*& pPayload, int& payloadLen)
+{
+	if (!_complete)
+		return false;
+	pPayload = _rows;
+	payloadLen = _payloadLen;
+	return true;
+}
+
+void FountainDecoder::xorBlock(uint8_t* pDest, const uint8_t* pSrc)
+{
+	for (int i = 0; i < _blockLen; i++)
+		pDest[i] ^= pSrc[i];
+}
+
+// Clear the higher blocks from each row working down from the last (which only
+// has its own block) so each row is left as its source block
+void FountainDecoder::backSubstitute()
+{
+	for (int rowIdx = _numBlocks - 1; rowIdx >= 0; rowIdx--)
+	{
+		uint32_t higherBlocks = _rowMasks[rowIdx] & ~(1ul << rowIdx);
+		while (higherBlocks != 0)
+		{
+			int blockIdx = __builtin_ctz(higherBlocks);
+			xorBlock(_rows + rowIdx * _blockLen, _rows + blockIdx * _blockLen);
+			higherBlocks &= higherBlocks - 1;
+		}
+		_rowMasks[rowIdx] = 1ul << rowIdx;
+	}
+}
@@ -0,0 +1,98 @@
+// FountainDecoder
+// Decodes a payload from the packets of a FountainEncoder carousel
+// Packets can arrive in any order and from any point in the carousel - each is
+// reduced against those already held (Gaussian elimination over GF(2) as it
+// arrives) so the payload is complete as soon as numBlocks independent packets
+// have been received and packets that add nothing are discarded at once
+// A packet from a different message (id, length or block length) starts again
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "FountainEncoder.h"
+
+class FountainDecoder
+{
+private:
+	// Rows - row N (if present) combines block N and only higher numbered blocks
+	// so once all are present back substitution leaves the payload in order
+	uint8_t* _rows;
+	std::vector<uint8_t> _ownRows;
+	int _maxPayloadLen;
+	uint32_t _rowMasks[FountainEncoder::MAX_SOURCE_BLOCKS];
+	uint32_t _rowsPresent;
+	int _rank;
+
+	// Message being received
+	bool _started;
+	bool _complete;
+	uint8_t _messageId;
+	int _payloadLen;
+	int _blockLen;
+	int _numBlocks;
+
+	// Packet being reduced
+	uint8_t _work[FountainEncoder::MAX_BLOCK_LEN];
+
+	// Stats
+	int _packetsReceived;
+	int _packetsDiscarded;
+
+public:
+	// Payloads can be up to maxPayloadLen bytes (up to FountainEncoder::MAX_PAYLOAD_LEN)
+	// - if pStorage is supplied it must hold storageLenFor(maxPayloadLen) bytes
+	FountainDecoder(int maxPayloadLen = FountainEncoder::MAX_PAYLOAD_LEN, uint8_t* pStorage = NULL);
+
+	// Storage needed for payloads up to maxPayloadLen (the last block is padded)
+	static constexpr int storageLenFor(int maxPayloadLen)
+	{
+		return maxPayloadLen + FountainEncoder::MAX_BLOCK_LEN;
+	}
+
+	// Check if a frame is a fountain packet
+	static bool isFountainPacket(const uint8_t* pPacket, int len)
+	{
+		return (len > FountainEncoder::HEADER_LEN) && (pPacket[0] == FountainEncoder::FOUNTAIN_MARKER);
+	}
+
+	// Handle a packet - returns true when it completes the payload
+	bool handlePacket(const uint8_t* pPacket, int len);
+
+	// Get the payload (null terminated) once complete - valid until the next packet
+	// of another message
+	bool getPayload(const uint8_t*& pPayload, int& payloadLen);
+
+	// Progress - independent packets held of the number needed
+	bool isComplete()
+	{
+		return _complete;
+	}
+	int getRank()
+	{
+		return _rank;
+	}
+	int getNumBlocks()
+	{
+		return _numBlocks;
+	}
+
+	// Packets received (for the current message) and those that added nothing
+	int getPacketsReceived()
+	{
+		return _packetsReceived;
+	}
+	int getPacketsDiscarded()
+	{
+		return _packetsDiscarded;
+	}
+
+	// Forget the message being received
+	void clear();
+
+private:
+	void startMessage(uint8_t messageId, int payloadLen, int blockLen);
+	void xorBlock(uint8_t* pDest, const uint8_t* pSrc);
+	void backSubstitute();
+};
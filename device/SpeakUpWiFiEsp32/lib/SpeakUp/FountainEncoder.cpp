@@ -0,0 +1,93 @@
+// FountainEncoder
+// Rateless (fountain) coding of a payload for carousel broadcast to many receivers
+
+#include "FountainEncoder.h"
+#include <string.h>
+
+FountainEncoder::FountainEncoder()
+{
+	_pPayload = NULL;
+	_payloadLen = 0;
+	_blockLen = 0;
+	_numBlocks = 0;
+	_messageId = 0;
+	_seq = 0;
+	memset(_packet, 0, sizeof(_packet));
+}
+
+bool FountainEncoder::setup(const uint8_t* pPayload, int payloadLen, int blockLen, uint8_t messageId)
+{
+	if ((payloadLen <= 0) || (payloadLen > MAX_PAYLOAD_LEN) || (blockLen < 0) || (blockLen > MAX_BLOCK_LEN))
+		return false;
+	if (blockLen == 0)
+	{
+		blockLen = (payloadLen + MAX_SOURCE_BLOCKS - 1) / MAX_SOURCE_BLOCKS;
+		if (blockLen < DEFAULT_BLOCK_LEN)
+			blockLen = DEFAULT_BLOCK_LEN;
+	}
+	if (getNumBlocks(payloadLen, blockLen) > MAX_SOURCE_BLOCKS)
+		return false;
+	_pPayload = pPayload;
+	_payloadLen = payloadLen;
+	_blockLen = blockLen;
+	_numBlocks = getNumBlocks(payloadLen, blockLen);
+	_messageId = messageId;
+	_seq = 0;
+	return true;
+}
+
+int FountainEncoder::getNextPacket(const uint8_t*& pPacket)
+{
+	pPacket = _packet;
+	if (_numBlocks == 0)
+		return 0;
+
+	// Header
+	_packet[0] = FOUNTAIN_MARKER;
+	_packet[1] = _messageId;
+	_packet[2] = _payloadLen & 0xff;
+	_packet[3] = _payloadLen >> 8;
+	_packet[4] = _blockLen;
+	_packet[5] = _seq & 0xff;
+	_packet[6] = _seq >> 8;
+
+	// XOR of the selected blocks (the last is padded with zeros)
+	uint8_t* pData = _packet + HEADER_LEN;
+	memset(pData, 0, _blockLen);
+	uint32_t blockMask = getBlockMask(_seq, _messageId, _numBlocks);
+	for (int blockIdx = 0; blockIdx < _numBlocks; blockIdx++)
+	{
+		if ((blockMask & (1ul << blockIdx)) == 0)
+			continue;
+		const uint8_t* pBlock = _pPayload + blockIdx * _blockLen;
+		int blockLen = _payloadLen - blockIdx * _blockLen;
+		if (blockLen > _blockLen)
+			blockLen = _blockLen;
+		for (int i = 0; i < blockLen; i++)
+			pData[i] ^= pBlock[i];
+	}
+	_seq++;
+	return HEADER_LEN + _blockLen;
+}
+
+uint32_t FountainEncoder::getBlockMask(uint16_t seq, uint8_t messageId, int numBlocks)
+{
+	// Source blocks first
+	if (seq < numBlocks)
+		return 1ul << seq;
+
+	// Then a hash of the sequence number and message id (retried if no blocks selected)
+	uint32_t allBlocks = (numBlocks >= 32) ? 0xffffffff : ((1ul << numBlocks) - 1);
+	uint32_t seed = ((uint32_t)seq << 8) | messageId;
+	for (uint32_t attempt = 0; ; attempt++)
+	{
+		uint32_t hash = seed + attempt * 0x9E3779B9;
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35;
+		hash ^= hash >> 16;
+		if ((hash & allBlocks) != 0)
+			return hash & allBlocks;
+	}
+}
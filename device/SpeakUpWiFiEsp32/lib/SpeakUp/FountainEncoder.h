@@ -0,0 +1,88 @@
+// FountainEncoder
+// Rateless (fountain) coding of a payload for carousel broadcast to many receivers
+// The payload is split into up to MAX_SOURCE_BLOCKS source blocks and an endless
+// stream of packets is generated, each to be sent in its own frame
+// A receiver can start at any packet and decodes once it has any numBlocks (or a
+// couple more) packets so a device that misses packets or joins late just waits
+// for more rather than for the whole payload to come round again
+//
+// Packet:
+//   FOUNTAIN_MARKER
+//   Message id (should change when the payload does)
+//   Payload length (2 bytes, low byte first)
+//   Block length
+//   Sequence number (2 bytes, low byte first)
+//   Block data - XOR of the source blocks selected by the sequence number
+//
+// The first numBlocks packets are the source blocks in order (so a receiver that
+// gets them all needs no decoding) and each later one combines a pseudo-random
+// subset of the blocks with every block equally likely to be included - this is
+// the dense limit of an LT code which needs the fewest packets when decoded by
+// elimination and at this number of blocks costs little
+
+#pragma once
+
+#include <stdint.h>
+
+class FountainEncoder
+{
+public:
+	static const uint8_t FOUNTAIN_MARKER = 0xFC;
+	static const int HEADER_LEN = 7;
+	static const int MAX_SOURCE_BLOCKS = 32;
+	static const int MAX_BLOCK_LEN = 64;
+	static const int MAX_PACKET_LEN = HEADER_LEN + MAX_BLOCK_LEN;
+	static const int MAX_PAYLOAD_LEN = MAX_SOURCE_BLOCKS * MAX_BLOCK_LEN;
+
+	// Block length used for short payloads (shorter packets are less likely to be
+	// lost but the header and preamble are a larger part of each - 16 byte blocks
+	// took longer to receive than 32 below 20% loss)
+	static const int DEFAULT_BLOCK_LEN = 32;
+
+private:
+	const uint8_t* _pPayload;
+	int _payloadLen;
+	int _blockLen;
+	int _numBlocks;
+	uint8_t _messageId;
+	uint16_t _seq;
+	uint8_t _packet[MAX_PACKET_LEN];
+
+public:
+	FountainEncoder();
+
+	// Setup for a payload which must remain valid while packets are generated
+	// A blockLen of 0 uses DEFAULT_BLOCK_LEN or longer blocks if the payload needs them
+	// Returns false if the payload doesn't fit in MAX_SOURCE_BLOCKS blocks
+	bool setup(const uint8_t* pPayload, int payloadLen, int blockLen, uint8_t messageId);
+
+	// Get the next packet - valid until the next call - returns the packet length
+	int getNextPacket(const uint8_t*& pPacket);
+
+	// Number of source blocks
+	int getNumBlocks()
+	{
+		return _numBlocks;
+	}
+
+	// Block length (as chosen when setup with 0)
+	int getBlockLen()
+	{
+		return _blockLen;
+	}
+
+	// Packets generated since setup
+	int getPacketCount()
+	{
+		return _seq;
+	}
+
+	// Number of source blocks for a payload
+	static int getNumBlocks(int payloadLen, int blockLen)
+	{
+		return (payloadLen + blockLen - 1) / blockLen;
+	}
+
+	// Source blocks combined in a packet (bit N set for block N)
+	static uint32_t getBlockMask(uint16_t seq, uint8_t messageId, int numBlocks);
+};
@@ -0,0 +1,80 @@
+// FrameAddress
+// Optional address at the start of a frame so several devices in earshot can share
+// a channel - the framers check it as soon as it arrives and drop frames for other
+// devices without buffering the rest or checking the CRC
+//
+// Address (2 bytes, high byte first, covered by the frame CRC):
+//   0xFFFF           broadcast - accepted by every device
+//   0x8000 | groups  group - accepted by a device in any of the 15 groups set
+//   0x0000 - 0x7FFF  unicast - accepted only by the device with that ID
+//
+// Both ends must agree on whether frames are addressed
+
+#pragma once
+
+#include <stdint.h>
+
+class FrameAddress
+{
+public:
+	static const int ADDRESS_LEN = 2;
+	static const uint16_t BROADCAST = 0xFFFF;
+	static const uint16_t GROUP_FLAG = 0x8000;
+	static const uint16_t MAX_DEVICE_ID = 0x7FFF;
+	static const uint16_t ALL_GROUPS = 0x7FFF;
+
+	// No address (frames sent without one)
+	static const int NONE = -1;
+
+private:
+	uint16_t _deviceId;
+	uint16_t _groupMask;
+
+public:
+	// Addresses
+	static uint16_t unicast(uint16_t deviceId)
+	{
+		return deviceId & MAX_DEVICE_ID;
+	}
+	static uint16_t group(uint16_t groupMask)
+	{
+		return GROUP_FLAG | (groupMask & ALL_GROUPS);
+	}
+
+	// Match rules of a device
+	FrameAddress()
+	{
+		_deviceId = 0;
+		_groupMask = 0;
+	}
+	FrameAddress(uint16_t deviceId, uint16_t groupMask)
+	{
+		_deviceId = deviceId & MAX_DEVICE_ID;
+		_groupMask = groupMask & ALL_GROUPS;
+	}
+
+	// Check if a frame address is for this device
+	bool matches(uint16_t address) const
+	{
+		if (address == BROADCAST)
+			return true;
+		if (address & GROUP_FLAG)
+			return (address & _groupMask) != 0;
+		return address == _deviceId;
+	}
+
+	// Address from the start of a frame
+	static uint16_t fromBytes(const uint8_t* pBytes)
+	{
+		return (pBytes[0] << 8) | pBytes[1];
+	}
+
+	uint16_t getDeviceId() const
+	{
+		return _deviceId;
+	}
+	uint16_t getGroupMask() const
+	{
+		return _groupMask;
+	}
+};
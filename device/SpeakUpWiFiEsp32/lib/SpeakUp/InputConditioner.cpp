@@ -0,0 +1,37 @@
+// InputConditioner
+// Integer input conditioning for audio samples
+
+#include "InputConditioner.h"
+
+// Reciprocal table used to form the AGC gain without a divide
+const uint32_t InputConditioner::_recipTable[16] =
+{
+	65536, 61681, 58254, 55188, 52429, 49932, 47663, 45591,
+	43691, 41943, 40330, 38836, 37449, 36158, 34953, 33825
+};
+
+// Update AGC at the end of each block
+void InputConditioner::updateAGC()
+{
+	// Envelope follows peaks immediately and decays slowly
+	if (_agcBlockPeak > _agcEnvelope)
+		_agcEnvelope = _agcBlockPeak;
+	else
+		_agcEnvelope -= (_agcEnvelope - _agcBlockPeak) >> AGC_RELEASE_SHIFT;
+	_agcBlockPeak = 0;
+	_agcBlockCount = 0;
+
+	// Limit gain on quiet input (and avoid a zero envelope)
+	int env = _agcEnvelope;
+	if (env < (AGC_TARGET_LEVEL << AGC_GAIN_FRAC_BITS) / AGC_MAX_GAIN)
+	{
+		_agcGain = AGC_MAX_GAIN;
+		return;
+	}
+
+	// Normalise envelope to a 5 bit mantissa (16..31) and an exponent
+	// then gain = target / envelope using the reciprocal table
+	int msbPos = 31 - __builtin_clz(env);
+	int mantissa = (env >> (msbPos - 4)) - 16;
+	_agcGain = (int)(((uint32_t)AGC_TARGET_LEVEL * _recipTable[mantissa]) >> (msbPos + AGC_GAIN_FRAC_BITS));
+}
@@ -0,0 +1,119 @@
+// InputConditioner
+// Integer input conditioning for audio samples
+// Scales raw ADC readings with a shift (no multiply/divide), removes DC offset
+// with a one-pole blocker and normalises level with a block-based AGC
+// (fast attack, slow release) so the demodulator sees a consistent amplitude
+// With an ADC offset it decodes messages at -55dB that plain map() scaling doesn't
+// (see tools/InputConditionerBench) for about 2.5ns/sample more on the host
+
+#pragma once
+
+#include <stdint.h>
+
+class InputConditioner
+{
+private:
+	// ADC scaling
+	int _adcShift;
+	int _adcMidpoint;
+
+	// DC blocker - the running DC level is held with DC_TRACK_SHIFT extra bits of precision
+	static const int DC_TRACK_SHIFT = 8;
+	int32_t _dcAccum;
+
+	// AGC
+	bool _agcEnabled;
+	static const int AGC_BLOCK_LEN = 64;
+	static const int AGC_GAIN_FRAC_BITS = 8;
+	static const int AGC_UNITY_GAIN = 1 << AGC_GAIN_FRAC_BITS;
+	static const int AGC_MAX_GAIN = 128 << AGC_GAIN_FRAC_BITS;
+	static const int AGC_TARGET_LEVEL = 16384;
+	static const int AGC_RELEASE_SHIFT = 6;
+	int _agcGain;
+	int _agcEnvelope;
+	int _agcBlockPeak;
+	int _agcBlockCount;
+
+	// Reciprocal table for the AGC gain calculation - entry i is 2^20 / (16 + i)
+	static const uint32_t _recipTable[16];
+
+public:
+	// Constructor - adcBits is the resolution of raw values passed to processAdcSample()
+	InputConditioner(int adcBits = 12)
+	{
+		_adcShift = 16 - adcBits;
+		_adcMidpoint = 1 << (adcBits - 1);
+		_agcEnabled = true;
+		clear();
+	}
+
+	// Clear state
+	void clear()
+	{
+		_dcAccum = 0;
+		_agcGain = AGC_UNITY_GAIN;
+		_agcEnvelope = 0;
+		_agcBlockPeak = 0;
+		_agcBlockCount = 0;
+	}
+
+	// Enable/disable AGC (DC blocking is always applied)
+	void enableAGC(bool enable)
+	{
+		_agcEnabled = enable;
+		_agcGain = AGC_UNITY_GAIN;
+	}
+
+	// Current AGC gain (fixed point with AGC_GAIN_FRAC_BITS fractional bits)
+	int getAGCGain()
+	{
+		return _agcGain;
+	}
+
+	// Process a raw (unsigned) ADC reading
+	inline int processAdcSample(int adcVal)
+	{
+		return processSample((adcVal - _adcMidpoint) << _adcShift);
+	}
+
+	// Process a signed 16 bit sample
+	inline int processSample(int sampleVal)
+	{
+		// DC blocker
+		int dcLevel = _dcAccum >> DC_TRACK_SHIFT;
+		_dcAccum += sampleVal - dcLevel;
+		int outVal = sampleVal - dcLevel;
+		if (!_agcEnabled)
+			return saturate(outVal);
+
+		// Track block peak
+		int absVal = (outVal < 0) ? -outVal : outVal;
+		if (absVal > _agcBlockPeak)
+			_agcBlockPeak = absVal;
+		if (++_agcBlockCount >= AGC_BLOCK_LEN)
+			updateAGC();
+
+		// Apply gain
+		return saturate((outVal * _agcGain) >> AGC_GAIN_FRAC_BITS);
+	}
+
+	// Process a block of signed samples in place
+	void processBlock(int16_t* pSamples, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i++)
+			pSamples[i] = processSample(pSamples[i]);
+	}
+
+private:
+	// Update AGC at the end of each block
+	void updateAGC();
+
+	static inline int saturate(int val)
+	{
+		if (val > 32767)
+			return 32767;
+		if (val < -32767)
+			return -32767;
+		return val;
+	}
+};
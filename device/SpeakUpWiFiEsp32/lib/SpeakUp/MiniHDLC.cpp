@@ -3,6 +3,7 @@
 // Very loosely based on https://github.com/mengguang/minihdlc
 
 #include "MiniHDLC.h"
+#include <algorithm>
 
 // CRC Lookup table
 const uint16_t MiniHDLC::_CRCTable[256] = { 
@@ -24,6 +25,21 @@ const uint16_t MiniHDLC::_CRCTable[256] = {
     0xef1f,0xff3e,0xcf5d,0xdf7c,0xaf9b,0xbfba,0x8fd9,0x9ff8,0x6e17,0x7e36,0x4e55,0x5e74,0x2e93,0x3eb2,0x0ed1,0x1ef0
 };
 
+// Bit access for packed bit buffers (LSB first)
+static inline int getBitAt(const uint8_t* pBits, int bitIdx)
+{
+	return (pBits[bitIdx >> 3] >> (bitIdx & 0x07)) & 0x01;
+}
+
+static inline void setBitAt(uint8_t* pBits, int bitIdx, int bitVal)
+{
+	uint8_t mask = 1 << (bitIdx & 0x07);
+	if (bitVal)
+		pBits[bitIdx >> 3] |= mask;
+	else
+		pBits[bitIdx >> 3] &= ~mask;
+}
+
 // Function to handle a single bit received
 void MiniHDLC::handleBit(uint8_t bit)
 {
@@ -34,19 +50,28 @@ void MiniHDLC::handleBit(uint8_t bit)
 	// Check for frame start flag
 	if (_bitwiseLast8Bits == FRAME_BOUNDARY_OCTET)
 	{
-		// Handle with the byte-based handler
-		handleChar(FRAME_BOUNDARY_OCTET);
-		_bitwiseByte = 0;
-		_bitwiseBitCount = 0;
+		handleFlag();
 		return;
 	}
 
+	// Frames for other devices (or while a frame is held) are ignored until the next flag
+	if (_rxRejected || _rxHeld)
+		return;
+
 	// Check for bit stuffing - HDLC abhors a sequence of more
 	// than 5 ones in regular data and stuffs a 0 in this case
 	// So here we detect that situation and ignore that 0
 	if ((_bitwiseLast8Bits & 0xfc) == 0x7c)
 		return;
 
+	// Keep the destuffed bits for repeat combining
+	if (_repeatCombining && (_rxBitCount <= REPEAT_COMBINE_MAX_BITS + 7))
+	{
+		if (_rxBitCount < REPEAT_COMBINE_MAX_BITS + 7)
+			setBitAt(_pCombineWork->rxBits, _rxBitCount, bit);
+		_rxBitCount++;
+	}
+
 	// Add the received bit into the byte
 	_bitwiseByte = _bitwiseByte >> 1;
 	_bitwiseByte |= (bit ? 0x80 : 0);
@@ -62,50 +87,59 @@ void MiniHDLC::handleBit(uint8_t bit)
 	}
 }
 
+// Handle bits packed into a word (first bit in the LSB)
+void MiniHDLC::handleBits(uint32_t bits, int numBits)
+{
+	for (int i = 0; i < numBits; i++)
+	{
+		// While a frame is ignored only the flag is looked for
+		if (_rxRejected || _rxHeld)
+		{
+			_bitwiseLast8Bits = (_bitwiseLast8Bits >> 1) | ((bits & 0x01) << 7);
+			bits = bits >> 1;
+			if (_bitwiseLast8Bits == FRAME_BOUNDARY_OCTET)
+				handleFlag();
+			continue;
+		}
+		handleBit(bits & 0x01);
+		bits = bits >> 1;
+	}
+}
+
+// Flag received in the bit stream
+void MiniHDLC::handleFlag()
+{
+	// Bits of the frame for repeat combining (excluding the first 7 bits of the flag)
+	_rxFrameBits = (_rxBitCount <= REPEAT_COMBINE_MAX_BITS + 7) ? _rxBitCount - 7 : -1;
+	_rxBitCount = 0;
+
+	// Handle with the byte-based handler
+	handleChar(FRAME_BOUNDARY_OCTET);
+	_bitwiseByte = 0;
+	_bitwiseBitCount = 0;
+}
+
 // Function to find valid HDLC frame from incoming data
 void MiniHDLC::handleChar(uint8_t ch)
 {
     // Check boundary
     if (ch == FRAME_BOUNDARY_OCTET) 
     {
-        if (_framePos >= 2) 
-        {
-            // Valid frame ?
-            uint16_t rxcrc = _rxBuffer[_framePos - 2] | (((uint16_t)_rxBuffer[_framePos-1]) << 8);
-            if (_bigEndianCRC)
-                rxcrc = _rxBuffer[_framePos - 1] | (((uint16_t)_rxBuffer[_framePos - 2]) << 8);
-            // Log.trace("...len %d calc %x rxcrc %x\n", _framePos, _frameCRC, rxcrc);
-            // for (int i = 0; i < _framePos-2; i++)
-            // {
-            //     if (_rxBuffer[i] == 0)
-            //         Serial.printf("\\0");
-            //     else
-            //         Serial.printf("%c", _rxBuffer[i]);
-            // }
-            // for (int i = _framePos-2; i < _framePos; i++)
-            // {
-            //     Serial.printf(" %02x", _rxBuffer[i]);
-            // }
-            // Serial.println("");
-            if (rxcrc == _frameCRC)
-            {
-                // Log.trace("FRAMEOK\n");
-                // Null terminate the frame (in case used as a string)
-                _rxBuffer[_framePos-2] = 0;
-
-                // Handle the frame
-                if(_frameRxFn)
-                    _frameRxFn(_rxBuffer, _framePos - 2);
-            }
-        }
+        if ((_framePos >= 2) && !_rxRejected)
+            handleFrameEnd();
 
         // Ready for new frame
+        _rxRejected = false;
         _inEscapeSeq = false;
         _framePos = 0;
         _frameCRC = CRC16_CCITT_INIT_VAL;
         return;
     }
 
+    // Frames for other devices (or while a frame is held) are ignored until the next boundary
+    if (_rxRejected || _rxHeld)
+        return;
+
     // Check escape
     if (_inEscapeSeq)
     {
@@ -130,8 +164,20 @@ void MiniHDLC::handleChar(uint8_t ch)
     // Bump position
     _framePos++;
 
-    // Check for max
-    if (_framePos == MINIHDLC_MAX_FRAME_LENGTH)
+    // Drop a frame for another device as soon as its address has arrived
+    if (_addressFilterEnabled && (_framePos == FrameAddress::ADDRESS_LEN) &&
+                !_addressFilter.matches(FrameAddress::fromBytes(_rxBuffer)))
+    {
+        _rxRejected = true;
+        _rejectedFrameCount++;
+        _framePos = 0;
+        _frameCRC = CRC16_CCITT_INIT_VAL;
+        return;
+    }
+
+    // Check for max - a frame can fill the buffer (the extra byte is for the
+    // terminator) so it is only too long once a byte beyond that arrives
+    if (_framePos > _maxFrameLen)
     {
         // Discard and start again
         _framePos = 0;
@@ -142,6 +188,19 @@ void MiniHDLC::handleChar(uint8_t ch)
 // Wrap given data in HDLC frame and send it out byte at a time
 void MiniHDLC::sendFrame(const uint8_t *pFrame, int frameLen)
 {
+    // Bitwise frames are generated by the streaming encoder
+    if (_bitwiseHDLC)
+    {
+        startTxFrame(pFrame, frameLen);
+        uint8_t bit = 0;
+        while (getTxBit(bit))
+        {
+            if (_putChFn)
+                _putChFn(bit);
+        }
+        return;
+    }
+
     uint16_t fcs = CRC16_CCITT_INIT_VAL;
 
     // Initial boundary
@@ -175,79 +234,530 @@ void MiniHDLC::sendFrame(const uint8_t *pFrame, int frameLen)
     sendChar(FRAME_BOUNDARY_OCTET);
 }
 
-uint16_t MiniHDLC::crcUpdateCCITT(unsigned short fcs, unsigned char value)
+// Start a streaming bitwise frame
+void MiniHDLC::startTxFrame(const uint8_t *pData, int frameLen, int address)
 {
-	return (fcs << 8) ^ _CRCTable[((fcs >> 8) ^ value) & 0xff];
+    _txAddress = address;
+    _txAddressBytesLeft = (address == FrameAddress::NONE) ? 0 : FrameAddress::ADDRESS_LEN;
+    _pTxData = pData;
+    _txLen = frameLen;
+    _txPos = 0;
+    _txCRC = CRC16_CCITT_INIT_VAL;
+    _txCRCBytesSent = 0;
+    _txEscapePending = false;
+    _txBitIdx = 8;
+    _txStuffBitPending = false;
+    _txStage = TX_STAGE_START_FLAG;
 }
 
-void MiniHDLC::sendChar(uint8_t ch)
+// Get the next bit of a streaming frame
+bool MiniHDLC::getTxBit(uint8_t& bit)
 {
-	if (_bitwiseHDLC)
-	{
-		// Send each bit
-		uint8_t bitData = ch;
-		for (int i = 0; i < 8; i++)
-		{
-			if (_putChFn)
-				_putChFn(bitData & 0x01);
-			bitData = bitData >> 1;
-		}
-	}
-	else
-	{
-		// Send byte-wise
-		if (_putChFn)
-			_putChFn(ch);
-	}
+    // Stuffed zero after five consecutive ones
+    if (_txStuffBitPending)
+    {
+        _txStuffBitPending = false;
+        bit = 0;
+        return true;
+    }
+
+    // Next byte
+    if (_txBitIdx >= 8)
+    {
+        if (!loadNextTxByte())
+            return false;
+    }
+
+    // Bits are sent LSB first
+    bit = (_txByte >> _txBitIdx) & 0x01;
+    _txBitIdx++;
+
+    // Handle bit stuffing - HDLC doesn't allow more than 5 x 1s in a row in data
+    if (_txByteStuffed)
+    {
+        if (bit)
+        {
+            _bitwiseSendOnesCount++;
+            if (_bitwiseSendOnesCount == 5)
+            {
+                _txStuffBitPending = true;
+                _bitwiseSendOnesCount = 0;
+            }
+        }
+        else
+        {
+            _bitwiseSendOnesCount = 0;
+        }
+    }
+    return true;
 }
 
-void MiniHDLC::sendCharWithStuffing(uint8_t ch)
+// Load the next byte of a streaming frame - handles escaping and CRC
+bool MiniHDLC::loadNextTxByte()
 {
-	if (_bitwiseHDLC)
-	{
-		// Send making sure we don't exceed 5 x 1s in a row
-		uint8_t bitData = ch;
-		for (int i = 0; i < 8; i++)
-		{
-			// Put the actual bit
-			if (_putChFn)
-				_putChFn(bitData & 0x01);
-
-			// Handle bit stuffing
-			if (bitData & 0x01)
-			{
-				// Count 1s
-				_bitwiseSendOnesCount++;
-				if (_bitwiseSendOnesCount == 5)
-				{
-					// Stuff a 0 to avoid 6 consecutive 1s
-					if (_putChFn)
-						_putChFn(0);
-					_bitwiseSendOnesCount = 0;
-				}
-			}
-			else
-			{
-				// Reset count of consecutive 1s
-				_bitwiseSendOnesCount = 0;
-			}
-			// Shift to next bit
-			bitData = bitData >> 1;
-		}
-	}
-	else
-	{
-		// Just send it
-		sendChar(ch);
-	}
+    _txBitIdx = 0;
+    switch (_txStage)
+    {
+        case TX_STAGE_START_FLAG:
+        {
+            // Frame boundary isn't stuffed and resets the count of consecutive 1s
+            _txByte = FRAME_BOUNDARY_OCTET;
+            _txByteStuffed = false;
+            _bitwiseSendOnesCount = 0;
+            _txStage = TX_STAGE_BODY;
+            return true;
+        }
+        case TX_STAGE_BODY:
+        {
+            // Second part of an escape sequence
+            _txByteStuffed = true;
+            if (_txEscapePending)
+            {
+                _txEscapePending = false;
+                _txByte = _txEscapedByte ^ INVERT_OCTET;
+                return true;
+            }
+
+            // Address then data then CRC then closing boundary
+            uint8_t ch = 0;
+            if (_txAddressBytesLeft > 0)
+            {
+                _txAddressBytesLeft--;
+                ch = (_txAddress >> (8 * _txAddressBytesLeft)) & 0xff;
+                _txCRC = crcUpdateCCITT(_txCRC, ch);
+            }
+            else if (_txPos < _txLen)
+            {
+                ch = _pTxData[_txPos++];
+                _txCRC = crcUpdateCCITT(_txCRC, ch);
+            }
+            else if (_txCRCBytesSent < 2)
+            {
+                bool highByte = (_txCRCBytesSent == 0) == _bigEndianCRC;
+                ch = highByte ? ((_txCRC >> 8) & 0xff) : (_txCRC & 0xff);
+                _txCRCBytesSent++;
+            }
+            else
+            {
+                _txByte = FRAME_BOUNDARY_OCTET;
+                _txByteStuffed = false;
+                _txStage = TX_STAGE_IDLE;
+                return true;
+            }
+
+            // Escape if needed
+            if ((ch == CONTROL_ESCAPE_OCTET) || (ch == FRAME_BOUNDARY_OCTET))
+            {
+                _txEscapePending = true;
+                _txEscapedByte = ch;
+                ch = CONTROL_ESCAPE_OCTET;
+            }
+            _txByte = ch;
+            return true;
+        }
+        default:
+            break;
+    }
+    _txBitIdx = 8;
+    return false;
+}
+
+// Handle the end of a frame - check CRC and try to repair if needed
+void MiniHDLC::handleFrameEnd()
+{
+    // Valid frame ?
+    uint16_t rxcrc = getRxCRC(_framePos);
+    // Log.trace("...len %d calc %x rxcrc %x\n", _framePos, _frameCRC, rxcrc);
+    if (rxcrc == _frameCRC)
+    {
+        // Log.trace("FRAMEOK\n");
+        deliverFrame(_framePos - 2);
+        clearRepeats();
+        return;
+    }
+
+    // Locate bit errors from the CRC syndrome
+    if ((_framePos <= _correctMaxLen) && correctErrors(_framePos, rxcrc ^ _frameCRC))
+    {
+        _correctedFrameCount++;
+        deliverFrame(_framePos - 2);
+        clearRepeats();
+        return;
+    }
+
+    // Combine with earlier failed copies
+    if (_repeatCombining && _bitwiseHDLC)
+        combineRepeats();
+}
+
+// Get the received CRC from the end of a frame in the receive buffer
+uint16_t MiniHDLC::getRxCRC(int frameLen)
+{
+    if (_bigEndianCRC)
+        return _rxBuffer[frameLen - 1] | (((uint16_t)_rxBuffer[frameLen - 2]) << 8);
+    return _rxBuffer[frameLen - 2] | (((uint16_t)_rxBuffer[frameLen - 1]) << 8);
+}
+
+// Check the CRC of a frame in the receive buffer
+bool MiniHDLC::checkRxBufferCRC(int frameLen)
+{
+    uint16_t fcs = CRC16_CCITT_INIT_VAL;
+    for (int i = 0; i < frameLen - 2; i++)
+        fcs = crcUpdateCCITT(fcs, _rxBuffer[i]);
+    return getRxCRC(frameLen) == fcs;
+}
+
+// Enable error correction
+void MiniHDLC::enableErrorCorrection(int maxFrameLen, bool doubleBit,
+            uint16_t* pSyndromeByPos, uint32_t* pSyndromeSorted)
+{
+    // Syndromes are unique for positions within the period of the CRC polynomial
+    if (maxFrameLen > MAX_CORRECTION_FRAME_LEN)
+        maxFrameLen = MAX_CORRECTION_FRAME_LEN;
+    _correctMaxLen = (maxFrameLen >= 3) ? maxFrameLen : 0;
+    _correctDoubleBit = doubleBit;
+    int numPositions = _correctMaxLen * 8;
+    if (pSyndromeByPos && pSyndromeSorted)
+    {
+        _pSyndromeByPos = pSyndromeByPos;
+        _pSyndromeSorted = pSyndromeSorted;
+    }
+    else
+    {
+        _ownSyndromeByPos.resize(numPositions);
+        _ownSyndromeSorted.resize(numPositions);
+        _pSyndromeByPos = _ownSyndromeByPos.data();
+        _pSyndromeSorted = _ownSyndromeSorted.data();
+    }
+    if (numPositions == 0)
+        return;
+
+    // Position p is bit (p % 8) of the byte (p / 8) from the end of the frame
+    // An error in the received CRC changes the syndrome by the bit itself
+    for (int bitIdx = 0; bitIdx < 8; bitIdx++)
+    {
+        uint16_t lastByteBit = _bigEndianCRC ? (1 << bitIdx) : (1 << (bitIdx + 8));
+        uint16_t firstByteBit = _bigEndianCRC ? (1 << (bitIdx + 8)) : (1 << bitIdx);
+        _pSyndromeByPos[bitIdx] = lastByteBit;
+        _pSyndromeByPos[8 + bitIdx] = firstByteBit;
+
+        // An error in data changes the CRC by the CRC (without init value) of the
+        // error followed by the zero bytes after it
+        uint16_t fcs = crcUpdateCCITT(0, 1 << bitIdx);
+        for (int bytePos = 2; bytePos < _correctMaxLen; bytePos++)
+        {
+            _pSyndromeByPos[bytePos * 8 + bitIdx] = fcs;
+            fcs = crcUpdateCCITT(fcs, 0);
+        }
+    }
+    for (int i = 0; i < numPositions; i++)
+        _pSyndromeSorted[i] = (((uint32_t)_pSyndromeByPos[i]) << 16) | i;
+    std::sort(_pSyndromeSorted, _pSyndromeSorted + numPositions);
+}
+
+// Find the position with a syndrome (less than numPositions) or -1
+int MiniHDLC::findSyndromePos(uint16_t syndrome, int numPositions)
+{
+    const uint32_t* pEnd = _pSyndromeSorted + _correctMaxLen * 8;
+    const uint32_t* it = std::lower_bound((const uint32_t*)_pSyndromeSorted, pEnd, ((uint32_t)syndrome) << 16);
+    for (; (it != pEnd) && ((*it >> 16) == syndrome); it++)
+    {
+        int pos = *it & 0xffff;
+        if (pos < numPositions)
+            return pos;
+    }
+    return -1;
+}
+
+// Try to correct errors in the frame in the receive buffer
+bool MiniHDLC::correctErrors(int frameLen, uint16_t syndrome)
+{
+    int numPositions = frameLen * 8;
+
+    // Single bit error
+    int errPos = findSyndromePos(syndrome, numPositions);
+    int errPos2 = -1;
+    if (errPos < 0)
+    {
+        if (!_correctDoubleBit || (frameLen > MAX_DOUBLE_BIT_FRAME_LEN))
+            return false;
+
+        // Double bit error - must be a unique solution
+        int numSolutions = 0;
+        for (int pos = 0; pos < numPositions; pos++)
+        {
+            int otherPos = findSyndromePos(syndrome ^ _pSyndromeByPos[pos], numPositions);
+            if (otherPos > pos)
+            {
+                if (++numSolutions > 1)
+                    return false;
+                errPos = pos;
+                errPos2 = otherPos;
+            }
+        }
+        if (numSolutions == 0)
+            return false;
+    }
+
+    // Repair and verify
+    _rxBuffer[frameLen - 1 - errPos / 8] ^= 1 << (errPos % 8);
+    if (errPos2 >= 0)
+        _rxBuffer[frameLen - 1 - errPos2 / 8] ^= 1 << (errPos2 % 8);
+    return checkRxBufferCRC(frameLen);
+}
+
+// Deliver the frame in the receive buffer
+void MiniHDLC::deliverFrame(int frameLen)
+{
+    // Null terminate the frame (in case used as a string)
+    _rxBuffer[frameLen] = 0;
+
+    // Handle the frame
+    if(_frameRxFn)
+        _frameRxFn(_rxBuffer, frameLen);
+}
+
+// Store the bits of a failed frame and try combining with earlier copies
+void MiniHDLC::combineRepeats()
+{
+    int numBits = _rxFrameBits;
+    if ((numBits < 24) || (numBits > REPEAT_COMBINE_MAX_BITS))
+        return;
+
+    // Find the two most recent copies of a similar length
+    int copyIdxs[2] = { -1, -1 };
+    for (int i = 0; i < REPEAT_COMBINE_SLOTS; i++)
+    {
+        int lenDiff = _combineBitLens[i] - numBits;
+        if ((_combineBitLens[i] == 0) || (lenDiff > REPEAT_COMBINE_MAX_SLIP) || (lenDiff < -REPEAT_COMBINE_MAX_SLIP))
+            continue;
+        if ((copyIdxs[0] < 0) || (_combineAges[i] > _combineAges[copyIdxs[0]]))
+        {
+            copyIdxs[1] = copyIdxs[0];
+            copyIdxs[0] = i;
+        }
+        else if ((copyIdxs[1] < 0) || (_combineAges[i] > _combineAges[copyIdxs[1]]))
+        {
+            copyIdxs[1] = i;
+        }
+    }
+
+    // Try a majority vote
+    bool combinedOk = false;
+    if ((copyIdxs[0] >= 0) && (copyIdxs[1] >= 0) &&
+            alignBits(_pCombineWork->rxBits, numBits, _pCombineWork->combineBits[copyIdxs[0]], _combineBitLens[copyIdxs[0]], _pCombineWork->alignedBits) &&
+            alignBits(_pCombineWork->rxBits, numBits, _pCombineWork->combineBits[copyIdxs[1]], _combineBitLens[copyIdxs[1]], _pCombineWork->alignedBits + REPEAT_COMBINE_MAX_BITS))
+    {
+        // Each bit is kept if at least two copies have it - and bits inserted
+        // by both of the other copies are added
+        uint8_t votedBits[REPEAT_COMBINE_MAX_BITS / 8];
+        int numVoted = 0;
+        for (int i = 0; (i < numBits) && (numVoted + ALIGN_MAX_INS < REPEAT_COMBINE_MAX_BITS); i++)
+        {
+            uint8_t a1 = _pCombineWork->alignedBits[i];
+            uint8_t a2 = _pCombineWork->alignedBits[REPEAT_COMBINE_MAX_BITS + i];
+            int refBit = getBitAt(_pCombineWork->rxBits, i);
+            int present = 1 + ((a1 & ALIGN_GAP) ? 0 : 1) + ((a2 & ALIGN_GAP) ? 0 : 1);
+            int ones = refBit + ((a1 & ALIGN_GAP) ? 0 : (a1 & ALIGN_BIT)) + ((a2 & ALIGN_GAP) ? 0 : (a2 & ALIGN_BIT));
+            if (present == 3)
+                setBitAt(votedBits, numVoted++, ones >= 2);
+            else if (present == 2)
+                setBitAt(votedBits, numVoted++, (ones == 1) ? refBit : (ones >> 1));
+            int ins1 = (a1 >> ALIGN_INS_COUNT_SHIFT) & 0x03;
+            int ins2 = (a2 >> ALIGN_INS_COUNT_SHIFT) & 0x03;
+            for (int k = 0; (k < ins1) && (k < ins2); k++)
+                setBitAt(votedBits, numVoted++, (a1 >> (ALIGN_INS_BITS_SHIFT + k)) & 0x01);
+        }
+        combinedOk = checkCombinedFrame(votedBits, numVoted);
+    }
+    if (combinedOk)
+    {
+        // Recovered
+        _combinedFrameCount++;
+        clearRepeats();
+        return;
+    }
+
+    // Store this copy in an empty slot or else the oldest not just used
+    int reuseIdx = -1;
+    for (int i = 0; i < REPEAT_COMBINE_SLOTS; i++)
+    {
+        if ((i == copyIdxs[0]) || (i == copyIdxs[1]))
+            continue;
+        if ((reuseIdx < 0) || (_combineAges[i] < _combineAges[reuseIdx]))
+            reuseIdx = i;
+    }
+    for (int i = 0; i < (numBits + 7) / 8; i++)
+        _pCombineWork->combineBits[reuseIdx][i] = _pCombineWork->rxBits[i];
+    _combineBitLens[reuseIdx] = numBits;
+    _combineAges[reuseIdx] = ++_combineCounter;
+}
+
+// Align the bits of a copy to the reference allowing for slipped (inserted or
+// deleted) bits using a banded edit distance - the result has an entry for each
+// reference bit with the copy's bit (or a gap) and any bits the copy has after it
+bool MiniHDLC::alignBits(const uint8_t* pRef, int refLen, const uint8_t* pCopy, int copyLen,
+            uint8_t* pAligned)
+{
+    static const int TRACE_DIAG = 0;
+    static const int TRACE_UP = 1;
+    static const int TRACE_LEFT = 2;
+    static const int COST_INVALID = 0x7fff;
+    const int maxSlip = REPEAT_COMBINE_MAX_SLIP;
+    int lenDiff = copyLen - refLen;
+    if ((lenDiff > maxSlip) || (lenDiff < -maxSlip))
+        return false;
+
+    // Costs are kept for the previous and current reference bit - column k is the
+    // copy position j = i + k - maxSlip
+    int prevCost[REPEAT_COMBINE_BAND];
+    int curCost[REPEAT_COMBINE_BAND];
+    for (int k = 0; k < REPEAT_COMBINE_BAND; k++)
+    {
+        int j = k - maxSlip;
+        prevCost[k] = ((j >= 0) && (j <= copyLen)) ? j : COST_INVALID;
+    }
+    for (int i = 1; i <= refLen; i++)
+    {
+        int refBit = getBitAt(pRef, i - 1);
+        for (int k = 0; k < REPEAT_COMBINE_BAND; k++)
+        {
+            int j = i + k - maxSlip;
+            int bestCost = COST_INVALID;
+            int dir = TRACE_DIAG;
+            if ((j >= 0) && (j <= copyLen))
+            {
+                if ((j >= 1) && (prevCost[k] != COST_INVALID))
+                    bestCost = prevCost[k] + ((refBit != getBitAt(pCopy, j - 1)) ? 1 : 0);
+                if ((k + 1 < REPEAT_COMBINE_BAND) && (prevCost[k + 1] != COST_INVALID) && (prevCost[k + 1] + 1 < bestCost))
+                {
+                    bestCost = prevCost[k + 1] + 1;
+                    dir = TRACE_UP;
+                }
+                if ((k >= 1) && (j >= 1) && (curCost[k - 1] != COST_INVALID) && (curCost[k - 1] + 1 < bestCost))
+                {
+                    bestCost = curCost[k - 1] + 1;
+                    dir = TRACE_LEFT;
+                }
+            }
+            curCost[k] = bestCost;
+            int cellIdx = i * REPEAT_COMBINE_BAND + k;
+            int traceShift = (cellIdx & 0x03) * 2;
+            _pCombineWork->alignTrace[cellIdx >> 2] = (_pCombineWork->alignTrace[cellIdx >> 2] & ~(0x03 << traceShift)) | (dir << traceShift);
+        }
+        for (int k = 0; k < REPEAT_COMBINE_BAND; k++)
+            prevCost[k] = curCost[k];
+    }
+
+    // Copies that differ too much (likely a different message) aren't used
+    int k = lenDiff + maxSlip;
+    if (prevCost[k] > refLen / 8)
+        return false;
+
+    // Trace back
+    for (int i = 0; i < refLen; i++)
+        pAligned[i] = 0;
+    int i = refLen;
+    while (i > 0)
+    {
+        int j = i + k - maxSlip;
+        int cellIdx = i * REPEAT_COMBINE_BAND + k;
+        int dir = (_pCombineWork->alignTrace[cellIdx >> 2] >> ((cellIdx & 0x03) * 2)) & 0x03;
+        if (dir == TRACE_DIAG)
+        {
+            pAligned[i - 1] |= getBitAt(pCopy, j - 1) ? ALIGN_BIT : 0;
+            i--;
+        }
+        else if (dir == TRACE_UP)
+        {
+            pAligned[i - 1] |= ALIGN_GAP;
+            i--;
+            k++;
+        }
+        else
+        {
+            // Copy bit inserted after reference bit i - 1 (found in reverse order)
+            uint8_t aligned = pAligned[i - 1];
+            int insCount = (aligned >> ALIGN_INS_COUNT_SHIFT) & 0x03;
+            if (insCount < ALIGN_MAX_INS)
+            {
+                int insBits = (aligned >> ALIGN_INS_BITS_SHIFT) & 0x07;
+                insBits = ((insBits << 1) | getBitAt(pCopy, j - 1)) & 0x07;
+                pAligned[i - 1] = (aligned & (ALIGN_BIT | ALIGN_GAP)) |
+                        ((insCount + 1) << ALIGN_INS_COUNT_SHIFT) | (insBits << ALIGN_INS_BITS_SHIFT);
+            }
+            k--;
+        }
+    }
+    return true;
+}
+
+// Convert combined bits to a frame, check the CRC and deliver if ok
+bool MiniHDLC::checkCombinedFrame(const uint8_t* pBits, int numBits)
+{
+    if ((numBits % 8) != 0)
+        return false;
+
+    // Remove escapes
+    int frameLen = 0;
+    bool inEscape = false;
+    for (int i = 0; i < numBits / 8; i++)
+    {
+        uint8_t ch = pBits[i];
+        if (ch == FRAME_BOUNDARY_OCTET)
+            return false;
+        if (inEscape)
+        {
+            ch ^= INVERT_OCTET;
+            inEscape = false;
+        }
+        else if (ch == CONTROL_ESCAPE_OCTET)
+        {
+            inEscape = true;
+            continue;
+        }
+        if (frameLen >= _maxFrameLen)
+            return false;
+        _rxBuffer[frameLen++] = ch;
+    }
+    if (frameLen < 3)
+        return false;
+
+    // Check CRC
+    if (!checkRxBufferCRC(frameLen))
+        return false;
+    deliverFrame(frameLen - 2);
+    return true;
+}
+
+void MiniHDLC::clearRepeats()
+{
+    for (int i = 0; i < REPEAT_COMBINE_SLOTS; i++)
+    {
+        _combineBitLens[i] = 0;
+        _combineAges[i] = 0;
+    }
+    _combineCounter = 0;
+}
+
+uint16_t MiniHDLC::crcUpdateCCITT(unsigned short fcs, unsigned char value)
+{
+	return (fcs << 8) ^ _CRCTable[((fcs >> 8) ^ value) & 0xff];
+}
+
+void MiniHDLC::sendChar(uint8_t ch)
+{
+	// Send byte-wise
+	if (_putChFn)
+		_putChFn(ch);
 }
 
 void MiniHDLC::sendEscaped(uint8_t ch)
 {
 	if ((ch == CONTROL_ESCAPE_OCTET) || (ch == FRAME_BOUNDARY_OCTET))
 	{
-		sendCharWithStuffing(CONTROL_ESCAPE_OCTET);
+		sendChar(CONTROL_ESCAPE_OCTET);
 		ch ^= INVERT_OCTET;
 	}
-	sendCharWithStuffing(ch);
+	sendChar(ch);
 }
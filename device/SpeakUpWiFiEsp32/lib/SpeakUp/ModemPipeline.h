@@ -0,0 +1,169 @@
+// ModemPipeline
+// A receive chain composed from stages at compile time - e.g.
+//   ModemPipeline<HighpassEnvelopeStage, SyncDetectStage, SlicerStage, ClockRecoveryStage,
+//                 ManchesterDecodeStage, HdlcDeframerStage, FrameSinkStage<64> >
+// Each stage is passed the rest of the pipeline as a template argument so its output
+// is a direct (inlined) call into the next stage - a sample runs through all the
+// stages in one loop with no FIFOs or callbacks between them, and swapping a stage
+// (e.g. the deframer) is a change of type with no runtime dispatch
+// Stages (see ModemStages.h) handle these events - ModemStage passes on all but process():
+//   process(val, next)         a sample, envelope, level or bit depending on the stage
+//   sync(result, next)         the preamble and sync word were found at this sample
+//   frame(pFrame, len, next)   a complete received frame
+//   inFrame(next)              true while a frame is being received
+// setup() and enableSyncDetector() take the same arguments as FSKDemod and are given
+// to every stage so SpeakUp::setupDemod() can set up a pipeline
+
+#pragma once
+
+#include <stdint.h>
+#include "PreambleDetector.h"
+#include "FSKDemodParams.h"
+
+// Base for stages - events other than process() are passed on unchanged
+class ModemStage
+{
+public:
+	void setup(int, int, int, int, bool, const FSKDemodParams&)
+	{
+	}
+	void enableSyncDetector(uint32_t, int, int)
+	{
+	}
+	template<typename Next>
+	void sync(const PreambleDetector::DetectResult& result, Next& next)
+	{
+		next.sync(result);
+	}
+	template<typename Next>
+	void frame(const uint8_t* pFrame, int frameLen, Next& next)
+	{
+		next.frame(pFrame, frameLen);
+	}
+	template<typename Next>
+	bool inFrame(Next& next)
+	{
+		return next.inFrame();
+	}
+};
+
+template<typename... Stages>
+class ModemPipeline;
+
+// Stage I of a pipeline
+template<int I, typename Pipeline>
+struct ModemPipelineStage
+{
+	typedef typename ModemPipelineStage<I - 1, typename Pipeline::RestType>::type type;
+	static type& get(Pipeline& pipeline)
+	{
+		return ModemPipelineStage<I - 1, typename Pipeline::RestType>::get(pipeline.rest());
+	}
+};
+
+template<typename Pipeline>
+struct ModemPipelineStage<0, Pipeline>
+{
+	typedef typename Pipeline::StageType type;
+	static type& get(Pipeline& pipeline)
+	{
+		return pipeline.head();
+	}
+};
+
+// End of a pipeline - anything passed out of the last stage is dropped
+template<>
+class ModemPipeline<>
+{
+public:
+	void process(int)
+	{
+	}
+	void sync(const PreambleDetector::DetectResult&)
+	{
+	}
+	void frame(const uint8_t*, int)
+	{
+	}
+	bool inFrame()
+	{
+		return false;
+	}
+	void setup(int, int, int, int, bool, const FSKDemodParams& = FSKDemodParams())
+	{
+	}
+	void enableSyncDetector(uint32_t, int, int)
+	{
+	}
+};
+
+template<typename Stage, typename... Rest>
+class ModemPipeline<Stage, Rest...>
+{
+public:
+	typedef Stage StageType;
+	typedef ModemPipeline<Rest...> RestType;
+
+private:
+	Stage _stage;
+	RestType _rest;
+
+public:
+	// Setup every stage - as FSKDemod::setup()
+	void setup(int sampleRate, int symbolRate, int symbolFreqHigh, int symbolFreqLow,
+				bool manchesterCodec, const FSKDemodParams& params = FSKDemodParams())
+	{
+		_stage.setup(sampleRate, symbolRate, symbolFreqHigh, symbolFreqLow, manchesterCodec, params);
+		_rest.setup(sampleRate, symbolRate, symbolFreqHigh, symbolFreqLow, manchesterCodec, params);
+	}
+
+	// Enable sync word detection in every stage that takes part - as FSKDemod
+	void enableSyncDetector(uint32_t syncWord, int syncWordBits, int preambleBits)
+	{
+		_stage.enableSyncDetector(syncWord, syncWordBits, preambleBits);
+		_rest.enableSyncDetector(syncWord, syncWordBits, preambleBits);
+	}
+
+	// Process a sample
+	inline void process(int val)
+	{
+		_stage.process(val, _rest);
+	}
+
+	// Process a block of samples (int16_t or int)
+	template<typename SampleT>
+	void processSamples(const SampleT* pSamples, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i++)
+			_stage.process(pSamples[i], _rest);
+	}
+
+	// Events from the previous stage
+	inline void sync(const PreambleDetector::DetectResult& result)
+	{
+		_stage.sync(result, _rest);
+	}
+	inline void frame(const uint8_t* pFrame, int frameLen)
+	{
+		_stage.frame(pFrame, frameLen, _rest);
+	}
+	inline bool inFrame()
+	{
+		return _stage.inFrame(_rest);
+	}
+
+	// Stages - stage<I>() is the Ith (from 0)
+	Stage& head()
+	{
+		return _stage;
+	}
+	RestType& rest()
+	{
+		return _rest;
+	}
+	template<int I>
+	typename ModemPipelineStage<I, ModemPipeline>::type& stage()
+	{
+		return ModemPipelineStage<I, ModemPipeline>::get(*this);
+	}
+};
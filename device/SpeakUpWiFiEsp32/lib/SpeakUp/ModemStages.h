@@ -0,0 +1,455 @@
+// ModemStages
+// Stages for a ModemPipeline - the FSK receive chain split up so the parts can be
+// composed (and swapped) at compile time
+//   ConditionStage          samples -> samples (DC removal and AGC)
+//   HighpassEnvelopeStage   samples -> envelope (as FSKDemod)
+//   SyncDetectStage         envelope -> envelope (and sync events from the preamble detector)
+//   SlicerStage             envelope -> level (peak followers, slicing and voting)
+//   ClockRecoveryStage      level -> symbols (one per symbol period)
+//   ManchesterDecodeStage   symbols -> bits
+//   HdlcDeframerStage       bits -> frames (MiniHDLC)
+//   SyncDeframerStage       bits -> frames (SyncFramer)
+//   FrameSinkStage          frames - keeps the latest until it is cleared
+// The FSK stages in order give the same bits and frames as FSKDemod
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "ModemPipeline.h"
+#include "InputConditioner.h"
+#include "FSKDemod.h"
+#include "ClockRecovery.h"
+#include "PreambleDetector.h"
+#include "MiniHDLC.h"
+#include "SyncFramer.h"
+
+// Input conditioning (see InputConditioner)
+class ConditionStage : public ModemStage
+{
+private:
+	InputConditioner _conditioner;
+
+public:
+	InputConditioner& getConditioner()
+	{
+		return _conditioner;
+	}
+
+	template<typename Next>
+	inline void process(int sampleVal, Next& next)
+	{
+		next.process(_conditioner.processSample(sampleVal));
+	}
+};
+
+// Highpass filter, rectifier and envelope follower - same as FSKDemod
+class HighpassEnvelopeStage : public ModemStage
+{
+private:
+	static const int FILTER_INT_MULT = 100;
+	static const int FILTER_GAIN = 4;
+	static const int FILTER_PARAM_1 = int(0.0562 * FILTER_INT_MULT + 0.5);
+	static const int FILTER_PARAM_2 = int(-0.4217 * FILTER_INT_MULT + 0.5);
+	static const int FILTER_PARAM_3 = int(0.5772 * FILTER_INT_MULT + 0.5);
+	int _xv0, _xv1, _xv2;
+	int _yv0, _yv1, _yv2;
+	int _envelope;
+	int _envelopePercent;
+
+public:
+	HighpassEnvelopeStage()
+	{
+		_xv0 = _xv1 = _xv2 = 0;
+		_yv0 = _yv1 = _yv2 = 0;
+		_envelope = 0;
+		_envelopePercent = FSKDemodParams().envelopePercent;
+	}
+
+	void setup(int, int, int, int, bool, const FSKDemodParams& params)
+	{
+		if (params.isValid())
+			_envelopePercent = params.envelopePercent;
+	}
+
+	template<typename Next>
+	inline void process(int sampleVal, Next& next)
+	{
+		int xv3 = (sampleVal * FILTER_INT_MULT) / FILTER_GAIN;
+		int yv3 = (xv3 - _xv0) + 3 * (_xv1 - _xv2) +
+					(FILTER_PARAM_1 * _yv0) + (FILTER_PARAM_2 * _yv1) + (FILTER_PARAM_3 * _yv2);
+		yv3 = yv3 / FILTER_INT_MULT;
+		_xv0 = _xv1;
+		_xv1 = _xv2;
+		_xv2 = xv3;
+		_yv0 = _yv1;
+		_yv1 = _yv2;
+		_yv2 = yv3;
+		int outVal = (yv3 < 0) ? -yv3 : yv3;
+		_envelope += ((outVal - _envelope) * _envelopePercent) / FILTER_INT_MULT;
+		next.process(_envelope);
+	}
+};
+
+// Preamble and sync word detector - a sync event is sent ahead of the envelope sample
+// at which the sync word is found unless the following stages are in a frame
+class SyncDetectStage : public ModemStage
+{
+private:
+	PreambleDetector _preambleDetector;
+	bool _enabled;
+	int _samplesPerSymbol;
+	uint32_t _sampleCount;
+	int _syncDetectCount;
+
+public:
+	// If pStorage is supplied it must hold PreambleDetector::STORAGE_LEN ints
+	SyncDetectStage(int* pStorage = NULL) : _preambleDetector(pStorage)
+	{
+		_enabled = false;
+		_samplesPerSymbol = 1;
+		_sampleCount = 0;
+		_syncDetectCount = 0;
+	}
+
+	void setup(int sampleRate, int symbolRate, int, int, bool, const FSKDemodParams&)
+	{
+		_samplesPerSymbol = sampleRate / symbolRate;
+	}
+
+	void enableSyncDetector(uint32_t syncWord, int syncWordBits, int preambleBits)
+	{
+		_preambleDetector.setup(_samplesPerSymbol, FSKDemod::syncTemplateBits(syncWord, preambleBits),
+					preambleBits + syncWordBits, syncWordBits);
+		_enabled = true;
+	}
+
+	int getSyncDetectCount()
+	{
+		return _syncDetectCount;
+	}
+
+	template<typename Next>
+	inline void process(int envelopeVal, Next& next)
+	{
+		if (_enabled)
+		{
+			PreambleDetector::DetectResult detectResult;
+			if (_preambleDetector.processSample(envelopeVal, _sampleCount, detectResult) && !next.inFrame())
+			{
+				_syncDetectCount++;
+				next.sync(detectResult);
+			}
+		}
+		_sampleCount++;
+		next.process(envelopeVal);
+	}
+};
+
+// Slicer - the envelope is compared with the mid point of the peak followers and the
+// level changes when numVotingSamples slicer outputs agree
+// A sync event sets the peak followers from the preamble
+class SlicerStage : public ModemStage
+{
+private:
+	int _signalHigh;
+	int _signalLow;
+	int _prevEnvelope;
+	bool _levelsFromSync;
+	int _peakFollowPer10K;
+	int _peakRestPer10K;
+	uint8_t _voteHistory;
+	uint8_t _voteMask;
+	int _signalLevel;
+
+public:
+	SlicerStage()
+	{
+		_signalHigh = 0;
+		_signalLow = 32767;
+		_prevEnvelope = 0;
+		_levelsFromSync = false;
+		_voteHistory = 0;
+		_signalLevel = 0;
+		setParams(FSKDemodParams());
+	}
+
+	void setup(int, int, int, int, bool, const FSKDemodParams& params)
+	{
+		if (params.isValid())
+			setParams(params);
+	}
+
+	void setParams(const FSKDemodParams& params)
+	{
+		_peakFollowPer10K = params.peakFollowPer10K;
+		_peakRestPer10K = params.peakRestPer10K;
+		_voteMask = (1 << params.numVotingSamples) - 1;
+	}
+
+	template<typename Next>
+	void sync(const PreambleDetector::DetectResult& result, Next& next)
+	{
+		_signalHigh = result.signalHigh;
+		_signalLow = result.signalLow;
+		_levelsFromSync = true;
+		next.sync(result);
+	}
+
+	template<typename Next>
+	inline void process(int envelopeVal, Next& next)
+	{
+		// Peak followers use the envelope before this sample (and are replaced by a sync)
+		if (!_levelsFromSync)
+		{
+			int highDiff = _prevEnvelope - _signalHigh;
+			_signalHigh += (highDiff * ((highDiff > 0) ? _peakFollowPer10K : _peakRestPer10K)) / 10000;
+			int lowDiff = _prevEnvelope - _signalLow;
+			_signalLow += (lowDiff * ((lowDiff < 0) ? _peakFollowPer10K : _peakRestPer10K)) / 10000;
+		}
+		_levelsFromSync = false;
+		_prevEnvelope = envelopeVal;
+
+		// Slice and vote
+		uint8_t instVal = envelopeVal > (_signalHigh + _signalLow) / 2;
+		_voteHistory = ((_voteHistory << 1) | instVal) & _voteMask;
+		if (_voteHistory == 0)
+			_signalLevel = 0;
+		else if (_voteHistory == _voteMask)
+			_signalLevel = 1;
+		next.process(_signalLevel);
+	}
+};
+
+// Clock recovery - passes on the level once per symbol at the sampling point
+// A sync event sets the symbol timing
+class ClockRecoveryStage : public ModemStage
+{
+private:
+	ClockRecovery _clockRecovery;
+
+public:
+	void setup(int sampleRate, int symbolRate, int, int, bool manchesterCodec,
+				const FSKDemodParams& params)
+	{
+		_clockRecovery.setup(sampleRate / symbolRate, manchesterCodec,
+					params.isValid() ? params : FSKDemodParams());
+	}
+
+	template<typename Next>
+	void sync(const PreambleDetector::DetectResult& result, Next& next)
+	{
+		_clockRecovery.setSymbolTiming(result.symbolEdgeSampleCount);
+		next.sync(result);
+	}
+
+	template<typename Next>
+	inline void process(int signalLevel, Next& next)
+	{
+		if (_clockRecovery.newSample(signalLevel))
+			next.process(signalLevel);
+	}
+};
+
+// Manchester line decoder - symbols are sampled just beyond the centre transition
+// so the bit is the inverse of the level
+class ManchesterDecodeStage : public ModemStage
+{
+public:
+	template<typename Next>
+	inline void process(int symbolVal, Next& next)
+	{
+		next.process(symbolVal ? 0 : 1);
+	}
+};
+
+// Deframers - on a sync event the sync word bits are regenerated (as FSKDemod does)
+// so the framer sees the complete sync word
+// Frames are up to MAX_FRAME_LEN bytes (for HDLC this includes the CRC)
+template<int MAX_FRAME_LEN = 258>
+class HdlcDeframerStage : public ModemStage
+{
+private:
+	uint8_t _rxBuffer[MAX_FRAME_LEN + 1];
+	MiniHDLC _hdlc;
+	const uint8_t* _pRxFrame;
+	int _rxFrameLen;
+	uint32_t _syncWord;
+	int _syncWordBits;
+
+public:
+	HdlcDeframerStage() :
+		_hdlc(NULL, [this](const uint8_t* pFrame, int frameLen) { _pRxFrame = pFrame; _rxFrameLen = frameLen; },
+					true, true, MAX_FRAME_LEN, _rxBuffer)
+	{
+		_pRxFrame = NULL;
+		_rxFrameLen = 0;
+		_syncWord = 0;
+		_syncWordBits = 0;
+	}
+
+	// The framer (for address filtering, repeat combining and error correction)
+	MiniHDLC& getFramer()
+	{
+		return _hdlc;
+	}
+
+	void enableSyncDetector(uint32_t syncWord, int syncWordBits, int)
+	{
+		_syncWord = syncWord;
+		_syncWordBits = syncWordBits;
+	}
+
+	template<typename Next>
+	void sync(const PreambleDetector::DetectResult& result, Next& next)
+	{
+		for (int i = 0; i < _syncWordBits; i++)
+			handleBit((_syncWord >> i) & 0x01, next);
+		next.sync(result);
+	}
+
+	template<typename Next>
+	inline void process(int bitVal, Next& next)
+	{
+		handleBit(bitVal, next);
+	}
+
+private:
+	template<typename Next>
+	inline void handleBit(int bitVal, Next& next)
+	{
+		_hdlc.handleBit(bitVal);
+		if (!_pRxFrame)
+			return;
+		const uint8_t* pFrame = _pRxFrame;
+		_pRxFrame = NULL;
+		next.frame(pFrame, _rxFrameLen);
+	}
+};
+
+template<int MAX_PAYLOAD_LEN = SyncFramer::MAX_PAYLOAD_LEN>
+class SyncDeframerStage : public ModemStage
+{
+private:
+	uint8_t _rxBuffer[MAX_PAYLOAD_LEN + 1];
+	SyncFramer _syncFramer;
+	const uint8_t* _pRxFrame;
+	int _rxFrameLen;
+	uint32_t _syncWord;
+	int _syncWordBits;
+
+public:
+	SyncDeframerStage() :
+		_syncFramer([this](const uint8_t* pFrame, int frameLen) { _pRxFrame = pFrame; _rxFrameLen = frameLen; },
+					MAX_PAYLOAD_LEN, SyncFramer::DEFAULT_SYNC_WORD, _rxBuffer)
+	{
+		_pRxFrame = NULL;
+		_rxFrameLen = 0;
+		_syncWord = 0;
+		_syncWordBits = 0;
+	}
+
+	// The framer (for address filtering)
+	SyncFramer& getFramer()
+	{
+		return _syncFramer;
+	}
+
+	void enableSyncDetector(uint32_t syncWord, int syncWordBits, int)
+	{
+		_syncWord = syncWord;
+		_syncWordBits = syncWordBits;
+	}
+
+	// The sync word can occur in the payload so sync detection is held during a frame
+	template<typename Next>
+	bool inFrame(Next&)
+	{
+		return _syncFramer.isRxInFrame();
+	}
+
+	template<typename Next>
+	void sync(const PreambleDetector::DetectResult& result, Next& next)
+	{
+		for (int i = 0; i < _syncWordBits; i++)
+			handleBit((_syncWord >> i) & 0x01, next);
+		next.sync(result);
+	}
+
+	template<typename Next>
+	inline void process(int bitVal, Next& next)
+	{
+		handleBit(bitVal, next);
+	}
+
+private:
+	template<typename Next>
+	inline void handleBit(int bitVal, Next& next)
+	{
+		_syncFramer.handleBit(bitVal);
+		if (!_pRxFrame)
+			return;
+		const uint8_t* pFrame = _pRxFrame;
+		_pRxFrame = NULL;
+		next.frame(pFrame, _rxFrameLen);
+	}
+};
+
+// Frame sink - the latest frame (null terminated) is kept until cleared and frames
+// received in the meantime are counted but dropped (as SpeakUp)
+template<int MAX_FRAME_LEN = 256>
+class FrameSinkStage : public ModemStage
+{
+private:
+	uint8_t _frame[MAX_FRAME_LEN + 1];
+	int _frameLen;
+	bool _ready;
+	int _frameCount;
+
+public:
+	FrameSinkStage()
+	{
+		_frameLen = 0;
+		_ready = false;
+		_frameCount = 0;
+	}
+
+	// Nothing other than frames passes the sink
+	template<typename Next>
+	inline void process(int val, Next& next)
+	{
+	}
+
+	template<typename Next>
+	void frame(const uint8_t* pFrame, int frameLen, Next&)
+	{
+		_frameCount++;
+		if (_ready || (frameLen > MAX_FRAME_LEN))
+			return;
+		memcpy(_frame, pFrame, frameLen);
+		_frame[frameLen] = 0;
+		_frameLen = frameLen;
+		_ready = true;
+	}
+
+	// Get the latest frame if available - it remains valid until clearFrame()
+	bool getFrame(const uint8_t*& pFrame, int& frameLen)
+	{
+		if (!_ready)
+			return false;
+		pFrame = _frame;
+		frameLen = _frameLen;
+		return true;
+	}
+
+	void clearFrame()
+	{
+		_ready = false;
+	}
+
+	// Frames received (including any dropped)
+	int getFrameCount()
+	{
+		return _frameCount;
+	}
+};
@@ -0,0 +1,196 @@
+// MultiStreamDecoder
+// Decodes many independent audio streams at once on a pool of worker threads
+
+#ifndef ARDUINO
+
+#include "MultiStreamDecoder.h"
+#include "SpeakUp.h"
+#include <new>
+
+MultiStreamDecoder::StreamState::StreamState(int streamId, MultiStreamDecoder* pDecoder, Arena& arena,
+			int queueLen, int maxFrameLen) :
+	fskDemod(DEMOD_FIFO_LEN, arena.allocateArray<uint32_t>(SymbolFifo::storageWordsFor(DEMOD_FIFO_LEN, 1)),
+			arena.allocateArray<int>(PreambleDetector::STORAGE_LEN)),
+	hdlc(NULL,
+			[pDecoder, streamId](const uint8_t* pFrame, int frameLen) { pDecoder->_frameRxFn(streamId, pFrame, frameLen); },
+			true, true, maxFrameLen, arena.allocateArray<uint8_t>(maxFrameLen + 1)),
+	queuePosn(queueLen + 1)
+{
+	pQueue = arena.allocateArray<int16_t>(queueLen + 1);
+	samplesProcessed = 0;
+	SpeakUp::setupDemod(fskDemod);
+}
+
+MultiStreamDecoder::MultiStreamDecoder(int numStreams, int numThreads, MultiStreamFrameRxFnType frameRxFn,
+			int inputQueueLen, int maxFrameLen)
+{
+	_frameRxFn = frameRxFn;
+	_roundNumber = 0;
+	_stopping = false;
+	_batchesLeft = 0;
+	_stealCount = 0;
+
+	// Streams
+	_streams.resize(numStreams);
+	for (int i = 0; i < numStreams; i++)
+	{
+		void* pMem = _arena.allocate(sizeof(StreamState), alignof(StreamState));
+		_streams[i] = new (pMem) StreamState(i, this, _arena, inputQueueLen, maxFrameLen);
+	}
+
+	// Workers
+	if (numThreads <= 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads <= 0)
+		numThreads = 1;
+	_workerQueues = std::vector<WorkerQueue>(numThreads);
+	for (int i = 0; i < numThreads; i++)
+		_workers.push_back(std::thread(&MultiStreamDecoder::workerLoop, this, i));
+}
+
+MultiStreamDecoder::~MultiStreamDecoder()
+{
+	{
+		std::lock_guard<std::mutex> lock(_roundLock);
+		_stopping = true;
+	}
+	_roundStartCV.notify_all();
+	for (size_t i = 0; i < _workers.size(); i++)
+		_workers[i].join();
+	for (size_t i = 0; i < _streams.size(); i++)
+		_streams[i]->~StreamState();
+}
+
+int MultiStreamDecoder::pushSamples(int streamId, const int16_t* pSamples, int numSamples)
+{
+	if ((streamId < 0) || (streamId >= (int)_streams.size()))
+		return 0;
+	StreamState& stream = *_streams[streamId];
+	int space = stream.queuePosn.space();
+	if (numSamples > space)
+		numSamples = space;
+	for (int i = 0; i < numSamples; i++)
+	{
+		stream.pQueue[stream.queuePosn.posToPut()] = pSamples[i];
+		stream.queuePosn.hasPut();
+	}
+	return numSamples;
+}
+
+void MultiStreamDecoder::process()
+{
+	// Deal batches out to the workers
+	int numBatches = (_streams.size() + STREAMS_PER_BATCH - 1) / STREAMS_PER_BATCH;
+	if (numBatches == 0)
+		return;
+	_batchesLeft = numBatches;
+	int numWorkers = _workerQueues.size();
+	for (int i = 0; i < numBatches; i++)
+	{
+		WorkerQueue& workerQueue = _workerQueues[i % numWorkers];
+		std::lock_guard<std::mutex> lock(workerQueue.lock);
+		workerQueue.batches.push_back(i);
+	}
+
+	// Start and wait until all are done
+	std::unique_lock<std::mutex> lock(_roundLock);
+	_roundNumber++;
+	_roundStartCV.notify_all();
+	_roundDoneCV.wait(lock, [this] { return _batchesLeft == 0; });
+}
+
+uint64_t MultiStreamDecoder::getSamplesProcessed()
+{
+	uint64_t total = 0;
+	for (size_t i = 0; i < _streams.size(); i++)
+		total += _streams[i]->samplesProcessed;
+	return total;
+}
+
+void MultiStreamDecoder::workerLoop(int workerIdx)
+{
+	uint32_t lastRound = 0;
+	while (true)
+	{
+		// Wait for a round
+		{
+			std::unique_lock<std::mutex> lock(_roundLock);
+			_roundStartCV.wait(lock, [this, lastRound] { return _stopping || (_roundNumber != lastRound); });
+			if (_stopping)
+				return;
+			lastRound = _roundNumber;
+		}
+
+		// Process batches until there are none left to take
+		int batchIdx = 0;
+		while (getBatch(workerIdx, batchIdx))
+		{
+			processBatch(batchIdx);
+			if (--_batchesLeft == 0)
+			{
+				std::lock_guard<std::mutex> lock(_roundLock);
+				_roundDoneCV.notify_all();
+			}
+		}
+	}
+}
+
+bool MultiStreamDecoder::getBatch(int workerIdx, int& batchIdx)
+{
+	// Own queue first
+	{
+		WorkerQueue& ownQueue = _workerQueues[workerIdx];
+		std::lock_guard<std::mutex> lock(ownQueue.lock);
+		if (!ownQueue.batches.empty())
+		{
+			batchIdx = ownQueue.batches.front();
+			ownQueue.batches.pop_front();
+			return true;
+		}
+	}
+
+	// Steal from the back of another queue
+	int numWorkers = _workerQueues.size();
+	for (int i = 1; i < numWorkers; i++)
+	{
+		WorkerQueue& otherQueue = _workerQueues[(workerIdx + i) % numWorkers];
+		std::lock_guard<std::mutex> lock(otherQueue.lock);
+		if (!otherQueue.batches.empty())
+		{
+			batchIdx = otherQueue.batches.back();
+			otherQueue.batches.pop_back();
+			_stealCount++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void MultiStreamDecoder::processBatch(int batchIdx)
+{
+	int firstStream = batchIdx * STREAMS_PER_BATCH;
+	int endStream = firstStream + STREAMS_PER_BATCH;
+	if (endStream > (int)_streams.size())
+		endStream = _streams.size();
+	for (int i = firstStream; i < endStream; i++)
+		processStream(*_streams[i]);
+}
+
+void MultiStreamDecoder::processStream(StreamState& stream)
+{
+	int numSamples = stream.queuePosn.count();
+	for (int i = 0; i < numSamples; i++)
+	{
+		stream.fskDemod.processSample(stream.pQueue[stream.queuePosn.posToGet()]);
+		stream.queuePosn.hasGot();
+
+		// Pass bits to HDLC
+		uint32_t rxBits = 0;
+		int numBits = stream.fskDemod.getRxBits(rxBits, 32);
+		if (numBits > 0)
+			stream.hdlc.handleBits(rxBits, numBits);
+	}
+	stream.samplesProcessed += numSamples;
+}
+
+#endif
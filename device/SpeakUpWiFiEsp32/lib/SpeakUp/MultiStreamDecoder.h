@@ -0,0 +1,122 @@
+// MultiStreamDecoder
+// Decodes many independent audio streams (at the modem sample rate) at once on a
+// pool of worker threads - for host test systems
+// Each stream has its own demodulator and HDLC decoder - their state and the
+// stream's input queue are allocated from an arena so adjacent streams are
+// adjacent in memory
+// Streams are grouped into batches and each batch is processed by one worker at a
+// time - a worker takes batches from the front of its own queue and when that is
+// empty steals from the back of another worker's queue
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include "Arena.h"
+#include "FSKDemod.h"
+#include "MiniHDLC.h"
+#include "RingBufferPosn.h"
+
+// Received frame callback function type
+typedef std::function<void(int streamId, const uint8_t* pFrame, int frameLen)> MultiStreamFrameRxFnType;
+
+class MultiStreamDecoder
+{
+public:
+	static const int DEFAULT_INPUT_QUEUE_LEN = 1024;
+	static const int DEFAULT_MAX_FRAME_LEN = 256;
+	static const int STREAMS_PER_BATCH = 16;
+
+private:
+	// Bits are passed from the demodulator to HDLC after every sample so only a
+	// few need to be held
+	static const int DEMOD_FIFO_LEN = 64;
+
+	// Per stream state - constructed in the arena
+	class StreamState
+	{
+	public:
+		FSKDemod fskDemod;
+		MiniHDLC hdlc;
+		int16_t* pQueue;
+		RingBufferPosn queuePosn;
+		uint64_t samplesProcessed;
+		StreamState(int streamId, MultiStreamDecoder* pDecoder, Arena& arena, int queueLen, int maxFrameLen);
+	};
+	Arena _arena;
+	std::vector<StreamState*> _streams;
+	MultiStreamFrameRxFnType _frameRxFn;
+
+	// Worker queues of batch numbers
+	class WorkerQueue
+	{
+	public:
+		std::mutex lock;
+		std::deque<int> batches;
+	};
+	std::vector<WorkerQueue> _workerQueues;
+	std::vector<std::thread> _workers;
+
+	// Rounds of processing are started by process()
+	std::mutex _roundLock;
+	std::condition_variable _roundStartCV;
+	std::condition_variable _roundDoneCV;
+	uint32_t _roundNumber;
+	bool _stopping;
+	std::atomic<int> _batchesLeft;
+	std::atomic<uint32_t> _stealCount;
+
+public:
+	// The frame callback is called from worker threads - it may be called for
+	// different streams at the same time but not for the same stream
+	// numThreads of 0 uses one thread per core
+	MultiStreamDecoder(int numStreams, int numThreads, MultiStreamFrameRxFnType frameRxFn,
+				int inputQueueLen = DEFAULT_INPUT_QUEUE_LEN, int maxFrameLen = DEFAULT_MAX_FRAME_LEN);
+	~MultiStreamDecoder();
+
+	int getNumStreams()
+	{
+		return _streams.size();
+	}
+	int getNumThreads()
+	{
+		return _workers.size();
+	}
+
+	// Queue samples for a stream - returns the number accepted (limited by the space
+	// in the stream's queue) - must not be called while process() is running
+	int pushSamples(int streamId, const int16_t* pSamples, int numSamples);
+
+	// Decode all queued samples using the worker threads - returns when done
+	void process();
+
+	// Stats
+	uint64_t getSamplesProcessed();
+	uint32_t getStealCount()
+	{
+		return _stealCount;
+	}
+	size_t getArenaBytes()
+	{
+		return _arena.getBytesReserved();
+	}
+
+private:
+	void workerLoop(int workerIdx);
+	bool getBatch(int workerIdx, int& batchIdx);
+	void processBatch(int batchIdx);
+	void processStream(StreamState& stream);
+
+	MultiStreamDecoder(const MultiStreamDecoder&);
+	MultiStreamDecoder& operator=(const MultiStreamDecoder&);
+};
+
+#endif
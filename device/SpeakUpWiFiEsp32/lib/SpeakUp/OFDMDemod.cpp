@@ -0,0 +1,310 @@
+// OFDMDemod
+// Multi-carrier (OFDM) demodulator
+
+#include "OFDMDemod.h"
+#include "FixedFFT.h"
+#include <string.h>
+#include <cmath>
+
+OFDMDemod::OFDMDemod(int rxFifoLen, uint32_t* pFifoStorage) : _rxBitFifo(rxFifoLen, 1, pFifoStorage)
+{
+	_carrierModulation = OFDMMod::OFDM_QPSK;
+	_firstBin = 0;
+	_lastBin = -1;
+	memset(_hist, 0, sizeof(_hist));
+	_histPos = 0;
+	_corr = 0;
+	_energy = 0;
+	_lockCount = 0;
+	_symbolCount = 0;
+	restartSearch();
+}
+
+bool OFDMDemod::setup(int sampleRate, int freqLow, int freqHigh, OFDMMod::CarrierModulation carrierModulation)
+{
+	if (!OFDMMod::binRange(sampleRate, freqLow, freqHigh, _firstBin, _lastBin))
+	{
+		_lastBin = -1;
+		return false;
+	}
+	_carrierModulation = carrierModulation;
+	memset(_hist, 0, sizeof(_hist));
+	_histPos = 0;
+	_corr = 0;
+	_energy = 0;
+	restartSearch();
+	return true;
+}
+
+void OFDMDemod::restartSearch()
+{
+	_rxState = RX_SEARCH;
+	_inPlateau = false;
+	_plateauLen = 0;
+	_plateauAboveLen = 0;
+	_samplesToWindowEnd = 0;
+	_weakCount = 0;
+	_phase = 0;
+	_phaseSlope = 0;
+}
+
+void OFDMDemod::processSample(int sampleVal)
+{
+	if (_lastBin < 0)
+		return;
+	if (sampleVal > 32767)
+		sampleVal = 32767;
+	else if (sampleVal < -32768)
+		sampleVal = -32768;
+	updateSyncMetric(sampleVal);
+
+	// Wait for the end of the next FFT window
+	if (_rxState != RX_SEARCH)
+	{
+		if (--_samplesToWindowEnd > 0)
+			return;
+		_samplesToWindowEnd = OFDMMod::SYMBOL_LEN;
+		int32_t re[FFT_SIZE];
+		int32_t im[FFT_SIZE];
+		transformWindow(re, im);
+		if (_rxState == RX_DATA)
+		{
+			processData(re, im);
+			return;
+		}
+		if (!processTraining(re, im))
+		{
+			restartSearch();
+			return;
+		}
+		_rxState = RX_DATA;
+		_lockCount++;
+		return;
+	}
+
+	// Search for the plateau of the sync metric - it starts above the start threshold
+	// and ends when it drops below the end threshold
+	bool aboveStart = (_energy >= SYNC_MIN_ENERGY) && (_corr * 16 > _energy * SYNC_START_RATIO_16THS);
+	if (!_inPlateau)
+	{
+		if (aboveStart)
+		{
+			_inPlateau = true;
+			_plateauLen = 1;
+			_plateauAboveLen = 1;
+		}
+		return;
+	}
+	_plateauLen++;
+	if (aboveStart)
+		_plateauAboveLen = _plateauLen;
+	bool belowEnd = (_energy < SYNC_MIN_ENERGY) || (_corr * 16 < _energy * SYNC_END_RATIO_16THS);
+	if (!belowEnd)
+		return;
+	_inPlateau = false;
+
+	// The plateau is centred on the window which starts half way into the prefix of
+	// the sync symbol
+	if ((_plateauAboveLen < SYNC_MIN_PLATEAU_LEN) || (_plateauAboveLen > SYNC_MAX_PLATEAU_LEN))
+		return;
+	int samplesSinceMiddle = _plateauLen - 1 - (_plateauAboveLen - 1) / 2;
+	_samplesToWindowEnd = OFDMMod::SYMBOL_LEN - samplesSinceMiddle;
+	_rxState = RX_TRAINING;
+}
+
+void OFDMDemod::updateSyncMetric(int sampleVal)
+{
+	// Correlation of the window's halves and energy of its second half are updated for the new sample
+	int64_t sample = sampleVal;
+	int64_t halfBack = _hist[(_histPos - HALF_LEN) & (HIST_LEN - 1)];
+	int64_t fullBack = _hist[(_histPos - FFT_SIZE) & (HIST_LEN - 1)];
+	_corr += halfBack * sample - fullBack * halfBack;
+	_energy += sample * sample - halfBack * halfBack;
+	_hist[_histPos] = sampleVal;
+	_histPos = (_histPos + 1) & (HIST_LEN - 1);
+}
+
+void OFDMDemod::transformWindow(int32_t* pRe, int32_t* pIm)
+{
+	for (int i = 0; i < FFT_SIZE; i++)
+	{
+		pRe[i] = (int32_t)_hist[(_histPos - FFT_SIZE + i) & (HIST_LEN - 1)] << FFT_INPUT_SHIFT;
+		pIm[i] = 0;
+	}
+	FixedFFT::transform(pRe, pIm, OFDMMod::FFT_LOG2_SIZE);
+}
+
+bool OFDMDemod::processTraining(const int32_t* pRe, const int32_t* pIm)
+{
+	// Channel is the received value over the known value
+	for (int bin = _firstBin; bin <= _lastBin; bin++)
+	{
+		int trainingVal = OFDMMod::trainingValue(bin);
+		_chanRe[bin] = (float)pRe[bin] * trainingVal;
+		_chanIm[bin] = (float)pIm[bin] * trainingVal;
+		_prevRe[bin] = (float)pRe[bin];
+		_prevIm[bin] = (float)pIm[bin];
+	}
+
+	// A real channel changes little between adjacent carriers (apart from a steady
+	// phase slope from the window position) while noise is random
+	float sumRe = 0;
+	float sumIm = 0;
+	float sumMag = 0;
+	for (int bin = _firstBin; bin < _lastBin; bin++)
+	{
+		sumRe += _chanRe[bin + 1] * _chanRe[bin] + _chanIm[bin + 1] * _chanIm[bin];
+		sumIm += _chanIm[bin + 1] * _chanRe[bin] - _chanRe[bin + 1] * _chanIm[bin];
+		sumMag += sqrtf((_chanRe[bin] * _chanRe[bin] + _chanIm[bin] * _chanIm[bin]) *
+					(_chanRe[bin + 1] * _chanRe[bin + 1] + _chanIm[bin + 1] * _chanIm[bin + 1]));
+	}
+	_phase = 0;
+	_phaseSlope = 0;
+	_weakCount = 0;
+	if ((sumMag <= 0) || (sqrtf(sumRe * sumRe + sumIm * sumIm) <= sumMag * MIN_CHANNEL_COHERENCE))
+		return false;
+
+	// Smooth the estimate with its neighbours (rotated by the slope) to reduce noise
+	float stepRe = sumRe / sqrtf(sumRe * sumRe + sumIm * sumIm);
+	float stepIm = sumIm / sqrtf(sumRe * sumRe + sumIm * sumIm);
+	float lastRe = _chanRe[_firstBin];
+	float lastIm = _chanIm[_firstBin];
+	for (int bin = _firstBin; bin <= _lastBin; bin++)
+	{
+		float thisRe = _chanRe[bin];
+		float thisIm = _chanIm[bin];
+		float nextRe = thisRe;
+		float nextIm = thisIm;
+		if (bin < _lastBin)
+		{
+			nextRe = _chanRe[bin + 1] * stepRe + _chanIm[bin + 1] * stepIm;
+			nextIm = _chanIm[bin + 1] * stepRe - _chanRe[bin + 1] * stepIm;
+		}
+		if (bin > _firstBin)
+		{
+			float prevRe = lastRe;
+			lastRe = lastRe * stepRe - lastIm * stepIm;
+			lastIm = prevRe * stepIm + lastIm * stepRe;
+		}
+		_chanRe[bin] = (lastRe + 2 * thisRe + nextRe) / 4;
+		_chanIm[bin] = (lastIm + 2 * thisIm + nextIm) / 4;
+		lastRe = thisRe;
+		lastIm = thisIm;
+	}
+	return true;
+}
+
+void OFDMDemod::processData(const int32_t* pRe, const int32_t* pIm)
+{
+	// Pilots relative to the channel and tracked phase
+	float centreBin = (_firstBin + _lastBin) / 2.0f;
+	float pilotRe[NUM_BINS / OFDMMod::PILOT_SPACING + 1];
+	float pilotIm[NUM_BINS / OFDMMod::PILOT_SPACING + 1];
+	int numPilots = 0;
+	for (int bin = _firstBin; bin <= _lastBin; bin += OFDMMod::PILOT_SPACING)
+	{
+		float rot = _phase + _phaseSlope * (bin - centreBin);
+		float refRe = _chanRe[bin] * cosf(rot) - _chanIm[bin] * sinf(rot);
+		float refIm = _chanRe[bin] * sinf(rot) + _chanIm[bin] * cosf(rot);
+		pilotRe[numPilots] = pRe[bin] * refRe + pIm[bin] * refIm;
+		pilotIm[numPilots] = pIm[bin] * refRe - pRe[bin] * refIm;
+		numPilots++;
+	}
+
+	// Phase slope error from the change between adjacent pilots then the common phase error
+	float sumRe = 0;
+	float sumIm = 0;
+	for (int i = 0; i + 1 < numPilots; i++)
+	{
+		sumRe += pilotRe[i + 1] * pilotRe[i] + pilotIm[i + 1] * pilotIm[i];
+		sumIm += pilotIm[i + 1] * pilotRe[i] - pilotRe[i + 1] * pilotIm[i];
+	}
+	float slopeError = atan2f(sumIm, sumRe) / OFDMMod::PILOT_SPACING;
+	sumRe = 0;
+	sumIm = 0;
+	float sumMag = 0;
+	for (int i = 0; i < numPilots; i++)
+	{
+		float rot = -slopeError * (_firstBin + i * OFDMMod::PILOT_SPACING - centreBin);
+		sumRe += pilotRe[i] * cosf(rot) - pilotIm[i] * sinf(rot);
+		sumIm += pilotRe[i] * sinf(rot) + pilotIm[i] * cosf(rot);
+		sumMag += sqrtf(pilotRe[i] * pilotRe[i] + pilotIm[i] * pilotIm[i]);
+	}
+
+	float phaseError = atan2f(sumIm, sumRe);
+
+	// Lost signal
+	_symbolCount++;
+	bool pilotsOk = (sumMag > 0) && (sqrtf(sumRe * sumRe + sumIm * sumIm) >= sumMag * MIN_PILOT_QUALITY);
+	if (pilotsOk)
+		_weakCount = 0;
+	else if (++_weakCount >= LOCK_LOST_SYMBOLS)
+	{
+		restartSearch();
+		return;
+	}
+
+	// Data carriers - QPSK against the channel corrected by this symbol's pilots,
+	// DBPSK against the previous symbol
+	float symbolPhase = pilotsOk ? _phase + phaseError : _phase;
+	float symbolSlope = pilotsOk ? _phaseSlope + slopeError : _phaseSlope;
+	for (int bin = _firstBin; bin <= _lastBin; bin++)
+	{
+		if (OFDMMod::isPilot(bin, _firstBin))
+			continue;
+		if (_carrierModulation == OFDMMod::OFDM_DBPSK)
+		{
+			float diffRe = pRe[bin] * _prevRe[bin] + pIm[bin] * _prevIm[bin];
+			_prevRe[bin] = (float)pRe[bin];
+			_prevIm[bin] = (float)pIm[bin];
+			_rxBitFifo.put(diffRe < 0 ? 1 : 0);
+			continue;
+		}
+		float rot = symbolPhase + symbolSlope * (bin - centreBin);
+		float refRe = _chanRe[bin] * cosf(rot) - _chanIm[bin] * sinf(rot);
+		float refIm = _chanRe[bin] * sinf(rot) + _chanIm[bin] * cosf(rot);
+		float valRe = pRe[bin] * refRe + pIm[bin] * refIm;
+		float valIm = pIm[bin] * refRe - pRe[bin] * refIm;
+		int scrambleBits = OFDMMod::scrambleBits(bin);
+		_rxBitFifo.put((valRe < 0 ? 1 : 0) ^ (scrambleBits & 0x01));
+		_rxBitFifo.put((valIm < 0 ? 1 : 0) ^ (scrambleBits >> 1));
+
+		// The channel estimate is refined from the decided value
+		if (!pilotsOk)
+			continue;
+		float decidedRe = (valRe < 0 ? -pRe[bin] : pRe[bin]) + (valIm < 0 ? -pIm[bin] : pIm[bin]);
+		float decidedIm = (valRe < 0 ? -pIm[bin] : pIm[bin]) - (valIm < 0 ? -pRe[bin] : pRe[bin]);
+		float measRe = (decidedRe * cosf(rot) + decidedIm * sinf(rot)) * (float)M_SQRT1_2;
+		float measIm = (decidedIm * cosf(rot) - decidedRe * sinf(rot)) * (float)M_SQRT1_2;
+		_chanRe[bin] += (measRe - _chanRe[bin]) * CHANNEL_TRACK_GAIN;
+		_chanIm[bin] += (measIm - _chanIm[bin]) * CHANNEL_TRACK_GAIN;
+	}
+
+	// The tracked phase predicts the next symbol
+	if (pilotsOk)
+	{
+		_phase += phaseError * PHASE_TRACK_GAIN;
+		_phaseSlope += slopeError * SLOPE_TRACK_GAIN;
+	}
+
+	// Timing drift shows as a phase slope - once it is a whole sample the window is
+	// moved and the slope (and the DBPSK reference) corrected to match
+	float sampleSlope = (float)(2 * M_PI / FFT_SIZE);
+	int windowShift = 0;
+	if (_phaseSlope > sampleSlope)
+		windowShift = -1;
+	else if (_phaseSlope < -sampleSlope)
+		windowShift = 1;
+	if (windowShift == 0)
+		return;
+	_samplesToWindowEnd += windowShift;
+	_phaseSlope += windowShift * sampleSlope;
+	_phase += windowShift * sampleSlope * centreBin;
+	for (int bin = _firstBin; bin <= _lastBin; bin++)
+	{
+		float rot = windowShift * sampleSlope * bin;
+		float prevRe = _prevRe[bin];
+		_prevRe[bin] = prevRe * cosf(rot) - _prevIm[bin] * sinf(rot);
+		_prevIm[bin] = prevRe * sinf(rot) + _prevIm[bin] * cosf(rot);
+	}
+}
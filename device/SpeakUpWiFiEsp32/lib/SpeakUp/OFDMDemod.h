@@ -0,0 +1,136 @@
+// OFDMDemod
+// Multi-carrier (OFDM) demodulator (for signals from OFDMMod)
+// The sync symbol is found with the Schmidl & Cox metric - the correlation between
+// the two halves of a symbol length window relative to the energy of the second
+// half - which is close to 1 while the window is within the sync symbol and its
+// cyclic prefix
+// FFT windows are then placed half way into the cyclic prefix so echoes and timing
+// drift of up to half the prefix don't spill between symbols
+// The training symbol gives the channel (gain and phase of each carrier) which the
+// pilots of each symbol then keep up to date (common phase and the phase slope
+// across carriers that comes from timing drift)
+// Per carrier work after the FFT is in floating point as there are only a few
+// dozen carriers per symbol
+
+#pragma once
+
+#include <stdint.h>
+#include "SymbolFifo.h"
+#include "OFDMMod.h"
+
+class OFDMDemod
+{
+private:
+	static const int FFT_SIZE = OFDMMod::FFT_SIZE;
+	static const int HALF_LEN = FFT_SIZE / 2;
+	static const int NUM_BINS = FFT_SIZE / 2;
+
+	// Settings
+	OFDMMod::CarrierModulation _carrierModulation;
+	int _firstBin;
+	int _lastBin;
+
+	// Input history (enough for the sync metric which needs two windows back)
+	static const int HIST_LEN = FFT_SIZE * 2;
+	int16_t _hist[HIST_LEN];
+	int _histPos;
+
+	// Sync metric - correlation between the halves and energy of the second half
+	// Thresholds are the ratio (corr / energy) as fractions of 16 - the plateau is
+	// widened by the ramps either side so it is up to SYNC_MAX_PLATEAU_LEN long
+	static const int SYNC_START_RATIO_16THS = 12;
+	static const int SYNC_END_RATIO_16THS = 8;
+	static const int SYNC_MIN_ENERGY = HALF_LEN * 32 * 32;
+	static const int SYNC_MIN_PLATEAU_LEN = OFDMMod::CYCLIC_PREFIX_LEN / 2;
+	static const int SYNC_MAX_PLATEAU_LEN = OFDMMod::CYCLIC_PREFIX_LEN * 3;
+	int64_t _corr;
+	int64_t _energy;
+	bool _inPlateau;
+	int _plateauLen;
+	int _plateauAboveLen;
+
+	// Samples are shifted up before the FFT to keep precision
+	static const int FFT_INPUT_SHIFT = 8;
+
+	// The training symbol is accepted if the channel varies smoothly between carriers
+	static constexpr float MIN_CHANNEL_COHERENCE = 0.5f;
+
+	// Lock is lost after this many symbols in a row with pilots that don't match
+	static constexpr float MIN_PILOT_QUALITY = 0.5f;
+	static const int LOCK_LOST_SYMBOLS = 2;
+
+	// Tracking - each symbol is corrected by its own pilots and these fractions of
+	// the correction are kept for the next symbol
+	static constexpr float PHASE_TRACK_GAIN = 0.5f;
+	static constexpr float SLOPE_TRACK_GAIN = 0.25f;
+
+	// QPSK channel estimates are updated from decided data by this fraction per symbol
+	static constexpr float CHANNEL_TRACK_GAIN = 0.125f;
+
+	// State
+	enum RxState
+	{
+		RX_SEARCH,
+		RX_TRAINING,
+		RX_DATA
+	};
+	RxState _rxState;
+	int _samplesToWindowEnd;
+	int _weakCount;
+	int _lockCount;
+	int _symbolCount;
+
+	// Channel estimate (and previous symbol for DBPSK) for each bin
+	float _chanRe[NUM_BINS];
+	float _chanIm[NUM_BINS];
+	float _prevRe[NUM_BINS];
+	float _prevIm[NUM_BINS];
+
+	// Tracked phase (radians) at the centre carrier and slope (radians per bin)
+	float _phase;
+	float _phaseSlope;
+
+	// Output bits
+	SymbolFifo _rxBitFifo;
+
+public:
+	// Constructor - the received bit FIFO can use external storage
+	// (SymbolFifo::storageWordsFor(rxFifoLen, 1) words)
+	OFDMDemod(int rxFifoLen, uint32_t* pFifoStorage = NULL);
+
+	// Setup - must match the modulator - returns false if not supported
+	bool setup(int sampleRate, int freqLow, int freqHigh, OFDMMod::CarrierModulation carrierModulation);
+
+	// Search for a new sync symbol (e.g. once a complete frame has been received)
+	void restartSearch();
+
+	// Process a single sample
+	void processSample(int sampleVal);
+
+	// Get up to maxBits (at most 32) received bits - the first received is in the LSB
+	// Returns the number of bits got
+	int getRxBits(uint32_t& bits, int maxBits)
+	{
+		return _rxBitFifo.getSymbols(bits, maxBits);
+	}
+
+	// Status
+	bool isLocked()
+	{
+		return _rxState == RX_DATA;
+	}
+	int getLockCount()
+	{
+		return _lockCount;
+	}
+	int getSymbolCount()
+	{
+		return _symbolCount;
+	}
+
+private:
+	void updateSyncMetric(int sampleVal);
+	void transformWindow(int32_t* pRe, int32_t* pIm);
+	bool processTraining(const int32_t* pRe, const int32_t* pIm);
+	void processData(const int32_t* pRe, const int32_t* pIm);
+};
@@ -0,0 +1,151 @@
+// OFDMMod
+// Multi-carrier (OFDM) modulator
+
+#include "OFDMMod.h"
+#include "FixedFFT.h"
+#include <string.h>
+
+OFDMMod::OFDMMod()
+{
+	_carrierModulation = OFDM_QPSK;
+	_firstBin = 0;
+	_lastBin = -1;
+	_bitsPerSymbol = 0;
+	_symbolPos = 0;
+	_generatorBusy = false;
+	memset(_carrierPhase, 0, sizeof(_carrierPhase));
+	_streamPreambleLeft = 0;
+	_streamSourceActive = false;
+}
+
+bool OFDMMod::binRange(int sampleRate, int freqLow, int freqHigh, int& firstBin, int& lastBin)
+{
+	if ((sampleRate <= 0) || (freqLow <= 0) || (freqHigh <= freqLow))
+		return false;
+	firstBin = (freqLow * FFT_SIZE + sampleRate - 1) / sampleRate;
+	lastBin = freqHigh * FFT_SIZE / sampleRate;
+	return (lastBin < FFT_SIZE / 2) && (lastBin - firstBin + 1 >= MIN_CARRIERS);
+}
+
+bool OFDMMod::setup(int sampleRate, int freqLow, int freqHigh, CarrierModulation carrierModulation)
+{
+	if (!binRange(sampleRate, freqLow, freqHigh, _firstBin, _lastBin))
+		return false;
+	_carrierModulation = carrierModulation;
+	int numCarriers = _lastBin - _firstBin + 1;
+	int numData = numCarriers - (numCarriers + PILOT_SPACING - 1) / PILOT_SPACING;
+	_bitsPerSymbol = (carrierModulation == OFDM_QPSK) ? numData * 2 : numData;
+	clear();
+	return true;
+}
+
+void OFDMMod::startStream()
+{
+	_streamPreambleLeft = 2;
+	_streamSourceActive = true;
+}
+
+void OFDMMod::clear()
+{
+	_streamPreambleLeft = 0;
+	_streamSourceActive = false;
+	_generatorBusy = false;
+}
+
+bool OFDMMod::getSample(int& sampleValue)
+{
+	if (!_generatorBusy)
+	{
+		int32_t re[FFT_SIZE];
+		int32_t im[FFT_SIZE];
+		memset(re, 0, sizeof(re));
+		memset(im, 0, sizeof(im));
+
+		// Sync symbol then training symbol then data
+		if (_streamPreambleLeft == 2)
+		{
+			// Even bins only - scaled up to keep the power of the other symbols
+			for (int bin = _firstBin; bin <= _lastBin; bin++)
+				re[bin] = syncValue(bin) * CARRIER_AMPLITUDE * 181 / 128;
+			_streamPreambleLeft--;
+		}
+		else if (_streamPreambleLeft == 1)
+		{
+			for (int bin = _firstBin; bin <= _lastBin; bin++)
+			{
+				re[bin] = trainingValue(bin) * CARRIER_AMPLITUDE;
+				_carrierPhase[bin] = trainingValue(bin) > 0 ? 0 : 2;
+			}
+			_streamPreambleLeft--;
+		}
+		else if (!makeDataSymbol(re, im))
+			return false;
+		makeSymbol(re, im);
+		_symbolPos = 0;
+		_generatorBusy = true;
+	}
+
+	sampleValue = _symbol[_symbolPos];
+	if (++_symbolPos >= SYMBOL_LEN)
+		_generatorBusy = false;
+	return true;
+}
+
+bool OFDMMod::makeDataSymbol(int32_t* pRe, int32_t* pIm)
+{
+	if (!_streamSourceActive)
+		return false;
+
+	// Bits from the source - the last symbol is padded with 0s
+	int numBits = 0;
+	for (int bin = _firstBin; bin <= _lastBin; bin++)
+	{
+		if (isPilot(bin, _firstBin))
+		{
+			pRe[bin] = CARRIER_AMPLITUDE;
+			continue;
+		}
+		int bits[2] = { 0, 0 };
+		int bitsPerCarrier = (_carrierModulation == OFDM_QPSK) ? 2 : 1;
+		for (int i = 0; i < bitsPerCarrier; i++)
+		{
+			if (_streamSourceActive && _bitSourceFn && _bitSourceFn(bits[i]))
+				numBits++;
+			else
+				_streamSourceActive = false;
+		}
+
+		// QPSK - the first bit is the sign of the real part (Gray coded)
+		if (_carrierModulation == OFDM_QPSK)
+		{
+			bits[0] ^= scrambleBits(bin) & 0x01;
+			bits[1] ^= scrambleBits(bin) >> 1;
+			pRe[bin] = (bits[0] & 0x01) ? -CARRIER_AMPLITUDE * 181 / 256 : CARRIER_AMPLITUDE * 181 / 256;
+			pIm[bin] = (bits[1] & 0x01) ? -CARRIER_AMPLITUDE * 181 / 256 : CARRIER_AMPLITUDE * 181 / 256;
+			continue;
+		}
+
+		// DBPSK - a 1 reverses the phase
+		if (bits[0] & 0x01)
+			_carrierPhase[bin] ^= 2;
+		pRe[bin] = _carrierPhase[bin] ? -CARRIER_AMPLITUDE : CARRIER_AMPLITUDE;
+	}
+	return numBits > 0;
+}
+
+void OFDMMod::makeSymbol(int32_t* pRe, int32_t* pIm)
+{
+	// Only positive frequencies are set so the real part of the inverse FFT is the
+	// signal (at half the amplitude)
+	FixedFFT::transform(pRe, pIm, FFT_LOG2_SIZE, true);
+	for (int i = 0; i < FFT_SIZE; i++)
+	{
+		int32_t sampleVal = pRe[i];
+		if (sampleVal > 32767)
+			sampleVal = 32767;
+		else if (sampleVal < -32767)
+			sampleVal = -32767;
+		_symbol[CYCLIC_PREFIX_LEN + i] = sampleVal;
+	}
+	memcpy(_symbol, _symbol + FFT_SIZE, CYCLIC_PREFIX_LEN * sizeof(_symbol[0]));
+}
@@ -0,0 +1,120 @@
+// OFDMMod
+// Multi-carrier (OFDM) modulator for high throughput
+// Each symbol is FFT_SIZE samples made by an inverse FFT of the carriers between
+// freqLow and freqHigh plus a cyclic prefix (a copy of its end) which absorbs
+// echoes and timing error - with 8000 samples/s carriers are 62.5Hz apart and
+// there are 50 symbols per second
+// Every PILOT_SPACING'th carrier is a pilot (fixed value) that the receiver uses to
+// track phase - the others carry 2 bits (QPSK) or 1 bit (DBPSK - by the change of
+// phase from the previous symbol which needs no channel estimate)
+// A transmission starts with a sync symbol (only even carriers so its two halves
+// are the same) which the receiver finds by correlation and a training symbol
+// (all carriers known) from which it estimates the channel
+
+#pragma once
+
+#include <stdint.h>
+#include "FSKMod.h"
+
+class OFDMMod
+{
+public:
+	enum CarrierModulation
+	{
+		OFDM_QPSK,
+		OFDM_DBPSK
+	};
+
+	// Symbol layout
+	static const int FFT_LOG2_SIZE = 7;
+	static const int FFT_SIZE = 1 << FFT_LOG2_SIZE;
+	static const int CYCLIC_PREFIX_LEN = 32;
+	static const int SYMBOL_LEN = FFT_SIZE + CYCLIC_PREFIX_LEN;
+	static const int PILOT_SPACING = 8;
+	static const int MIN_CARRIERS = PILOT_SPACING * 2 + 1;
+
+	// Amplitude of each carrier at the inverse FFT input - the output is clipped to
+	// 16 bits which only affects rare peaks
+	static const int CARRIER_AMPLITUDE = 1 << 17;
+
+private:
+	// Settings
+	CarrierModulation _carrierModulation;
+	int _firstBin;
+	int _lastBin;
+	int _bitsPerSymbol;
+
+	// Symbol being sent (cyclic prefix first)
+	int16_t _symbol[SYMBOL_LEN];
+	int _symbolPos;
+	bool _generatorBusy;
+
+	// Phase of each carrier (in quarter cycles) for DBPSK
+	int8_t _carrierPhase[FFT_SIZE / 2];
+
+	// Bits are pulled from the source a symbol at a time
+	FSKModSymbolSourceFnType _bitSourceFn;
+	int _streamPreambleLeft;
+	bool _streamSourceActive;
+
+public:
+	OFDMMod();
+
+	// Setup - carriers are the FFT bins in the range freqLow to freqHigh
+	bool setup(int sampleRate, int freqLow, int freqHigh, CarrierModulation carrierModulation);
+
+	// Source of bits to send
+	void setBitSource(FSKModSymbolSourceFnType bitSourceFn)
+	{
+		_bitSourceFn = bitSourceFn;
+	}
+
+	// Start streaming - sync and training symbols then symbols until the source has
+	// no more bits (the last symbol is padded with 0s)
+	void startStream();
+
+	// Stop
+	void clear();
+
+	// Get a sample from the modulated output
+	bool getSample(int& sampleValue);
+
+	// Data bits carried by each symbol
+	int getBitsPerSymbol()
+	{
+		return _bitsPerSymbol;
+	}
+
+	// Carrier plan - shared with the demodulator
+	static bool binRange(int sampleRate, int freqLow, int freqHigh, int& firstBin, int& lastBin);
+	static bool isPilot(int bin, int firstBin)
+	{
+		return (bin - firstBin) % PILOT_SPACING == 0;
+	}
+
+	// Known values (+1 or -1) of the sync symbol (even bins only) and training symbol
+	static int syncValue(int bin)
+	{
+		return (bin & 0x01) ? 0 : (((SYNC_PATTERN >> (bin & 0x3f)) & 0x01) ? 1 : -1);
+	}
+	static int trainingValue(int bin)
+	{
+		return ((TRAINING_PATTERN >> (bin & 0x3f)) & 0x01) ? 1 : -1;
+	}
+
+	// QPSK bits are inverted by a fixed pattern (2 bits per bin) so that repetitive
+	// data doesn't line up the phases of the carriers and make large peaks
+	static int scrambleBits(int bin)
+	{
+		return (int)((SCRAMBLE_PATTERN_RE >> (bin & 0x3f)) & 0x01) | (int)(((SCRAMBLE_PATTERN_IM >> (bin & 0x3f)) & 0x01) << 1);
+	}
+
+private:
+	static const uint64_t SYNC_PATTERN = 0x9d2c5680e3a4b71fULL;
+	static const uint64_t TRAINING_PATTERN = 0x5b3e1c92f0a7648dULL;
+	static const uint64_t SCRAMBLE_PATTERN_RE = 0xc4f1a83d6e2b9057ULL;
+	static const uint64_t SCRAMBLE_PATTERN_IM = 0x2a6dd3580fb1e49cULL;
+
+	void makeSymbol(int32_t* pRe, int32_t* pIm);
+	bool makeDataSymbol(int32_t* pRe, int32_t* pIm);
+};
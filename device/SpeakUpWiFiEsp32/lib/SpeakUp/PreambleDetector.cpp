@@ -0,0 +1,168 @@
+// PreambleDetector
+// Matched filter for the end of the preamble and the sync word
+
+#include "PreambleDetector.h"
+
+PreambleDetector::PreambleDetector(int* pStorage)
+{
+	_pChipSums = pStorage;
+	_numChips = 0;
+	_firstExactChip = 0;
+	_numSteps = 0;
+	_samplesPerSymbol = 1;
+	_minContrast16 = DEFAULT_MIN_CONTRAST_16;
+	clear();
+}
+
+// Setup template
+void PreambleDetector::setup(int samplesPerSymbol, uint32_t templateBits, int numTemplateBits, int numExactBits)
+{
+	if (numTemplateBits > MAX_TEMPLATE_BITS)
+		numTemplateBits = MAX_TEMPLATE_BITS;
+	if (numExactBits > numTemplateBits)
+		numExactBits = numTemplateBits;
+	_samplesPerSymbol = samplesPerSymbol;
+	if (!_pChipSums)
+	{
+		_ownChipSums.resize(STORAGE_LEN);
+		_pChipSums = _ownChipSums.data();
+	}
+
+	// Manchester - a 1 is sent as high tone then low tone and a 0 the reverse
+	_numChips = numTemplateBits * 2;
+	for (int i = 0; i < numTemplateBits; i++)
+	{
+		int bitVal = (templateBits >> i) & 0x01;
+		_template[i * 2] = bitVal ? 1 : -1;
+		_template[i * 2 + 1] = bitVal ? -1 : 1;
+	}
+	_firstExactChip = (numTemplateBits - numExactBits) * 2;
+	_numSteps = _numChips * STEPS_PER_CHIP;
+	clear();
+}
+
+void PreambleDetector::clear()
+{
+	_stepFraction = 0;
+	_stepAccum = 0;
+	_stepPutPos = 0;
+	_stepsFilled = 0;
+	_runningChipSum = 0;
+	for (int i = 0; i < STEPS_PER_CHIP; i++)
+		_stepSums[i] = 0;
+	_candidateValid = false;
+	_candidateScore = 0;
+}
+
+// Process an envelope sample
+bool PreambleDetector::processSample(int envelopeVal, uint32_t sampleCount, DetectResult& result)
+{
+	if (_numSteps == 0)
+		return false;
+
+	// Accumulate over a step - steps are a fraction of a symbol so the step
+	// length varies by a sample when the symbol doesn't divide exactly
+	_stepAccum += envelopeVal;
+	_stepFraction += STEPS_PER_SYMBOL;
+	if (_stepFraction < _samplesPerSymbol)
+		return false;
+	_stepFraction -= _samplesPerSymbol;
+
+	// Store step sum (replacing the one from a chip ago) and update the sum over the latest chip
+	int* pStepSum = &_stepSums[_stepPutPos % STEPS_PER_CHIP];
+	_runningChipSum += _stepAccum - *pStepSum;
+	*pStepSum = _stepAccum;
+	_pChipSums[_stepPutPos] = _runningChipSum;
+	_stepAccum = 0;
+	if (++_stepPutPos >= _numSteps)
+		_stepPutPos = 0;
+	if (_stepsFilled < _numSteps)
+	{
+		_stepsFilled++;
+		return false;
+	}
+
+	// Check for a match - while the score keeps rising the best is held as a candidate
+	int score = 0;
+	DetectResult curResult;
+	bool isMatch = evaluate(sampleCount, score, curResult);
+	if (isMatch && (!_candidateValid || (score > _candidateScore)))
+	{
+		_candidate = curResult;
+		_candidateScore = score;
+		_candidateValid = true;
+		return false;
+	}
+
+	// Report when the peak has passed
+	if (_candidateValid)
+	{
+		result = _candidate;
+		_candidateValid = false;
+
+		// Window must refill before detecting again
+		_stepsFilled = 0;
+		return true;
+	}
+	return false;
+}
+
+// Evaluate the template against the current window
+bool PreambleDetector::evaluate(uint32_t sampleCount, int& score, DetectResult& result)
+{
+	// Get each chip sum - the oldest chip ends STEPS_PER_CHIP - 1 steps after the put position
+	int chipSums[MAX_TEMPLATE_CHIPS];
+	int highSum = 0;
+	int lowSum = 0;
+	int numHigh = 0;
+	int stepPos = _stepPutPos + STEPS_PER_CHIP - 1;
+	for (int chipIdx = 0; chipIdx < _numChips; chipIdx++)
+	{
+		if (stepPos >= _numSteps)
+			stepPos -= _numSteps;
+		int chipSum = _pChipSums[stepPos];
+		stepPos += STEPS_PER_CHIP;
+		chipSums[chipIdx] = chipSum;
+		if (_template[chipIdx] > 0)
+		{
+			highSum += chipSum;
+			numHigh++;
+		}
+		else
+		{
+			lowSum += chipSum;
+		}
+	}
+
+	// Check contrast and level
+	int highMean = highSum / numHigh;
+	int lowMean = lowSum / (_numChips - numHigh);
+	if (highMean * 16 <= lowMean * _minContrast16)
+		return false;
+	int signalHigh = highMean * 2 / _samplesPerSymbol;
+	if (signalHigh < MIN_HIGH_LEVEL)
+		return false;
+
+	// Check individual chips
+	int midLevel = (highMean + lowMean) / 2;
+	int chipErrors = 0;
+	for (int chipIdx = 0; chipIdx < _numChips; chipIdx++)
+	{
+		bool isHigh = chipSums[chipIdx] > midLevel;
+		if (isHigh != (_template[chipIdx] > 0))
+		{
+			if (chipIdx >= _firstExactChip)
+				return false;
+			chipErrors++;
+		}
+	}
+	if (chipErrors > MAX_CHIP_ERRORS)
+		return false;
+
+	// Matched
+	score = highMean - lowMean;
+	result.symbolEdgeSampleCount = sampleCount + 1;
+	result.signalHigh = signalHigh;
+	result.signalLow = lowMean * 2 / _samplesPerSymbol;
+	return true;
+}
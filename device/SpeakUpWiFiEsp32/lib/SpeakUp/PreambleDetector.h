@@ -0,0 +1,97 @@
+// PreambleDetector
+// Matched filter for the end of the preamble and the sync word
+// Correlates the demodulator envelope against the expected Manchester chip
+// pattern so that symbol timing and slicer thresholds can be set in one shot
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class PreambleDetector
+{
+public:
+	// Result of a detection
+	class DetectResult
+	{
+	public:
+		// Sample count at which the symbol following the sync word starts
+		uint32_t symbolEdgeSampleCount;
+		// Mean envelope levels of the high and low tone chips
+		int signalHigh;
+		int signalLow;
+	};
+
+private:
+	// Template - one entry per chip (half symbol), +1 for the high tone and -1 for low
+	static const int MAX_TEMPLATE_BITS = 16;
+	static const int MAX_TEMPLATE_CHIPS = MAX_TEMPLATE_BITS * 2;
+	int8_t _template[MAX_TEMPLATE_CHIPS];
+	int _numChips;
+	int _firstExactChip;
+
+	// The envelope is summed over steps of a quarter chip
+	static const int STEPS_PER_CHIP = 4;
+	static const int STEPS_PER_SYMBOL = STEPS_PER_CHIP * 2;
+	static const int MAX_STEPS = MAX_TEMPLATE_CHIPS * STEPS_PER_CHIP;
+	int _samplesPerSymbol;
+	int _stepFraction;
+	int _stepAccum;
+
+	// Step sums of the latest chip (a ring of STEPS_PER_CHIP - the number of steps is
+	// a multiple of it) and a ring of chip sums (the sum of the chip ending at each
+	// step) - the chip sums are either owned or supplied externally
+	int _stepSums[STEPS_PER_CHIP];
+	int* _pChipSums;
+	std::vector<int> _ownChipSums;
+	int _runningChipSum;
+	int _numSteps;
+	int _stepPutPos;
+	int _stepsFilled;
+
+	// Thresholds - high chips must exceed low chips by a ratio (in 16ths)
+	// and only a few chips may be on the wrong side of the mid level - errors
+	// are not allowed in the exact part (the sync word) as bit stuffing ensures
+	// it can't appear in data but near misses can
+	int _minContrast16;
+	static const int MIN_HIGH_LEVEL = 20;
+	static const int MAX_CHIP_ERRORS = 2;
+
+	// Peak tracking
+	bool _candidateValid;
+	int _candidateScore;
+	DetectResult _candidate;
+
+public:
+	// Default ratio (in 16ths) of the high to the low chips
+	static const int DEFAULT_MIN_CONTRAST_16 = 32;
+
+	// Ints of external storage for the chip sums
+	static const int STORAGE_LEN = MAX_STEPS;
+
+	// Constructor - if pStorage is supplied it must hold STORAGE_LEN ints and remain valid
+	// (otherwise storage is allocated by setup())
+	PreambleDetector(int* pStorage = NULL);
+
+	// Setup - the bits are in transmission order (bit 0 first) and the last
+	// numExactBits must match without error
+	void setup(int samplesPerSymbol, uint32_t templateBits, int numTemplateBits, int numExactBits);
+
+	// Change the ratio (in 16ths) the high chips must exceed the low chips by
+	void setMinContrast(int minContrast16)
+	{
+		_minContrast16 = minContrast16;
+	}
+
+	// Clear state
+	void clear();
+
+	// Process an envelope sample - sampleCount identifies the sample
+	// Returns true when the template has been found (once the correlation peak has passed)
+	bool processSample(int envelopeVal, uint32_t sampleCount, DetectResult& result);
+
+private:
+	// Evaluate the template against the current window
+	bool evaluate(uint32_t sampleCount, int& score, DetectResult& result);
+};
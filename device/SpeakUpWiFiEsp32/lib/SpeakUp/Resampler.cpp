@@ -0,0 +1,158 @@
+// Resampler
+// Fixed-point polyphase rational resampler
+
+#include "Resampler.h"
+#include <math.h>
+
+// Setup - design the anti-alias/anti-image filter and split it into polyphase branches
+bool Resampler::setup(int inputRate, int outputRate, int tapsPerPhase)
+{
+	// Filter size - external storage must be large enough
+	int numTaps = 0;
+	int historyLen = 0;
+	if (!filterSize(inputRate, outputRate, tapsPerPhase, numTaps, historyLen))
+		return false;
+	if (_pCoeffStorage && ((numTaps > _coeffStorageLen) || (historyLen > _historyStorageLen)))
+		return false;
+
+	// Reduce the ratio
+	int gcd = greatestCommonDivisor(inputRate, outputRate);
+	_interpFactor = outputRate / gcd;
+	_decimFactor = inputRate / gcd;
+
+	// Nothing to do if rates match
+	_tapsPerPhase = historyLen / 2;
+	if (isPassthrough())
+	{
+		clear();
+		return true;
+	}
+	if (_pCoeffStorage)
+	{
+		_coeffs = _pCoeffStorage;
+		_history = _pHistoryStorage;
+	}
+	else
+	{
+		_ownCoeffs.resize(numTaps);
+		_ownHistory.resize(historyLen);
+		_coeffs = _ownCoeffs.data();
+		_history = _ownHistory.data();
+	}
+
+	// Windowed-sinc (Blackman) prototype with a gain of L to make up for zero stuffing
+	int maxFactor = (_interpFactor > _decimFactor) ? _interpFactor : _decimFactor;
+	double cutoff = 0.5 / maxFactor;
+	double centre = (numTaps - 1) / 2.0;
+	for (int phase = 0; phase < _interpFactor; phase++)
+	{
+		for (int k = 0; k < _tapsPerPhase; k++)
+		{
+			int tapIdx = phase + k * _interpFactor;
+			double t = tapIdx - centre;
+			double sinc = (t == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+			double window = 0.42 - 0.5 * cos(2 * M_PI * tapIdx / (numTaps - 1)) +
+							0.08 * cos(4 * M_PI * tapIdx / (numTaps - 1));
+			double coeff = sinc * window * _interpFactor * (1 << COEFF_FRAC_BITS);
+			_coeffs[phase * _tapsPerPhase + k] = (int16_t)lround(coeff);
+		}
+	}
+
+	clear();
+	return true;
+}
+
+// The filter runs at the interpolated rate and must cut off at half the lower of
+// the two rates - so the length is scaled to keep the transition band the same
+// proportion of the cutoff whichever way the conversion goes
+bool Resampler::filterSize(int inputRate, int outputRate, int tapsPerPhase, int& numCoeffs, int& historyLen)
+{
+	numCoeffs = 0;
+	historyLen = 0;
+	if ((inputRate <= 0) || (outputRate <= 0) || (tapsPerPhase <= 0))
+		return false;
+	int gcd = greatestCommonDivisor(inputRate, outputRate);
+	int interpFactor = outputRate / gcd;
+	int decimFactor = inputRate / gcd;
+	if ((interpFactor == 1) && (decimFactor == 1))
+		return true;
+	int maxFactor = (interpFactor > decimFactor) ? interpFactor : decimFactor;
+	int branchTaps = (tapsPerPhase * maxFactor + interpFactor - 1) / interpFactor;
+	numCoeffs = branchTaps * interpFactor;
+	historyLen = branchTaps * 2;
+	return true;
+}
+
+void Resampler::clear()
+{
+	for (int i = 0; i < _tapsPerPhase * 2; i++)
+		_history[i] = 0;
+	_historyPos = 0;
+	_phase = 0;
+}
+
+// Process a single input sample
+int Resampler::processSample(int inSample, int16_t* pOut)
+{
+	int16_t sampleVal = saturateS16(inSample);
+	if (isPassthrough())
+	{
+		pOut[0] = sampleVal;
+		return 1;
+	}
+
+	// Add to history - newest sample is at _historyPos
+	_historyPos = (_historyPos == 0) ? _tapsPerPhase - 1 : _historyPos - 1;
+	_history[_historyPos] = sampleVal;
+	_history[_historyPos + _tapsPerPhase] = sampleVal;
+
+	// Generate all output samples that fall before the next input sample
+	int numOut = 0;
+	while (_phase < _interpFactor)
+	{
+		pOut[numOut++] = computeOutput();
+		_phase += _decimFactor;
+	}
+	_phase -= _interpFactor;
+	return numOut;
+}
+
+// Process a block of input samples
+int Resampler::processBlock(const int16_t* pIn, int numIn, int16_t* pOut, int maxOut, int& numOut)
+{
+	int maxPerInput = maxOutputSamples(1);
+	int inIdx = 0;
+	numOut = 0;
+	while ((inIdx < numIn) && (numOut + maxPerInput <= maxOut))
+		numOut += processSample(pIn[inIdx++], pOut + numOut);
+	return inIdx;
+}
+
+// Compute a single output sample from the current polyphase branch
+int16_t Resampler::computeOutput()
+{
+	const int16_t* pCoeff = _coeffs + _phase * _tapsPerPhase;
+	const int16_t* pHist = _history + _historyPos;
+	int32_t acc = 0;
+	for (int k = 0; k < _tapsPerPhase; k++)
+		acc += pCoeff[k] * pHist[k];
+
+	// Round and saturate
+	int outVal = (acc + (1 << (COEFF_FRAC_BITS - 1))) >> COEFF_FRAC_BITS;
+	if (outVal > 32767)
+		outVal = 32767;
+	else if (outVal < -32767)
+		outVal = -32767;
+	return outVal;
+}
+
+int Resampler::greatestCommonDivisor(int a, int b)
+{
+	while (b != 0)
+	{
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
@@ -0,0 +1,100 @@
+// Resampler
+// Fixed-point polyphase rational resampler
+// Converts audio at any input rate (e.g. 44.1KHz, 48KHz or an oversampled ADC)
+// to the modem sample rate by interpolating by L and decimating by M
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "SampleFormat.h"
+
+class Resampler
+{
+private:
+	// Interpolation (L) and decimation (M) factors - reduced by their GCD
+	int _interpFactor;
+	int _decimFactor;
+
+	// Number of FIR taps in each polyphase branch
+	int _tapsPerPhase;
+
+	// Coefficients are stored branch by branch in Q14 format
+	static const int COEFF_FRAC_BITS = 14;
+	int16_t* _coeffs;
+
+	// Input history - each sample is stored twice so that a contiguous
+	// window of the most recent samples is always available
+	int16_t* _history;
+	int _historyPos;
+
+	// Storage - either owned or supplied externally (with its length)
+	std::vector<int16_t> _ownCoeffs;
+	std::vector<int16_t> _ownHistory;
+	int16_t* _pCoeffStorage;
+	int _coeffStorageLen;
+	int16_t* _pHistoryStorage;
+	int _historyStorageLen;
+
+	// Polyphase branch for the next output sample
+	int _phase;
+
+public:
+	static const int DEFAULT_TAPS_PER_PHASE = 16;
+
+	// Constructor - coefficients and history can use external storage in which case
+	// setup() fails for conversions that need more (see filterSize())
+	Resampler(int16_t* pCoeffStorage = NULL, int coeffStorageLen = 0,
+				int16_t* pHistoryStorage = NULL, int historyStorageLen = 0)
+	{
+		_interpFactor = 1;
+		_decimFactor = 1;
+		_tapsPerPhase = 0;
+		_coeffs = NULL;
+		_history = NULL;
+		_historyPos = 0;
+		_phase = 0;
+		_pCoeffStorage = pCoeffStorage;
+		_coeffStorageLen = coeffStorageLen;
+		_pHistoryStorage = pHistoryStorage;
+		_historyStorageLen = historyStorageLen;
+	}
+
+	// Setup for the given input and output rates - a longer filter (more taps per phase)
+	// gives a sharper transition band at the cost of more work per output sample
+	bool setup(int inputRate, int outputRate, int tapsPerPhase = DEFAULT_TAPS_PER_PHASE);
+
+	// Number of coefficients and history entries needed for a conversion
+	static bool filterSize(int inputRate, int outputRate, int tapsPerPhase, int& numCoeffs, int& historyLen);
+
+	// Clear the filter history
+	void clear();
+
+	// True if no conversion is needed
+	bool isPassthrough()
+	{
+		return (_interpFactor == 1) && (_decimFactor == 1);
+	}
+
+	// Max output samples that can be generated by numInputSamples
+	int maxOutputSamples(int numInputSamples)
+	{
+		return (numInputSamples * _interpFactor + _decimFactor - 1) / _decimFactor + 1;
+	}
+
+	// Process a single input sample (saturated to 16 bits)
+	// Output samples are written to pOut (which must hold at least maxOutputSamples(1))
+	// Returns the number of output samples generated
+	int processSample(int inSample, int16_t* pOut);
+
+	// Process a block of input samples
+	// Stops early if pOut would overflow - returns the number of input samples used
+	// and sets numOut to the number of output samples generated
+	int processBlock(const int16_t* pIn, int numIn, int16_t* pOut, int maxOut, int& numOut);
+
+private:
+	// Helpers
+	int16_t computeOutput();
+	static int greatestCommonDivisor(int a, int b);
+};
@@ -75,6 +75,31 @@ public:
             _getPos = 0;
     }
 
+    // Advance by several elements at once - caller must check count() / space()
+    void hasPut(unsigned int num)
+    {
+        unsigned int newPos = _putPos + num;
+        if (newPos >= _bufLen)
+            newPos -= _bufLen;
+        _putPos = newPos;
+    }
+
+    void hasGot(unsigned int num)
+    {
+        unsigned int newPos = _getPos + num;
+        if (newPos >= _bufLen)
+            newPos -= _bufLen;
+        _getPos = newPos;
+    }
+
+    // Number of elements that can be put
+    unsigned int space()
+    {
+        if (_bufLen == 0)
+            return 0;
+        return _bufLen - 1 - count();
+    }
+
     unsigned int count()
     {
         unsigned int posToGet = _getPos;
@@ -0,0 +1,28 @@
+// SampleFormat
+// Conversion of blocks of compact samples to and from signed 16 bit
+
+#include "SampleFormat.h"
+
+void samplesToS16(const uint8_t* pIn, SampleFormat format, int16_t* pOut, int numSamples)
+{
+	if (format == SAMPLE_FORMAT_ULAW)
+	{
+		for (int i = 0; i < numSamples; i++)
+			pOut[i] = ulawToS16(pIn[i]);
+		return;
+	}
+	for (int i = 0; i < numSamples; i++)
+		pOut[i] = u8ToS16(pIn[i]);
+}
+
+void samplesFromS16(const int16_t* pIn, SampleFormat format, uint8_t* pOut, int numSamples)
+{
+	if (format == SAMPLE_FORMAT_ULAW)
+	{
+		for (int i = 0; i < numSamples; i++)
+			pOut[i] = s16ToUlaw(pIn[i]);
+		return;
+	}
+	for (int i = 0; i < numSamples; i++)
+		pOut[i] = s16ToU8(pIn[i]);
+}
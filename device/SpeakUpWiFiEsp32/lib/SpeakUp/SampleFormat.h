@@ -0,0 +1,71 @@
+// SampleFormat
+// Compact sample formats and conversion to and from the signed 16 bit samples
+// used by the modem's audio interfaces and buffers
+//   S16   signed 16 bit - the modem's native format
+//   U8    unsigned 8 bit PCM centred on 128 (as generated by the web transmitter)
+//   ULAW  G.711 mu-law - 8 bits with about 13 bits of dynamic range
+// Conversions to the narrow formats saturate rather than wrap
+
+#pragma once
+
+#include <stdint.h>
+
+enum SampleFormat
+{
+	SAMPLE_FORMAT_S16,
+	SAMPLE_FORMAT_U8,
+	SAMPLE_FORMAT_ULAW
+};
+
+// Saturate to the 16 bit sample range
+static inline int16_t saturateS16(int val)
+{
+	if (val > 32767)
+		return 32767;
+	if (val < -32768)
+		return -32768;
+	return (int16_t)val;
+}
+
+// Unsigned 8 bit PCM
+static inline int16_t u8ToS16(uint8_t val)
+{
+	return (int16_t)((val - 128) << 8);
+}
+static inline uint8_t s16ToU8(int16_t val)
+{
+	return (uint8_t)((val >> 8) + 128);
+}
+
+// G.711 mu-law (segment and mantissa are stored inverted)
+static const int ULAW_BIAS = 0x84;
+static const int ULAW_CLIP = 32635;
+static inline int16_t ulawToS16(uint8_t val)
+{
+	val = ~val;
+	int magnitude = ((((val & 0x0f) << 3) + ULAW_BIAS) << ((val & 0x70) >> 4)) - ULAW_BIAS;
+	return (int16_t)((val & 0x80) ? -magnitude : magnitude);
+}
+static inline uint8_t s16ToUlaw(int16_t val)
+{
+	int sign = (val < 0) ? 0x80 : 0;
+	int magnitude = (val < 0) ? -(int)val : val;
+	if (magnitude > ULAW_CLIP)
+		magnitude = ULAW_CLIP;
+	magnitude += ULAW_BIAS;
+	int segment = 7;
+	for (int mask = 0x4000; ((magnitude & mask) == 0) && (segment > 0); mask >>= 1)
+		segment--;
+	int mantissa = (magnitude >> (segment + 3)) & 0x0f;
+	return (uint8_t)~(sign | (segment << 4) | mantissa);
+}
+
+// Bytes per sample of a format
+static inline int sampleFormatBytes(SampleFormat format)
+{
+	return (format == SAMPLE_FORMAT_S16) ? 2 : 1;
+}
+
+// Convert blocks of 8 bit samples (U8 or ULAW) to and from S16
+void samplesToS16(const uint8_t* pIn, SampleFormat format, int16_t* pOut, int numSamples);
+void samplesFromS16(const int16_t* pIn, SampleFormat format, uint8_t* pOut, int numSamples);
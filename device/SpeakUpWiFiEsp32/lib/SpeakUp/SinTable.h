@@ -0,0 +1,37 @@
+// SinTable
+// Quarter wave sine table shared by the modulators and the FFT
+// A full cycle is CYCLE_LEN steps and values are scaled to +/-PEAK
+
+#pragma once
+
+#include <stdint.h>
+
+class SinTable
+{
+public:
+	static const int CYCLE_BITS = 10;
+	static const int CYCLE_LEN = 1 << CYCLE_BITS;
+	static const int QUARTER_LEN = CYCLE_LEN / 4;
+	static const int PEAK = 32767;
+
+	// sin(2 * pi * i / CYCLE_LEN) for i in the first quarter (the last entry is just short of PEAK)
+	static const int16_t QUARTER_WAVE[QUARTER_LEN];
+
+	// Sine and cosine of a phase in CYCLE_LEN steps per cycle (any value - it is wrapped)
+	static int sin(int phase)
+	{
+		phase &= CYCLE_LEN - 1;
+		int idx = phase & (QUARTER_LEN - 1);
+		switch (phase / QUARTER_LEN)
+		{
+			case 0: return QUARTER_WAVE[idx];
+			case 1: return idx == 0 ? PEAK : QUARTER_WAVE[QUARTER_LEN - idx];
+			case 2: return -QUARTER_WAVE[idx];
+			default: return idx == 0 ? -PEAK : -QUARTER_WAVE[QUARTER_LEN - idx];
+		}
+	}
+	static int cos(int phase)
+	{
+		return sin(phase + QUARTER_LEN);
+	}
+};
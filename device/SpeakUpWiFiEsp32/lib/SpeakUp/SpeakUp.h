@@ -1,114 +1,992 @@
 // SpeakUp - send messages over audio
 // Rob Dobson 2018
+// SpeakUpT is configured at compile time (see SpeakUpConfig.h) so every buffer is a
+// fixed size member and nothing is allocated from the heap - SpeakUp has the
+// default configuration
 
 #pragma once
 
 #include <functional>
+#include <type_traits>
+#include <string.h>
+#include "SpeakUpConfig.h"
 #include "FSKDemod.h"
 #include "FSKMod.h"
+#include "ChirpDemod.h"
+#include "ChirpMod.h"
+#include "OFDMDemod.h"
+#include "OFDMMod.h"
 #include "MiniHDLC.h"
+#include "SyncFramer.h"
+#include "Resampler.h"
+#include "EnergySquelch.h"
+#include "SpectrumMonitor.h"
+#include "FountainEncoder.h"
+#include "FountainDecoder.h"
+#include "FrameAddress.h"
+#include "AudioIO.h"
+#include "SampleFormat.h"
 
-class SpeakUp
+template<typename Config>
+class SpeakUpT
 {
+public:
+	// Framing of messages - bitwise HDLC or a sync word with a length header
+	enum FramingMode
+	{
+		FRAMING_HDLC,
+		FRAMING_SYNC
+	};
+
+	// Modulation - FSK, chirp spread spectrum (slower but works well below the noise)
+	// or OFDM (kilobits per second for larger payloads but needs a clean channel)
+	enum ModulationMode
+	{
+		MODULATION_FSK,
+		MODULATION_CHIRP,
+		MODULATION_OFDM_QPSK,
+		MODULATION_OFDM_DBPSK
+	};
+	static const int DEFAULT_CHIRP_SPREADING_FACTOR = 8;
+
+	// Carousel payloads up to this length are repeated as they are rather than
+	// fountain coded (see encodeCarouselToSamples())
+	static const int CAROUSEL_REPEAT_MAX_LEN = FountainEncoder::MAX_BLOCK_LEN;
+
+	// Spectrum monitor bands
+	static const int SPECTRUM_BAND_LOW_TONE = 0;
+	static const int SPECTRUM_BAND_HIGH_TONE = 1;
+
+	// Memory used by each part in bytes (all within the object) - see getFootprintBytes()
+	enum FootprintPart
+	{
+		FOOTPRINT_FSK_MOD,
+		FOOTPRINT_FSK_DEMOD,
+		FOOTPRINT_FRAMING,
+		FOOTPRINT_CHIRP,
+		FOOTPRINT_OFDM,
+		FOOTPRINT_RESAMPLER,
+		FOOTPRINT_SQUELCH,
+		FOOTPRINT_SPECTRUM_MONITOR,
+		FOOTPRINT_FOUNTAIN,
+		FOOTPRINT_OTHER,
+		FOOTPRINT_NUM_PARTS
+	};
+
 private:
-	// Received frame
+	// Settings
+	static const int SAMPLE_RATE_PER_SEC = Config::SAMPLE_RATE;
+	static const int SYMBOL_RATE_PER_SEC = Config::SYMBOL_RATE;
+	static const int SYMBOL_FREQ_HIGH = Config::SYMBOL_FREQ_HIGH;
+	static const int SYMBOL_FREQ_LOW = Config::SYMBOL_FREQ_LOW;
+
+	// Preamble length - only a few symbols are needed as the receiver finds
+	// the end of the preamble and the HDLC frame boundary with a matched filter
+	static const int PREAMBLE_SYMBOLS = 8;
+	static const int SYNC_PREAMBLE_SYMBOLS = 4;
+	static const uint8_t SYNC_WORD = 0x7E;
+
+	// Chirps sweep the same band as the FSK tones
+	static const int CHIRP_FREQ_LOW = 1000;
+	static const int CHIRP_BANDWIDTH = 2000;
+	static const int CHIRP_RX_BITS_FIFO_LEN = 64;
+
+	// OFDM carriers (62.5Hz apart) fill most of the audio band - a symbol carries
+	// up to 84 bits so the receive FIFO holds a few symbols
+	static const int OFDM_FREQ_LOW = 500;
+	static const int OFDM_FREQ_HIGH = 3500;
+	static const int OFDM_RX_BITS_FIFO_LEN = 256;
+
+	// Input rates down to a quarter of the modem rate can be upsampled
+	static const int MAX_RESAMPLED_PER_INPUT = 4;
+
+	// Squelch lookback (4 symbols) and hang time (100ms) in samples
+	// Buffered samples are caught up at up to SQUELCH_CATCHUP_RATE per input sample
+	static const int SQUELCH_LOOKBACK_LEN = 320;
+	static const int SQUELCH_HANG_SAMPLES = 800;
+	static const int SQUELCH_CATCHUP_RATE = 2;
+
+	// Spectrum monitor bands either side of each FSK tone
+	static const int SPECTRUM_BAND_HALF_WIDTH = 250;
+
+	// Audio block for decodeFromSource() (on the stack)
+	static const int AUDIO_BLOCK_LEN = 128;
+
+	// Parts - those left out of the configuration are stand-ins that take no memory
+	static const bool CHIRP_INCLUDED = Config::CHIRP_MAX_SPREADING_FACTOR > 0;
+	static const bool RESAMPLER_INCLUDED = Config::RESAMPLER_MAX_COEFFS > 0;
+	typedef typename std::conditional<Config::ENABLE_TX, FSKMod, SpeakUpOmittedPart>::type FSKModType;
+	typedef typename std::conditional<Config::ENABLE_SYNC_DETECT && Config::ENABLE_EQUALISER, FSKEqualiser,
+				SpeakUpOmittedPart>::type EqualiserType;
+	typedef typename std::conditional<Config::ENABLE_SYNC_FRAMING, SyncFramer, SpeakUpOmittedPart>::type SyncFramerType;
+	typedef typename std::conditional<Config::ENABLE_TX && CHIRP_INCLUDED, ChirpMod, SpeakUpOmittedPart>::type ChirpModType;
+	typedef typename std::conditional<CHIRP_INCLUDED, ChirpDemod, SpeakUpOmittedPart>::type ChirpDemodType;
+	typedef typename std::conditional<Config::ENABLE_TX && Config::ENABLE_OFDM, OFDMMod, SpeakUpOmittedPart>::type OFDMModType;
+	typedef typename std::conditional<Config::ENABLE_OFDM, OFDMDemod, SpeakUpOmittedPart>::type OFDMDemodType;
+	typedef typename std::conditional<RESAMPLER_INCLUDED, Resampler, SpeakUpOmittedPart>::type ResamplerType;
+	typedef typename std::conditional<Config::ENABLE_SQUELCH, EnergySquelch, SpeakUpOmittedPart>::type SquelchType;
+	typedef typename std::conditional<Config::ENABLE_SPECTRUM_MONITOR, SpectrumMonitor, SpeakUpOmittedPart>::type SpectrumMonitorType;
+	typedef typename std::conditional<Config::ENABLE_TX && Config::ENABLE_FOUNTAIN, FountainEncoder, SpeakUpOmittedPart>::type FountainEncoderType;
+	typedef typename std::conditional<Config::ENABLE_FOUNTAIN, FountainDecoder, SpeakUpOmittedPart>::type FountainDecoderType;
+
+	// Storage for the parts - sized for the configuration
+	// The framers see any address (see enableAddressing()) as part of the frame
+	static const int HDLC_MAX_FRAME_LEN = Config::MAX_FRAME_LEN + FrameAddress::ADDRESS_LEN + 2;
+	static const int SYNC_MAX_PAYLOAD_LEN = Config::MAX_FRAME_LEN + FrameAddress::ADDRESS_LEN < SyncFramer::MAX_PAYLOAD_LEN ?
+				Config::MAX_FRAME_LEN + FrameAddress::ADDRESS_LEN : SyncFramer::MAX_PAYLOAD_LEN;
+	static const int CORRECTION_MAX_FRAME_LEN = Config::MAX_CORRECTION_FRAME_LEN < MiniHDLC::MAX_CORRECTION_FRAME_LEN ?
+				Config::MAX_CORRECTION_FRAME_LEN : MiniHDLC::MAX_CORRECTION_FRAME_LEN;
+	static const int FOUNTAIN_MAX_PAYLOAD_LEN = Config::MAX_FRAME_LEN < FountainEncoder::MAX_PAYLOAD_LEN ?
+				Config::MAX_FRAME_LEN : FountainEncoder::MAX_PAYLOAD_LEN;
+	static const int TX_BLOCK_LEN = Config::ENABLE_TX ? Config::TX_AUDIO_BLOCK_LEN : 0;
+	static const int TX_QUEUE_LEN = Config::ENABLE_TX ? Config::TX_QUEUE_LEN : 0;
+	SpeakUpStorage<uint32_t, Config::ENABLE_TX ? SymbolFifo::storageWordsFor(Config::TX_BITS_FIFO_LEN, 1) : 0> _fskModFifoStorage;
+	SpeakUpStorage<uint32_t, SymbolFifo::storageWordsFor(Config::RX_BITS_FIFO_LEN, 1)> _fskDemodFifoStorage;
+	SpeakUpStorage<int, Config::ENABLE_SYNC_DETECT ? PreambleDetector::STORAGE_LEN : 0> _syncDetectStorage;
+	SpeakUpStorage<uint8_t, HDLC_MAX_FRAME_LEN + 1> _hdlcRxBuffer;
+	SpeakUpStorage<MiniHDLC::RepeatCombineWork, Config::ENABLE_REPEAT_COMBINING ? 1 : 0> _repeatCombineWork;
+	SpeakUpStorage<uint16_t, CORRECTION_MAX_FRAME_LEN * 8> _syndromeByPos;
+	SpeakUpStorage<uint32_t, CORRECTION_MAX_FRAME_LEN * 8> _syndromeSorted;
+	SpeakUpStorage<uint8_t, Config::ENABLE_SYNC_FRAMING ? SYNC_MAX_PAYLOAD_LEN + 1 : 0> _syncRxBuffer;
+	SpeakUpStorage<uint32_t, CHIRP_INCLUDED ? SymbolFifo::storageWordsFor(CHIRP_RX_BITS_FIFO_LEN, 1) : 0> _chirpFifoStorage;
+	SpeakUpStorage<int32_t, CHIRP_INCLUDED ? ChirpDemod::workStorageLenFor(SAMPLE_RATE_PER_SEC, CHIRP_BANDWIDTH,
+				Config::CHIRP_MAX_SPREADING_FACTOR) : 0> _chirpWorkStorage;
+	SpeakUpStorage<uint32_t, Config::ENABLE_OFDM ? SymbolFifo::storageWordsFor(OFDM_RX_BITS_FIFO_LEN, 1) : 0> _ofdmFifoStorage;
+	SpeakUpStorage<int16_t, Config::RESAMPLER_MAX_COEFFS> _resamplerCoeffs;
+	SpeakUpStorage<int16_t, Config::RESAMPLER_MAX_HISTORY> _resamplerHistory;
+	SpeakUpStorage<int16_t, Config::ENABLE_SQUELCH ? SQUELCH_LOOKBACK_LEN : 0> _squelchLookback;
+	SpeakUpStorage<uint8_t, Config::ENABLE_FOUNTAIN ? FountainDecoder::storageLenFor(FOUNTAIN_MAX_PAYLOAD_LEN) : 0> _fountainRows;
+
+	// Received frame - left in the buffer of the framer (or fountain decoder) that
+	// delivered it and held there until read so it can be used in place
 	volatile bool _rxReady = false;
-	String _rxMessage;
+	const uint8_t* _pRxFrame;
+	int _rxFrameLen;
+	uint16_t _rxFrameAddress;
+
+	// Addressed frames (see FrameAddress) - the address is checked by the framer
+	bool _addressingEnabled;
+
+	// Queued messages sent one after another by encodeTxQueueToSamples()
+	struct TxQueueEntry
+	{
+		const uint8_t* pData;
+		int len;
+		uint16_t address;
+	};
+	SpeakUpStorage<TxQueueEntry, TX_QUEUE_LEN> _txQueue;
+	int _txQueueCount;
+	int _txQueueSendLen;
+	int _txQueuePos;
 
 	// Mod/Demod & data link
-	FSKMod _fskMod;
+	FSKModType _fskMod;
 	FSKDemod _fskDemod;
+	EqualiserType _equaliser;
 	MiniHDLC _hdlc;
+	SyncFramerType _syncFramer;
+	FramingMode _framingMode;
 
-	// Settings
-	static const int SAMPLE_RATE_PER_SEC = 8000;
-	static const int TX_BITS_FIFO_LEN = 1000;
-	static const int RX_SAMPLES_FIFO_LEN = 4000;
-	static const int SYMBOL_RATE_PER_SEC = 100;
-	static const int SYMBOL_FREQ_HIGH = 2000;
-	static const int SYMBOL_FREQ_LOW = 1000;
+	// Chirp modulation
+	ChirpModType _chirpMod;
+	ChirpDemodType _chirpDemod;
+
+	// OFDM modulation
+	OFDMModType _ofdmMod;
+	OFDMDemodType _ofdmDemod;
+	ModulationMode _modulationMode;
+
+	// Input resampling (when audio is not at the modem sample rate)
+	ResamplerType _inputResampler;
+	bool _resampleInput;
+
+	// Squelch to idle the demodulator when there is no signal
+	SquelchType _squelch;
+	bool _squelchEnabled;
+
+	// Spectrum monitor for diagnostics
+	SpectrumMonitorType _spectrumMonitor;
+	bool _spectrumMonitorEnabled;
+
+	// Fountain coded carousel - packets left to send (-1 for endless) and receive
+	// A short payload is repeated as it is (_pCarouselRepeat) instead
+	FountainEncoderType _fountainEncoder;
+	FountainDecoderType _fountainDecoder;
+	bool _carouselActive;
+	int _carouselPacketsLeft;
+	const uint8_t* _pCarouselRepeat;
+	int _carouselRepeatLen;
+	bool _fountainReceiveEnabled;
+
+	// Transmit audio block - samples not yet accepted by a sink are held here
+	SpeakUpStorage<int16_t, TX_BLOCK_LEN> _txBlock;
+	int _txBlockLen;
+	int _txBlockPos;
 
 public:
-	SpeakUp() :
-		_fskMod(TX_BITS_FIFO_LEN),
-		_fskDemod(RX_SAMPLES_FIFO_LEN),
-		_hdlc(std::bind(&SpeakUp::putBit, this, std::placeholders::_1), 
-					std::bind(&SpeakUp::rxFrame, this, std::placeholders::_1, std::placeholders::_2),
-					 true, true)
+	SpeakUpT() :
+		_fskMod(Config::TX_BITS_FIFO_LEN, _fskModFifoStorage.get()),
+		_fskDemod(Config::RX_BITS_FIFO_LEN, _fskDemodFifoStorage.get(), _syncDetectStorage.get()),
+		_hdlc(NULL,
+					[this](const uint8_t* pFrame, int frameLen) { rxFrame(pFrame, frameLen); },
+					true, true, HDLC_MAX_FRAME_LEN, _hdlcRxBuffer.get()),
+		_syncFramer([this](const uint8_t* pFrame, int frameLen) { rxFrame(pFrame, frameLen); },
+					SYNC_MAX_PAYLOAD_LEN, SyncFramer::DEFAULT_SYNC_WORD, _syncRxBuffer.get()),
+		_chirpDemod(CHIRP_RX_BITS_FIFO_LEN, _chirpFifoStorage.get(),
+					_chirpWorkStorage.get(), sizeof(_chirpWorkStorage) / sizeof(int32_t)),
+		_ofdmDemod(OFDM_RX_BITS_FIFO_LEN, _ofdmFifoStorage.get()),
+		_inputResampler(_resamplerCoeffs.get(), Config::RESAMPLER_MAX_COEFFS,
+					_resamplerHistory.get(), Config::RESAMPLER_MAX_HISTORY),
+		_squelch(SQUELCH_LOOKBACK_LEN, SQUELCH_HANG_SAMPLES, _squelchLookback.get()),
+		_fountainDecoder(FOUNTAIN_MAX_PAYLOAD_LEN, _fountainRows.get())
 	{
+		static_assert((Config::RAM_BUDGET_BYTES == 0) || (sizeof(SpeakUpT) <= Config::RAM_BUDGET_BYTES),
+					"SpeakUp configuration is over its RAM budget");
 		_rxReady = false;
+		_pRxFrame = NULL;
+		_rxFrameLen = 0;
+		_rxFrameAddress = FrameAddress::BROADCAST;
+		_addressingEnabled = false;
+		_txQueueCount = 0;
+		_txQueueSendLen = 0;
+		_txQueuePos = 0;
+		_resampleInput = false;
+		_squelchEnabled = false;
+		_spectrumMonitorEnabled = false;
+		_carouselActive = false;
+		_carouselPacketsLeft = 0;
+		_pCarouselRepeat = NULL;
+		_carouselRepeatLen = 0;
+		_fountainReceiveEnabled = false;
+		_framingMode = FRAMING_HDLC;
+		_modulationMode = MODULATION_FSK;
+		_txBlockLen = 0;
+		_txBlockPos = 0;
+		_fskMod.setSymbolSource([this](int& symbol) { return getTxSymbol(symbol); });
+		_chirpMod.setBitSource([this](int& bitVal) { return getTxSymbol(bitVal); });
+		_ofdmMod.setBitSource([this](int& bitVal) { return getTxSymbol(bitVal); });
 		setup();
 	}
 
 	// Setup library
 	void setup()
 	{
-		_fskMod.setup(SAMPLE_RATE_PER_SEC, SYMBOL_RATE_PER_SEC, SYMBOL_FREQ_HIGH, SYMBOL_FREQ_LOW, true);
-		_fskDemod.setup(SAMPLE_RATE_PER_SEC, SYMBOL_RATE_PER_SEC, SYMBOL_FREQ_HIGH, SYMBOL_FREQ_LOW, true);
+		setupMod(_fskMod);
+		setupDemod(_fskDemod, Config::ENABLE_SYNC_DETECT);
+	}
+
+	// Memory footprint - the bytes used by a part (FootprintPart) and in total
+	// (everything is in the object so this is sizeof the object) - constants that
+	// can be checked at compile time
+	static constexpr int getFootprintBytes(int part)
+	{
+		return (part == FOOTPRINT_FSK_MOD) ? sizeof(FSKModType) + sizeof(_fskModFifoStorage) + sizeof(_txBlock) :
+			(part == FOOTPRINT_FSK_DEMOD) ? sizeof(FSKDemod) + sizeof(_fskDemodFifoStorage) + sizeof(_syncDetectStorage) +
+						sizeof(EqualiserType) :
+			(part == FOOTPRINT_FRAMING) ? sizeof(MiniHDLC) + sizeof(_hdlcRxBuffer) + sizeof(_repeatCombineWork) +
+						sizeof(_syndromeByPos) + sizeof(_syndromeSorted) + sizeof(SyncFramerType) +
+						sizeof(_syncRxBuffer) + sizeof(_txQueue) :
+			(part == FOOTPRINT_CHIRP) ? sizeof(ChirpModType) + sizeof(ChirpDemodType) + sizeof(_chirpFifoStorage) +
+						sizeof(_chirpWorkStorage) :
+			(part == FOOTPRINT_OFDM) ? sizeof(OFDMModType) + sizeof(OFDMDemodType) + sizeof(_ofdmFifoStorage) :
+			(part == FOOTPRINT_RESAMPLER) ? sizeof(ResamplerType) + sizeof(_resamplerCoeffs) + sizeof(_resamplerHistory) :
+			(part == FOOTPRINT_SQUELCH) ? sizeof(SquelchType) + sizeof(_squelchLookback) :
+			(part == FOOTPRINT_SPECTRUM_MONITOR) ? sizeof(SpectrumMonitorType) :
+			(part == FOOTPRINT_FOUNTAIN) ? sizeof(FountainEncoderType) + sizeof(FountainDecoderType) + sizeof(_fountainRows) :
+			(part == FOOTPRINT_OTHER) ? getFootprintTotal() - footprintSum(0) : 0;
+	}
+	static constexpr int getFootprintTotal()
+	{
+		return sizeof(SpeakUpT);
+	}
+	static const char* getFootprintName(int part)
+	{
+		switch (part)
+		{
+			case FOOTPRINT_FSK_MOD: return "FSK modulator";
+			case FOOTPRINT_FSK_DEMOD: return "FSK demodulator";
+			case FOOTPRINT_FRAMING: return "Framing";
+			case FOOTPRINT_CHIRP: return "Chirp";
+			case FOOTPRINT_OFDM: return "OFDM";
+			case FOOTPRINT_RESAMPLER: return "Resampler";
+			case FOOTPRINT_SQUELCH: return "Squelch";
+			case FOOTPRINT_SPECTRUM_MONITOR: return "Spectrum monitor";
+			case FOOTPRINT_FOUNTAIN: return "Fountain carousel";
+			case FOOTPRINT_OTHER: return "Other";
+			default: return "";
+		}
+	}
+
+	// Setup a modulator with the SpeakUp modem settings (at another symbol rate for tests)
+	template<typename ModType>
+	static void setupMod(ModType& fskMod, int symbolRate = SYMBOL_RATE_PER_SEC)
+	{
+		fskMod.setup(SAMPLE_RATE_PER_SEC, symbolRate, SYMBOL_FREQ_HIGH, SYMBOL_FREQ_LOW, true);
+		fskMod.setPreamble(PREAMBLE_SYMBOLS);
+	}
+
+	// Setup a demodulator (an FSKDemod or FSKDemodBank) with the SpeakUp modem settings
+	// and the demodulator preset for the symbol rate
+	template<typename DemodType>
+	static void setupDemod(DemodType& fskDemod, bool syncDetect = true, int symbolRate = SYMBOL_RATE_PER_SEC)
+	{
+		fskDemod.setup(SAMPLE_RATE_PER_SEC, symbolRate, SYMBOL_FREQ_HIGH, SYMBOL_FREQ_LOW, true,
+					FSKDemodParams::forSymbolRate(SAMPLE_RATE_PER_SEC, symbolRate));
+		if (syncDetect)
+			fskDemod.enableSyncDetector(SYNC_WORD, 8, SYNC_PREAMBLE_SYMBOLS);
+	}
+
+	// Sample rate of the modem
+	static int getModemSampleRate()
+	{
+		return SAMPLE_RATE_PER_SEC;
+	}
+
+	// Set the sample rate of audio passed to decodeProcessSample()
+	// Audio at other than the modem rate is resampled before demodulation
+	// Returns false (and input stays at the previous rate) if the rate is below a
+	// quarter of the modem rate or needs more resampler storage than the configuration
+	// has - the default configuration has none (see SpeakUpResamplingConfig for the
+	// rates covered)
+	bool setInputSampleRate(int sampleRate)
+	{
+		if (sampleRate == SAMPLE_RATE_PER_SEC)
+		{
+			_resampleInput = false;
+			return true;
+		}
+		if (sampleRate * MAX_RESAMPLED_PER_INPUT < SAMPLE_RATE_PER_SEC)
+			return false;
+		if (!_inputResampler.setup(sampleRate, SAMPLE_RATE_PER_SEC))
+			return false;
+		_resampleInput = !_inputResampler.isPassthrough();
+		return true;
+	}
+
+	// Enable squelch - the full demodulator chain only runs while a signal is present
+	// Returns false if squelch is not in the configuration
+	bool enableSquelch(bool enable)
+	{
+		if (!Config::ENABLE_SQUELCH)
+			return !enable;
+		_squelch.clear();
+		_squelchEnabled = enable;
+		return true;
+	}
+
+	// Check if the squelch is open (always true if squelch disabled)
+	bool isSquelchOpen()
+	{
+		return !_squelchEnabled || (_squelch.getState() != EnergySquelch::SQUELCH_CLOSED);
 	}
 
-	// Generate audio samples for a message
-	void encodeMessageToSamples(const char* msg)
+	// Enable the equaliser - in a reverberant room it removes the echoes of earlier
+	// symbols from the FSK envelope (see FSKEqualiser) - it only takes over the slicer
+	// when training finds the eye partly closed so it is left out of the default
+	// configuration (see SpeakUpEqualiserConfig) as the default rate doesn't need it
+	// Returns false if the equaliser is not in the configuration
+	bool enableEqualiser(bool enable)
 	{
+		if (!enable)
+		{
+			_fskDemod.setEqualiser(NULL);
+			return true;
+		}
+		if (!_equaliser.setup(SAMPLE_RATE_PER_SEC / SYMBOL_RATE_PER_SEC))
+			return false;
+		_fskDemod.setEqualiser(equaliserPtr(_equaliser));
+		return true;
+	}
+
+	// Enable the spectrum monitor - it sees all input (even while squelched) and keeps
+	// statistics of a band around each FSK tone (SPECTRUM_BAND_LOW_TONE and
+	// SPECTRUM_BAND_HIGH_TONE) analysing one block in every analysisInterval
+	// Returns false if the monitor is not in the configuration
+	bool enableSpectrumMonitor(bool enable, int analysisInterval = SpectrumMonitor::DEFAULT_ANALYSIS_INTERVAL)
+	{
+		if (!Config::ENABLE_SPECTRUM_MONITOR)
+			return !enable;
+		_spectrumMonitorEnabled = enable;
+		if (!enable)
+			return true;
+		_spectrumMonitor.setup(SAMPLE_RATE_PER_SEC, analysisInterval);
+		_spectrumMonitor.addBand(SYMBOL_FREQ_LOW - SPECTRUM_BAND_HALF_WIDTH, SYMBOL_FREQ_LOW + SPECTRUM_BAND_HALF_WIDTH);
+		_spectrumMonitor.addBand(SYMBOL_FREQ_HIGH - SPECTRUM_BAND_HALF_WIDTH, SYMBOL_FREQ_HIGH + SPECTRUM_BAND_HALF_WIDTH);
+		return true;
+	}
+
+	// Spectrum monitor for statistics
+	SpectrumMonitorType& getSpectrumMonitor()
+	{
+		return _spectrumMonitor;
+	}
+
+	// Set the framing mode - both ends must use the same mode
+	// Sync framing has no bit stuffing so the air time is fixed by the message length
+	// but messages are limited to SyncFramer::MAX_PAYLOAD_LEN bytes - it is only shorter
+	// than HDLC for heavily stuffed payloads as its sync word is longer than the HDLC flag
+	// (a 34 byte credentials message takes 7% longer - see tools/SyncFramingBench)
+	// Returns false if the framing is not in the configuration
+	bool setFramingMode(FramingMode framingMode)
+	{
+		if ((framingMode == FRAMING_SYNC) && !Config::ENABLE_SYNC_FRAMING)
+			return false;
+		_framingMode = framingMode;
+		_syncFramer.clearRx();
+		_fskDemod.holdSyncDetector(false);
+		return true;
+	}
+
+	// Set the modulation - both ends must use the same mode (and spreading factor)
+	// Chirps carry spreadingFactor bits per 2^spreadingFactor / 2000 seconds so each
+	// step up in spreading factor roughly halves the bit rate and gains about 2.5dB
+	// OFDM QPSK carries 4200 bits/s and DBPSK 2100 bits/s (more tolerant of noise)
+	// Returns false if the modulation (or the spreading factor) is not in the configuration
+	bool setModulationMode(ModulationMode modulationMode, int spreadingFactor = DEFAULT_CHIRP_SPREADING_FACTOR)
+	{
+		if (modulationMode == MODULATION_CHIRP)
+		{
+			if (Config::ENABLE_TX && !_chirpMod.setup(SAMPLE_RATE_PER_SEC, CHIRP_FREQ_LOW, CHIRP_BANDWIDTH, spreadingFactor))
+				return false;
+			if (!_chirpDemod.setup(SAMPLE_RATE_PER_SEC, CHIRP_FREQ_LOW, CHIRP_BANDWIDTH, spreadingFactor))
+				return false;
+		}
+		else if ((modulationMode == MODULATION_OFDM_QPSK) || (modulationMode == MODULATION_OFDM_DBPSK))
+		{
+			OFDMMod::CarrierModulation carrierModulation =
+						(modulationMode == MODULATION_OFDM_QPSK) ? OFDMMod::OFDM_QPSK : OFDMMod::OFDM_DBPSK;
+			if (Config::ENABLE_TX && !_ofdmMod.setup(SAMPLE_RATE_PER_SEC, OFDM_FREQ_LOW, OFDM_FREQ_HIGH, carrierModulation))
+				return false;
+			if (!_ofdmDemod.setup(SAMPLE_RATE_PER_SEC, OFDM_FREQ_LOW, OFDM_FREQ_HIGH, carrierModulation))
+				return false;
+		}
+		_modulationMode = modulationMode;
 		_fskMod.clear();
-		_fskMod.addPreamble();
-		_hdlc.sendFrame((const uint8_t*)msg, strlen(msg));
-		_fskMod.addPostamble();
+		_chirpMod.clear();
+		_ofdmMod.clear();
+		_syncFramer.clearRx();
+		_fskDemod.holdSyncDetector(false);
+		return true;
+	}
+
+	// Enable combining of repeated transmissions - failed copies of a message are
+	// kept and combined so that a looped message can get through on a poor link
+	// Returns false if combining is not in the configuration
+	bool enableRepeatCombining(bool enable)
+	{
+		if (!Config::ENABLE_REPEAT_COMBINING)
+			return !enable;
+		_hdlc.enableRepeatCombining(enable, _repeatCombineWork.get());
+		return true;
+	}
+
+	// Enable correction of bit errors in frames up to maxFrameLen bytes using the CRC
+	// (limited to MAX_CORRECTION_FRAME_LEN in the configuration)
+	// Double bit correction is only tried in frames up to MiniHDLC::MAX_DOUBLE_BIT_FRAME_LEN
+	// (16) bytes and there it delivers 8.3% of garbled frames (single bit 0.17%) - see
+	// MiniHDLC::enableErrorCorrection()
+	// Returns false if correction is not in the configuration
+	bool enableErrorCorrection(int maxFrameLen, bool doubleBit = false)
+	{
+		if (CORRECTION_MAX_FRAME_LEN == 0)
+			return maxFrameLen <= 0;
+		if (maxFrameLen > CORRECTION_MAX_FRAME_LEN)
+			maxFrameLen = CORRECTION_MAX_FRAME_LEN;
+		_hdlc.enableErrorCorrection(maxFrameLen, doubleBit, _syndromeByPos.get(), _syndromeSorted.get());
+		return true;
+	}
+
+	// Enable reception of fountain coded carousels (see encodeCarouselToSamples()) -
+	// packets are collected and the payload is received as a single frame once
+	// enough have arrived - other frames are received as before
+	// Returns false if fountain coding is not in the configuration
+	bool enableFountainReceive(bool enable)
+	{
+		if (!Config::ENABLE_FOUNTAIN)
+			return !enable;
+		_fountainDecoder.clear();
+		_fountainReceiveEnabled = enable;
+		return true;
+	}
+
+	// Fountain decoder for progress (packets held of those needed)
+	FountainDecoderType& getFountainDecoder()
+	{
+		return _fountainDecoder;
+	}
+
+	// Enable addressed frames (see FrameAddress) - both ends must agree
+	// Frames received are only those for deviceId, one of the groups in groupMask or
+	// broadcast - others are dropped by the framer as soon as their address arrives
+	// and the address is removed from frames received (see decodeGetFrameAddress())
+	// Frames sent without an address are sent to FrameAddress::BROADCAST
+	void enableAddressing(bool enable, uint16_t deviceId = 0, uint16_t groupMask = 0)
+	{
+		FrameAddress filter(deviceId, groupMask);
+		_addressingEnabled = enable;
+		_hdlc.enableAddressFilter(enable, filter);
+		_syncFramer.enableAddressFilter(enable, filter);
+	}
+
+	// Frames dropped as they were for other devices
+	int getRejectedFrameCount()
+	{
+		return _hdlc.getRejectedFrameCount() + _syncFramer.getRejectedFrameCount();
+	}
+
+	// Generate audio samples for a message (sent to an address - see FrameAddress -
+	// if addressing is enabled)
+	// Samples are generated as they are requested so the message must remain
+	// valid until encodeGetSample() returns false
+	// Returns false (and no samples are generated) if the message is too long for
+	// the framing (SyncFramer::MAX_PAYLOAD_LEN including the address in sync mode)
+	bool encodeMessageToSamples(const char* msg, uint16_t address = FrameAddress::BROADCAST)
+	{
+		_carouselActive = false;
+		_txQueueSendLen = 0;
+		_txQueuePos = 0;
+		_txBlockLen = 0;
+		_txBlockPos = 0;
+		return startTxFrame((const uint8_t*)msg, strlen(msg), address);
+	}
+
+	// Queue a message for a device or group (see FrameAddress) - the queue is sent by
+	// encodeTxQueueToSamples() so one transmission can carry a different message
+	// (e.g. credentials) for each device - the data must remain valid until sent
+	// Returns false if the queue is full (Config::TX_QUEUE_LEN) or being sent
+	bool queueAddressedMessage(uint16_t address, const uint8_t* pData, int len)
+	{
+		if ((_txQueueCount >= TX_QUEUE_LEN) || (_txQueuePos < _txQueueSendLen))
+			return false;
+		TxQueueEntry& entry = _txQueue.get()[_txQueueCount++];
+		entry.pData = pData;
+		entry.len = len;
+		entry.address = address;
+		return true;
+	}
+
+	// Generate audio samples for the queued messages one after another (each in
+	// its own frame with a preamble) - the queue is emptied as they are sent
+	// Addressing must be enabled - returns false if it isn't or the queue is empty
+	// Sending stops at a message that is too long for the framing
+	bool encodeTxQueueToSamples()
+	{
+		if (!_addressingEnabled || (_txQueueCount == 0))
+			return false;
+		_carouselActive = false;
+		_txQueueSendLen = _txQueueCount;
+		_txQueuePos = 0;
+		_txBlockLen = 0;
+		_txBlockPos = 0;
+		return startNextTxFrame();
+	}
+
+	// Generate audio samples for a fountain coded carousel of a payload - packets
+	// (see FountainEncoder) are sent one after another, each in its own frame with a
+	// preamble, so receivers can start at any point and decode once they have any
+	// few more packets than the payload has blocks
+	// numPackets is the number to send (0 for endless) and blockLen the packet data
+	// length (0 to choose) - the payload must remain valid while samples are generated
+	// With blockLen 0 a payload of up to CAROUSEL_REPEAT_MAX_LEN is sent as it is in
+	// each frame (receivers get every copy that arrives) - fountain coded it takes
+	// longer to receive at any loss rate - from tools/FountainBench (mean time to receive
+	// against the loss rate of a 2.3s packet) repeating a 128 byte payload is quicker
+	// up to about 10% loss and a 256 byte one only without loss, beyond that and for
+	// longer payloads the carousel wins by more the more is lost
+	// Returns false if fountain coding is not in the configuration or the payload
+	// is too long (it must fit in FountainEncoder::MAX_SOURCE_BLOCKS blocks)
+	bool encodeCarouselToSamples(const uint8_t* pPayload, int payloadLen, int numPackets = 0, int blockLen = 0)
+	{
+		// A short payload is repeated unless it could be taken for a fountain packet
+		_pCarouselRepeat = NULL;
+		_carouselRepeatLen = 0;
+		if (Config::ENABLE_FOUNTAIN && (blockLen == 0) && (payloadLen > 0) && (payloadLen <= CAROUSEL_REPEAT_MAX_LEN) &&
+					!FountainDecoder::isFountainPacket(pPayload, payloadLen))
+		{
+			_pCarouselRepeat = pPayload;
+			_carouselRepeatLen = payloadLen;
+		}
+
+		// The message id is taken from the payload so receivers that have it
+		// ignore later packets and start again when the payload changes
+		uint16_t crc = MiniHDLC::CRC16_CCITT_INIT_VAL;
+		for (int i = 0; i < payloadLen; i++)
+			crc = MiniHDLC::crcUpdateCCITT(crc, pPayload[i]);
+		if (!_fountainEncoder.setup(pPayload, payloadLen, blockLen, crc & 0xff))
+			return false;
+		_carouselActive = true;
+		_carouselPacketsLeft = (numPackets > 0) ? numPackets : -1;
+		_txQueueSendLen = 0;
+		_txQueuePos = 0;
+		_txBlockLen = 0;
+		_txBlockPos = 0;
+		return startNextTxFrame();
 	}
 
 	// Get next audio sample for message
 	// Returns false if no sample available
 	bool encodeGetSample(int& sampleValue)
 	{
-		return _fskMod.getSample(sampleValue);
+		while (true)
+		{
+			if (_modulationMode == MODULATION_CHIRP)
+			{
+				if (_chirpMod.getSample(sampleValue))
+					return true;
+			}
+			else if (isOFDM())
+			{
+				if (_ofdmMod.getSample(sampleValue))
+					return true;
+			}
+			else if (_fskMod.getSample(sampleValue))
+			{
+				return true;
+			}
+
+			// The next packet of a carousel or queued message
+			if (!startNextTxFrame())
+				return false;
+		}
+	}
+
+	// Get a block of audio samples for a message
+	// Returns the number of samples (less than maxSamples once the message ends)
+	int encodeGetSamples(int16_t* pSamples, int maxSamples)
+	{
+		int numSamples = 0;
+		int sampleVal = 0;
+		while ((numSamples < maxSamples) && encodeGetSample(sampleVal))
+			pSamples[numSamples++] = saturateS16(sampleVal);
+		return numSamples;
+	}
+
+	// Get a block of 8 bit audio samples (SAMPLE_FORMAT_U8 or SAMPLE_FORMAT_ULAW)
+	int encodeGetSamples(uint8_t* pSamples, int maxSamples, SampleFormat format)
+	{
+		int16_t samples[AUDIO_BLOCK_LEN];
+		int numSamples = 0;
+		while (numSamples < maxSamples)
+		{
+			int blockLen = (maxSamples - numSamples < AUDIO_BLOCK_LEN) ? maxSamples - numSamples : AUDIO_BLOCK_LEN;
+			int numGot = encodeGetSamples(samples, blockLen);
+			samplesFromS16(samples, format, pSamples + numSamples, numGot);
+			numSamples += numGot;
+			if (numGot < blockLen)
+				break;
+		}
+		return numSamples;
+	}
+
+	// Send the audio for a message (started with encodeMessageToSamples()) to a sink
+	// Call until it returns false (all samples accepted by the sink)
+	bool encodeToSink(AudioSink& sink)
+	{
+		while (true)
+		{
+			// Next block
+			if (_txBlockPos >= _txBlockLen)
+			{
+				_txBlockLen = 0;
+				_txBlockPos = 0;
+				_txBlockLen = encodeGetSamples(_txBlock.get(), TX_BLOCK_LEN);
+				if (_txBlockLen == 0)
+					return false;
+			}
+
+			// Stop if the sink is full
+			int numWritten = sink.write(_txBlock.get() + _txBlockPos, _txBlockLen - _txBlockPos);
+			if (numWritten < 0)
+				return false;
+			_txBlockPos += numWritten;
+			if (_txBlockPos < _txBlockLen)
+				return true;
+		}
 	}
 
 	// Process an audio sample
 	void decodeProcessSample(int sampleVal, FSKDemod::FSKDebugVals* pDebugVals = NULL)
 	{
-		// Process sample
-		_fskDemod.processSample(sampleVal, pDebugVals);
-		
-		// Get any bits received and send to hdlc
-		int bitVal = 0;
-		if (_fskDemod.getRxBit(bitVal))
-			_hdlc.handleBit(bitVal);
+		if (!_resampleInput)
+		{
+			demodSample(sampleVal, pDebugVals);
+			return;
+		}
+
+		// Resample to the modem rate
+		int16_t resampled[MAX_RESAMPLED_PER_INPUT];
+		int numResampled = _inputResampler.processSample(sampleVal, resampled);
+		for (int i = 0; i < numResampled; i++)
+			demodSample(resampled[i], pDebugVals);
+	}
+
+	// Process a block of audio samples
+	void decodeProcessSamples(const int16_t* pSamples, int numSamples)
+	{
+		for (int i = 0; i < numSamples; i++)
+			decodeProcessSample(pSamples[i]);
+	}
+
+	// Process a block of 8 bit audio samples (SAMPLE_FORMAT_U8 or SAMPLE_FORMAT_ULAW)
+	// e.g. from the web transmitter or a compact capture
+	void decodeProcessSamples(const uint8_t* pSamples, int numSamples, SampleFormat format)
+	{
+		int16_t samples[AUDIO_BLOCK_LEN];
+		while (numSamples > 0)
+		{
+			int blockLen = (numSamples < AUDIO_BLOCK_LEN) ? numSamples : AUDIO_BLOCK_LEN;
+			samplesToS16(pSamples, format, samples, blockLen);
+			decodeProcessSamples(samples, blockLen);
+			pSamples += blockLen;
+			numSamples -= blockLen;
+		}
+	}
+
+	// Decode a block of audio from a source
+	// Returns the number of samples processed or -1 at the end of the stream
+	int decodeFromSource(AudioSource& source)
+	{
+		int16_t samples[AUDIO_BLOCK_LEN];
+		int numSamples = source.read(samples, AUDIO_BLOCK_LEN);
+		if (numSamples > 0)
+			decodeProcessSamples(samples, numSamples);
+		return numSamples;
 	}
 
+#ifdef ARDUINO
 	// Get a message if available
 	bool decodeGetMessage(String& msg)
 	{
 		if (_rxReady)
 		{
-			msg = _rxMessage;
-			_rxReady = false;
+			msg = (const char*) _pRxFrame;
+			decodeClearMessage();
 			return true;
 		}
 		return false;
 	}
+#endif
 
-	// Clear ready message
+	// Get a received frame (binary and null terminated) if available without copying
+	// The frame remains valid (and no other frame is received) until
+	// decodeClearMessage() is called
+	bool decodeGetFrame(const uint8_t*& pFrame, int& frameLen)
+	{
+		if (!_rxReady)
+			return false;
+		pFrame = _pRxFrame;
+		frameLen = _rxFrameLen;
+		return true;
+	}
+
+	// Address of the received frame (FrameAddress::BROADCAST if addressing is disabled)
+	uint16_t decodeGetFrameAddress()
+	{
+		return _rxFrameAddress;
+	}
+
+	// Clear ready message - the framer holding it starts receiving again
 	void decodeClearMessage()
 	{
+		if (!_rxReady)
+			return;
 		_rxReady = false;
+		_hdlc.holdRx(false);
+		_syncFramer.holdRx(false);
 	}
 
 private:
-	// Callback from HDLC encode when a bit is ready to be "sent" 
-	void putBit(uint8_t bit)
+	// Equaliser for the demodulator - NULL if it is not in the configuration
+	static FSKEqualiser* equaliserPtr(FSKEqualiser& equaliser)
+	{
+		return &equaliser;
+	}
+	static FSKEqualiser* equaliserPtr(SpeakUpOmittedPart&)
+	{
+		return NULL;
+	}
+
+	// Handle a sample at the modem rate
+	void demodSample(int sampleVal, FSKDemod::FSKDebugVals* pDebugVals)
+	{
+		if (_spectrumMonitorEnabled)
+			_spectrumMonitor.processSample(sampleVal);
+		if (!_squelchEnabled)
+		{
+			demodulate(sampleVal, pDebugVals);
+			return;
+		}
+
+		// Only the energy detector runs while squelched - once open the buffered
+		// lookback is fed through the demodulator faster than real time to catch up
+		if (!_squelch.processSample(sampleVal))
+			return;
+		int bufferedVal = 0;
+		for (int i = 0; (i < SQUELCH_CATCHUP_RATE) && _squelch.getSample(bufferedVal); i++)
+			demodulate(bufferedVal, pDebugVals);
+	}
+
+	// Demodulate a sample
+	void demodulate(int sampleVal, FSKDemod::FSKDebugVals* pDebugVals)
 	{
-		_fskMod.addSymbol(bit);
+		// Process sample
+		uint32_t rxBits = 0;
+		int numBits = 0;
+		if (_modulationMode == MODULATION_CHIRP)
+		{
+			_chirpDemod.processSample(sampleVal);
+			numBits = _chirpDemod.getRxBits(rxBits, 32);
+		}
+		else if (isOFDM())
+		{
+			_ofdmDemod.processSample(sampleVal);
+			numBits = _ofdmDemod.getRxBits(rxBits, 32);
+		}
+		else
+		{
+			_fskDemod.processSample(sampleVal, pDebugVals);
+			numBits = _fskDemod.getRxBits(rxBits, 32);
+		}
+
+		// Send any bits received to the framer
+		if (numBits <= 0)
+			return;
+		if (_framingMode == FRAMING_HDLC)
+		{
+			_hdlc.handleBits(rxBits, numBits);
+			return;
+		}
+
+		// The sync word can occur in the payload so sync detection is held during a frame
+		_syncFramer.handleBits(rxBits, numBits);
+		if (_modulationMode == MODULATION_FSK)
+			_fskDemod.holdSyncDetector(_syncFramer.isRxInFrame());
+	}
+
+	// Sum of the part footprints from a part on
+	static constexpr int footprintSum(int part)
+	{
+		return (part >= FOOTPRINT_OTHER) ? 0 : getFootprintBytes(part) + footprintSum(part + 1);
+	}
+
+	// Start sending a frame - returns false (with the modulators idle) if the
+	// framer can't take it
+	bool startTxFrame(const uint8_t* pData, int len, uint16_t address)
+	{
+		_fskMod.clear();
+		_chirpMod.clear();
+		_ofdmMod.clear();
+		int frameAddress = _addressingEnabled ? address : FrameAddress::NONE;
+		if (_framingMode == FRAMING_SYNC)
+		{
+			if (!_syncFramer.startTxFrame(pData, len, frameAddress))
+				return false;
+		}
+		else
+		{
+			_hdlc.startTxFrame(pData, len, frameAddress);
+		}
+		if (_modulationMode == MODULATION_CHIRP)
+			_chirpMod.startStream();
+		else if (isOFDM())
+			_ofdmMod.startStream();
+		else
+			_fskMod.startStream();
+		return true;
+	}
+
+	// Start the next packet of a carousel or the next queued message - returns
+	// false if there are no more (or the framer can't take it)
+	bool startNextTxFrame()
+	{
+		if (_txQueuePos < _txQueueSendLen)
+		{
+			const TxQueueEntry& entry = _txQueue.get()[_txQueuePos++];
+			if (_txQueuePos == _txQueueSendLen)
+				_txQueueCount = 0;
+			return startTxFrame(entry.pData, entry.len, entry.address);
+		}
+		if (!_carouselActive || (_carouselPacketsLeft == 0))
+			return false;
+		const uint8_t* pPacket = _pCarouselRepeat;
+		int packetLen = _carouselRepeatLen;
+		if (!pPacket)
+			packetLen = _fountainEncoder.getNextPacket(pPacket);
+		if (packetLen <= 0)
+			return false;
+		if (_carouselPacketsLeft > 0)
+			_carouselPacketsLeft--;
+		return startTxFrame(pPacket, packetLen, FrameAddress::BROADCAST);
+	}
+
+	bool isOFDM()
+	{
+		return (_modulationMode == MODULATION_OFDM_QPSK) || (_modulationMode == MODULATION_OFDM_DBPSK);
+	}
+
+	// Callback from modulator when the next symbol is needed
+	bool getTxSymbol(int& symbol)
+	{
+		uint8_t bit = 0;
+		bool bitValid = (_framingMode == FRAMING_SYNC) ? _syncFramer.getTxBit(bit) : _hdlc.getTxBit(bit);
+		if (!bitValid)
+			return false;
+		symbol = bit;
+		return true;
 	}
 
 	// Callback from HDLC decode when a frame is complete
 	void rxFrame(const uint8_t *framebufferNullTerminated, int framelength)
 	{
+		// The chirp and OFDM demodulators look for the next preamble once a frame is complete
+		if (_modulationMode == MODULATION_CHIRP)
+			_chirpDemod.restartSearch();
+		else if (isOFDM())
+			_ofdmDemod.restartSearch();
+
+		// The address has already been checked by the framer
+		uint16_t frameAddress = FrameAddress::BROADCAST;
+		if (_addressingEnabled)
+		{
+			if (framelength < FrameAddress::ADDRESS_LEN)
+				return;
+			frameAddress = FrameAddress::fromBytes(framebufferNullTerminated);
+			framebufferNullTerminated += FrameAddress::ADDRESS_LEN;
+			framelength -= FrameAddress::ADDRESS_LEN;
+		}
+
+		// Fountain packets are collected until the payload is complete
+		if (_fountainReceiveEnabled && FountainDecoder::isFountainPacket(framebufferNullTerminated, framelength))
+		{
+			if (_rxReady || !_fountainDecoder.handlePacket(framebufferNullTerminated, framelength))
+				return;
+			const uint8_t* pPayload = NULL;
+			int payloadLen = 0;
+			_fountainDecoder.getPayload(pPayload, payloadLen);
+			framebufferNullTerminated = pPayload;
+			framelength = payloadLen;
+		}
+
 		// Check if previous message not handled
 		if (_rxReady)
 			return;
-			
-		// Store the message as a string
-		_rxMessage = (const char*) framebufferNullTerminated;
+
+		// Frames that don't fit are dropped
+		if (framelength > Config::MAX_FRAME_LEN)
+			return;
+
+		// The frame is used in place (it is null terminated so it can be used as a
+		// string) - the framer is held until it has been read
+		_pRxFrame = framebufferNullTerminated;
+		_rxFrameLen = framelength;
+		_rxFrameAddress = frameAddress;
 		_rxReady = true;
+		if (_framingMode == FRAMING_HDLC)
+			_hdlc.holdRx(true);
+		else
+			_syncFramer.holdRx(true);
 	}
 };
+
+// SpeakUp with everything included
+typedef SpeakUpT<SpeakUpDefaultConfig> SpeakUp;
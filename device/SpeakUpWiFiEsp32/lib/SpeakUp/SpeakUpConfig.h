@@ -0,0 +1,246 @@
+// SpeakUpConfig
+// Compile-time configurations for SpeakUpT - the modem settings, buffer sizes and the
+// parts included are all constants so every buffer is a fixed size member of the
+// SpeakUpT object and nothing is allocated from the heap
+// A configuration derives from one here and overrides the values that differ
+
+#pragma once
+
+#include <stddef.h>
+
+// Everything but the equaliser and the input resampler - the settings SpeakUp has always had
+struct SpeakUpDefaultConfig
+{
+	// Modem
+	static const int SAMPLE_RATE = 8000;
+	static const int SYMBOL_RATE = 100;
+	static const int SYMBOL_FREQ_LOW = 1000;
+	static const int SYMBOL_FREQ_HIGH = 2000;
+
+	// FIFO lengths in bits - the receive FIFO is emptied as each sample is processed
+	static const int TX_BITS_FIFO_LEN = 16;
+	static const int RX_BITS_FIFO_LEN = 4000;
+
+	// Longest frame received (not including the CRC or any address)
+	static const int MAX_FRAME_LEN = 2048;
+
+	// Audio block held for encodeToSink()
+	static const int TX_AUDIO_BLOCK_LEN = 128;
+
+	// Addressed messages that can be queued for one transmission
+	static const int TX_QUEUE_LEN = 8;
+
+	// Parts - a part left out takes no memory and can't be enabled or selected
+	static const bool ENABLE_TX = true;
+	static const bool ENABLE_SYNC_DETECT = true;
+	static const bool ENABLE_EQUALISER = false;
+	static const bool ENABLE_SYNC_FRAMING = true;
+	static const bool ENABLE_REPEAT_COMBINING = true;
+	static const bool ENABLE_OFDM = true;
+	static const bool ENABLE_SQUELCH = true;
+	static const bool ENABLE_SPECTRUM_MONITOR = true;
+	static const bool ENABLE_FOUNTAIN = true;
+
+	// Longest frame (including the CRC) that errors can be corrected in (0 for none)
+	static const int MAX_CORRECTION_FRAME_LEN = 128;
+
+	// Highest chirp spreading factor (0 for no chirp modulation)
+	static const int CHIRP_MAX_SPREADING_FACTOR = 10;
+
+	// Input resampler storage (0 for input at the modem rate only) - left out as the
+	// coefficients for the 44.1KHz family take about 15KB (see SpeakUpResamplingConfig)
+	static const int RESAMPLER_MAX_COEFFS = 0;
+	static const int RESAMPLER_MAX_HISTORY = 0;
+
+	// RAM budget for the whole SpeakUpT object checked at compile time (0 for none)
+	static const int RAM_BUDGET_BYTES = 0;
+};
+
+// Receive WiFi credentials only - FSK and HDLC with frames big enough for an SSID,
+// password and channel in either the binary or JSON format
+struct SpeakUpCredentialsConfig : SpeakUpDefaultConfig
+{
+	static const int RX_BITS_FIFO_LEN = 32;
+	static const int MAX_FRAME_LEN = 128;
+	static const int TX_AUDIO_BLOCK_LEN = 1;
+	static const bool ENABLE_TX = false;
+	static const bool ENABLE_SYNC_DETECT = false;
+	static const bool ENABLE_EQUALISER = false;
+	static const bool ENABLE_SYNC_FRAMING = false;
+	static const bool ENABLE_REPEAT_COMBINING = false;
+	static const bool ENABLE_OFDM = false;
+	static const bool ENABLE_SQUELCH = false;
+	static const bool ENABLE_SPECTRUM_MONITOR = false;
+	static const bool ENABLE_FOUNTAIN = false;
+	static const int MAX_CORRECTION_FRAME_LEN = 0;
+	static const int CHIRP_MAX_SPREADING_FACTOR = 0;
+
+	// About 1KB on the ESP32 - the budget allows for the larger pointers and
+	// std::function of a 64 bit host
+	static const int RAM_BUDGET_BYTES = 1280;
+};
+
+// Receive only - FSK and HDLC with the diagnostics and robustness parts used by the
+// credentials receiver example
+struct SpeakUpReceiverConfig : SpeakUpDefaultConfig
+{
+	static const int RX_BITS_FIFO_LEN = 64;
+	static const int MAX_FRAME_LEN = 256;
+	static const int TX_AUDIO_BLOCK_LEN = 1;
+	static const bool ENABLE_TX = false;
+	static const bool ENABLE_EQUALISER = false;
+	static const bool ENABLE_SYNC_FRAMING = false;
+	static const bool ENABLE_OFDM = false;
+	static const int CHIRP_MAX_SPREADING_FACTOR = 0;
+};
+
+// Everything including the FSK equaliser - for reverberant rooms at symbol rates above
+// the default (at 100 baud it has nothing to remove - see tools/EqualiserBench)
+struct SpeakUpEqualiserConfig : SpeakUpDefaultConfig
+{
+	static const bool ENABLE_EQUALISER = true;
+};
+
+// Everything including the equaliser and the input resampler - for audio at any standard
+// rate (see Resampler::filterSize()) - the 44.1KHz family needs the most coefficients as
+// its ratio to 8KHz doesn't reduce (11.025KHz 7360, 22.05KHz 7200, 44.1KHz 7120) and the
+// history grows with the rate (96KHz needs 384) - this covers the standard rates from
+// 11.025KHz to 96KHz - setInputSampleRate() fails for others
+struct SpeakUpResamplingConfig : SpeakUpEqualiserConfig
+{
+	static const int RESAMPLER_MAX_COEFFS = 7360;
+	static const int RESAMPLER_MAX_HISTORY = 384;
+};
+
+// Fixed size storage for a part - takes no space (beyond a byte) when LEN is 0
+template<typename T, int LEN>
+struct SpeakUpStorage
+{
+	T buf[LEN];
+	T* get()
+	{
+		return buf;
+	}
+};
+
+template<typename T>
+struct SpeakUpStorage<T, 0>
+{
+	T* get()
+	{
+		return NULL;
+	}
+};
+
+// Stand-in for a part left out of a configuration - it accepts the calls SpeakUpT
+// makes and does nothing (setup fails and there is never any output)
+class SpeakUpOmittedPart
+{
+public:
+	template<typename... Args>
+	SpeakUpOmittedPart(Args&&...)
+	{
+	}
+	template<typename... Args>
+	bool setup(Args&&...)
+	{
+		return false;
+	}
+	template<typename... Args>
+	int processSample(Args&&...)
+	{
+		return 0;
+	}
+	template<typename... Args>
+	int getRxBits(Args&&...)
+	{
+		return 0;
+	}
+	template<typename... Args>
+	bool getSample(Args&&...)
+	{
+		return false;
+	}
+	template<typename... Args>
+	void setBitSource(Args&&...)
+	{
+	}
+	template<typename... Args>
+	void setSymbolSource(Args&&...)
+	{
+	}
+	template<typename... Args>
+	void setPreamble(Args&&...)
+	{
+	}
+	template<typename... Args>
+	bool startTxFrame(Args&&...)
+	{
+		return false;
+	}
+	template<typename... Args>
+	bool getTxBit(Args&&...)
+	{
+		return false;
+	}
+	template<typename... Args>
+	void handleBits(Args&&...)
+	{
+	}
+	template<typename... Args>
+	int addBand(Args&&...)
+	{
+		return -1;
+	}
+	template<typename... Args>
+	bool handlePacket(Args&&...)
+	{
+		return false;
+	}
+	template<typename... Args>
+	int getNextPacket(Args&&...)
+	{
+		return 0;
+	}
+	template<typename... Args>
+	bool getPayload(Args&&...)
+	{
+		return false;
+	}
+	template<typename... Args>
+	void enableAddressFilter(Args&&...)
+	{
+	}
+	template<typename... Args>
+	void holdRx(Args&&...)
+	{
+	}
+	void startStream()
+	{
+	}
+	void clear()
+	{
+	}
+	void clearRx()
+	{
+	}
+	void restartSearch()
+	{
+	}
+	bool isRxInFrame()
+	{
+		return false;
+	}
+	bool isPassthrough()
+	{
+		return true;
+	}
+	int getState()
+	{
+		return 0;
+	}
+	int getRejectedFrameCount()
+	{
+		return 0;
+	}
+};
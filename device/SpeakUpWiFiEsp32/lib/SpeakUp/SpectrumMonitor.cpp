@@ -0,0 +1,168 @@
+// SpectrumMonitor
+// Low duty cycle spectrum analysis
+
+#include "SpectrumMonitor.h"
+#include "FixedFFT.h"
+#include <cmath>
+
+SpectrumMonitor::SpectrumMonitor()
+{
+	for (int i = 0; i < FFT_SIZE; i++)
+		_window[i] = (int16_t)lround(16383.5 * (1 - cos(2 * M_PI * i / FFT_SIZE)));
+	_sampleRate = 0;
+	_analysisInterval = DEFAULT_ANALYSIS_INTERVAL;
+	_numBands = 0;
+	clear();
+}
+
+bool SpectrumMonitor::setup(int sampleRate, int analysisInterval)
+{
+	if ((sampleRate <= 0) || (analysisInterval < 1))
+		return false;
+	_sampleRate = sampleRate;
+	_analysisInterval = analysisInterval;
+	_numBands = 0;
+	clear();
+	return true;
+}
+
+int SpectrumMonitor::addBand(int freqLow, int freqHigh)
+{
+	if ((_numBands >= MAX_BANDS) || (_sampleRate <= 0) || (freqLow < 0) || (freqHigh < freqLow))
+		return -1;
+	Band& band = _bands[_numBands];
+	band.firstBin = (freqLow * FFT_SIZE + _sampleRate / 2) / _sampleRate;
+	band.lastBin = (freqHigh * FFT_SIZE + _sampleRate / 2) / _sampleRate;
+	if (band.firstBin < 1)
+		band.firstBin = 1;
+	if (band.lastBin > FFT_SIZE / 2 - 2)
+		band.lastBin = FFT_SIZE / 2 - 2;
+	if (band.lastBin < band.firstBin)
+		return -1;
+	band.noiseFloor = -1;
+	band.peak = 0;
+	band.level = 0;
+	band.toneFreqSum = 0;
+	band.tonePowerSum = 0;
+	band.toneBlocks = 0;
+	return _numBands++;
+}
+
+void SpectrumMonitor::clear()
+{
+	_blockPos = 0;
+	_skipSamples = 0;
+	_prevSample = 0;
+	_peakSample = 0;
+	_flatTopSamples = 0;
+	_blocksAnalysed = 0;
+	for (int i = 0; i < _numBands; i++)
+	{
+		_bands[i].noiseFloor = -1;
+		_bands[i].peak = 0;
+		_bands[i].level = 0;
+		_bands[i].toneFreqSum = 0;
+		_bands[i].tonePowerSum = 0;
+		_bands[i].toneBlocks = 0;
+	}
+}
+
+void SpectrumMonitor::analyseBlock()
+{
+	// Input level and flat tops
+	for (int i = 0; i < FFT_SIZE; i++)
+	{
+		int sampleVal = _block[i];
+		int absVal = sampleVal < 0 ? -sampleVal : sampleVal;
+		if (absVal > _peakSample)
+			_peakSample = absVal;
+		if ((sampleVal == _prevSample) && (absVal >= FLAT_TOP_MIN_LEVEL))
+			_flatTopSamples++;
+		_prevSample = sampleVal;
+	}
+
+	// Windowed transform
+	for (int i = 0; i < FFT_SIZE; i++)
+	{
+		_fftRe[i] = ((_block[i] * _window[i]) >> 15) << FFT_INPUT_SHIFT;
+		_fftIm[i] = 0;
+	}
+	FixedFFT::transform(_fftRe, _fftIm, FFT_LOG2_SIZE);
+	_blocksAnalysed++;
+
+	for (int bandIdx = 0; bandIdx < _numBands; bandIdx++)
+	{
+		// Peak and mean power over the band
+		Band& band = _bands[bandIdx];
+		int peakBin = band.firstBin;
+		float peakPower = 0;
+		float sumPower = 0;
+		for (int bin = band.firstBin; bin <= band.lastBin; bin++)
+		{
+			float power = (float)FixedFFT::power(_fftRe[bin], _fftIm[bin]);
+			sumPower += power;
+			if (power > peakPower)
+			{
+				peakPower = power;
+				peakBin = bin;
+			}
+		}
+		float meanPower = sumPower / (band.lastBin - band.firstBin + 1);
+
+		// Noise floor from the mean of quiet blocks
+		if ((band.noiseFloor < 0) || (meanPower < band.noiseFloor))
+			band.noiseFloor = meanPower;
+		else
+			band.noiseFloor += (meanPower - band.noiseFloor) * NOISE_FLOOR_RISE;
+		band.level = peakPower;
+		if (peakPower > band.peak)
+			band.peak = peakPower;
+		if (peakPower <= band.noiseFloor * TONE_RATIO)
+			continue;
+
+		// Tone frequency - for a Hann window a tone a fraction d of a bin from the peak
+		// makes the larger neighbour a = (1 + d) / (2 - d) of the peak in magnitude
+		float peakMag = sqrtf(peakPower);
+		float belowMag = sqrtf((float)FixedFFT::power(_fftRe[peakBin - 1], _fftIm[peakBin - 1]));
+		float aboveMag = sqrtf((float)FixedFFT::power(_fftRe[peakBin + 1], _fftIm[peakBin + 1]));
+		float ratio = (aboveMag > belowMag ? aboveMag : belowMag) / peakMag;
+		float fraction = (2 * ratio - 1) / (ratio + 1);
+		if (fraction < 0)
+			fraction = 0;
+		float toneBin = aboveMag > belowMag ? peakBin + fraction : peakBin - fraction;
+		band.toneFreqSum += toneBin * _sampleRate / FFT_SIZE * peakPower;
+		band.tonePowerSum += peakPower;
+		band.toneBlocks++;
+	}
+}
+
+bool SpectrumMonitor::getBandStats(int bandIdx, BandStats& stats)
+{
+	if ((bandIdx < 0) || (bandIdx >= _numBands))
+		return false;
+	Band& band = _bands[bandIdx];
+	float noiseFloor = band.noiseFloor > 0 ? band.noiseFloor : 0;
+	stats.noiseFloorDb = powerToDb(noiseFloor);
+	stats.peakDb = powerToDb(band.peak);
+	stats.levelDb = powerToDb(band.level);
+	stats.toneBlocks = band.toneBlocks;
+	stats.toneFreqHz = 0;
+	stats.snrDb = 0;
+	if ((band.toneBlocks > 0) && (band.tonePowerSum > 0))
+	{
+		stats.toneFreqHz = band.toneFreqSum / band.tonePowerSum;
+		stats.snrDb = powerToDb(band.tonePowerSum / band.toneBlocks) - stats.noiseFloorDb;
+	}
+	return true;
+}
+
+// A full scale sine centred on a bin gives (32767 / 4) << FFT_INPUT_SHIFT in that bin
+// (half from the window and half from the negative frequency)
+float SpectrumMonitor::powerToDb(float power)
+{
+	static const float FULL_SCALE_MAG = (32767 / 4) << FFT_INPUT_SHIFT;
+	static const float MIN_POWER = 1.0f;
+	if (power < MIN_POWER)
+		power = MIN_POWER;
+	return 10 * log10f(power / (FULL_SCALE_MAG * FULL_SCALE_MAG));
+}
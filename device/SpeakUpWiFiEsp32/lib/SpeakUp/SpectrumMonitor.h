@@ -0,0 +1,139 @@
+// SpectrumMonitor
+// Low duty cycle spectrum analysis alongside the demodulator to show why a
+// reception failed - a noisy room, a clipping input or tones off frequency
+// One block of FFT_SIZE samples in every analysisInterval blocks is windowed and
+// transformed and each band keeps a noise floor, peak level, tone frequency and SNR
+// Samples of analysed blocks are also checked for flat tops (runs of equal large
+// values) which are left by clipping even after DC removal and AGC
+// Samples between analysed blocks cost only a count
+// Levels are in dB relative to a full scale sine
+
+#pragma once
+
+#include <stdint.h>
+
+class SpectrumMonitor
+{
+public:
+	static const int FFT_LOG2_SIZE = 8;
+	static const int FFT_SIZE = 1 << FFT_LOG2_SIZE;
+	static const int MAX_BANDS = 4;
+
+	// One 32ms block in every 32 (about once a second at 8KHz) - each halving of the
+	// interval roughly doubles the cost of the analysis but there is also a small cost
+	// for every sample (see tools/SpectrumMonitorBench)
+	static const int DEFAULT_ANALYSIS_INTERVAL = 32;
+
+	// Band statistics
+	struct BandStats
+	{
+		float noiseFloorDb;
+		float peakDb;
+		float levelDb;
+		float toneFreqHz;
+		float snrDb;
+		int toneBlocks;
+	};
+
+private:
+	// Settings
+	int _sampleRate;
+	int _analysisInterval;
+
+	// Hann window (Q15)
+	int16_t _window[FFT_SIZE];
+
+	// Block being collected - blocks between analyses are skipped
+	int16_t _block[FFT_SIZE];
+	int _blockPos;
+	int _skipSamples;
+	int32_t _fftRe[FFT_SIZE];
+	int32_t _fftIm[FFT_SIZE];
+
+	// Samples are shifted up before the FFT to keep precision
+	static const int FFT_INPUT_SHIFT = 8;
+
+	// Bands - powers are in FFT output units
+	struct Band
+	{
+		int firstBin;
+		int lastBin;
+		float noiseFloor;
+		float peak;
+		float level;
+		float toneFreqSum;
+		float tonePowerSum;
+		int toneBlocks;
+	};
+	Band _bands[MAX_BANDS];
+	int _numBands;
+
+	// Noise floor falls to a quieter block at once and rises slowly (per block)
+	static constexpr float NOISE_FLOOR_RISE = 0.02f;
+
+	// A block has a tone if its band peak exceeds the noise floor by this ratio (10dB)
+	static constexpr float TONE_RATIO = 10.0f;
+
+	// Flat tops - a sample equal to the previous one above this level
+	static const int FLAT_TOP_MIN_LEVEL = 8192;
+	int _prevSample;
+	int _peakSample;
+	int _flatTopSamples;
+	int _blocksAnalysed;
+
+public:
+	SpectrumMonitor();
+
+	// Setup - analyses one block in every analysisInterval (clears bands and stats)
+	bool setup(int sampleRate, int analysisInterval = DEFAULT_ANALYSIS_INTERVAL);
+
+	// Add a band to monitor - returns the band index or -1 if no more bands
+	int addBand(int freqLow, int freqHigh);
+
+	// Clear statistics
+	void clear();
+
+	// Process a sample
+	void processSample(int sampleVal)
+	{
+		// Samples between analysed blocks are skipped
+		if (_skipSamples > 0)
+		{
+			_skipSamples--;
+			return;
+		}
+
+		// Collect a block
+		_block[_blockPos] = sampleVal > 32767 ? 32767 : (sampleVal < -32768 ? -32768 : sampleVal);
+		if (++_blockPos < FFT_SIZE)
+			return;
+		_blockPos = 0;
+		_skipSamples = (_analysisInterval - 1) * FFT_SIZE;
+		analyseBlock();
+	}
+
+	// Get the statistics of a band - returns false if no such band
+	bool getBandStats(int bandIdx, BandStats& stats);
+
+	// Input statistics (of the analysed blocks)
+	int getPeakLevel()
+	{
+		return _peakSample;
+	}
+	int getFlatTopSamples()
+	{
+		return _flatTopSamples;
+	}
+	int getBlocksAnalysed()
+	{
+		return _blocksAnalysed;
+	}
+	int getSamplesAnalysed()
+	{
+		return _blocksAnalysed * FFT_SIZE;
+	}
+
+private:
+	void analyseBlock();
+	float powerToDb(float power);
+};
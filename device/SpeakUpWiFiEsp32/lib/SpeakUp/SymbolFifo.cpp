@@ -0,0 +1,99 @@
+// SymbolFifo
+// Interrupt-safe FIFO of symbols packed into 32 bit words
+
+#include "SymbolFifo.h"
+
+// Bits used to store a symbol and log2 of the symbols per word
+static int symbolStoreBits(int bitsPerSymbol)
+{
+	if (bitsPerSymbol <= 1)
+		return 1;
+	if (bitsPerSymbol == 2)
+		return 2;
+	return 4;
+}
+
+SymbolFifo::SymbolFifo(int maxSymbols, int bitsPerSymbol, uint32_t* pStorage) : _posn(0)
+{
+	_storeBits = symbolStoreBits(bitsPerSymbol);
+	_symbolsPerWordShift = wordShiftFor(bitsPerSymbol);
+	_symbolMask = (1 << _storeBits) - 1;
+	_numWords = storageWordsFor(maxSymbols, bitsPerSymbol);
+	if (pStorage)
+	{
+		_pBuf = pStorage;
+	}
+	else
+	{
+		_ownBuf.resize(_numWords);
+		_pBuf = _ownBuf.data();
+	}
+	_posn.init(_numWords << _symbolsPerWordShift);
+}
+
+bool SymbolFifo::putWord(uint32_t word)
+{
+	int symbolsInWord = 1 << _symbolsPerWordShift;
+	if ((int)_posn.space() < symbolsInWord)
+		return false;
+
+	// Aligned case is a single store
+	unsigned int pos = _posn.posToPut();
+	int wordIdx = pos >> _symbolsPerWordShift;
+	int bitPos = (pos & (symbolsInWord - 1)) * _storeBits;
+	if (bitPos == 0)
+	{
+		_pBuf[wordIdx] = word;
+	}
+	else
+	{
+		// Otherwise the symbols span two words - the symbols before the put
+		// position may not have been got yet so must be preserved
+		int nextIdx = (wordIdx + 1 >= _numWords) ? 0 : wordIdx + 1;
+		uint32_t lowMask = (1UL << bitPos) - 1;
+		_pBuf[wordIdx] = (_pBuf[wordIdx] & lowMask) | (word << bitPos);
+		_pBuf[nextIdx] = (_pBuf[nextIdx] & ~lowMask) | (word >> (32 - bitPos));
+	}
+	_posn.hasPut(symbolsInWord);
+	return true;
+}
+
+bool SymbolFifo::getWord(uint32_t& word)
+{
+	int symbolsInWord = 1 << _symbolsPerWordShift;
+	if ((int)_posn.count() < symbolsInWord)
+		return false;
+	getSymbols(word, symbolsInWord);
+	return true;
+}
+
+int SymbolFifo::getSymbols(uint32_t& packed, int maxSymbols)
+{
+	int symbolsInWord = 1 << _symbolsPerWordShift;
+	int numSymbols = _posn.count();
+	if (numSymbols > maxSymbols)
+		numSymbols = maxSymbols;
+	if (numSymbols > symbolsInWord)
+		numSymbols = symbolsInWord;
+	if (numSymbols <= 0)
+		return 0;
+
+	// Symbols may span two words
+	unsigned int pos = _posn.posToGet();
+	int wordIdx = pos >> _symbolsPerWordShift;
+	int bitPos = (pos & (symbolsInWord - 1)) * _storeBits;
+	uint32_t bits = _pBuf[wordIdx] >> bitPos;
+	if (bitPos != 0)
+	{
+		int nextIdx = (wordIdx + 1 >= _numWords) ? 0 : wordIdx + 1;
+		bits |= _pBuf[nextIdx] << (32 - bitPos);
+	}
+
+	// Mask off any symbols beyond those requested
+	int numBits = numSymbols * _storeBits;
+	if (numBits < 32)
+		bits &= (1UL << numBits) - 1;
+	packed = bits;
+	_posn.hasGot(numSymbols);
+	return numSymbols;
+}
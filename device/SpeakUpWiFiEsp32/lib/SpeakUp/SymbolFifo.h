@@ -0,0 +1,110 @@
+// SymbolFifo
+// Interrupt-safe FIFO of symbols packed into 32 bit words
+// Symbols of 1, 2 or 4 bits are stored in that many bits (3 bit symbols use 4) so a
+// binary symbol stream takes an eighth of the space of one symbol per byte
+// The first symbol in a word is in the least significant bits - the same order as
+// HDLC sends bits - so words can be handed to multi-bit consumers directly
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "RingBufferPosn.h"
+
+class SymbolFifo
+{
+private:
+	// Positions are in symbols
+	RingBufferPosn _posn;
+
+	// Storage - either owned or supplied externally
+	std::vector<uint32_t> _ownBuf;
+	uint32_t* _pBuf;
+	int _numWords;
+
+	// Packing
+	int _storeBits;
+	int _symbolsPerWordShift;
+	uint32_t _symbolMask;
+
+public:
+	// Constructor - if pStorage is supplied it must be at least storageWordsFor() long
+	SymbolFifo(int maxSymbols, int bitsPerSymbol = 1, uint32_t* pStorage = NULL);
+
+	// Number of 32 bit words needed to hold maxSymbols (a compile-time constant for
+	// constant arguments) - one slot is always left empty to distinguish full from empty
+	static constexpr int storageWordsFor(int maxSymbols, int bitsPerSymbol)
+	{
+		return (maxSymbols + (1 << wordShiftFor(bitsPerSymbol))) >> wordShiftFor(bitsPerSymbol);
+	}
+
+	// Log2 of the symbols per word
+	static constexpr int wordShiftFor(int bitsPerSymbol)
+	{
+		return (bitsPerSymbol <= 1) ? 5 : ((bitsPerSymbol == 2) ? 4 : 3);
+	}
+
+	// Clear
+	void clear()
+	{
+		_posn.clear();
+	}
+
+	// Status
+	bool canPut()
+	{
+		return _posn.canPut();
+	}
+	bool canGet()
+	{
+		return _posn.canGet();
+	}
+	unsigned int count()
+	{
+		return _posn.count();
+	}
+	unsigned int space()
+	{
+		return _posn.space();
+	}
+	int symbolsPerWord()
+	{
+		return 1 << _symbolsPerWordShift;
+	}
+
+	// Put a single symbol - returns false if full
+	bool put(int symbol)
+	{
+		if (!_posn.canPut())
+			return false;
+		unsigned int pos = _posn.posToPut();
+		uint32_t* pWord = _pBuf + (pos >> _symbolsPerWordShift);
+		int bitPos = (pos & ((1 << _symbolsPerWordShift) - 1)) * _storeBits;
+		*pWord = (*pWord & ~(_symbolMask << bitPos)) | (((uint32_t)symbol & _symbolMask) << bitPos);
+		_posn.hasPut();
+		return true;
+	}
+
+	// Get a single symbol - returns false if empty
+	bool get(int& symbol)
+	{
+		if (!_posn.canGet())
+			return false;
+		unsigned int pos = _posn.posToGet();
+		int bitPos = (pos & ((1 << _symbolsPerWordShift) - 1)) * _storeBits;
+		symbol = (_pBuf[pos >> _symbolsPerWordShift] >> bitPos) & _symbolMask;
+		_posn.hasGot();
+		return true;
+	}
+
+	// Put a whole word of symbols (symbolsPerWord()) - returns false if there isn't space
+	bool putWord(uint32_t word);
+
+	// Get a whole word of symbols (symbolsPerWord()) - returns false if there aren't enough
+	bool getWord(uint32_t& word);
+
+	// Get up to maxSymbols (limited to a word) packed with the first in the LSBs
+	// Returns the number of symbols got
+	int getSymbols(uint32_t& packed, int maxSymbols);
+};
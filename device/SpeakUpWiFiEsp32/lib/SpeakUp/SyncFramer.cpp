@@ -0,0 +1,228 @@
+// SyncFramer
+// Framing with a sync word and a length header as an alternative to bitwise HDLC
+
+#include "SyncFramer.h"
+
+SyncFramer::SyncFramer(MiniHDLCFrameRxFnType frameRxFn, int maxPayloadLen, uint32_t syncWord, uint8_t* pRxBuffer)
+{
+	_frameRxFn = frameRxFn;
+	_syncWord = syncWord;
+	if ((maxPayloadLen <= 0) || (maxPayloadLen > MAX_PAYLOAD_LEN))
+		maxPayloadLen = MAX_PAYLOAD_LEN;
+	_maxPayloadLen = maxPayloadLen;
+	if (pRxBuffer)
+	{
+		_rxBuffer = pRxBuffer;
+	}
+	else
+	{
+		_ownRxBuffer.resize(maxPayloadLen + 1);
+		_rxBuffer = _ownRxBuffer.data();
+	}
+	_rxHeld = false;
+	_addressFilterEnabled = false;
+	_rxHeaderErrorCount = 0;
+	_rxCRCErrorCount = 0;
+	_rxRejectedCount = 0;
+	clearRx();
+	_txStage = TX_STAGE_IDLE;
+	_pTxData = NULL;
+	_txLen = 0;
+	_txPos = 0;
+	_txCRC = MiniHDLC::CRC16_CCITT_INIT_VAL;
+	_txShiftReg = 0;
+	_txBitsLeft = 0;
+	_txAddress = FrameAddress::NONE;
+	_txAddressBytesLeft = 0;
+}
+
+// Start a streaming frame
+bool SyncFramer::startTxFrame(const uint8_t* pData, int len, int address)
+{
+	int addressLen = (address == FrameAddress::NONE) ? 0 : FrameAddress::ADDRESS_LEN;
+	if ((len < 0) || (len + addressLen > MAX_PAYLOAD_LEN))
+		return false;
+	_txAddress = address;
+	_txAddressBytesLeft = addressLen;
+	_pTxData = pData;
+	_txLen = len;
+	_txPos = 0;
+	_txCRC = MiniHDLC::CRC16_CCITT_INIT_VAL;
+	_txBitsLeft = 0;
+	_txStage = TX_STAGE_SYNC;
+	return true;
+}
+
+// Get the next bit of a streaming frame
+bool SyncFramer::getTxBit(uint8_t& bit)
+{
+	if (_txBitsLeft == 0)
+	{
+		if (!loadNextTxBits())
+			return false;
+	}
+
+	// Bits are sent LSB first
+	bit = _txShiftReg & 0x01;
+	_txShiftReg >>= 1;
+	_txBitsLeft--;
+	return true;
+}
+
+// Load the next part of a streaming frame
+bool SyncFramer::loadNextTxBits()
+{
+	switch (_txStage)
+	{
+		case TX_STAGE_SYNC:
+			_txShiftReg = _syncWord;
+			_txBitsLeft = SYNC_WORD_BITS;
+			_txStage = TX_STAGE_HEADER;
+			return true;
+		case TX_STAGE_HEADER:
+		{
+			int payloadLen = _txLen + _txAddressBytesLeft;
+			_txShiftReg = payloadLen | ((~payloadLen & 0xff) << 8);
+			_txBitsLeft = 16;
+			_txCRC = MiniHDLC::crcUpdateCCITT(_txCRC, payloadLen);
+			_txStage = (payloadLen > 0) ? TX_STAGE_PAYLOAD : TX_STAGE_CRC;
+			return true;
+		}
+		case TX_STAGE_PAYLOAD:
+			if (_txAddressBytesLeft > 0)
+			{
+				_txAddressBytesLeft--;
+				_txShiftReg = (_txAddress >> (8 * _txAddressBytesLeft)) & 0xff;
+				_txBitsLeft = 8;
+				_txCRC = MiniHDLC::crcUpdateCCITT(_txCRC, _txShiftReg);
+				if ((_txAddressBytesLeft == 0) && (_txLen == 0))
+					_txStage = TX_STAGE_CRC;
+				return true;
+			}
+			_txShiftReg = _pTxData[_txPos++];
+			_txBitsLeft = 8;
+			_txCRC = MiniHDLC::crcUpdateCCITT(_txCRC, _txShiftReg);
+			if (_txPos >= _txLen)
+				_txStage = TX_STAGE_CRC;
+			return true;
+		case TX_STAGE_CRC:
+			_txShiftReg = ((_txCRC >> 8) & 0xff) | ((_txCRC & 0xff) << 8);
+			_txBitsLeft = 16;
+			_txStage = TX_STAGE_IDLE;
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+// Abandon any frame being received
+void SyncFramer::clearRx()
+{
+	_rxStage = RX_STAGE_HUNT;
+	_rxShiftReg = 0;
+	_rxBitCount = 0;
+	_rxPayloadLen = 0;
+	_rxPos = 0;
+	_rxCRC = MiniHDLC::CRC16_CCITT_INIT_VAL;
+}
+
+// Handle a received bit
+void SyncFramer::handleBit(uint8_t bit)
+{
+	if (_rxHeld)
+		return;
+
+	// Bits arrive LSB first so shift in at the top
+	_rxShiftReg = (_rxShiftReg >> 1) | (((uint32_t)bit) << 31);
+	_rxBitCount++;
+
+	// Look for the sync word
+	if (_rxStage == RX_STAGE_HUNT)
+	{
+		if ((_rxBitCount >= SYNC_WORD_BITS) &&
+					(__builtin_popcount(_rxShiftReg ^ _syncWord) <= MAX_SYNC_BIT_ERRORS))
+		{
+			_rxStage = RX_STAGE_HEADER;
+			_rxBitCount = 0;
+		}
+		return;
+	}
+
+	// Header and payload are handled a byte at a time
+	if (_rxBitCount == 8)
+	{
+		_rxBitCount = 0;
+		handleRxByte(_rxShiftReg >> 24);
+	}
+}
+
+// Handle received bits
+void SyncFramer::handleBits(uint32_t bits, int numBits)
+{
+	for (int i = 0; i < numBits; i++)
+	{
+		handleBit(bits & 0x01);
+		bits >>= 1;
+	}
+}
+
+// Handle a received byte of the header or payload
+void SyncFramer::handleRxByte(uint8_t ch)
+{
+	if (_rxStage == RX_STAGE_HEADER)
+	{
+		// Length then its inverse
+		if (_rxPos == 0)
+		{
+			_rxPayloadLen = ch;
+			_rxPos++;
+			return;
+		}
+		if ((ch != (~_rxPayloadLen & 0xff)) || (_rxPayloadLen > _maxPayloadLen))
+		{
+			_rxHeaderErrorCount++;
+			clearRx();
+			return;
+		}
+		_rxCRC = MiniHDLC::crcUpdateCCITT(_rxCRC, _rxPayloadLen);
+		_rxPos = 0;
+		_rxStage = RX_STAGE_PAYLOAD;
+		return;
+	}
+
+	// Payload and then CRC - a frame for another device is dropped once its
+	// address has arrived
+	if (_rxPos < _rxPayloadLen)
+	{
+		_rxBuffer[_rxPos++] = ch;
+		_rxCRC = MiniHDLC::crcUpdateCCITT(_rxCRC, ch);
+		if (_addressFilterEnabled && (_rxPos == FrameAddress::ADDRESS_LEN) &&
+					!_addressFilter.matches(FrameAddress::fromBytes(_rxBuffer)))
+		{
+			_rxRejectedCount++;
+			clearRx();
+		}
+		return;
+	}
+	if (_rxPos == _rxPayloadLen)
+	{
+		_rxCRC ^= ((uint16_t)ch) << 8;
+		_rxPos++;
+		return;
+	}
+	_rxCRC ^= ch;
+
+	// Valid frame if the CRC matched
+	if (_rxCRC == 0)
+	{
+		_rxBuffer[_rxPayloadLen] = 0;
+		if (_frameRxFn)
+			_frameRxFn(_rxBuffer, _rxPayloadLen);
+	}
+	else
+	{
+		_rxCRCErrorCount++;
+	}
+	clearRx();
+}
@@ -0,0 +1,170 @@
+// SyncFramer
+// Framing with a sync word and a length header as an alternative to bitwise HDLC
+//
+// Frame (bits sent LSB first):
+//   Sync word (32 bits)
+//   Payload length byte then the length inverted
+//   Payload
+//   CRC-16-CCITT of the length byte and payload (high byte first)
+//
+// There is no bit stuffing or escaping so the air time depends only on the
+// payload length and the receiver knows the length (and can reject a bad one)
+// as soon as the header has arrived
+// The sync word can appear in the payload so the receiver doesn't look for it
+// while a frame is in progress
+// An address (see FrameAddress) can start the payload and with the address filter
+// enabled the receiver goes back to looking for the sync word as soon as it has
+// the address of a frame for another device
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "MiniHDLC.h"
+
+class SyncFramer
+{
+public:
+	// Sync word - starts with 0x7E (so the demodulator's sync detector can be used
+	// unchanged) and differs by at least 15 bits from any shift of itself that
+	// overlaps the alternating preamble
+	static const uint32_t DEFAULT_SYNC_WORD = 0x4A73307E;
+	static const int SYNC_WORD_BITS = 32;
+	static const int MAX_PAYLOAD_LEN = 255;
+
+	// Frame overhead in bits (sync word, header and CRC)
+	static const int FRAME_OVERHEAD_BITS = SYNC_WORD_BITS + 16 + 16;
+
+private:
+	// Bit errors allowed in a received sync word
+	static const int MAX_SYNC_BIT_ERRORS = 3;
+
+	// Callback for received frames
+	MiniHDLCFrameRxFnType _frameRxFn;
+	uint32_t _syncWord;
+	int _maxPayloadLen;
+
+	// Receive state
+	enum RxStage
+	{
+		RX_STAGE_HUNT,
+		RX_STAGE_HEADER,
+		RX_STAGE_PAYLOAD
+	};
+	RxStage _rxStage;
+	uint32_t _rxShiftReg;
+	int _rxBitCount;
+	int _rxPayloadLen;
+	int _rxPos;
+	uint16_t _rxCRC;
+
+	// Receive buffer - external or owned
+	uint8_t* _rxBuffer;
+	std::vector<uint8_t> _ownRxBuffer;
+
+	// Received frame held in the buffer (see holdRx())
+	bool _rxHeld;
+
+	// Address filter
+	bool _addressFilterEnabled;
+	FrameAddress _addressFilter;
+
+	// Stats
+	int _rxHeaderErrorCount;
+	int _rxCRCErrorCount;
+	int _rxRejectedCount;
+
+	// Transmit state
+	enum TxStage
+	{
+		TX_STAGE_IDLE,
+		TX_STAGE_SYNC,
+		TX_STAGE_HEADER,
+		TX_STAGE_PAYLOAD,
+		TX_STAGE_CRC
+	};
+	TxStage _txStage;
+	const uint8_t* _pTxData;
+	int _txLen;
+	int _txPos;
+	uint16_t _txCRC;
+	uint32_t _txShiftReg;
+	int _txBitsLeft;
+	int _txAddress;
+	int _txAddressBytesLeft;
+
+public:
+	// The receive buffer is sized for the max payload length (up to MAX_PAYLOAD_LEN) - if
+	// pRxBuffer is supplied it must hold maxPayloadLen + 1 bytes and remain valid
+	SyncFramer(MiniHDLCFrameRxFnType frameRxFn, int maxPayloadLen = MAX_PAYLOAD_LEN,
+				uint32_t syncWord = DEFAULT_SYNC_WORD, uint8_t* pRxBuffer = NULL);
+
+	// Number of bits on air for a payload
+	static int getFrameBits(int payloadLen)
+	{
+		return FRAME_OVERHEAD_BITS + payloadLen * 8;
+	}
+
+	// Streaming (pull-based) transmit - start a frame and then call getTxBit()
+	// until it returns false - the data must remain valid until then
+	// The payload starts with the address (see FrameAddress) unless it is NONE
+	// Returns false if the payload (including any address) is too long
+	bool startTxFrame(const uint8_t* pData, int len, int address = FrameAddress::NONE);
+	bool getTxBit(uint8_t& bit);
+
+	// Check if a frame is being sent
+	bool isTxBusy()
+	{
+		return (_txStage != TX_STAGE_IDLE) || (_txBitsLeft > 0);
+	}
+
+	// Handle received bits (bit 0 received first)
+	void handleBit(uint8_t bit);
+	void handleBits(uint32_t bits, int numBits);
+
+	// Check if a frame is being received (after the sync word)
+	bool isRxInFrame()
+	{
+		return _rxStage != RX_STAGE_HUNT;
+	}
+
+	// Abandon any frame being received
+	void clearRx();
+
+	// Hold the frame last delivered in the receive buffer so it can be used in place
+	// (from the frame callback) - bits received while held are ignored and once
+	// released the receiver looks for the next sync word
+	void holdRx(bool hold)
+	{
+		_rxHeld = hold;
+		clearRx();
+	}
+
+	// Accept only frames addressed (see FrameAddress) to this device - the address
+	// is left at the start of delivered payloads
+	void enableAddressFilter(bool enable, const FrameAddress& filter = FrameAddress())
+	{
+		_addressFilterEnabled = enable;
+		_addressFilter = filter;
+	}
+
+	// Frames rejected at the header or by CRC
+	int getHeaderErrorCount()
+	{
+		return _rxHeaderErrorCount;
+	}
+	int getCRCErrorCount()
+	{
+		return _rxCRCErrorCount;
+	}
+
+	// Frames dropped by the address filter
+	int getRejectedFrameCount()
+	{
+		return _rxRejectedCount;
+	}
+
+private:
+	bool loadNextTxBits();
+	void handleRxByte(uint8_t ch);
+};
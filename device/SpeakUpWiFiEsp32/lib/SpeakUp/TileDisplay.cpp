@@ -0,0 +1,126 @@
+// TileDisplay
+// Text model of a character display that draws only the tiles that changed
+
+#include "TileDisplay.h"
+#include <string.h>
+
+static const uint16_t ALL_COLS_MASK = (1u << TileDisplay::COLS) - 1;
+
+TileDisplay::TileDisplay()
+{
+	memset(_text, ' ', sizeof(_text));
+	memset(_shown, ' ', sizeof(_shown));
+	// The display contents aren't known until it is first drawn
+	for (int row = 0; row < ROWS; row++)
+		_dirtyMasks[row] = ALL_COLS_MASK;
+	_shownValid = false;
+	_tilesDrawn = 0;
+	_transfers = 0;
+}
+
+void TileDisplay::setText(int col, int row, const char* pText)
+{
+	setChars(col, row, pText, false);
+}
+
+void TileDisplay::setLine(int row, const char* pText)
+{
+	setChars(0, row, pText, true);
+}
+
+void TileDisplay::clearLine(int row)
+{
+	setChars(0, row, "", true);
+}
+
+void TileDisplay::clear()
+{
+	for (int row = 0; row < ROWS; row++)
+		clearLine(row);
+}
+
+void TileDisplay::setChars(int col, int row, const char* pText, bool padRow)
+{
+	if ((row < 0) || (row >= ROWS) || (col < 0) || (col >= COLS))
+		return;
+	std::lock_guard<std::mutex> lock(_lock);
+	for (; col < COLS; col++)
+	{
+		char ch = *pText;
+		if (ch == 0)
+		{
+			if (!padRow)
+				break;
+			ch = ' ';
+		}
+		else
+		{
+			pText++;
+		}
+		if (_text[row][col] != ch)
+		{
+			_text[row][col] = ch;
+			_dirtyMasks[row] |= 1u << col;
+		}
+	}
+}
+
+bool TileDisplay::hasChanges()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	for (int row = 0; row < ROWS; row++)
+	{
+		if (_dirtyMasks[row])
+			return true;
+	}
+	return false;
+}
+
+void TileDisplay::invalidate()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	for (int row = 0; row < ROWS; row++)
+		_dirtyMasks[row] = ALL_COLS_MASK;
+	_shownValid = false;
+}
+
+int TileDisplay::render(TileDisplayDevice& device)
+{
+	// Copy the changed rows so the lock isn't held while drawing
+	char text[ROWS][COLS];
+	uint16_t dirtyMasks[ROWS];
+	bool shownValid = false;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		memcpy(text, _text, sizeof(text));
+		memcpy(dirtyMasks, _dirtyMasks, sizeof(dirtyMasks));
+		memset(_dirtyMasks, 0, sizeof(_dirtyMasks));
+		shownValid = _shownValid;
+		_shownValid = true;
+	}
+
+	// Tiles changed back to what is shown are skipped - the rest are drawn in runs
+	int tilesDrawn = 0;
+	for (int row = 0; row < ROWS; row++)
+	{
+		uint16_t drawMask = 0;
+		for (uint16_t dirty = dirtyMasks[row]; dirty != 0; dirty &= dirty - 1)
+		{
+			int col = __builtin_ctz(dirty);
+			if (!shownValid || (text[row][col] != _shown[row][col]))
+				drawMask |= 1u << col;
+		}
+		while (drawMask != 0)
+		{
+			int startCol = __builtin_ctz(drawMask);
+			int numTiles = __builtin_ctz(~(drawMask >> startCol));
+			device.drawTiles(startCol, row, text[row] + startCol, numTiles);
+			memcpy(_shown[row] + startCol, text[row] + startCol, numTiles);
+			drawMask &= ~(((1u << numTiles) - 1) << startCol);
+			tilesDrawn += numTiles;
+			_transfers++;
+		}
+	}
+	_tilesDrawn += tilesDrawn;
+	return tilesDrawn;
+}
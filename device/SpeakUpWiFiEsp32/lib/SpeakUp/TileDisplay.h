@@ -0,0 +1,90 @@
+// TileDisplay
+// Text model of a character display made of 8x8 pixel tiles (16 x 8 tiles on a
+// 128x64 OLED) - the main loop only changes the model (which never waits for the
+// display) and rendering is done later, usually from a low priority task
+// Each row keeps a mask of the tiles changed since they were last drawn and only
+// tiles that differ from what the display shows are sent - runs of adjacent tiles
+// go in one transfer
+// Implementations of TileDisplayDevice are in TileDisplayEsp32 (U8x8 OLED on the
+// ESP32) and TileDisplayHost (a fake device that takes the time of a real bus)
+
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+
+// Display that draws runs of character tiles
+class TileDisplayDevice
+{
+public:
+	virtual ~TileDisplayDevice()
+	{
+	}
+
+	// Initialise the display (may take a long time) - returns false on failure
+	virtual bool begin() = 0;
+
+	// Draw numTiles characters starting at a tile - all in one row
+	virtual void drawTiles(int col, int row, const char* pChars, int numTiles) = 0;
+};
+
+class TileDisplay
+{
+public:
+	static const int COLS = 16;
+	static const int ROWS = 8;
+
+private:
+	// Text to show and the tiles changed in each row (bit N is column N)
+	char _text[ROWS][COLS];
+	uint16_t _dirtyMasks[ROWS];
+
+	// Text the display shows - only used when rendering
+	char _shown[ROWS][COLS];
+	bool _shownValid;
+
+	// Held only while the model is changed or copied - never while drawing
+	std::mutex _lock;
+
+	// Stats
+	uint32_t _tilesDrawn;
+	uint32_t _transfers;
+
+public:
+	TileDisplay();
+
+	// Write text starting at a tile - text beyond the end of the row is dropped
+	void setText(int col, int row, const char* pText);
+
+	// Write a whole row - the rest of the row is cleared
+	void setLine(int row, const char* pText);
+
+	// Clear a row or all rows
+	void clearLine(int row);
+	void clear();
+
+	// Check if any tiles are waiting to be drawn
+	bool hasChanges();
+
+	// Draw the changed tiles on a device - returns the number of tiles drawn
+	// Call from one task only - the model can be changed while this runs and
+	// changes made while drawing are drawn on the next call
+	int render(TileDisplayDevice& device);
+
+	// Forget what the display shows so the next render draws every tile (e.g.
+	// after the display is reset)
+	void invalidate();
+
+	// Tiles drawn and transfers made
+	uint32_t getTilesDrawn()
+	{
+		return _tilesDrawn;
+	}
+	uint32_t getTransfers()
+	{
+		return _transfers;
+	}
+
+private:
+	void setChars(int col, int row, const char* pText, bool padRow);
+};
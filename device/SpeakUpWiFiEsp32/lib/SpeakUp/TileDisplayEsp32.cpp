@@ -0,0 +1,96 @@
+// TileDisplayEsp32
+// Tile display device for a U8x8 OLED and a FreeRTOS task to render a TileDisplay
+
+#ifdef ESP32
+
+#include "TileDisplayEsp32.h"
+#include <string.h>
+
+U8x8TileDisplayDevice::U8x8TileDisplayDevice(U8X8& u8x8, const uint8_t* pFont, uint32_t busClockHz) :
+	_u8x8(u8x8)
+{
+	_pFont = pFont;
+	_busClockHz = busClockHz;
+}
+
+bool U8x8TileDisplayDevice::begin()
+{
+	if (_busClockHz != 0)
+		_u8x8.setBusClock(_busClockHz);
+	if (!_u8x8.begin())
+		return false;
+	_u8x8.setFont(_pFont);
+	return true;
+}
+
+void U8x8TileDisplayDevice::drawTiles(int col, int row, const char* pChars, int numTiles)
+{
+	char str[TileDisplay::COLS + 1];
+	if (numTiles > TileDisplay::COLS)
+		numTiles = TileDisplay::COLS;
+	memcpy(str, pChars, numTiles);
+	str[numTiles] = 0;
+	_u8x8.drawString(col, row, str);
+}
+
+TileDisplayRenderTask::TileDisplayRenderTask(TileDisplay& display, TileDisplayDevice& device) :
+	_display(display), _device(device)
+{
+	_taskHandle = NULL;
+	_running = false;
+	_intervalMs = 20;
+}
+
+TileDisplayRenderTask::~TileDisplayRenderTask()
+{
+	stop();
+}
+
+bool TileDisplayRenderTask::start(int intervalMs, int priority, int core)
+{
+	if (_taskHandle)
+		return true;
+	_intervalMs = (intervalMs > 0) ? intervalMs : 1;
+	_running = true;
+	if (xTaskCreatePinnedToCore(taskEntry, "TileDisplay", STACK_SIZE, this, priority, &_taskHandle, core) != pdPASS)
+	{
+		_taskHandle = NULL;
+		_running = false;
+		return false;
+	}
+	return true;
+}
+
+void TileDisplayRenderTask::stop()
+{
+	if (!_taskHandle)
+		return;
+	_running = false;
+	while (_taskHandle)
+		vTaskDelay(1);
+}
+
+void TileDisplayRenderTask::taskEntry(void* pArg)
+{
+	((TileDisplayRenderTask*)pArg)->taskLoop();
+}
+
+void TileDisplayRenderTask::taskLoop()
+{
+	// Initialising the display is slow so it is done here rather than at startup
+	bool deviceOk = _device.begin();
+	_display.invalidate();
+	while (_running && deviceOk)
+	{
+		_display.render(_device);
+		vTaskDelay(pdMS_TO_TICKS(_intervalMs));
+	}
+	if (deviceOk)
+		_display.render(_device);
+
+	// Tasks must delete themselves rather than return
+	_taskHandle = NULL;
+	vTaskDelete(NULL);
+}
+
+#endif
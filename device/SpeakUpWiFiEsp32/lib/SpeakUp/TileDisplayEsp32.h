@@ -0,0 +1,65 @@
+// TileDisplayEsp32
+// Tile display device for a U8x8 (U8g2 library) OLED and a FreeRTOS task that
+// renders a TileDisplay so the main loop never waits for the display
+// With software I2C every byte is bit-banged by the CPU (a full screen takes
+// tens of ms) - hardware I2C at 400KHz is much quicker and mostly waits on the
+// peripheral so prefer it where the pins allow (set it up with U8X8_..._HW_I2C)
+
+#pragma once
+
+#ifdef ESP32
+
+#include <stdint.h>
+#include <U8x8lib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "TileDisplay.h"
+
+// U8x8 display
+class U8x8TileDisplayDevice : public TileDisplayDevice
+{
+private:
+	U8X8& _u8x8;
+	const uint8_t* _pFont;
+	uint32_t _busClockHz;
+
+public:
+	// busClockHz of 0 leaves the U8x8 default
+	U8x8TileDisplayDevice(U8X8& u8x8, const uint8_t* pFont = u8x8_font_chroma48medium8_r, uint32_t busClockHz = 0);
+
+	virtual bool begin();
+	virtual void drawTiles(int col, int row, const char* pChars, int numTiles);
+};
+
+// Low priority task rendering a TileDisplay
+class TileDisplayRenderTask
+{
+public:
+	// Below the Arduino loop and WiFi - on core 0 by default as the loop runs on core 1
+	static const int DEFAULT_PRIORITY = 1;
+	static const int DEFAULT_CORE = 0;
+	static const int STACK_SIZE = 2048;
+
+private:
+	TileDisplay& _display;
+	TileDisplayDevice& _device;
+	TaskHandle_t _taskHandle;
+	volatile bool _running;
+	int _intervalMs;
+
+public:
+	TileDisplayRenderTask(TileDisplay& display, TileDisplayDevice& device);
+	~TileDisplayRenderTask();
+
+	// The device is initialised on the task then changes are drawn every intervalMs
+	bool start(int intervalMs = 20, int priority = DEFAULT_PRIORITY, int core = DEFAULT_CORE);
+
+	// Stops after drawing any remaining changes
+	void stop();
+
+private:
+	static void taskEntry(void* pArg);
+	void taskLoop();
+};
+
+#endif
@@ -0,0 +1,99 @@
+// TileDisplayHost
+// Tile display device and render thread for running the display code on a Linux host
+
+#ifndef ARDUINO
+
+#include "TileDisplayHost.h"
+#include <string.h>
+#include <chrono>
+
+FakeTileDisplayDevice::FakeTileDisplayDevice(int busClockHz)
+{
+	_busClockHz = (busClockHz > 0) ? busClockHz : 100000;
+	memset(_screen, 0, sizeof(_screen));
+	_tilesDrawn = 0;
+	_transfers = 0;
+	_busySecs = 0;
+}
+
+bool FakeTileDisplayDevice::begin()
+{
+	busyWait(BEGIN_TIME_US / 1e6);
+	return true;
+}
+
+void FakeTileDisplayDevice::drawTiles(int col, int row, const char* pChars, int numTiles)
+{
+	if ((row < 0) || (row >= TileDisplay::ROWS) || (col < 0) || (col + numTiles > TileDisplay::COLS))
+		return;
+	memcpy(_screen[row] + col, pChars, numTiles);
+	_tilesDrawn += numTiles;
+	_transfers++;
+	busyWait(transferSecs(numTiles));
+}
+
+bool FakeTileDisplayDevice::shows(const char pText[TileDisplay::ROWS][TileDisplay::COLS])
+{
+	return memcmp(_screen, pText, sizeof(_screen)) == 0;
+}
+
+double FakeTileDisplayDevice::transferSecs(int numTiles)
+{
+	int numBytes = TRANSFER_OVERHEAD_BYTES + numTiles * BYTES_PER_TILE;
+	return numBytes * 9.0 / _busClockHz;
+}
+
+// Spins rather than sleeping as a bit-banged bus keeps the CPU busy
+void FakeTileDisplayDevice::busyWait(double secs)
+{
+	std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now() +
+				std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(secs));
+	while (std::chrono::steady_clock::now() < endTime)
+		;
+	_busySecs += secs;
+}
+
+TileDisplayRenderThread::TileDisplayRenderThread(TileDisplay& display, TileDisplayDevice& device) :
+	_display(display), _device(device)
+{
+	_running = false;
+	_intervalMs = 20;
+}
+
+TileDisplayRenderThread::~TileDisplayRenderThread()
+{
+	stop();
+}
+
+bool TileDisplayRenderThread::start(int intervalMs)
+{
+	if (_running)
+		return true;
+	_intervalMs = (intervalMs > 0) ? intervalMs : 1;
+	_running = true;
+	_thread = std::thread(&TileDisplayRenderThread::threadLoop, this);
+	return true;
+}
+
+void TileDisplayRenderThread::stop()
+{
+	if (!_running)
+		return;
+	_running = false;
+	_thread.join();
+}
+
+void TileDisplayRenderThread::threadLoop()
+{
+	if (!_device.begin())
+		return;
+	_display.invalidate();
+	while (_running)
+	{
+		_display.render(_device);
+		std::this_thread::sleep_for(std::chrono::milliseconds(_intervalMs));
+	}
+	_display.render(_device);
+}
+
+#endif
@@ -0,0 +1,100 @@
+// TileDisplayHost
+// Tile display device and render thread for running the display code on a Linux host
+// The fake device keeps the characters drawn and busy waits for the time the
+// transfers would take on an I2C bus so the time a caller is blocked can be measured
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+#include "TileDisplay.h"
+
+// Fake SSD1306 style display
+class FakeTileDisplayDevice : public TileDisplayDevice
+{
+public:
+	// Bytes on the bus to position a transfer (address, commands and restarts)
+	// and for each tile (8 columns of 8 pixels)
+	static const int TRANSFER_OVERHEAD_BYTES = 8;
+	static const int BYTES_PER_TILE = 8;
+
+	// Time to initialise the controller (reset and command sequence)
+	static const int BEGIN_TIME_US = 100000;
+
+private:
+	// I2C clock - each byte takes 9 clocks
+	int _busClockHz;
+
+	// Characters on the display
+	char _screen[TileDisplay::ROWS][TileDisplay::COLS];
+
+	// Stats
+	uint32_t _tilesDrawn;
+	uint32_t _transfers;
+	double _busySecs;
+
+public:
+	// Software I2C on the ESP32 manages about 100KHz and hardware I2C 400KHz
+	FakeTileDisplayDevice(int busClockHz);
+
+	virtual bool begin();
+	virtual void drawTiles(int col, int row, const char* pChars, int numTiles);
+
+	// Check the display shows the same text as a model
+	bool shows(const char pText[TileDisplay::ROWS][TileDisplay::COLS]);
+
+	// Character shown on a tile
+	char getChar(int col, int row)
+	{
+		return _screen[row][col];
+	}
+
+	// Time a transfer of numTiles takes on the bus
+	double transferSecs(int numTiles);
+
+	// Stats
+	uint32_t getTilesDrawn()
+	{
+		return _tilesDrawn;
+	}
+	uint32_t getTransfers()
+	{
+		return _transfers;
+	}
+	double getBusySecs()
+	{
+		return _busySecs;
+	}
+
+private:
+	void busyWait(double secs);
+};
+
+// Thread rendering a TileDisplay - the host equivalent of TileDisplayRenderTask
+class TileDisplayRenderThread
+{
+private:
+	TileDisplay& _display;
+	TileDisplayDevice& _device;
+	std::thread _thread;
+	std::atomic<bool> _running;
+	int _intervalMs;
+
+public:
+	TileDisplayRenderThread(TileDisplay& display, TileDisplayDevice& device);
+	~TileDisplayRenderThread();
+
+	// The device is initialised on the thread then changes are drawn every intervalMs
+	bool start(int intervalMs = 20);
+
+	// Stops after drawing any remaining changes
+	void stop();
+
+private:
+	void threadLoop();
+};
+
+#endif
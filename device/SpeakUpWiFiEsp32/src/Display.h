@@ -1,26 +1,64 @@
 // Display handler for WiFi credentials over sound
 // Rob Dobson 2018
 
+// The show functions only update a TileDisplay model and return at once - the
+// display is initialised and drawn by a low priority task (started by begin())
+// which sends only the tiles that changed
+
+#include "TileDisplay.h"
+
 // Heltec 0.96" OLED ESP32 Module
 // To run without this display just comment out the following line
 #define HELTEC_0_96_IN_OLED_ESP32 1
 
+// Use the I2C peripheral rather than bit-banging the bus - comment out to use
+// software I2C (the original driver)
+#define HELTEC_OLED_HW_I2C 1
+
 #ifdef HELTEC_0_96_IN_OLED_ESP32
 // Heltec display driver is U8g2 https://github.com/olikraus/u8g2
 // The line ... lib_deps=U8g2 ... needs to be in Platformio.ini file
 #include <U8x8lib.h>
-// the OLED used
-U8X8_SSD1306_128X64_NONAME_SW_I2C u8x8(/* clock=*/ 15, /* data=*/ 4, /* reset=*/ 16);
+#include "TileDisplayEsp32.h"
 #endif
 
 class Display
 {
+private:
+    TileDisplay _tiles;
+#ifdef HELTEC_0_96_IN_OLED_ESP32
+    // the OLED used
+#ifdef HELTEC_OLED_HW_I2C
+    static const uint32_t OLED_BUS_CLOCK_HZ = 400000;
+    U8X8_SSD1306_128X64_NONAME_HW_I2C _u8x8;
+#else
+    static const uint32_t OLED_BUS_CLOCK_HZ = 0;
+    U8X8_SSD1306_128X64_NONAME_SW_I2C _u8x8;
+#endif
+    U8x8TileDisplayDevice _device;
+    TileDisplayRenderTask _renderTask;
+#endif
+
 public:
+    // Nothing is sent to the display until begin()
     Display()
+#ifdef HELTEC_0_96_IN_OLED_ESP32
+#ifdef HELTEC_OLED_HW_I2C
+        : _u8x8(/* reset=*/ 16, /* clock=*/ 15, /* data=*/ 4),
+#else
+        : _u8x8(/* clock=*/ 15, /* data=*/ 4, /* reset=*/ 16),
+#endif
+          _device(_u8x8, u8x8_font_chroma48medium8_r, OLED_BUS_CLOCK_HZ),
+          _renderTask(_tiles, _device)
+#endif
+    {
+    }
+
+    // Start the render task - call from setup()
+    void begin()
     {
 #ifdef HELTEC_0_96_IN_OLED_ESP32
-        u8x8.begin();
-        u8x8.setFont(u8x8_font_chroma48medium8_r);
+        _renderTask.start();
 #endif
     }
 
@@ -28,25 +66,19 @@ public:
     {
         int pin = (adc1Channel < 4) ? adc1Channel + 36 : adc1Channel - 4 + 32;
         String dispMsg = "Mic on pin " + String(pin);
-#ifdef HELTEC_0_96_IN_OLED_ESP32
-        u8x8.drawString(0, 0, dispMsg.c_str());
-        u8x8.drawString(0, 1, "Listening ...");
-#endif
-    }    
+        _tiles.setLine(0, dispMsg.c_str());
+        _tiles.setLine(1, "Listening ...");
+    }
 
     void showSSID(String& ssid)
     {
-#ifdef HELTEC_0_96_IN_OLED_ESP32
-        u8x8.drawString(0, 3, "Connecting to");
-        u8x8.drawString(0, 4, ssid.c_str());
-#endif
-    }    
+        _tiles.setLine(3, "Connecting to");
+        _tiles.setLine(4, ssid.c_str());
+    }
 
     void showConnectionState(String& msg)
     {
-#ifdef HELTEC_0_96_IN_OLED_ESP32
-        u8x8.drawString(0, 6, msg.c_str());
-#endif
+        _tiles.setLine(6, msg.c_str());
     }
 
 };
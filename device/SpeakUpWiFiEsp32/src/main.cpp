@@ -4,92 +4,140 @@
 #include <Arduino.h>
 #include <driver/adc.h>
 #include "SpeakUp.h"
+#include "AudioIOEsp32.h"
+#include "InputConditioner.h"
+#include "CredentialParser.h"
 #include "Display.h"
 #include <WiFi.h>
 
-// Handler for audio comms
-SpeakUp speakUp;
+// Handler for audio comms - receive only so all buffers are sized for that
+typedef SpeakUpT<SpeakUpReceiverConfig> SpeakUpReceiver;
+SpeakUpReceiver speakUp;
 
-// ESP32 timer pointer
-hw_timer_t *_pHwTimer = NULL;
+// Input conditioning (ADC scaling, DC removal and AGC)
+InputConditioner inputConditioner(12);
 
 // ESP32 ADC1 channel for analog audio (ADC)
 // This is of the form ADC1_CHANNEL_N
 // Where N is:0,1,2,3,4,5,6,7 for ESP32 pins 36,37,38,39,32,33,34,35 respectively
 const adc1_channel_t ADC_INPUT_CHANNEL = ADC1_CHANNEL_7;
 
-// Optional display driver
+// Audio input - the ADC is sampled at 8KHz into DMA buffers
+const int AUDIO_SAMPLE_RATE = 8000;
+const int AUDIO_BLOCK_LEN = 128;
+Esp32AdcAudioSource audioInput(ADC_INPUT_CHANNEL, AUDIO_SAMPLE_RATE);
+
+// Optional display driver - drawn by its own low priority task
 Display display;
 
-// Timer interrupt for ADC and comms
-void IRAM_ATTR onTimer() 
-{
-    // Get analog from pin
-    int adcVal = adc1_get_raw(ADC_INPUT_CHANNEL); 
-    int mappedValue = map(adcVal, 0 , 4095, -32767, 32767);
+// Spectrum statistics are printed when a signal ends without a message
+bool prevSquelchOpen = false;
+bool frameWhileOpen = false;
 
-    // Send to audio
-    speakUp.decodeProcessSample(mappedValue);
+void printSpectrumStats()
+{
+    SpectrumMonitor& monitor = speakUp.getSpectrumMonitor();
+    const int bands[] = { SpeakUpReceiver::SPECTRUM_BAND_LOW_TONE, SpeakUpReceiver::SPECTRUM_BAND_HIGH_TONE };
+    for (int bandIdx : bands)
+    {
+        SpectrumMonitor::BandStats stats;
+        if (!monitor.getBandStats(bandIdx, stats))
+            continue;
+        Serial.printf("Band %d floor %.1fdB peak %.1fdB tone %.1fHz SNR %.1fdB (%d blocks)\n", bandIdx,
+                    stats.noiseFloorDb, stats.peakDb, stats.toneFreqHz, stats.snrDb, stats.toneBlocks);
+    }
+    Serial.printf("Input peak %d flat tops %d of %d samples\n", monitor.getPeakLevel(),
+                    monitor.getFlatTopSamples(), monitor.getSamplesAnalysed());
 }
 
-void setESP32TimerForADC()
+// Decode audio that has been sampled since the last call
+void processAudioInput()
 {
-    // Configure ADC1
-    adc1_config_width(ADC_WIDTH_12Bit);
-    adc1_config_channel_atten(ADC_INPUT_CHANNEL, ADC_ATTEN_11db);
-    
-    // Timer prescaled to 80 (assumes ESP32 timer base clock is 80MHz)
-    _pHwTimer = timerBegin(1, 80, true);
-    timerAttachInterrupt(_pHwTimer, &onTimer, true);
-
-    // Set timer alarm to result in 8KHz sampling
-    timerAlarmWrite(_pHwTimer, 125, true);
-    timerAlarmEnable(_pHwTimer);
+    int16_t samples[AUDIO_BLOCK_LEN];
+    int numSamples = audioInput.read(samples, AUDIO_BLOCK_LEN);
+    if (numSamples <= 0)
+        return;
+    for (int i = 0; i < numSamples; i++)
+        samples[i] = inputConditioner.processAdcSample(samples[i]);
+    speakUp.decodeProcessSamples(samples, numSamples);
 }
 
 int prevWiFiStatus = -1;
 
+// Memory used by the modem
+void printFootprint()
+{
+    for (int part = 0; part < SpeakUpReceiver::FOOTPRINT_NUM_PARTS; part++)
+    {
+        int numBytes = SpeakUpReceiver::getFootprintBytes(part);
+        if (numBytes > 0)
+            Serial.printf("%s %d bytes\n", SpeakUpReceiver::getFootprintName(part), numBytes);
+    }
+    Serial.printf("SpeakUp total %d bytes\n", SpeakUpReceiver::getFootprintTotal());
+}
+
 void setup() {
     Serial.begin(115200);
+    printFootprint();
     speakUp.setup();
-    setESP32TimerForADC();
+    speakUp.enableSquelch(true);
+    speakUp.enableRepeatCombining(true);
+    speakUp.enableFountainReceive(true);
+    speakUp.enableSpectrumMonitor(true);
+    audioInput.begin();
+    display.begin();
     display.welcome(ADC_INPUT_CHANNEL);
     Serial.println("Waiting for audio ...\n");
 }
 
 void loop() {
-    // See if anything received
-    String msg;
-    if (speakUp.decodeGetMessage(msg))
+    // Handle audio
+    processAudioInput();
+
+    // Report why a signal that came and went wasn't received
+    bool squelchOpen = speakUp.isSquelchOpen();
+    if (squelchOpen && !prevSquelchOpen)
+        frameWhileOpen = false;
+    if (!squelchOpen && prevSquelchOpen && !frameWhileOpen)
     {
-        // Show progress
-        Serial.println(msg);
+        Serial.println("Signal ended without a message");
+        printSpectrumStats();
+    }
+    prevSquelchOpen = squelchOpen;
 
-        // Extract SSID & PW
-        int ssidPos = msg.indexOf("\"s\":");
-        if (ssidPos < 0)
-            return;
-        int ssidEnd = msg.indexOf("\"", ssidPos+5);
-        if (ssidEnd < 0)
-            return;
-        int pwPos = msg.indexOf("\"p\":");
-        if (pwPos < 0)
-            return;
-        int pwEnd = msg.indexOf("\"", pwPos+5);
-        if (pwEnd < 0)
+    // See if anything received
+    const uint8_t* pFrame = NULL;
+    int frameLen = 0;
+    if (speakUp.decodeGetFrame(pFrame, frameLen))
+    {
+        // Extract credentials - binary format or the original JSON text
+        WiFiCredentials creds;
+        bool credsOk = false;
+        if (CredentialParser::isBinaryFormat(pFrame, frameLen))
+            credsOk = CredentialParser::parse(pFrame, frameLen, creds);
+        else
+            credsOk = CredentialParser::parseJson(pFrame, frameLen, creds);
+        speakUp.decodeClearMessage();
+        frameWhileOpen = true;
+        if (!credsOk)
+        {
+            Serial.printf("Invalid credentials frame len %d\n", frameLen);
+            printSpectrumStats();
             return;
-        String ssid = msg.substring(ssidPos+5, ssidEnd);
-        String pw = msg.substring(pwPos+5, pwEnd);
+        }
 
         // Show progress
+        Serial.printf("SSID %s channel %d\n", creds.ssid, creds.channel);
+        String ssid = creds.ssid;
         display.showSSID(ssid);
 
-        // Stop timer as it conflicts with WiFi on the WEMOS platform
-        Serial.println("Stopping timer\n");
-        timerAlarmDisable(_pHwTimer);
+        // Stop sampling as it conflicts with WiFi on the WEMOS platform
+        Serial.println("Stopping audio input\n");
+        audioInput.end();
 
         // Start connecting
-        WiFi.begin(ssid.c_str(), pw.c_str());
+        const char* pPassword = creds.password[0] ? creds.password : NULL;
+        WiFi.begin(creds.ssid, pPassword, creds.channel, creds.bssidValid ? creds.bssid : NULL);
     }
 
     // Check if connecting
@@ -0,0 +1,206 @@
+// AddressFilterBench
+// One transmission carrying a different message for each of several devices (and
+// one for a group and one for all) - checks each device receives only its own,
+// counts the work the address filter avoids (frames passed to the application and
+// bytes buffered and CRC checked) and times the framer with and without it
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o AddressFilterBench AddressFilterBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   AddressFilterBench [-r repeats]
+//     -r  times the received bits are framed for the timing (default 200)
+//
+// Bits of a rejected frame only go through the flag search (no destuffing, repeat
+// combining, buffering or CRC) and the application isn't woken for foreign frames
+// Frames rejected include noise between frames that would otherwise have been
+// buffered and CRC checked too
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+
+static const int NUM_DEVICES = 6;
+static const uint16_t EVEN_DEVICES_GROUP = 0x0001;
+static int _numRepeats = 200;
+
+// Device IDs and groups
+static uint16_t deviceIdFor(int deviceIdx)
+{
+	return 0x100 + deviceIdx;
+}
+static uint16_t groupMaskFor(int deviceIdx)
+{
+	return (deviceIdx % 2 == 0) ? EVEN_DEVICES_GROUP : 0;
+}
+
+// Demodulated bits of the transmission
+struct RxBits
+{
+	uint32_t bits;
+	int numBits;
+};
+
+// Framing of the bits with or without the filter
+struct FramingResult
+{
+	double nsPerBit;
+	int callbacks;
+	int delivered;
+	int rejected;
+};
+
+// Time to frame the bits with the frames passed to the application (callbacks),
+// those it keeps and those the filter rejected (each per pass)
+static FramingResult timeFraming(const std::vector<RxBits>& rxBits, int totalBits, bool filter,
+			const FrameAddress& address)
+{
+	int numCallbacks = 0;
+	int framesDelivered = 0;
+	MiniHDLC hdlc(NULL, [&numCallbacks, &framesDelivered, filter, &address](const uint8_t* pFrame, int) {
+			// Without the filter the application checks the address of every good frame
+			numCallbacks++;
+			if (filter || address.matches(FrameAddress::fromBytes(pFrame)))
+				framesDelivered++;
+		}, true, true, 256);
+	hdlc.enableAddressFilter(filter, address);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int rep = 0; rep < _numRepeats; rep++)
+	{
+		for (const RxBits& rx : rxBits)
+			hdlc.handleBits(rx.bits, rx.numBits);
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	FramingResult result;
+	result.nsPerBit = secs * 1e9 / ((double)totalBits * _numRepeats);
+	result.callbacks = numCallbacks / _numRepeats;
+	result.delivered = framesDelivered / _numRepeats;
+	result.rejected = hdlc.getRejectedFrameCount() / _numRepeats;
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "r:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r': _numRepeats = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-r repeats]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (_numRepeats < 1)
+		_numRepeats = 1;
+
+	// Credentials for each device, a message to the even devices and one to all
+	static SpeakUp speakUpTx;
+	speakUpTx.enableAddressing(true);
+	std::vector<std::string> messages;
+	for (int i = 0; i < NUM_DEVICES; i++)
+		messages.push_back("{\"s\":\"Rack" + std::to_string(i) + "\",\"p\":\"secret" + std::to_string(i * 37) + "\"}");
+	messages.push_back("even devices");
+	messages.push_back("all devices");
+	std::vector<uint16_t> addresses;
+	for (int i = 0; i < NUM_DEVICES; i++)
+		addresses.push_back(FrameAddress::unicast(deviceIdFor(i)));
+	addresses.push_back(FrameAddress::group(EVEN_DEVICES_GROUP));
+	addresses.push_back((uint16_t)FrameAddress::BROADCAST);
+	for (size_t i = 0; i < messages.size(); i++)
+		speakUpTx.queueAddressedMessage(addresses[i], (const uint8_t*)messages[i].c_str(), messages[i].size());
+	std::vector<int> audio;
+	if (speakUpTx.encodeTxQueueToSamples())
+	{
+		int sampleVal = 0;
+		while (speakUpTx.encodeGetSample(sampleVal))
+			audio.push_back(sampleVal / 4);
+	}
+	audio.resize(audio.size() + SpeakUp::getModemSampleRate() / 10, 0);
+	printf("%d messages in one transmission of %.1fs\n\n", (int)messages.size(),
+				(double)audio.size() / SpeakUp::getModemSampleRate());
+
+	// Each device receives only its own messages
+	bool allOk = true;
+	for (int i = 0; i < NUM_DEVICES; i++)
+	{
+		static SpeakUp speakUpRx;
+		speakUpRx.enableAddressing(true, deviceIdFor(i), groupMaskFor(i));
+		std::vector<std::string> expected;
+		expected.push_back(messages[i]);
+		if (groupMaskFor(i) & EVEN_DEVICES_GROUP)
+			expected.push_back(messages[NUM_DEVICES]);
+		expected.push_back(messages[NUM_DEVICES + 1]);
+		std::vector<std::string> received;
+		int rejectedBefore = speakUpRx.getRejectedFrameCount();
+		for (int sampleVal : audio)
+		{
+			speakUpRx.decodeProcessSample(sampleVal);
+			const uint8_t* pFrame = NULL;
+			int frameLen = 0;
+			if (speakUpRx.decodeGetFrame(pFrame, frameLen))
+			{
+				received.push_back(std::string((const char*)pFrame, frameLen));
+				speakUpRx.decodeClearMessage();
+			}
+		}
+		bool deviceOk = (received == expected);
+		allOk = allOk && deviceOk;
+		printf("device 0x%04x groups 0x%04x: %d received %d rejected %s\n", deviceIdFor(i), groupMaskFor(i),
+					(int)received.size(), speakUpRx.getRejectedFrameCount() - rejectedBefore,
+					deviceOk ? "ok" : "WRONG MESSAGES");
+	}
+
+	// Framer work with and without the filter on the same bits
+	FSKDemod fskDemod(64);
+	SpeakUp::setupDemod(fskDemod, false);
+	std::vector<RxBits> rxBits;
+	int totalBits = 0;
+	for (int sampleVal : audio)
+	{
+		fskDemod.processSample(sampleVal);
+		RxBits rx;
+		rx.bits = 0;
+		rx.numBits = fskDemod.getRxBits(rx.bits, 32);
+		if (rx.numBits > 0)
+		{
+			rxBits.push_back(rx);
+			totalBits += rx.numBits;
+		}
+	}
+	FrameAddress address(deviceIdFor(1), groupMaskFor(1));
+	FramingResult unfiltered = timeFraming(rxBits, totalBits, false, address);
+	FramingResult filtered = timeFraming(rxBits, totalBits, true, address);
+
+	// Bytes after the address (the rest of the payload and the CRC) of the frames for
+	// other devices - the filter neither buffers nor CRC checks them
+	int foreignFrames = 0;
+	int foreignBytes = 0;
+	for (size_t i = 0; i < messages.size(); i++)
+	{
+		if (address.matches(addresses[i]))
+			continue;
+		foreignFrames++;
+		foreignBytes += messages[i].size() + 2;
+	}
+	printf("\nFraming %d bits for device 0x%04x (%d of the %d frames are for other devices)\n", totalBits,
+				deviceIdFor(1), foreignFrames, (int)messages.size());
+	printf("  without filter %6.2f ns/bit - %d frames to the application, %d kept\n", unfiltered.nsPerBit,
+				unfiltered.callbacks, unfiltered.delivered);
+	printf("  with filter    %6.2f ns/bit - %d frames to the application, %d rejected at the address"
+				" (with noise) - %d bytes of foreign frames not buffered or CRC checked\n", filtered.nsPerBit, filtered.callbacks,
+				filtered.rejected, foreignBytes);
+	printf("  framing time with the filter %+.0f%%\n", 100 * (filtered.nsPerBit / unfiltered.nsPerBit - 1));
+	if (filtered.delivered != unfiltered.delivered)
+	{
+		printf("Filtered and unfiltered frames differ\n");
+		allOk = false;
+	}
+	return allOk ? 0 : 1;
+}
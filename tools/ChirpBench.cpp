@@ -0,0 +1,181 @@
+// ChirpBench
+// Chirp spread spectrum against FSK - bit rate, demodulator CPU cost and the
+// proportion of messages received at a range of signal to noise ratios
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o ChirpBench ChirpBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   ChirpBench [-t trials] [-d seconds]
+//     -t  messages sent at each signal to noise ratio (default 10)
+//     -d  seconds of audio for the CPU measurement (default 60)
+//
+// The signal to noise ratio is of white noise over the whole audio band (0-4kHz)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "SpeakUp.h"
+
+static const char* TEST_MESSAGE = "{\"s\":\"MyNetwork\",\"p\":\"pass\"}";
+static const int SNR_DB[] = { 10, 0, -5, -10, -15, -20 };
+static const int NUM_SNRS = sizeof(SNR_DB) / sizeof(SNR_DB[0]);
+
+// Keep the signal well below full scale so noise at the lowest SNR doesn't clip
+static const int SIGNAL_DIV = 32;
+
+// Silence before and after each message
+static const int GAP_SAMPLES = 4000;
+
+static int _numTrials = 10;
+static int _cpuSecs = 60;
+
+// Setup modulation - spreadingFactor 0 is FSK
+static bool setupModulation(SpeakUp& speakUp, int spreadingFactor)
+{
+	if (spreadingFactor == 0)
+		return speakUp.setModulationMode(SpeakUp::MODULATION_FSK);
+	return speakUp.setModulationMode(SpeakUp::MODULATION_CHIRP, spreadingFactor);
+}
+
+// Audio for the test message with silence either side
+static void encodeMessage(SpeakUp& speakUp, std::vector<int>& audio, double& signalPower)
+{
+	audio.assign(GAP_SAMPLES, 0);
+	speakUp.encodeMessageToSamples(TEST_MESSAGE);
+	int sampleVal = 0;
+	double sumSquares = 0;
+	int numSignal = 0;
+	while (speakUp.encodeGetSample(sampleVal))
+	{
+		sampleVal /= SIGNAL_DIV;
+		audio.push_back(sampleVal);
+		sumSquares += (double)sampleVal * sampleVal;
+		numSignal++;
+	}
+	audio.resize(audio.size() + GAP_SAMPLES, 0);
+	signalPower = numSignal > 0 ? sumSquares / numSignal : 0;
+}
+
+// Proportion of messages received at each SNR
+static void runSensitivity(const char* name, int spreadingFactor)
+{
+	static SpeakUp speakUp;
+	setupModulation(speakUp, spreadingFactor);
+	std::vector<int> audio;
+	double signalPower = 0;
+	encodeMessage(speakUp, audio, signalPower);
+	int messageLen = strlen(TEST_MESSAGE);
+	double airSecs = (double)(audio.size() - 2 * GAP_SAMPLES) / SpeakUp::getModemSampleRate();
+	printf("%-6s %5.2fs %6.1f bps ", name, airSecs, messageLen * 8 / airSecs);
+
+	std::mt19937 rng(1234);
+	for (int snrIdx = 0; snrIdx < NUM_SNRS; snrIdx++)
+	{
+		double noiseSigma = sqrt(signalPower / pow(10.0, SNR_DB[snrIdx] / 10.0));
+		std::normal_distribution<double> noise(0, noiseSigma);
+		int numOk = 0;
+		for (int trial = 0; trial < _numTrials; trial++)
+		{
+			setupModulation(speakUp, spreadingFactor);
+			speakUp.decodeClearMessage();
+			bool gotMessage = false;
+			for (size_t i = 0; i < audio.size(); i++)
+			{
+				speakUp.decodeProcessSample(audio[i] + (int)lround(noise(rng)));
+				const uint8_t* pFrame = NULL;
+				int frameLen = 0;
+				if (speakUp.decodeGetFrame(pFrame, frameLen))
+				{
+					gotMessage = gotMessage || ((frameLen == messageLen) && (memcmp(pFrame, TEST_MESSAGE, frameLen) == 0));
+					speakUp.decodeClearMessage();
+				}
+			}
+			if (gotMessage)
+				numOk++;
+		}
+		printf(" %3d%%", numOk * 100 / _numTrials);
+		fflush(stdout);
+	}
+	printf("\n");
+}
+
+// Demodulator CPU time on a continuous signal with noise
+static void runCpu(int spreadingFactor)
+{
+	static const int SAMPLE_RATE = 8000;
+	static const int FREQ_LOW = 1000;
+	static const int BANDWIDTH = 2000;
+	ChirpMod chirpMod;
+	ChirpDemod chirpDemod(64);
+	chirpMod.setup(SAMPLE_RATE, FREQ_LOW, BANDWIDTH, spreadingFactor);
+	chirpDemod.setup(SAMPLE_RATE, FREQ_LOW, BANDWIDTH, spreadingFactor);
+	std::mt19937 rng(5678);
+	chirpMod.setBitSource([&rng](int& bitVal) { bitVal = rng() & 0x01; return true; });
+	chirpMod.startStream();
+
+	// Generate first so only the demodulator is timed
+	int numSamples = _cpuSecs * SAMPLE_RATE;
+	std::vector<int> audio(numSamples);
+	std::normal_distribution<double> noise(0, 1000);
+	for (int i = 0; i < numSamples; i++)
+	{
+		int sampleVal = 0;
+		chirpMod.getSample(sampleVal);
+		audio[i] = sampleVal / SIGNAL_DIV + (int)lround(noise(rng));
+	}
+
+	long long numBits = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < numSamples; i++)
+	{
+		chirpDemod.processSample(audio[i]);
+		uint32_t rxBits = 0;
+		numBits += chirpDemod.getRxBits(rxBits, 32);
+	}
+	double cpuSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	double numSymbols = (double)numSamples / chirpMod.getSamplesPerSymbol();
+	printf("SF%-4d %6.1f us/symbol %6.3f us/sample %7.0fx real time  bits %lld\n", spreadingFactor,
+				cpuSecs * 1e6 / numSymbols, cpuSecs * 1e6 / numSamples, _cpuSecs / cpuSecs, numBits);
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "t:d:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't': _numTrials = atoi(optarg); break;
+			case 'd': _cpuSecs = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-t trials] [-d seconds]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (_numTrials <= 0)
+		_numTrials = 1;
+
+	printf("Demodulator CPU\n");
+	for (int sf = ChirpMod::MIN_SPREADING_FACTOR; sf <= ChirpMod::MAX_SPREADING_FACTOR; sf++)
+		runCpu(sf);
+
+	printf("\nMessages received (%d byte message, %d trials)\n", (int)strlen(TEST_MESSAGE), _numTrials);
+	printf("mode   air    rate      ");
+	for (int snrIdx = 0; snrIdx < NUM_SNRS; snrIdx++)
+		printf(" %3ddB", SNR_DB[snrIdx]);
+	printf("\n");
+	runSensitivity("FSK", 0);
+	for (int sf = ChirpMod::MIN_SPREADING_FACTOR; sf <= ChirpMod::MAX_SPREADING_FACTOR; sf++)
+	{
+		char name[8];
+		snprintf(name, sizeof(name), "SF%d", sf);
+		runSensitivity(name, sf);
+	}
+	return 0;
+}
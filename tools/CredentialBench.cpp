@@ -0,0 +1,249 @@
+// CredentialBench
+// Air time of the binary (TLV) credential format against the JSON text it replaced,
+// encode/parse round trips of random credentials, a fuzz test of the parsers
+// (mutated and random frames must not overrun the output fields) and the parse cost
+// against the original find/substr approach
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o CredentialBench CredentialBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   CredentialBench [-r roundTrips] [-f fuzzFrames] [-i iterations]
+//     -r  random round trips (default 200000)
+//     -f  fuzzed frames (default 2000000)
+//     -i  parses of the example for the timing (default 1000000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include "SpeakUp.h"
+#include "CredentialParser.h"
+
+static const char* EXAMPLE_SSID = "MyNetwork";
+static const char* EXAMPLE_PASSWORD = "secretpass";
+static const int PREAMBLE_SYMBOLS = 8;
+static const int MAX_FRAME_LEN = 258;
+static const int FRAME_BUF_LEN = 128;
+static const uint32_t GUARD = 0xdeadbeef;
+
+static long _numRoundTrips = 200000;
+static long _numFuzzFrames = 2000000;
+static long _parseIterations = 1000000;
+
+// Credentials with guards either side to catch overruns
+struct GuardedCredentials
+{
+	uint32_t guardBefore[4];
+	WiFiCredentials creds;
+	uint32_t guardAfter[4];
+	GuardedCredentials()
+	{
+		for (int i = 0; i < 4; i++)
+			guardBefore[i] = guardAfter[i] = GUARD;
+	}
+	bool intact()
+	{
+		for (int i = 0; i < 4; i++)
+			if ((guardBefore[i] != GUARD) || (guardAfter[i] != GUARD))
+				return false;
+		return (memchr(creds.ssid, 0, sizeof(creds.ssid)) != NULL) &&
+					(memchr(creds.password, 0, sizeof(creds.password)) != NULL);
+	}
+};
+
+// Bits sent for a frame (bitwise HDLC with flags, stuffing and the CRC)
+static int hdlcFrameBits(const uint8_t* pFrame, int frameLen)
+{
+	MiniHDLC hdlc(NULL, NULL, true, true, MAX_FRAME_LEN);
+	hdlc.startTxFrame(pFrame, frameLen);
+	int numBits = 0;
+	uint8_t bit = 0;
+	while (hdlc.getTxBit(bit))
+		numBits++;
+	return numBits;
+}
+
+// Original parsing (main.cpp before the binary format) with std::string for String
+static bool parseFindSubstr(const std::string& msg, std::string& ssid, std::string& pw)
+{
+	size_t ssidPos = msg.find("\"s\":");
+	if (ssidPos == std::string::npos)
+		return false;
+	size_t ssidEnd = msg.find("\"", ssidPos + 5);
+	if (ssidEnd == std::string::npos)
+		return false;
+	size_t pwPos = msg.find("\"p\":");
+	if (pwPos == std::string::npos)
+		return false;
+	size_t pwEnd = msg.find("\"", pwPos + 5);
+	if (pwEnd == std::string::npos)
+		return false;
+	ssid = msg.substr(ssidPos + 5, ssidEnd - ssidPos - 5);
+	pw = msg.substr(pwPos + 5, pwEnd - pwPos - 5);
+	return true;
+}
+
+// Random text - sometimes from the packed alphabet only
+static void randomText(std::mt19937& rng, int maxLen, int minLen, char* pOut)
+{
+	static const char* PACKABLE = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_";
+	bool packable = (rng() % 2) == 0;
+	int len = minLen + rng() % (maxLen - minLen + 1);
+	for (int i = 0; i < len; i++)
+		pOut[i] = packable ? PACKABLE[rng() % 64] : (char)(' ' + rng() % 95);
+	pOut[len] = 0;
+}
+
+static void randomCredentials(std::mt19937& rng, WiFiCredentials& creds)
+{
+	creds.clear();
+	randomText(rng, WiFiCredentials::MAX_SSID_LEN, 1, creds.ssid);
+	randomText(rng, WiFiCredentials::MAX_PASSWORD_LEN, 0, creds.password);
+	if (rng() % 2)
+	{
+		creds.bssidValid = true;
+		for (int i = 0; i < WiFiCredentials::BSSID_LEN; i++)
+			creds.bssid[i] = rng();
+	}
+	if (rng() % 2)
+		creds.channel = 1 + rng() % 13;
+	if (rng() % 2)
+		creds.security = rng() % 5;
+}
+
+static bool sameCredentials(const WiFiCredentials& a, const WiFiCredentials& b)
+{
+	return (strcmp(a.ssid, b.ssid) == 0) && (strcmp(a.password, b.password) == 0) &&
+				(a.bssidValid == b.bssidValid) && (!a.bssidValid || (memcmp(a.bssid, b.bssid, WiFiCredentials::BSSID_LEN) == 0)) &&
+				(a.channel == b.channel) && (a.security == b.security);
+}
+
+// Time per call (ns) of a parse function
+template<typename ParseFn>
+static double timeParse(ParseFn parseFn)
+{
+	int okCount = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (long i = 0; i < _parseIterations; i++)
+		okCount += parseFn() ? 1 : 0;
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return (okCount == _parseIterations) ? secs * 1e9 / _parseIterations : -1;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "r:f:i:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r': _numRoundTrips = atol(optarg); break;
+			case 'f': _numFuzzFrames = atol(optarg); break;
+			case 'i': _parseIterations = atol(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-r roundTrips] [-f fuzzFrames] [-i iterations]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_numRoundTrips < 1) || (_numFuzzFrames < 1) || (_parseIterations < 1))
+	{
+		fprintf(stderr, "Counts must be at least 1\n");
+		return 1;
+	}
+
+	// Air time of the example
+	char json[FRAME_BUF_LEN];
+	int jsonLen = snprintf(json, sizeof(json), "{\"s\":\"%s\",\"p\":\"%s\"}", EXAMPLE_SSID, EXAMPLE_PASSWORD);
+	WiFiCredentials example;
+	strcpy(example.ssid, EXAMPLE_SSID);
+	strcpy(example.password, EXAMPLE_PASSWORD);
+	uint8_t binary[FRAME_BUF_LEN];
+	int binaryLen = CredentialParser::encode(example, binary, sizeof(binary));
+	int jsonBits = hdlcFrameBits((const uint8_t*)json, jsonLen);
+	int binaryBits = hdlcFrameBits(binary, binaryLen);
+	double symbolSecs = 1.0 / SpeakUpDefaultConfig::SYMBOL_RATE;
+	printf("Example frame: JSON %d bytes %d bits, binary %d bytes %d bits - %.2fs vs %.2fs on air"
+				" at %d baud with the preamble\n", jsonLen, jsonBits, binaryLen, binaryBits,
+				(jsonBits + PREAMBLE_SYMBOLS) * symbolSecs, (binaryBits + PREAMBLE_SYMBOLS) * symbolSecs,
+				SpeakUpDefaultConfig::SYMBOL_RATE);
+
+	// Round trips
+	std::mt19937 rng(1);
+	long roundTripFails = 0;
+	long jsonBytes = 0;
+	long binaryBytes = 0;
+	for (long i = 0; i < _numRoundTrips; i++)
+	{
+		WiFiCredentials creds;
+		randomCredentials(rng, creds);
+		uint8_t frame[FRAME_BUF_LEN];
+		int frameLen = CredentialParser::encode(creds, frame, sizeof(frame));
+		GuardedCredentials parsed;
+		if ((frameLen <= 0) || !CredentialParser::parse(frame, frameLen, parsed.creds) ||
+					!sameCredentials(creds, parsed.creds) || !parsed.intact())
+			roundTripFails++;
+		binaryBytes += frameLen;
+		jsonBytes += strlen(creds.ssid) + strlen(creds.password) + 15;
+	}
+	printf("Round trips: %ld of %ld failed - mean frame %.1f bytes (JSON with the same text %.1f)\n",
+				roundTripFails, _numRoundTrips, (double)binaryBytes / _numRoundTrips, (double)jsonBytes / _numRoundTrips);
+
+	// Fuzz - valid frames with bytes changed, truncated or extended and random frames
+	long fuzzFails = 0;
+	long fuzzAccepted = 0;
+	for (long i = 0; i < _numFuzzFrames; i++)
+	{
+		uint8_t frame[FRAME_BUF_LEN];
+		int frameLen = 0;
+		int kind = rng() % 3;
+		if (kind < 2)
+		{
+			WiFiCredentials creds;
+			randomCredentials(rng, creds);
+			frameLen = CredentialParser::encode(creds, frame, sizeof(frame));
+			int numChanges = 1 + rng() % 4;
+			for (int j = 0; j < numChanges; j++)
+				frame[rng() % frameLen] = rng();
+			if (kind == 1)
+				frameLen = rng() % (sizeof(frame) + 1);
+		}
+		else
+		{
+			frameLen = rng() % (sizeof(frame) + 1);
+			for (int j = 0; j < frameLen; j++)
+				frame[j] = rng();
+			if ((frameLen > 0) && (rng() % 2))
+				frame[0] = CredentialParser::CREDENTIAL_FORMAT_VERSION;
+		}
+		GuardedCredentials parsed;
+		if (CredentialParser::parse(frame, frameLen, parsed.creds))
+			fuzzAccepted++;
+		GuardedCredentials parsedJson;
+		CredentialParser::parseJson(frame, frameLen, parsedJson.creds);
+		if (!parsed.intact() || !parsedJson.intact())
+			fuzzFails++;
+	}
+	printf("Fuzz: %ld of %ld frames overran (%ld accepted as binary)\n", fuzzFails, _numFuzzFrames, fuzzAccepted);
+
+	// Parse cost
+	std::string jsonString(json, jsonLen);
+	double findNs = timeParse([&jsonString]() {
+		std::string ssid;
+		std::string pw;
+		return parseFindSubstr(jsonString, ssid, pw);
+	});
+	double jsonNs = timeParse([&json, jsonLen]() {
+		WiFiCredentials creds;
+		return CredentialParser::parseJson((const uint8_t*)json, jsonLen, creds);
+	});
+	double binaryNs = timeParse([&binary, binaryLen]() {
+		WiFiCredentials creds;
+		return CredentialParser::parse(binary, binaryLen, creds);
+	});
+	printf("Parse: find/substr %.0f ns, parseJson %.0f ns, binary %.0f ns\n", findNs, jsonNs, binaryNs);
+	return ((roundTripFails == 0) && (fuzzFails == 0)) ? 0 : 1;
+}
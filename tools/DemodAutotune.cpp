@@ -0,0 +1,430 @@
+// DemodAutotune
+// Searches the FSK demodulator tracking constants and clock recovery windows
+// (FSKDemodParams) for the set that receives the most frames at each symbol rate -
+// over audio sent through simulated channels (see ChannelSimulator) and recordings
+// Parameter sets are evaluated in parallel on all cores
+//
+// Build (from this folder):
+//   g++ -O2 -pthread -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o DemodAutotune DemodAutotune.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   DemodAutotune [-b rates] [-m grid|random] [-n sets] [-f frames] [-t threads] [-r rate] [-s seed] [recording.raw[:frames] ...]
+//     -b  symbol rates to tune, comma separated (default 50,100,200)
+//     -m  search a grid of values or random sets (default random)
+//     -n  parameter sets tried by a random search (default 200)
+//     -f  frames sent through each simulated channel (default 8)
+//     -t  worker threads (default 0 - one per core)
+//     -r  symbol rate of the recordings (default 100 - the SpeakUp rate)
+//     -s  seed for the random search and the channel noise (default 1)
+//
+// Recordings are 8KHz signed 16 bit raw audio of HDLC framed SpeakUp messages -
+// :frames gives the number of frames in a recording, otherwise the most frames any
+// parameter set receives from it is taken as the number
+// The current preset for each rate and the defaults are always tried (in that order)
+// and earlier sets win ties so presets only change where tuning finds an improvement
+// - the output ends with a line for each rate for the preset table in FSKDemodParams.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+#include "AudioIOHost.h"
+#include "ChannelSimulator.h"
+
+static const int FIFO_LEN = 64;
+static const int MAX_FRAME_LEN = 256;
+
+// Audio with the messages it carries
+struct Clip
+{
+	std::string name;
+	int symbolRate;
+	std::vector<int> audio;
+	std::vector<std::string> messages;
+	int numFrames;
+	bool numFramesKnown;
+};
+
+// Simulated channels
+struct Condition
+{
+	const char* pName;
+	double snrDb;
+	double gain;
+	double clockOffsetPpm;
+	double fadeDepth;
+	double humLevel;
+	int dcOffset;
+};
+// Most are near the edge of what the default params receive so sets can be told apart
+static const Condition CONDITIONS[] = {
+	{ "clean", 30, 1, 0, 0, 0, 0 },
+	{ "noisy", 14, 1, 0, 0, 0, 0 },
+	{ "very noisy", 11, 1, 0, 0, 0, 0 },
+	{ "clock fast", 16, 1, 3000, 0, 0, 0 },
+	{ "clock slow", 16, 1, -3000, 0, 0, 0 },
+	{ "fading", 20, 1, 0, 0.75, 0, 0 },
+	{ "quiet with hum", 16, 0.1, 0, 0, 300, 200 },
+};
+static const int NUM_CONDITIONS = sizeof(CONDITIONS) / sizeof(CONDITIONS[0]);
+static const double FADE_PERIOD_SECS = 1.5;
+
+static std::vector<int> _symbolRates;
+static bool _gridSearch = false;
+static int _numRandomSets = 200;
+static int _framesPerCondition = 8;
+static int _numThreads = 0;
+static int _recordingRate = 100;
+static uint32_t _seed = 1;
+
+// Credentials-like messages of varied lengths
+static std::string makeMessage(int idx, std::mt19937& rng)
+{
+	std::uniform_int_distribution<int> lenDist(4, 24);
+	std::uniform_int_distribution<int> charDist('a', 'z');
+	std::string password;
+	for (int i = lenDist(rng); i > 0; i--)
+		password += (char)charDist(rng);
+	return "{\"s\":\"Net" + std::to_string(idx) + "\",\"p\":\"" + password + "\"}";
+}
+
+// Modulate HDLC frames at a symbol rate with gaps between them
+static void modulateFrames(int symbolRate, const std::vector<std::string>& messages, std::vector<int>& audio)
+{
+	MiniHDLC hdlc(NULL, NULL, true, true, MAX_FRAME_LEN);
+	FSKMod fskMod(FIFO_LEN);
+	SpeakUp::setupMod(fskMod, symbolRate);
+	fskMod.setSymbolSource([&hdlc](int& symbol) {
+			uint8_t bit = 0;
+			if (!hdlc.getTxBit(bit))
+				return false;
+			symbol = bit;
+			return true;
+		});
+	int gapLen = SpeakUp::getModemSampleRate() * 3 / 10;
+	audio.resize(gapLen, 0);
+	for (const std::string& message : messages)
+	{
+		hdlc.startTxFrame((const uint8_t*)message.c_str(), message.size());
+		fskMod.startStream();
+		int sampleVal = 0;
+		while (fskMod.getSample(sampleVal))
+			audio.push_back(sampleVal / 4);
+		audio.resize(audio.size() + gapLen, 0);
+	}
+}
+
+// Frames received from a clip with a parameter set
+static int countFrames(const Clip& clip, const FSKDemodParams& params)
+{
+	std::vector<bool> received(clip.messages.size(), false);
+	int numFrames = 0;
+	MiniHDLC hdlc(NULL, [&clip, &received, &numFrames](const uint8_t* pFrame, int frameLen) {
+			// Simulated frames must be one of those sent (and each counts once)
+			if (clip.messages.empty())
+			{
+				numFrames++;
+				return;
+			}
+			for (size_t i = 0; i < clip.messages.size(); i++)
+			{
+				if (!received[i] && ((int)clip.messages[i].size() == frameLen) &&
+							(memcmp(clip.messages[i].c_str(), pFrame, frameLen) == 0))
+				{
+					received[i] = true;
+					numFrames++;
+					break;
+				}
+			}
+		}, true, true, MAX_FRAME_LEN);
+	FSKDemod fskDemod(FIFO_LEN);
+	SpeakUp::setupDemod(fskDemod, SpeakUpDefaultConfig::ENABLE_SYNC_DETECT, clip.symbolRate);
+	fskDemod.setParams(params);
+	for (int sampleVal : clip.audio)
+	{
+		fskDemod.processSample(sampleVal);
+		uint32_t rxBits = 0;
+		int numBits = fskDemod.getRxBits(rxBits, 32);
+		if (numBits > 0)
+			hdlc.handleBits(rxBits, numBits);
+	}
+	return numFrames;
+}
+
+// Parameter sets to try - the defaults first
+static void makeCandidates(std::vector<FSKDemodParams>& candidates, std::mt19937& rng)
+{
+	FSKDemodParams defaults;
+	candidates.push_back(defaults);
+	if (_gridSearch)
+	{
+		static const int ENVELOPE[] = { 10, 20, 35 };
+		static const int FOLLOW[] = { 250, 500, 1000 };
+		static const int REST[] = { 5, 10, 20 };
+		static const int VOTING[] = { 2, 3, 4 };
+		static const int TRANSITION[][2] = { { 85, 115 }, { 90, 110 }, { 95, 105 } };
+		static const int CENTRE[][2] = { { 20, 80 }, { 25, 75 }, { 30, 70 } };
+		for (int env : ENVELOPE)
+		for (int follow : FOLLOW)
+		for (int rest : REST)
+		for (int voting : VOTING)
+		for (const int* pTransition : TRANSITION)
+		for (const int* pCentre : CENTRE)
+		{
+			FSKDemodParams params;
+			params.envelopePercent = env;
+			params.peakFollowPer10K = follow;
+			params.peakRestPer10K = rest;
+			params.numVotingSamples = voting;
+			params.transitionMinPercent = pTransition[0];
+			params.transitionMaxPercent = pTransition[1];
+			params.centreMinPercent = pCentre[0];
+			params.centreMaxPercent = pCentre[1];
+			candidates.push_back(params);
+		}
+		return;
+	}
+
+	// Random sets - rates are spread on a log scale
+	std::uniform_real_distribution<double> unit(0, 1);
+	while ((int)candidates.size() < _numRandomSets)
+	{
+		FSKDemodParams params;
+		params.envelopePercent = 5 + (int)(unit(rng) * 56);
+		params.peakFollowPer10K = (int)lround(100 * pow(30, unit(rng)));
+		params.peakRestPer10K = (int)lround(pow(100, unit(rng)));
+		params.numVotingSamples = 1 + (int)(unit(rng) * 6);
+		params.transitionMinPercent = 75 + (int)(unit(rng) * 24);
+		params.transitionMaxPercent = 102 + (int)(unit(rng) * 24);
+		params.centreMinPercent = 10 + (int)(unit(rng) * 31);
+		params.centreMaxPercent = 60 + (int)(unit(rng) * 31);
+		if (params.isValid())
+			candidates.push_back(params);
+	}
+}
+
+// Frames received from each clip by each candidate - candidates are shared out
+// between the workers
+static void evaluate(const std::vector<Clip>& clips, const std::vector<FSKDemodParams>& candidates,
+			std::vector<std::vector<int> >& frames)
+{
+	frames.assign(candidates.size(), std::vector<int>(clips.size(), 0));
+	std::atomic<int> nextCandidate(0);
+	int numThreads = (_numThreads > 0) ? _numThreads : std::thread::hardware_concurrency();
+	if (numThreads < 1)
+		numThreads = 1;
+	std::vector<std::thread> workers;
+	for (int i = 0; i < numThreads; i++)
+	{
+		workers.push_back(std::thread([&]() {
+				for (int idx = nextCandidate++; idx < (int)candidates.size(); idx = nextCandidate++)
+					for (size_t clipIdx = 0; clipIdx < clips.size(); clipIdx++)
+						frames[idx][clipIdx] = countFrames(clips[clipIdx], candidates[idx]);
+			}));
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+static void printParams(const FSKDemodParams& params)
+{
+	printf("env %2d%% follow %4d rest %3d vote %d transition %d-%d%% centre %d-%d%%", params.envelopePercent,
+				params.peakFollowPer10K, params.peakRestPer10K, params.numVotingSamples,
+				params.transitionMinPercent, params.transitionMaxPercent,
+				params.centreMinPercent, params.centreMaxPercent);
+}
+
+// Tune one rate - returns the best set
+static FSKDemodParams tuneRate(std::vector<Clip>& clips, const std::vector<FSKDemodParams>& candidates, int symbolRate)
+{
+	std::vector<std::vector<int> > frames;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	evaluate(clips, candidates, frames);
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Recordings without a frame count expect the most any set received
+	int totalFrames = 0;
+	for (size_t clipIdx = 0; clipIdx < clips.size(); clipIdx++)
+	{
+		Clip& clip = clips[clipIdx];
+		if (!clip.numFramesKnown)
+		{
+			for (size_t idx = 0; idx < candidates.size(); idx++)
+				clip.numFrames = std::max(clip.numFrames, frames[idx][clipIdx]);
+		}
+		totalFrames += clip.numFrames;
+	}
+
+	// Rank by frames received - earlier candidates (the defaults first) win ties
+	std::vector<int> totals(candidates.size(), 0);
+	std::vector<int> order(candidates.size());
+	for (size_t idx = 0; idx < candidates.size(); idx++)
+	{
+		for (size_t clipIdx = 0; clipIdx < clips.size(); clipIdx++)
+			totals[idx] += std::min(frames[idx][clipIdx], clips[clipIdx].numFrames);
+		order[idx] = idx;
+	}
+	std::stable_sort(order.begin(), order.end(), [&totals](int a, int b) { return totals[a] > totals[b]; });
+
+	printf("%d symbols/s - %d sets in %.1fs - %d frames\n", symbolRate, (int)candidates.size(), secs, totalFrames);
+	printf("  %-16s", "");
+	for (const Clip& clip : clips)
+		printf(" %10.10s", clip.name.c_str());
+	printf("   success\n");
+	int numShown = std::min((int)order.size(), 5);
+	for (int rank = -2; rank < numShown; rank++)
+	{
+		int idx = (rank < 0) ? rank + 2 : order[rank];
+		printf("  %-16s", (rank == -2) ? "preset" : (rank == -1) ? "default" : ("best " + std::to_string(rank + 1)).c_str());
+		for (size_t clipIdx = 0; clipIdx < clips.size(); clipIdx++)
+			printf(" %4d of %3d", frames[idx][clipIdx], clips[clipIdx].numFrames);
+		printf("   %5.1f%%  ", totalFrames ? 100.0 * totals[idx] / totalFrames : 0);
+		printParams(candidates[idx]);
+		printf("\n");
+	}
+	printf("\n");
+	return candidates[order[0]];
+}
+
+static bool loadRecording(const char* pArg, Clip& clip)
+{
+	std::string fileName = pArg;
+	clip.numFrames = 0;
+	clip.numFramesKnown = false;
+	size_t colonPos = fileName.rfind(':');
+	if (colonPos != std::string::npos)
+	{
+		clip.numFrames = atoi(fileName.c_str() + colonPos + 1);
+		clip.numFramesKnown = true;
+		fileName.resize(colonPos);
+	}
+	FileAudioSource source(fileName.c_str(), SpeakUp::getModemSampleRate());
+	if (!source.isOpen())
+		return false;
+	int16_t samples[256];
+	int numSamples = 0;
+	while ((numSamples = source.read(samples, 256)) >= 0)
+		clip.audio.insert(clip.audio.end(), samples, samples + numSamples);
+	size_t slashPos = fileName.rfind('/');
+	clip.name = (slashPos == std::string::npos) ? fileName : fileName.substr(slashPos + 1);
+	clip.symbolRate = _recordingRate;
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* pRates = "50,100,200";
+	int opt;
+	while ((opt = getopt(argc, argv, "b:m:n:f:t:r:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'b': pRates = optarg; break;
+			case 'm': _gridSearch = (strcmp(optarg, "grid") == 0); break;
+			case 'n': _numRandomSets = atoi(optarg); break;
+			case 'f': _framesPerCondition = atoi(optarg); break;
+			case 't': _numThreads = atoi(optarg); break;
+			case 'r': _recordingRate = atoi(optarg); break;
+			case 's': _seed = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "Usage: %s [-b rates] [-m grid|random] [-n sets] [-f frames] [-t threads] [-r rate] [-s seed] "
+							"[recording.raw[:frames] ...]\n", argv[0]);
+				return 1;
+		}
+	}
+	for (const char* pRate = pRates; *pRate; )
+	{
+		int symbolRate = atoi(pRate);
+		if ((symbolRate > 0) && (SpeakUp::getModemSampleRate() / symbolRate >= 8))
+			_symbolRates.push_back(symbolRate);
+		const char* pComma = strchr(pRate, ',');
+		pRate = pComma ? pComma + 1 : pRate + strlen(pRate);
+	}
+	if (_symbolRates.empty())
+	{
+		fprintf(stderr, "No usable symbol rates\n");
+		return 1;
+	}
+	if (_framesPerCondition < 1)
+		_framesPerCondition = 1;
+
+	// Recordings
+	std::vector<Clip> recordings;
+	for (int argIdx = optind; argIdx < argc; argIdx++)
+	{
+		Clip clip;
+		if (!loadRecording(argv[argIdx], clip))
+		{
+			fprintf(stderr, "Can't read %s\n", argv[argIdx]);
+			return 1;
+		}
+		recordings.push_back(clip);
+	}
+
+	std::mt19937 rng(_seed);
+	std::vector<FSKDemodParams> candidates;
+	makeCandidates(candidates, rng);
+
+	std::vector<FSKDemodParams> best;
+	for (int symbolRate : _symbolRates)
+	{
+		// The same messages through each simulated channel
+		std::vector<Clip> clips;
+		std::vector<std::string> messages;
+		for (int i = 0; i < _framesPerCondition; i++)
+			messages.push_back(makeMessage(i, rng));
+		std::vector<int> sent;
+		modulateFrames(symbolRate, messages, sent);
+		for (int condIdx = 0; condIdx < NUM_CONDITIONS; condIdx++)
+		{
+			const Condition& cond = CONDITIONS[condIdx];
+			ChannelSimulator::Settings settings;
+			settings.snrDb = cond.snrDb;
+			settings.gain = cond.gain;
+			settings.clockOffsetPpm = cond.clockOffsetPpm;
+			settings.fadeDepth = cond.fadeDepth;
+			settings.fadePeriodSecs = FADE_PERIOD_SECS;
+			settings.humLevel = cond.humLevel;
+			settings.dcOffset = cond.dcOffset;
+			ChannelSimulator channel(SpeakUp::getModemSampleRate(), _seed + condIdx);
+			channel.setup(settings);
+			Clip clip;
+			clip.name = cond.pName;
+			clip.symbolRate = symbolRate;
+			channel.process(sent, clip.audio);
+			clip.messages = messages;
+			clip.numFrames = messages.size();
+			clip.numFramesKnown = true;
+			clips.push_back(clip);
+		}
+		for (const Clip& recording : recordings)
+		{
+			if (recording.symbolRate == symbolRate)
+				clips.push_back(recording);
+		}
+		std::vector<FSKDemodParams> rateCandidates(1, FSKDemodParams::forSymbolRate(SpeakUp::getModemSampleRate(), symbolRate));
+		rateCandidates.insert(rateCandidates.end(), candidates.begin(), candidates.end());
+		best.push_back(tuneRate(clips, rateCandidates, symbolRate));
+	}
+
+	// Preset table lines
+	printf("Presets for FSKDemodParams.cpp (samples per symbol first)\n");
+	for (size_t i = 0; i < best.size(); i++)
+	{
+		const FSKDemodParams& params = best[i];
+		printf("\t{ %d, %d, %d, %d, %d, %d, %d, %d, %d },\n", SpeakUp::getModemSampleRate() / _symbolRates[i],
+					params.envelopePercent, params.peakFollowPer10K, params.peakRestPer10K, params.numVotingSamples,
+					params.transitionMinPercent, params.transitionMaxPercent,
+					params.centreMinPercent, params.centreMaxPercent);
+	}
+	return 0;
+}
@@ -0,0 +1,178 @@
+// DisplayBench
+// Time the main loop is blocked by display updates - drawing each string as it is
+// shown (the original driver), drawing only the changed tiles from the loop, and
+// drawing the changed tiles from a render thread (as TileDisplayRenderTask does
+// on the ESP32) - on a fake display that takes the time of a real I2C bus
+//
+// Build (from this folder):
+//   g++ -O2 -pthread -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o DisplayBench DisplayBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   DisplayBench [-c busClockHz] [-u updates] [-i intervalMs]
+//     -c  I2C clock (default 100000 - software I2C, 400000 for hardware I2C)
+//     -u  display updates (default 60)
+//     -i  time between updates in the loop (default 40)
+//
+// An audio block is 16ms (128 samples at 8KHz) - the DMA buffers hold 128ms so
+// longer stalls lose audio
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <algorithm>
+#include "TileDisplay.h"
+#include "TileDisplayHost.h"
+
+static const double AUDIO_BLOCK_SECS = 0.016;
+static const double AUDIO_BUFFER_SECS = 0.128;
+
+enum BenchMode
+{
+	MODE_DIRECT,
+	MODE_DIRTY_TILES,
+	MODE_RENDER_THREAD
+};
+static const char* MODE_NAMES[] = { "direct strings", "dirty tiles in loop", "render thread" };
+
+static int _busClockHz = 100000;
+static int _numUpdates = 60;
+static int _intervalMs = 40;
+
+// Lines shown by an update - as main.cpp shows them plus a signal level that
+// changes on most updates
+struct DisplayLine
+{
+	int row;
+	std::string text;
+};
+static int getUpdateLines(int updateIdx, DisplayLine lines[])
+{
+	static const char* CONN_STATES[] = { "Connecting ... ", "Disconnected   ", "Connected ok   " };
+	int numLines = 0;
+	if (updateIdx == 0)
+	{
+		lines[numLines++] = { 0, "Mic on pin 35" };
+		lines[numLines++] = { 1, "Listening ..." };
+	}
+	if (updateIdx % 20 == 5)
+	{
+		lines[numLines++] = { 3, "Connecting to" };
+		lines[numLines++] = { 4, "Office-" + std::to_string(updateIdx / 20) };
+	}
+	if (updateIdx % 10 == 7)
+		lines[numLines++] = { 6, CONN_STATES[(updateIdx / 10) % 3] };
+	char levelStr[TileDisplay::COLS + 1];
+	snprintf(levelStr, sizeof(levelStr), "Level %3d dB", -20 - (updateIdx * 7) % 23);
+	lines[numLines++] = { 7, levelStr };
+	return numLines;
+}
+
+// Run the updates - returns false if the display doesn't end up showing them
+static bool runMode(BenchMode mode)
+{
+	FakeTileDisplayDevice device(_busClockHz);
+	TileDisplay display;
+	TileDisplayRenderThread renderThread(display, device);
+	char expected[TileDisplay::ROWS][TileDisplay::COLS];
+	memset(expected, ' ', sizeof(expected));
+
+	// Starting the display
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	if (mode == MODE_RENDER_THREAD)
+	{
+		renderThread.start();
+	}
+	else
+	{
+		device.begin();
+		if (mode == MODE_DIRECT)
+		{
+			for (int row = 0; row < TileDisplay::ROWS; row++)
+				device.drawTiles(0, row, expected[row], TileDisplay::COLS);
+		}
+	}
+	double beginSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	double sumBlockedSecs = 0;
+	double maxBlockedSecs = 0;
+	int numOverBlock = 0;
+	int numOverBuffer = 0;
+	for (int updateIdx = 0; updateIdx < _numUpdates; updateIdx++)
+	{
+		DisplayLine lines[8];
+		int numLines = getUpdateLines(updateIdx, lines);
+		startTime = std::chrono::steady_clock::now();
+		for (int lineIdx = 0; lineIdx < numLines; lineIdx++)
+		{
+			const DisplayLine& line = lines[lineIdx];
+			if (mode == MODE_DIRECT)
+			{
+				// U8x8 drawString sends each character as a separate transfer
+				for (int col = 0; (col < TileDisplay::COLS) && (col < (int)line.text.size()); col++)
+					device.drawTiles(col, line.row, line.text.c_str() + col, 1);
+			}
+			else
+			{
+				display.setLine(line.row, line.text.c_str());
+			}
+			memset(expected[line.row], ' ', TileDisplay::COLS);
+			memcpy(expected[line.row], line.text.c_str(), std::min((int)line.text.size(), TileDisplay::COLS));
+		}
+		if (mode == MODE_DIRTY_TILES)
+			display.render(device);
+		double blockedSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		sumBlockedSecs += blockedSecs;
+		if (maxBlockedSecs < blockedSecs)
+			maxBlockedSecs = blockedSecs;
+		if (blockedSecs > AUDIO_BLOCK_SECS)
+			numOverBlock++;
+		if (blockedSecs > AUDIO_BUFFER_SECS)
+			numOverBuffer++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(_intervalMs));
+	}
+	renderThread.stop();
+
+	// The original driver leaves the end of shorter strings on the display
+	bool showsOk = device.shows(expected);
+	printf("%-20s %8.2f %9.3f %9.3f %6d %6d %7d %9d %5.0f%%  %s\n", MODE_NAMES[mode], beginSecs * 1000,
+				sumBlockedSecs * 1000 / _numUpdates, maxBlockedSecs * 1000, numOverBlock, numOverBuffer,
+				device.getTilesDrawn(), device.getTransfers(),
+				100 * device.getBusySecs() / (_numUpdates * _intervalMs / 1000.0),
+				showsOk ? "ok" : (mode == MODE_DIRECT ? "stale text" : "WRONG"));
+	return showsOk || (mode == MODE_DIRECT);
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "c:u:i:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'c': _busClockHz = atoi(optarg); break;
+			case 'u': _numUpdates = atoi(optarg); break;
+			case 'i': _intervalMs = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-c busClockHz] [-u updates] [-i intervalMs]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (_busClockHz < 1000)
+		_busClockHz = 1000;
+	if (_numUpdates < 1)
+		_numUpdates = 1;
+	if (_intervalMs < 0)
+		_intervalMs = 0;
+
+	printf("%d updates every %dms - I2C at %dKHz\n\n", _numUpdates, _intervalMs, _busClockHz / 1000);
+	printf("                      begin ms   mean ms    max ms  >16ms >128ms   tiles transfers   bus\n");
+	bool allOk = true;
+	allOk = runMode(MODE_DIRECT) && allOk;
+	allOk = runMode(MODE_DIRTY_TILES) && allOk;
+	allOk = runMode(MODE_RENDER_THREAD) && allOk;
+	return allOk ? 0 : 1;
+}
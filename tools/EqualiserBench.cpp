@@ -0,0 +1,318 @@
+// EqualiserBench
+// Bit error rate of the FSK demodulator with and without the decision feedback
+// equaliser (FSKEqualiser) over the channel simulator's multipath profiles at a
+// range of symbol rates - and the cost of the equaliser per sample
+// Each burst is the sync word and random bits - a burst whose sync isn't detected
+// counts as all bits in error and "ok" is the number of bursts without an error
+// Then whole HDLC frames (the credentials message) through SpeakUpT with and without
+// the equaliser over the reverberant room - the bench fails unless the equaliser
+// decodes frames there that the plain slicer doesn't, and loses none on a clean channel
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o EqualiserBench EqualiserBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   EqualiserBench [-n bursts] [-s snrDb] [-b bits]
+//     -n  bursts for each profile and rate (default 30)
+//     -s  signal to noise ratio in dB (default 25)
+//     -b  random bits in each burst (default 256)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+#include "ChannelSimulator.h"
+
+// Sync word the demodulator detects (as SpeakUp - the HDLC flag)
+static const uint8_t SYNC_WORD = 0x7E;
+static const int SYMBOL_RATES[] = { 100, 200, 250, 400, 500 };
+static const char* PROFILES[] = { "none", "desk", "room", "hall" };
+
+// Frame check - frames for each channel and the SNR (the room at 200 and 400 baud
+// decodes no frames without the equaliser)
+static const int FRAME_CHECK_FRAMES = 20;
+static const double FRAME_CHECK_SNR_DB = 25;
+static const char* FRAME_CHECK_MESSAGE = "{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}";
+
+static int _numBursts = 30;
+static double _snrDb = 25;
+static int _numBits = 256;
+
+struct Burst
+{
+	size_t startPos;
+	size_t endPos;
+	std::vector<uint8_t> bits;
+};
+
+struct RunResult
+{
+	long bitErrors;
+	int missed;
+	int ok;
+};
+
+// Bursts separated by silence
+static void makeAudio(int symbolRate, std::vector<int>& audio, std::vector<Burst>& bursts)
+{
+	std::mt19937 rng(1);
+	FSKMod mod(64);
+	SpeakUp::setupMod(mod, symbolRate);
+	int gapLen = SpeakUp::getModemSampleRate() * 3 / 10;
+	audio.assign(gapLen, 0);
+	for (int burstIdx = 0; burstIdx < _numBursts; burstIdx++)
+	{
+		Burst burst;
+		for (int i = 0; i < _numBits; i++)
+			burst.bits.push_back(rng() & 1);
+		std::vector<uint8_t> txBits;
+		for (int i = 0; i < 8; i++)
+			txBits.push_back((SYNC_WORD >> i) & 1);
+		txBits.insert(txBits.end(), burst.bits.begin(), burst.bits.end());
+		size_t txPos = 0;
+		mod.setSymbolSource([&txBits, &txPos](int& symbol) {
+			if (txPos >= txBits.size())
+				return false;
+			symbol = txBits[txPos++];
+			return true;
+		});
+		burst.startPos = audio.size();
+		mod.startStream();
+		int sampleVal = 0;
+		while (mod.getSample(sampleVal))
+			audio.push_back(sampleVal / 4);
+		burst.endPos = audio.size();
+		audio.resize(audio.size() + gapLen, 0);
+		bursts.push_back(burst);
+	}
+}
+
+// Demodulate and compare - the sync detector is held during a burst (as when a
+// sync framed frame is received)
+static RunResult runDemod(const std::vector<int>& rx, const std::vector<Burst>& bursts, int symbolRate, bool equalise)
+{
+	FSKDemod demod(64);
+	SpeakUp::setupDemod(demod, true, symbolRate);
+	FSKEqualiser equaliser;
+	if (equalise && equaliser.setup(SpeakUp::getModemSampleRate() / symbolRate))
+		demod.setEqualiser(&equaliser);
+
+	RunResult result = { 0, 0, 0 };
+	std::vector<bool> found(bursts.size(), false);
+	int curBurst = -1;
+	int bitIdx = 0;
+	int syncBitsLeft = 0;
+	long burstErrors = 0;
+	int syncCount = 0;
+	for (size_t pos = 0; pos < rx.size(); pos++)
+	{
+		demod.processSample(rx[pos]);
+
+		// Start of a burst
+		if (demod.getSyncDetectCount() != syncCount)
+		{
+			syncCount = demod.getSyncDetectCount();
+			curBurst = -1;
+			for (size_t burstIdx = 0; burstIdx < bursts.size(); burstIdx++)
+				if ((pos >= bursts[burstIdx].startPos) && (pos < bursts[burstIdx].endPos) && !found[burstIdx])
+					curBurst = burstIdx;
+			if (curBurst >= 0)
+			{
+				found[curBurst] = true;
+				bitIdx = 0;
+				burstErrors = 0;
+				syncBitsLeft = 8;
+				demod.holdSyncDetector(true);
+			}
+		}
+
+		// Compare bits (the regenerated sync word first)
+		int bitVal = 0;
+		while (demod.getRxBit(bitVal))
+		{
+			if (curBurst < 0)
+				continue;
+			if (syncBitsLeft > 0)
+			{
+				syncBitsLeft--;
+				continue;
+			}
+			if (bitVal != bursts[curBurst].bits[bitIdx])
+				burstErrors++;
+			if (++bitIdx >= _numBits)
+			{
+				result.bitErrors += burstErrors;
+				if (burstErrors == 0)
+					result.ok++;
+				curBurst = -1;
+				demod.holdSyncDetector(false);
+			}
+		}
+	}
+	if (curBurst >= 0)
+		result.bitErrors += burstErrors + _numBits - bitIdx;
+	for (size_t burstIdx = 0; burstIdx < bursts.size(); burstIdx++)
+	{
+		if (found[burstIdx])
+			continue;
+		result.missed++;
+		result.bitErrors += _numBits;
+	}
+	return result;
+}
+
+// Demodulator time per sample (bits are discarded)
+static double timeDemod(const std::vector<int>& rx, int symbolRate, bool equalise)
+{
+	FSKDemod demod(64);
+	SpeakUp::setupDemod(demod, true, symbolRate);
+	FSKEqualiser equaliser;
+	if (equalise && equaliser.setup(SpeakUp::getModemSampleRate() / symbolRate))
+		demod.setEqualiser(&equaliser);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	uint32_t rxBits = 0;
+	for (int sampleVal : rx)
+	{
+		demod.processSample(sampleVal);
+		demod.getRxBits(rxBits, 32);
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return secs * 1e9 / rx.size();
+}
+
+// The equaliser configuration at another symbol rate
+template<int RATE>
+struct FrameCheckConfig : SpeakUpEqualiserConfig
+{
+	static const int SYMBOL_RATE = RATE;
+};
+
+// Frames decoded intact without and with the equaliser - returns false unless the
+// equaliser decodes at least as many (and more when expectGain)
+template<int RATE>
+static bool checkFrames(const char* pProfileName, bool expectGain)
+{
+	typedef SpeakUpT<FrameCheckConfig<RATE>> FrameSpeakUp;
+	static FrameSpeakUp speakUpTx;
+	static FrameSpeakUp speakUpPlain;
+	static FrameSpeakUp speakUpEqualised;
+	speakUpEqualised.enableEqualiser(true);
+
+	int gapLen = SpeakUp::getModemSampleRate() * 3 / 10;
+	std::vector<int> audio(gapLen, 0);
+	for (int frameIdx = 0; frameIdx < FRAME_CHECK_FRAMES; frameIdx++)
+	{
+		speakUpTx.encodeMessageToSamples(FRAME_CHECK_MESSAGE);
+		int sampleVal = 0;
+		while (speakUpTx.encodeGetSample(sampleVal))
+			audio.push_back(sampleVal / 4);
+		audio.resize(audio.size() + gapLen, 0);
+	}
+	ChannelSimulator channel(SpeakUp::getModemSampleRate(), 7);
+	ChannelSimulator::Settings settings;
+	settings.snrDb = FRAME_CHECK_SNR_DB;
+	settings.pMultipath = ChannelSimulator::getMultipathProfile(pProfileName);
+	channel.setup(settings);
+	std::vector<int> rx;
+	channel.process(audio, rx);
+
+	int plainFrames = 0;
+	int equalisedFrames = 0;
+	for (int sampleVal : rx)
+	{
+		speakUpPlain.decodeProcessSample(sampleVal);
+		speakUpEqualised.decodeProcessSample(sampleVal);
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (speakUpPlain.decodeGetFrame(pFrame, frameLen))
+		{
+			if (std::string((const char*)pFrame, frameLen) == FRAME_CHECK_MESSAGE)
+				plainFrames++;
+			speakUpPlain.decodeClearMessage();
+		}
+		if (speakUpEqualised.decodeGetFrame(pFrame, frameLen))
+		{
+			if (std::string((const char*)pFrame, frameLen) == FRAME_CHECK_MESSAGE)
+				equalisedFrames++;
+			speakUpEqualised.decodeClearMessage();
+		}
+	}
+	bool ok = expectGain ? (equalisedFrames > plainFrames) : (equalisedFrames >= plainFrames);
+	printf("%-6s %5d  %6d / %-6d %s\n", pProfileName, RATE, plainFrames, equalisedFrames, ok ? "" : "FAIL");
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:b:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': _numBursts = atoi(optarg); break;
+			case 's': _snrDb = atof(optarg); break;
+			case 'b': _numBits = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n bursts] [-s snrDb] [-b bits]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_numBursts < 1) || (_numBits < 1))
+	{
+		fprintf(stderr, "Bursts and bits must be at least 1\n");
+		return 1;
+	}
+
+	printf("%d bursts of %d bits at %.0fdB SNR - BER (missed bursts, bursts without error)\n",
+				_numBursts, _numBits, _snrDb);
+	printf("%-6s %5s  %-24s %-24s %s\n", "", "baud", "no equaliser", "equaliser", "ns/sample");
+	double plainNs = 0;
+	double equalisedNs = 0;
+	int numRuns = 0;
+	for (const char* pProfileName : PROFILES)
+	{
+		for (int symbolRate : SYMBOL_RATES)
+		{
+			std::vector<int> audio;
+			std::vector<Burst> bursts;
+			makeAudio(symbolRate, audio, bursts);
+			ChannelSimulator channel(SpeakUp::getModemSampleRate(), 7);
+			ChannelSimulator::Settings settings;
+			settings.snrDb = _snrDb;
+			settings.pMultipath = ChannelSimulator::getMultipathProfile(pProfileName);
+			channel.setup(settings);
+			std::vector<int> rx;
+			channel.process(audio, rx);
+
+			RunResult plain = runDemod(rx, bursts, symbolRate, false);
+			RunResult equalised = runDemod(rx, bursts, symbolRate, true);
+			double plainNsPerSample = timeDemod(rx, symbolRate, false);
+			double equalisedNsPerSample = timeDemod(rx, symbolRate, true);
+			double totalBits = (double)_numBursts * _numBits;
+			char plainText[32];
+			char equalisedText[32];
+			snprintf(plainText, sizeof(plainText), "%.4f (%d, %d)", plain.bitErrors / totalBits, plain.missed, plain.ok);
+			snprintf(equalisedText, sizeof(equalisedText), "%.4f (%d, %d)", equalised.bitErrors / totalBits,
+						equalised.missed, equalised.ok);
+			printf("%-6s %5d  %-24s %-24s %.0f / %.0f\n", pProfileName, symbolRate, plainText, equalisedText,
+						plainNsPerSample, equalisedNsPerSample);
+			plainNs += plainNsPerSample;
+			equalisedNs += equalisedNsPerSample;
+			numRuns++;
+		}
+	}
+	printf("Demodulator %.0f ns/sample - with the equaliser %.0f ns/sample\n", plainNs / numRuns, equalisedNs / numRuns);
+
+	printf("\n%d frames at %.0fdB SNR - frames decoded (no equaliser / equaliser)\n", FRAME_CHECK_FRAMES,
+				FRAME_CHECK_SNR_DB);
+	bool ok = checkFrames<100>("none", false);
+	ok = checkFrames<400>("none", false) && ok;
+	ok = checkFrames<100>("room", false) && ok;
+	ok = checkFrames<200>("room", true) && ok;
+	ok = checkFrames<400>("room", true) && ok;
+	return ok ? 0 : 1;
+}
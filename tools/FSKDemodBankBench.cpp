@@ -0,0 +1,139 @@
+// FSKDemodBankBench
+// Throughput of FSKDemodBank against the same number of separate FSKDemod instances
+// and a check that both produce the same bits on every channel
+//
+// Build (from this folder):
+//   g++ -O3 -march=native -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o FSKDemodBankBench FSKDemodBankBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   FSKDemodBankBench [-d seconds] [-n]
+//     -d  seconds of audio per channel (default 20)
+//     -n  no sync word detection
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "SpeakUp.h"
+#include "FSKDemodBank.h"
+
+static const int FIFO_LEN = 64;
+
+// Looped audio for each channel - the messages start at different points and
+// the level and noise differ
+static std::vector<int> _audio;
+static int _durationSecs = 20;
+static bool _syncDetect = true;
+
+static int channelSample(int channel, long long pos)
+{
+	int loopLen = _audio.size();
+	int sampleVal = _audio[(pos + channel * 997LL) % loopLen] * (2 + channel % 5) / 4;
+	uint32_t noiseSeed = (uint32_t)(pos * 2654435761u) ^ (uint32_t)(channel * 40503u);
+	return sampleVal + (int)((noiseSeed >> 16) % 2001) - 1000;
+}
+
+template<int N>
+static bool runBench()
+{
+	// Interleaved input
+	long long numSteps = (long long)_durationSecs * SpeakUp::getModemSampleRate();
+	std::vector<int> input(numSteps * N);
+	for (long long step = 0; step < numSteps; step++)
+		for (int c = 0; c < N; c++)
+			input[step * N + c] = channelSample(c, step);
+
+	// Separate demodulators - one channel at a time
+	std::vector<FSKDemod*> demods(N);
+	for (int c = 0; c < N; c++)
+	{
+		demods[c] = new FSKDemod(FIFO_LEN);
+		SpeakUp::setupDemod(*demods[c], _syncDetect);
+	}
+	std::vector<std::vector<uint8_t> > demodBits(N);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int c = 0; c < N; c++)
+	{
+		FSKDemod& demod = *demods[c];
+		std::vector<uint8_t>& bits = demodBits[c];
+		for (long long step = 0; step < numSteps; step++)
+		{
+			demod.processSample(input[step * N + c]);
+			uint32_t rxBits = 0;
+			int numBits = demod.getRxBits(rxBits, 32);
+			for (int i = 0; i < numBits; i++)
+				bits.push_back((rxBits >> i) & 0x01);
+		}
+	}
+	double demodSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Bank
+	FSKDemodBank<N>* pBank = new FSKDemodBank<N>(FIFO_LEN);
+	SpeakUp::setupDemod(*pBank, _syncDetect);
+	std::vector<std::vector<uint8_t> > bankBits(N);
+	static const int BLOCK_STEPS = 32;
+	startTime = std::chrono::steady_clock::now();
+	for (long long step = 0; step < numSteps; step += BLOCK_STEPS)
+	{
+		int blockSteps = (numSteps - step < BLOCK_STEPS) ? numSteps - step : BLOCK_STEPS;
+		pBank->processSamples(&input[step * N], blockSteps);
+		for (int c = 0; c < N; c++)
+		{
+			uint32_t rxBits = 0;
+			int numBits = pBank->getRxBits(c, rxBits, 32);
+			for (int i = 0; i < numBits; i++)
+				bankBits[c].push_back((rxBits >> i) & 0x01);
+		}
+	}
+	double bankSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// Compare
+	bool same = true;
+	size_t totalBits = 0;
+	for (int c = 0; c < N; c++)
+	{
+		same = same && (demodBits[c] == bankBits[c]) && (demods[c]->getSyncDetectCount() == pBank->getSyncDetectCount(c));
+		totalBits += bankBits[c].size();
+		delete demods[c];
+	}
+	delete pBank;
+	double samples = (double)numSteps * N;
+	printf("N %3d  FSKDemod %7.1f Msamples/s  FSKDemodBank %7.1f Msamples/s  x%.2f  bits %zu %s\n", N,
+				samples / demodSecs / 1e6, samples / bankSecs / 1e6, demodSecs / bankSecs, totalBits,
+				same ? "match" : "MISMATCH");
+	return same;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "d:n")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd': _durationSecs = atoi(optarg); break;
+			case 'n': _syncDetect = false; break;
+			default:
+				fprintf(stderr, "Usage: %s [-d seconds] [-n]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Audio for a message followed by silence
+	static SpeakUp speakUp;
+	speakUp.encodeMessageToSamples("{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}");
+	int sampleVal = 0;
+	while (speakUp.encodeGetSample(sampleVal))
+		_audio.push_back(sampleVal / 3);
+	_audio.resize(_audio.size() + SpeakUp::getModemSampleRate() / 2, 0);
+
+	bool ok = runBench<1>();
+	ok = runBench<2>() && ok;
+	ok = runBench<4>() && ok;
+	ok = runBench<8>() && ok;
+	ok = runBench<16>() && ok;
+	ok = runBench<32>() && ok;
+	ok = runBench<64>() && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+// FountainBench
+// Expected time to decode a fountain coded carousel (see FountainEncoder) against
+// packet loss rate compared with repeating the whole message, and a check that a
+// receiver joining a SpeakUp carousel part way through decodes the payload (one
+// short enough to be repeated and one fountain coded)
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o FountainBench FountainBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   FountainBench [-t trials]
+//     -t  receivers simulated at each loss rate (default 1000)
+//
+// Receivers join at a random point in the carousel and each packet is lost
+// independently - the loss rate is that of a packet with REF_BLOCK_LEN byte blocks
+// and anything longer on air (a packet with longer blocks or a repeated message) is
+// lost if any part of it would have been
+// Each payload is sent with the block length the encoder chooses (see
+// FountainEncoder::setup()) and the loss rates up to which repeating the message is
+// quicker are listed - the bench fails if repeating is quicker at 20% loss for a
+// payload longer than SpeakUp::CAROUSEL_REPEAT_MAX_LEN (shorter ones are repeated)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "SpeakUp.h"
+
+static const int LOSS_PERCENT[] = { 0, 5, 10, 20, 30, 50 };
+static const int FOUNTAIN_CHECK_LOSS_IDX = 3;
+static const int NUM_LOSS_RATES = sizeof(LOSS_PERCENT) / sizeof(LOSS_PERCENT[0]);
+
+// Payload lengths
+static const int PAYLOAD_LENS[] = { 64, 128, 256, 1024 };
+
+// Block length of the packet the loss rates are for
+static const int REF_BLOCK_LEN = 16;
+
+static int _numTrials = 1000;
+
+// Printable payload so it can also be sent as a plain message
+static void makePayload(std::vector<uint8_t>& payload, int payloadLen)
+{
+	payload.resize(payloadLen + 1);
+	for (int i = 0; i < payloadLen; i++)
+		payload[i] = 'a' + (i * 7 + i / 26) % 26;
+	payload[payloadLen] = 0;
+}
+
+// Air time (seconds) of the audio generated by SpeakUp
+static double getAirSecs(SpeakUp& speakUp)
+{
+	int sampleVal = 0;
+	int numSamples = 0;
+	while (speakUp.encodeGetSample(sampleVal))
+		numSamples++;
+	return (double)numSamples / SpeakUp::getModemSampleRate();
+}
+
+// Packets sent until a receiver joining at a random point decodes the payload
+static int packetsToDecode(const std::vector<uint8_t>& payload, int payloadLen, int blockLen,
+			double lossRate, std::mt19937& rng)
+{
+	FountainEncoder encoder;
+	encoder.setup(payload.data(), payloadLen, blockLen, 0x5A);
+	FountainDecoder decoder;
+	std::uniform_int_distribution<int> joinDist(0, encoder.getNumBlocks() * 4);
+	std::uniform_real_distribution<double> lossDist(0, 1);
+	const uint8_t* pPacket = NULL;
+	for (int i = joinDist(rng); i > 0; i--)
+		encoder.getNextPacket(pPacket);
+	for (int numSent = 1; ; numSent++)
+	{
+		int packetLen = encoder.getNextPacket(pPacket);
+		if ((lossDist(rng) >= lossRate) && decoder.handlePacket(pPacket, packetLen))
+		{
+			const uint8_t* pDecoded = NULL;
+			int decodedLen = 0;
+			decoder.getPayload(pDecoded, decodedLen);
+			if ((decodedLen != payloadLen) || (memcmp(pDecoded, payload.data(), payloadLen) != 0))
+				return -1;
+			return numSent;
+		}
+	}
+}
+
+// Time to decode at each loss rate for a payload
+static bool runScenario(int payloadLen, std::mt19937& rng)
+{
+	static SpeakUp speakUp;
+	std::vector<uint8_t> payload;
+	makePayload(payload, payloadLen);
+	FountainEncoder encoder;
+	encoder.setup(payload.data(), payloadLen, 0, 0);
+	int blockLen = encoder.getBlockLen();
+	speakUp.encodeCarouselToSamples(payload.data(), payloadLen, 1, blockLen);
+	double packetSecs = getAirSecs(speakUp);
+	speakUp.encodeCarouselToSamples(payload.data(), REF_BLOCK_LEN, 1, REF_BLOCK_LEN);
+	double refPacketSecs = getAirSecs(speakUp);
+	speakUp.encodeMessageToSamples((const char*)payload.data());
+	double messageSecs = getAirSecs(speakUp);
+	printf("%d byte payload - %d blocks of %d bytes - packet %.2fs - message %.2fs\n", payloadLen,
+				encoder.getNumBlocks(), blockLen, packetSecs, messageSecs);
+	printf("  loss  packets mean   p90   fountain mean    p90   repeated mean\n");
+
+	int repeatQuickerPercent = -1;
+	for (int lossIdx = 0; lossIdx < NUM_LOSS_RATES; lossIdx++)
+	{
+		double refLossRate = LOSS_PERCENT[lossIdx] / 100.0;
+		double lossRate = 1 - pow(1 - refLossRate, packetSecs / refPacketSecs);
+		std::vector<int> packets(_numTrials);
+		double sumPackets = 0;
+		for (int trial = 0; trial < _numTrials; trial++)
+		{
+			packets[trial] = packetsToDecode(payload, payloadLen, blockLen, lossRate, rng);
+			if (packets[trial] < 0)
+			{
+				printf("Decoded payload is wrong\n");
+				return false;
+			}
+			sumPackets += packets[trial];
+		}
+		std::sort(packets.begin(), packets.end());
+		double meanPackets = sumPackets / _numTrials;
+		int p90Packets = packets[_numTrials * 9 / 10];
+
+		// A repeated message is heard from the next start and resent until a copy gets through
+		double messageLoss = 1 - pow(1 - refLossRate, messageSecs / refPacketSecs);
+		// A carousel is heard from the next packet start
+		double fountainSecs = packetSecs / 2 + meanPackets * packetSecs;
+		printf("  %3d%%  %12.1f %5d %14.1fs %6.1fs", LOSS_PERCENT[lossIdx], meanPackets, p90Packets,
+					fountainSecs, packetSecs / 2 + p90Packets * packetSecs);
+		if (messageLoss < 0.999)
+		{
+			double repeatedSecs = messageSecs / 2 + messageSecs / (1 - messageLoss);
+			printf(" %14.1fs\n", repeatedSecs);
+			if ((repeatedSecs < fountainSecs) && (repeatQuickerPercent == lossIdx - 1))
+				repeatQuickerPercent = lossIdx;
+		}
+		else
+		{
+			printf("          never\n");
+		}
+	}
+	bool repeated = payloadLen <= SpeakUp::CAROUSEL_REPEAT_MAX_LEN;
+	if (repeatQuickerPercent < 0)
+		printf("  fountain quicker at every loss rate");
+	else
+		printf("  repeating the message quicker up to %d%% loss", LOSS_PERCENT[repeatQuickerPercent]);
+	printf("%s\n\n", repeated ? " - SpeakUp repeats it" : "");
+	return repeated || (repeatQuickerPercent < FOUNTAIN_CHECK_LOSS_IDX);
+}
+
+// A receiver joining an endless SpeakUp carousel part way through a packet
+static bool runAudioCheck(int payloadLen)
+{
+	static SpeakUp speakUpTx;
+	static SpeakUp speakUpRx;
+	std::vector<uint8_t> payload;
+	makePayload(payload, payloadLen);
+	speakUpTx.encodeCarouselToSamples(payload.data(), payloadLen);
+	speakUpRx.enableFountainReceive(true);
+	std::mt19937 rng(4321);
+	std::normal_distribution<double> noise(0, 300);
+	int joinSample = SpeakUp::getModemSampleRate() * 17 / 2;
+	int maxSamples = SpeakUp::getModemSampleRate() * 600;
+	int sampleVal = 0;
+	for (int sampleIdx = 0; (sampleIdx < maxSamples) && speakUpTx.encodeGetSample(sampleVal); sampleIdx++)
+	{
+		if (sampleIdx < joinSample)
+			continue;
+		speakUpRx.decodeProcessSample(sampleVal / 4 + (int)lround(noise(rng)));
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (!speakUpRx.decodeGetFrame(pFrame, frameLen))
+			continue;
+		bool payloadOk = (frameLen == payloadLen) && (memcmp(pFrame, payload.data(), payloadLen) == 0);
+		FountainDecoder& decoder = speakUpRx.getFountainDecoder();
+		printf("Audio carousel of %d bytes joined at %.1fs - %s after %.1fs (%d packets, %d not needed)\n",
+					payloadLen, (double)joinSample / SpeakUp::getModemSampleRate(), payloadOk ? "decoded" : "WRONG PAYLOAD",
+					(double)(sampleIdx - joinSample) / SpeakUp::getModemSampleRate(),
+					decoder.getPacketsReceived(), decoder.getPacketsDiscarded());
+		speakUpRx.decodeClearMessage();
+		return payloadOk;
+	}
+	printf("Audio carousel of %d bytes not decoded\n", payloadLen);
+	return false;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "t:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't': _numTrials = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-t trials]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (_numTrials < 1)
+		_numTrials = 1;
+
+	std::mt19937 rng(1234);
+	bool ok = true;
+	for (int payloadLen : PAYLOAD_LENS)
+		ok = runScenario(payloadLen, rng) && ok;
+	ok = runAudioCheck(48) && ok;
+	ok = runAudioCheck(256) && ok;
+	return ok ? 0 : 1;
+}
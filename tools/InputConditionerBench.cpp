@@ -0,0 +1,262 @@
+// InputConditionerBench
+// InputConditioner against the Arduino map() scaling it replaced - a simulated 12 bit
+// ADC with an offset feeds messages at levels over a 55dB range to the demodulator
+// Reports frames decoded for a range of preamble lengths, the AGC lock time (from the
+// start of a burst until the output level stays within 3dB of its final level), the
+// DC blocker's settling after a step in the ADC offset and the cost per sample
+// The exit code is 1 if the conditioner decodes fewer frames than map() at any level
+// or no more at the quietest levels (a few LSBs from the ADC, where map() leaves the
+// demodulator too little signal)
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o InputConditionerBench InputConditionerBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   InputConditionerBench [-n frames] [-o offset] [-s noiseLsb]
+//     -n  frames for each preamble length and level (default 40)
+//     -o  ADC offset from mid scale in LSBs (default 250)
+//     -s  ADC noise (standard deviation) in LSBs (default 1)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+#include "InputConditioner.h"
+
+static const int ADC_BITS = 12;
+static const int ADC_MAX = (1 << ADC_BITS) - 1;
+static const int LEVELS_DB[] = { -55, -50, -40, -30, -20, -10, 0 };
+static const int QUIET_LEVEL_DB = -55;
+static const int PREAMBLE_SYMBOLS[] = { 4, 8, 20 };
+static const int SPEAKUP_PREAMBLE_SYMBOLS = 8;
+static const int MAX_FRAME_LEN = 258;
+static const int GAP_LEN = 4000;
+static const int AGC_PREROLL_SECS = 4;
+static const char* MESSAGE = "{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}";
+
+static int _numFrames = 40;
+static int _adcOffset = 250;
+static double _noiseLsb = 1;
+
+// Samples of a frame at full scale with the given preamble
+static void makeFrame(int preambleSymbols, std::vector<int>& frame)
+{
+	FSKMod mod(16);
+	SpeakUp::setupMod(mod);
+	mod.setPreamble(preambleSymbols);
+	MiniHDLC hdlc(NULL, NULL, true, true, MAX_FRAME_LEN);
+	hdlc.startTxFrame((const uint8_t*)MESSAGE, strlen(MESSAGE));
+	mod.setSymbolSource([&hdlc](int& symbol) {
+		uint8_t bit = 0;
+		if (!hdlc.getTxBit(bit))
+			return false;
+		symbol = bit;
+		return true;
+	});
+	mod.startStream();
+	frame.clear();
+	int sampleVal = 0;
+	while (mod.getSample(sampleVal))
+		frame.push_back(sampleVal);
+}
+
+// Raw ADC readings of frames at a level (dB from full scale) each after a gap
+static void makeAdcAudio(const std::vector<int>& frame, int levelDb, int numFrames, int gapLen,
+				std::mt19937& rng, std::vector<int>& adcVals)
+{
+	std::normal_distribution<double> noise(0, _noiseLsb);
+	double scale = pow(10, levelDb / 20.0) * (ADC_MAX / 2) / 32767;
+	adcVals.clear();
+	for (int frameIdx = 0; frameIdx < numFrames; frameIdx++)
+	{
+		for (int i = 0; i < gapLen + (int)frame.size(); i++)
+		{
+			double sampleVal = (i < gapLen) ? 0 : frame[i - gapLen] * scale;
+			int adcVal = (ADC_MAX + 1) / 2 + _adcOffset + (int)lround(sampleVal + noise(rng));
+			adcVals.push_back((adcVal < 0) ? 0 : (adcVal > ADC_MAX) ? ADC_MAX : adcVal);
+		}
+	}
+	adcVals.resize(adcVals.size() + gapLen, (ADC_MAX + 1) / 2 + _adcOffset);
+}
+
+// Arduino map() as the ISR used it
+static inline int mapAdc(int adcVal)
+{
+	return (int)((long)adcVal * 65534 / ADC_MAX) - 32767;
+}
+
+// Frames decoded from ADC readings - the demodulator is set up as SpeakUp's
+template<typename ScaleFn>
+static int decodeFrames(const std::vector<int>& adcVals, ScaleFn scaleFn)
+{
+	FSKDemod demod(64);
+	SpeakUp::setupDemod(demod);
+	int numDecoded = 0;
+	MiniHDLC hdlc(NULL, [&numDecoded](const uint8_t* pFrame, int frameLen) {
+					if (std::string((const char*)pFrame, frameLen) == MESSAGE)
+						numDecoded++;
+				}, true, true, MAX_FRAME_LEN);
+	for (int adcVal : adcVals)
+	{
+		demod.processSample(scaleFn(adcVal));
+		uint32_t rxBits = 0;
+		int numBits = demod.getRxBits(rxBits, 32);
+		if (numBits > 0)
+			hdlc.handleBits(rxBits, numBits);
+	}
+	return numDecoded;
+}
+
+// Time (ms) from the start of a burst until the conditioned output's peak in each
+// 1ms stays within 3dB of its level at the end of the burst - the burst follows
+// long enough a silence for the AGC to release from the start up transient (as a
+// device that has been listening)
+static double agcLockMs(const std::vector<int>& frame, int levelDb, std::mt19937& rng)
+{
+	std::vector<int> adcVals;
+	int gapLen = SpeakUp::getModemSampleRate() * AGC_PREROLL_SECS;
+	makeAdcAudio(frame, levelDb, 1, gapLen, rng, adcVals);
+	InputConditioner conditioner(ADC_BITS);
+	int blockLen = SpeakUp::getModemSampleRate() / 1000;
+	std::vector<int> blockPeaks;
+	int blockPeak = 0;
+	for (int i = 0; i < gapLen + (int)frame.size(); i++)
+	{
+		int outVal = abs(conditioner.processAdcSample(adcVals[i]));
+		if (i < gapLen)
+			continue;
+		blockPeak = (outVal > blockPeak) ? outVal : blockPeak;
+		if ((i - gapLen) % blockLen == blockLen - 1)
+		{
+			blockPeaks.push_back(blockPeak);
+			blockPeak = 0;
+		}
+	}
+	double finalPeak = 0;
+	int numFinal = blockPeaks.size() / 4;
+	for (size_t i = blockPeaks.size() - numFinal; i < blockPeaks.size(); i++)
+		finalPeak += blockPeaks[i];
+	finalPeak /= numFinal;
+	int lockBlock = blockPeaks.size();
+	for (int i = blockPeaks.size() - 1; i >= 0; i--)
+	{
+		if ((blockPeaks[i] < finalPeak / M_SQRT2) || (blockPeaks[i] > finalPeak * M_SQRT2))
+			break;
+		lockBlock = i;
+	}
+	return lockBlock;
+}
+
+// Time (ms) for the DC left by a step in the ADC offset to fall below a fraction of the
+// step (AGC off so only the blocker acts)
+static double dcSettleMs(int stepLsb, double fraction)
+{
+	InputConditioner conditioner(ADC_BITS);
+	conditioner.enableAGC(false);
+	int midScale = (ADC_MAX + 1) / 2;
+	for (int i = 0; i < SpeakUp::getModemSampleRate(); i++)
+		conditioner.processAdcSample(midScale + _adcOffset);
+	int stepVal = mapAdc(midScale + stepLsb) - mapAdc(midScale);
+	for (int i = 0; i < SpeakUp::getModemSampleRate(); i++)
+	{
+		if (abs(conditioner.processAdcSample(midScale + _adcOffset + stepLsb)) < stepVal * fraction)
+			return i * 1000.0 / SpeakUp::getModemSampleRate();
+	}
+	return -1;
+}
+
+// Time per sample (ns) of a scaling function - the quickest of TIMING_PASSES passes
+static const int TIMING_PASSES = 7;
+template<typename ScaleFn>
+static double timeScaling(const std::vector<int>& adcVals, ScaleFn scaleFn)
+{
+	volatile int sink = 0;
+	double bestSecs = 0;
+	for (int pass = 0; pass < TIMING_PASSES; pass++)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		for (int adcVal : adcVals)
+			sink = sink + scaleFn(adcVal);
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		if ((pass == 0) || (secs < bestSecs))
+			bestSecs = secs;
+	}
+	return bestSecs * 1e9 / adcVals.size();
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "n:o:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': _numFrames = atoi(optarg); break;
+			case 'o': _adcOffset = atoi(optarg); break;
+			case 's': _noiseLsb = atof(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n frames] [-o offset] [-s noiseLsb]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_numFrames < 1) || (abs(_adcOffset) > ADC_MAX / 4) || (_noiseLsb < 0))
+	{
+		fprintf(stderr, "Frames must be at least 1, the offset within a quarter of the ADC range and the noise positive\n");
+		return 1;
+	}
+
+	// Decoding
+	std::mt19937 rng(1);
+	printf("%d bit ADC offset %d LSB noise %.1f LSB - frames decoded (of %d) map() / conditioned\n",
+				ADC_BITS, _adcOffset, _noiseLsb, _numFrames);
+	printf("%-9s", "preamble");
+	for (int levelDb : LEVELS_DB)
+		printf("  %4ddB     ", levelDb);
+	printf("\n");
+	std::vector<int> frame;
+	std::vector<int> adcVals;
+	bool ok = true;
+	for (int preambleSymbols : PREAMBLE_SYMBOLS)
+	{
+		makeFrame(preambleSymbols, frame);
+		printf("%-9d", preambleSymbols);
+		for (int levelDb : LEVELS_DB)
+		{
+			makeAdcAudio(frame, levelDb, _numFrames, GAP_LEN, rng, adcVals);
+			int mapped = decodeFrames(adcVals, mapAdc);
+			InputConditioner conditioner(ADC_BITS);
+			int conditioned = decodeFrames(adcVals, [&conditioner](int adcVal) {
+							return conditioner.processAdcSample(adcVal); });
+			printf("  %3d / %-3d  ", mapped, conditioned);
+			if ((conditioned < mapped) || ((levelDb <= QUIET_LEVEL_DB) && (conditioned <= mapped)))
+				ok = false;
+		}
+		printf("\n");
+	}
+
+	// AGC lock
+	makeFrame(SPEAKUP_PREAMBLE_SYMBOLS, frame);
+	double symbolMs = 1000.0 / SpeakUpDefaultConfig::SYMBOL_RATE;
+	printf("AGC lock (ms, preamble %.0fms):", SPEAKUP_PREAMBLE_SYMBOLS * symbolMs);
+	for (int levelDb : LEVELS_DB)
+		printf(" %ddB %.0f", levelDb, agcLockMs(frame, levelDb, rng));
+	printf("\n");
+
+	// DC blocker
+	printf("DC step of 100 LSB: below 10%% after %.0fms, below 1%% after %.0fms\n",
+				dcSettleMs(100, 0.1), dcSettleMs(100, 0.01));
+
+	// Cost
+	makeAdcAudio(frame, -20, 20, GAP_LEN, rng, adcVals);
+	InputConditioner conditioner(ADC_BITS);
+	printf("Cost: map() %.2f ns/sample, conditioner %.2f ns/sample\n", timeScaling(adcVals, mapAdc),
+				timeScaling(adcVals, [&conditioner](int adcVal) { return conditioner.processAdcSample(adcVal); }));
+	if (!ok)
+		printf("Conditioner decoded fewer frames than map() or none more at %ddB\n", QUIET_LEVEL_DB);
+	return ok ? 0 : 1;
+}
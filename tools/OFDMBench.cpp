@@ -0,0 +1,167 @@
+// OFDMBench
+// OFDM demodulator CPU cost per symbol and the proportion of kilobyte messages
+// received at a range of signal to noise ratios
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o OFDMBench OFDMBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   OFDMBench [-t trials] [-d seconds] [-l messageLen]
+//     -t  messages sent at each signal to noise ratio (default 10)
+//     -d  seconds of audio for the CPU measurement (default 60)
+//     -l  message length in bytes (default 1024)
+//
+// The signal to noise ratio is of white noise over the whole audio band (0-4kHz)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+
+static const int SNR_DB[] = { 30, 20, 15, 12, 10, 8 };
+static const int NUM_SNRS = sizeof(SNR_DB) / sizeof(SNR_DB[0]);
+
+// Silence before and after each message
+static const int GAP_SAMPLES = 4000;
+
+static int _numTrials = 10;
+static int _cpuSecs = 60;
+static int _messageLen = 1024;
+
+// Demodulator CPU time on a continuous signal with noise
+static void runCpu(const char* name, OFDMMod::CarrierModulation carrierModulation)
+{
+	static const int SAMPLE_RATE = 8000;
+	OFDMMod ofdmMod;
+	OFDMDemod ofdmDemod(256);
+	ofdmMod.setup(SAMPLE_RATE, 500, 3500, carrierModulation);
+	ofdmDemod.setup(SAMPLE_RATE, 500, 3500, carrierModulation);
+	std::mt19937 rng(5678);
+	ofdmMod.setBitSource([&rng](int& bitVal) { bitVal = rng() & 0x01; return true; });
+	ofdmMod.startStream();
+
+	// Generate first so only the demodulator is timed
+	int numSamples = _cpuSecs * SAMPLE_RATE;
+	std::vector<int> audio(numSamples);
+	std::normal_distribution<double> noise(0, 500);
+	for (int i = 0; i < numSamples; i++)
+	{
+		int sampleVal = 0;
+		ofdmMod.getSample(sampleVal);
+		audio[i] = sampleVal + (int)lround(noise(rng));
+	}
+
+	long long numBits = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < numSamples; i++)
+	{
+		ofdmDemod.processSample(audio[i]);
+		uint32_t rxBits = 0;
+		int gotBits = 0;
+		while ((gotBits = ofdmDemod.getRxBits(rxBits, 32)) > 0)
+			numBits += gotBits;
+	}
+	double cpuSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	double numSymbols = (double)numSamples / OFDMMod::SYMBOL_LEN;
+	printf("%-6s %4d bits/symbol %5d bps  %6.1f us/symbol %6.3f us/sample %7.0fx real time  bits %lld\n", name,
+				ofdmMod.getBitsPerSymbol(), ofdmMod.getBitsPerSymbol() * SAMPLE_RATE / OFDMMod::SYMBOL_LEN,
+				cpuSecs * 1e6 / numSymbols, cpuSecs * 1e6 / numSamples, _cpuSecs / cpuSecs, numBits);
+}
+
+// Proportion of messages received at each SNR
+static void runSensitivity(const char* name, SpeakUp::ModulationMode modulationMode, const std::string& message)
+{
+	// Audio for the message with silence either side
+	static SpeakUp speakUp;
+	speakUp.setModulationMode(modulationMode);
+	std::vector<int> audio(GAP_SAMPLES, 0);
+	speakUp.encodeMessageToSamples(message.c_str());
+	int sampleVal = 0;
+	double sumSquares = 0;
+	int numSignal = 0;
+	while (speakUp.encodeGetSample(sampleVal))
+	{
+		audio.push_back(sampleVal);
+		sumSquares += (double)sampleVal * sampleVal;
+		numSignal++;
+	}
+	audio.resize(audio.size() + GAP_SAMPLES, 0);
+	double signalPower = numSignal > 0 ? sumSquares / numSignal : 0;
+	double airSecs = (double)numSignal / SpeakUp::getModemSampleRate();
+	printf("%-6s %5.2fs %6.0f bps ", name, airSecs, message.size() * 8 / airSecs);
+
+	std::mt19937 rng(1234);
+	for (int snrIdx = 0; snrIdx < NUM_SNRS; snrIdx++)
+	{
+		std::normal_distribution<double> noise(0, sqrt(signalPower / pow(10.0, SNR_DB[snrIdx] / 10.0)));
+		int numOk = 0;
+		for (int trial = 0; trial < _numTrials; trial++)
+		{
+			speakUp.setModulationMode(modulationMode);
+			speakUp.decodeClearMessage();
+			bool gotMessage = false;
+			for (size_t i = 0; i < audio.size(); i++)
+			{
+				speakUp.decodeProcessSample(audio[i] + (int)lround(noise(rng)));
+				const uint8_t* pFrame = NULL;
+				int frameLen = 0;
+				if (speakUp.decodeGetFrame(pFrame, frameLen))
+				{
+					gotMessage = gotMessage || ((frameLen == (int)message.size()) && (memcmp(pFrame, message.c_str(), frameLen) == 0));
+					speakUp.decodeClearMessage();
+				}
+			}
+			if (gotMessage)
+				numOk++;
+		}
+		printf(" %3d%%", numOk * 100 / _numTrials);
+		fflush(stdout);
+	}
+	printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "t:d:l:")) != -1)
+	{
+		switch (opt)
+		{
+			case 't': _numTrials = atoi(optarg); break;
+			case 'd': _cpuSecs = atoi(optarg); break;
+			case 'l': _messageLen = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-t trials] [-d seconds] [-l messageLen]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (_numTrials <= 0)
+		_numTrials = 1;
+
+	printf("Demodulator CPU\n");
+	runCpu("QPSK", OFDMMod::OFDM_QPSK);
+	runCpu("DBPSK", OFDMMod::OFDM_DBPSK);
+
+	// A configuration blob - printable so it can be sent as a string
+	std::string message = "{\"cfg\":\"";
+	std::mt19937 rng(99);
+	while ((int)message.size() < _messageLen - 2)
+		message += (char)('A' + rng() % 26);
+	message += "\"}";
+	message.resize(_messageLen);
+
+	printf("\nMessages received (%d byte message, %d trials)\n", (int)message.size(), _numTrials);
+	printf("mode   air    rate      ");
+	for (int snrIdx = 0; snrIdx < NUM_SNRS; snrIdx++)
+		printf(" %3ddB", SNR_DB[snrIdx]);
+	printf("\n");
+	runSensitivity("QPSK", SpeakUp::MODULATION_OFDM_QPSK, message);
+	runSensitivity("DBPSK", SpeakUp::MODULATION_OFDM_DBPSK, message);
+	return 0;
+}
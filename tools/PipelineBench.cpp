@@ -0,0 +1,169 @@
+// PipelineBench
+// Throughput of a fused ModemPipeline against the current receive chain (FSKDemod ->
+// bit FIFO -> framer -> callback) and a check that both receive the same frames
+// Both framings are run - the pipelines differ only in the deframer stage
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o PipelineBench PipelineBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   PipelineBench [-d seconds] [-l noiseLevel]
+//     -d  seconds of audio (default 60)
+//     -l  peak level of the added noise (default 1000 - the signal peak is about 10000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+#include "ModemPipeline.h"
+#include "ModemStages.h"
+
+static const int FIFO_LEN = 64;
+static const int MAX_FRAME_LEN = 258;
+
+typedef ModemPipeline<HighpassEnvelopeStage, SyncDetectStage, SlicerStage, ClockRecoveryStage,
+			ManchesterDecodeStage, HdlcDeframerStage<MAX_FRAME_LEN>, FrameSinkStage<MAX_FRAME_LEN> > HdlcPipeline;
+typedef ModemPipeline<HighpassEnvelopeStage, SyncDetectStage, SlicerStage, ClockRecoveryStage,
+			ManchesterDecodeStage, SyncDeframerStage<>, FrameSinkStage<MAX_FRAME_LEN> > SyncPipeline;
+static const int SYNC_DETECT_STAGE = 1;
+static const int FRAME_SINK_STAGE = 6;
+
+static int _durationSecs = 60;
+static int _noiseLevel = 1000;
+
+// Messages separated by silence with noise throughout
+static void makeAudio(bool syncFraming, std::vector<int16_t>& audio)
+{
+	static SpeakUp speakUp;
+	if (syncFraming)
+		speakUp.setFramingMode(SpeakUp::FRAMING_SYNC);
+	else
+		speakUp.setFramingMode(SpeakUp::FRAMING_HDLC);
+	size_t numSamples = (size_t)_durationSecs * SpeakUp::getModemSampleRate();
+	audio.clear();
+	for (int msgIdx = 0; audio.size() < numSamples; msgIdx++)
+	{
+		audio.resize(audio.size() + SpeakUp::getModemSampleRate() / 5, 0);
+		char msg[64];
+		snprintf(msg, sizeof(msg), "{\"s\":\"MyNetwork\",\"p\":\"secretpass%d\"}", msgIdx);
+		speakUp.encodeMessageToSamples(msg);
+		int sampleVal = 0;
+		while (speakUp.encodeGetSample(sampleVal))
+			audio.push_back(sampleVal / 3);
+	}
+	audio.resize(numSamples);
+	for (size_t pos = 0; pos < numSamples; pos++)
+	{
+		uint32_t noiseSeed = (uint32_t)(pos * 2654435761u);
+		int noise = (int)((noiseSeed >> 16) % (2 * _noiseLevel + 1)) - _noiseLevel;
+		audio[pos] = saturateS16(audio[pos] + noise);
+	}
+}
+
+// Sync detection is held during sync framed frames (as SpeakUp)
+static void holdSyncDetector(FSKDemod&, MiniHDLC&)
+{
+}
+static void holdSyncDetector(FSKDemod& demod, SyncFramer& framer)
+{
+	demod.holdSyncDetector(framer.isRxInFrame());
+}
+
+// Current chain - as SpeakUp::demodulate() - frames are collected by the framer's callback
+template<typename FramerType>
+static double runChain(const std::vector<int16_t>& audio, FramerType& framer, FSKDemod& demod)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int16_t sampleVal : audio)
+	{
+		demod.processSample(sampleVal);
+		uint32_t rxBits = 0;
+		int numBits = demod.getRxBits(rxBits, 32);
+		if (numBits <= 0)
+			continue;
+		framer.handleBits(rxBits, numBits);
+		holdSyncDetector(demod, framer);
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Fused pipeline - frames are collected from the sink after each block
+template<typename PipelineType>
+static double runPipeline(const std::vector<int16_t>& audio, PipelineType& pipeline, std::vector<std::string>& frames)
+{
+	static const int BLOCK_LEN = 128;
+	auto& sink = pipeline.template stage<FRAME_SINK_STAGE>();
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (size_t pos = 0; pos < audio.size(); pos += BLOCK_LEN)
+	{
+		int blockLen = (audio.size() - pos < (size_t)BLOCK_LEN) ? audio.size() - pos : BLOCK_LEN;
+		pipeline.processSamples(audio.data() + pos, blockLen);
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (sink.getFrame(pFrame, frameLen))
+		{
+			frames.push_back(std::string((const char*)pFrame, frameLen));
+			sink.clearFrame();
+		}
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+template<typename FramerType, typename PipelineType>
+static bool runBench(const char* pName, bool syncFraming, FramerType& framer, std::vector<std::string>& chainFrames)
+{
+	std::vector<int16_t> audio;
+	makeAudio(syncFraming, audio);
+
+	// Current chain
+	FSKDemod demod(FIFO_LEN);
+	SpeakUp::setupDemod(demod);
+	double chainSecs = runChain(audio, framer, demod);
+
+	// Pipeline
+	PipelineType* pPipeline = new PipelineType();
+	SpeakUp::setupDemod(*pPipeline);
+	std::vector<std::string> pipelineFrames;
+	double pipelineSecs = runPipeline(audio, *pPipeline, pipelineFrames);
+
+	// Compare
+	bool same = (chainFrames == pipelineFrames) &&
+				(demod.getSyncDetectCount() == pPipeline->template stage<SYNC_DETECT_STAGE>().getSyncDetectCount());
+	printf("%-5s chain %6.1f Msamples/s  pipeline %6.1f Msamples/s  x%.2f  frames %zu syncs %d %s\n", pName,
+				audio.size() / chainSecs / 1e6, audio.size() / pipelineSecs / 1e6, chainSecs / pipelineSecs,
+				pipelineFrames.size(), demod.getSyncDetectCount(), same ? "match" : "MISMATCH");
+	delete pPipeline;
+	return same;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "d:l:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd': _durationSecs = atoi(optarg); break;
+			case 'l': _noiseLevel = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-d seconds] [-l noiseLevel]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Framers for the current chain collect frames through their callbacks
+	std::vector<std::string> hdlcFrames;
+	MiniHDLC hdlc(NULL, [&hdlcFrames](const uint8_t* pFrame, int frameLen) {
+					hdlcFrames.push_back(std::string((const char*)pFrame, frameLen)); },
+				true, true, MAX_FRAME_LEN);
+	std::vector<std::string> syncFrames;
+	SyncFramer syncFramer([&syncFrames](const uint8_t* pFrame, int frameLen) {
+					syncFrames.push_back(std::string((const char*)pFrame, frameLen)); });
+
+	bool ok = runBench<MiniHDLC, HdlcPipeline>("HDLC", false, hdlc, hdlcFrames);
+	ok = runBench<SyncFramer, SyncPipeline>("Sync", true, syncFramer, syncFrames) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// PreambleBench
+// Acquisition of the correlating preamble and sync word detector (PreambleDetector)
+// in FSKDemod against the demodulator without it - frames with a range of preamble
+// lengths are sent in noise and the detection rate, the time from the start of a
+// frame to detection and the frames decoded are reported - and false detections
+// are counted on noise alone
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o PreambleBench PreambleBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   PreambleBench [-n frames] [-d seconds]
+//     -n  frames for each preamble length and noise level (default 40)
+//     -d  seconds of noise at each level for false detections (default 600)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+
+// Noise (standard deviation) relative to the signal peak
+static const double NOISE_LEVELS[] = { 0.1, 0.15, 0.2, 0.3 };
+static const int PREAMBLE_SYMBOLS[] = { 4, 8, 20 };
+static const int SIGNAL_PEAK = 8000;
+static const int MAX_FRAME_LEN = 258;
+static const char* MESSAGE = "{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}";
+
+static int _numFrames = 40;
+static int _noiseSecs = 600;
+
+struct RunResult
+{
+	int detected;
+	double acquireMsSum;
+	int decoded;
+	int falseDetects;
+};
+
+// Frame at SIGNAL_PEAK with the given preamble
+static void makeFrame(int preambleSymbols, std::vector<int>& frame)
+{
+	FSKMod mod(16);
+	SpeakUp::setupMod(mod);
+	mod.setPreamble(preambleSymbols);
+	MiniHDLC hdlc(NULL, NULL, true, true, MAX_FRAME_LEN);
+	hdlc.startTxFrame((const uint8_t*)MESSAGE, strlen(MESSAGE));
+	mod.setSymbolSource([&hdlc](int& symbol) {
+		uint8_t bit = 0;
+		if (!hdlc.getTxBit(bit))
+			return false;
+		symbol = bit;
+		return true;
+	});
+	mod.startStream();
+	frame.clear();
+	int sampleVal = 0;
+	while (mod.getSample(sampleVal))
+		frame.push_back(sampleVal * SIGNAL_PEAK / 32767);
+}
+
+// Frames (if any) each after a gap with noise throughout - frameStarts has the
+// position of each frame
+static void makeAudio(const std::vector<int>& frame, int numFrames, int gapLen, double noiseLevel,
+				std::mt19937& rng, std::vector<int16_t>& audio, std::vector<size_t>& frameStarts)
+{
+	std::normal_distribution<double> noise(0, noiseLevel * SIGNAL_PEAK);
+	audio.clear();
+	frameStarts.clear();
+	for (int frameIdx = 0; frameIdx < numFrames; frameIdx++)
+	{
+		audio.resize(audio.size() + gapLen, 0);
+		frameStarts.push_back(audio.size());
+		audio.insert(audio.end(), frame.begin(), frame.end());
+	}
+	audio.resize(audio.size() + gapLen, 0);
+	for (size_t i = 0; i < audio.size(); i++)
+		audio[i] = saturateS16(audio[i] + (int)lround(noise(rng)));
+}
+
+// Demodulate - a detection within a frame counts once (the first) and others
+// (outside frames or repeated within one) are false
+static RunResult runDemod(const std::vector<int16_t>& audio, const std::vector<size_t>& frameStarts,
+				size_t frameLen, bool syncDetect)
+{
+	FSKDemod demod(64);
+	SpeakUp::setupDemod(demod, syncDetect);
+	RunResult result = { 0, 0, 0, 0 };
+	MiniHDLC hdlc(NULL, [&result](const uint8_t* pFrame, int frameLen) {
+					if (std::string((const char*)pFrame, frameLen) == MESSAGE)
+						result.decoded++;
+				}, true, true, MAX_FRAME_LEN);
+	int syncCount = 0;
+	size_t nextFrame = 0;
+	int lastDetectedFrame = -1;
+	for (size_t pos = 0; pos < audio.size(); pos++)
+	{
+		demod.processSample(audio[pos]);
+		uint32_t rxBits = 0;
+		int numBits = demod.getRxBits(rxBits, 32);
+		if (numBits > 0)
+			hdlc.handleBits(rxBits, numBits);
+		while ((nextFrame < frameStarts.size()) && (frameStarts[nextFrame] + frameLen <= pos))
+			nextFrame++;
+		if (demod.getSyncDetectCount() == syncCount)
+			continue;
+		syncCount = demod.getSyncDetectCount();
+		bool inFrame = (nextFrame < frameStarts.size()) && (pos >= frameStarts[nextFrame]);
+		if (!inFrame || (lastDetectedFrame == (int)nextFrame))
+		{
+			result.falseDetects++;
+			continue;
+		}
+		lastDetectedFrame = nextFrame;
+		result.detected++;
+		result.acquireMsSum += (pos - frameStarts[nextFrame]) * 1000.0 / SpeakUp::getModemSampleRate();
+	}
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "n:d:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': _numFrames = atoi(optarg); break;
+			case 'd': _noiseSecs = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n frames] [-d seconds]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_numFrames < 1) || (_noiseSecs < 1))
+	{
+		fprintf(stderr, "Frames and seconds must be at least 1\n");
+		return 1;
+	}
+
+	// Acquisition
+	std::mt19937 rng(1);
+	std::vector<int> frame;
+	std::vector<int16_t> audio;
+	std::vector<size_t> frameStarts;
+	int gapLen = SpeakUp::getModemSampleRate() / 2;
+	double symbolMs = 1000.0 / SpeakUpDefaultConfig::SYMBOL_RATE;
+	printf("%d frames - detected, mean time to detection and frames decoded with the detector"
+				" / decoded without\n", _numFrames);
+	printf("%-9s %-6s", "preamble", "noise");
+	printf("  %-9s %-9s %s\n", "detected", "acquire", "decoded");
+	for (int preambleSymbols : PREAMBLE_SYMBOLS)
+	{
+		makeFrame(preambleSymbols, frame);
+		for (double noiseLevel : NOISE_LEVELS)
+		{
+			makeAudio(frame, _numFrames, gapLen, noiseLevel, rng, audio, frameStarts);
+			RunResult detector = runDemod(audio, frameStarts, frame.size(), true);
+			RunResult plain = runDemod(audio, frameStarts, frame.size(), false);
+			char acquireText[16] = "-";
+			if (detector.detected > 0)
+				snprintf(acquireText, sizeof(acquireText), "%.0fms", detector.acquireMsSum / detector.detected);
+			printf("%-9d %-6.2f  %-9d %-9s %d / %d\n", preambleSymbols, noiseLevel, detector.detected,
+						acquireText, detector.decoded, plain.decoded);
+		}
+	}
+	printf("The sync word takes %.0fms after the preamble\n", 8 * symbolMs);
+
+	// False detections on noise
+	printf("False detections in %ds of noise:", _noiseSecs);
+	for (double noiseLevel : NOISE_LEVELS)
+	{
+		makeAudio(frame, 0, _noiseSecs * SpeakUp::getModemSampleRate(), noiseLevel, rng, audio, frameStarts);
+		RunResult result = runDemod(audio, frameStarts, 0, true);
+		printf(" %.2f: %d", noiseLevel, result.falseDetects);
+	}
+	printf("\n");
+	return 0;
+}
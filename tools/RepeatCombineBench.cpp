@@ -0,0 +1,185 @@
+// RepeatCombineBench
+// Gain of combining repeated transmissions in MiniHDLC - a message is sent a number
+// of times through a simulated channel (see ChannelSimulator) and each trial counts
+// as received if any copy is decoded - with copies decoded independently and with
+// failed copies combined - frames delivered from noise alone are also counted and the
+// extra time the framer takes for each failed copy
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o RepeatCombineBench RepeatCombineBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   RepeatCombineBench [-n trials] [-r repeats] [-d seconds]
+//     -n  trials at each SNR (default 60)
+//     -r  copies of the message in each trial (default 3)
+//     -d  seconds of noise for false frames (default 1200)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+#include "ChannelSimulator.h"
+
+// Near the edge of what the demodulator receives so copies fail
+static const double SNRS_DB[] = { 11, 10, 9, 8 };
+static const double CLOCK_OFFSET_PPM = 2000;
+static const int NOISE_ALONE_LEVEL = 2000;
+static const int FIFO_LEN = 64;
+static const int MAX_FRAME_LEN = 258;
+static const char* MESSAGE = "{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}";
+
+static int _numTrials = 60;
+static int _numRepeats = 3;
+static int _noiseSecs = 1200;
+
+struct RunResult
+{
+	int received;
+	int copiesDecoded;
+	int combined;
+	int wrongFrames;
+	double secs;
+};
+
+// Copies of the message with gaps between them
+static void makeAudio(std::vector<int>& audio)
+{
+	MiniHDLC hdlc(NULL, NULL, true, true, MAX_FRAME_LEN);
+	FSKMod fskMod(FIFO_LEN);
+	SpeakUp::setupMod(fskMod);
+	fskMod.setSymbolSource([&hdlc](int& symbol) {
+			uint8_t bit = 0;
+			if (!hdlc.getTxBit(bit))
+				return false;
+			symbol = bit;
+			return true;
+		});
+	int gapLen = SpeakUp::getModemSampleRate() * 3 / 10;
+	audio.assign(gapLen, 0);
+	for (int i = 0; i < _numRepeats; i++)
+	{
+		hdlc.startTxFrame((const uint8_t*)MESSAGE, strlen(MESSAGE));
+		fskMod.startStream();
+		int sampleVal = 0;
+		while (fskMod.getSample(sampleVal))
+			audio.push_back(sampleVal / 4);
+		audio.resize(audio.size() + gapLen, 0);
+	}
+}
+
+// Demodulated bits of audio - packed as FSKDemod gives them with the count of each
+static void demodulate(const std::vector<int>& audio, std::vector<uint32_t>& bits, std::vector<int>& bitCounts)
+{
+	FSKDemod demod(FIFO_LEN);
+	SpeakUp::setupDemod(demod);
+	bits.clear();
+	bitCounts.clear();
+	for (int sampleVal : audio)
+	{
+		demod.processSample(sampleVal);
+		uint32_t rxBits = 0;
+		int numBits = demod.getRxBits(rxBits, 32);
+		if (numBits <= 0)
+			continue;
+		bits.push_back(rxBits);
+		bitCounts.push_back(numBits);
+	}
+}
+
+// Decode the bits - counts copies decoded and frames that aren't the message and
+// the time taken by the framer
+static void decode(const std::vector<uint32_t>& bits, const std::vector<int>& bitCounts, bool combine,
+				RunResult& result)
+{
+	int copiesDecoded = 0;
+	MiniHDLC hdlc(NULL, [&copiesDecoded, &result](const uint8_t* pFrame, int frameLen) {
+				if (std::string((const char*)pFrame, frameLen) == MESSAGE)
+					copiesDecoded++;
+				else
+					result.wrongFrames++;
+			}, true, true, MAX_FRAME_LEN);
+	hdlc.enableRepeatCombining(combine);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < bits.size(); i++)
+		hdlc.handleBits(bits[i], bitCounts[i]);
+	result.secs += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.copiesDecoded += copiesDecoded;
+	result.combined += hdlc.getCombinedFrameCount();
+	if (copiesDecoded > 0)
+		result.received++;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "n:r:d:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': _numTrials = atoi(optarg); break;
+			case 'r': _numRepeats = atoi(optarg); break;
+			case 'd': _noiseSecs = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n trials] [-r repeats] [-d seconds]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_numTrials < 1) || (_numRepeats < 1) || (_noiseSecs < 1))
+	{
+		fprintf(stderr, "Trials, repeats and seconds must be at least 1\n");
+		return 1;
+	}
+
+	std::vector<int> audio;
+	makeAudio(audio);
+	std::vector<uint32_t> bits;
+	std::vector<int> bitCounts;
+	printf("%d trials of %d copies (clock offset %.0fppm) - trials received (copies decoded)\n",
+				_numTrials, _numRepeats, CLOCK_OFFSET_PPM);
+	printf("%-6s  %-14s %-14s %-9s %s\n", "SNR", "independent", "combined", "by vote", "extra us/copy");
+	for (double snrDb : SNRS_DB)
+	{
+		RunResult independent = { 0, 0, 0, 0, 0 };
+		RunResult combined = { 0, 0, 0, 0, 0 };
+		for (int trial = 0; trial < _numTrials; trial++)
+		{
+			ChannelSimulator channel(SpeakUp::getModemSampleRate(), trial + 1);
+			ChannelSimulator::Settings settings;
+			settings.snrDb = snrDb;
+			settings.clockOffsetPpm = CLOCK_OFFSET_PPM;
+			channel.setup(settings);
+			std::vector<int> rx;
+			channel.process(audio, rx);
+			demodulate(rx, bits, bitCounts);
+			decode(bits, bitCounts, false, independent);
+			decode(bits, bitCounts, true, combined);
+		}
+		char independentText[32];
+		char combinedText[32];
+		snprintf(independentText, sizeof(independentText), "%d (%d)", independent.received, independent.copiesDecoded);
+		snprintf(combinedText, sizeof(combinedText), "%d (%d)", combined.received, combined.copiesDecoded);
+		int numFailed = _numTrials * _numRepeats - independent.copiesDecoded;
+		double extraUs = (numFailed > 0) ? (combined.secs - independent.secs) * 1e6 / numFailed : 0;
+		printf("%-4.0fdB  %-14s %-14s %-9d %.1f\n", snrDb, independentText, combinedText, combined.combined, extraUs);
+		if (independent.wrongFrames + combined.wrongFrames > 0)
+			printf("        wrong frames delivered: %d independent, %d combined\n",
+						independent.wrongFrames, combined.wrongFrames);
+	}
+
+	// Noise alone
+	std::mt19937 rng(1234);
+	std::normal_distribution<double> noiseDist(0, NOISE_ALONE_LEVEL);
+	std::vector<int> noise(_noiseSecs * SpeakUp::getModemSampleRate());
+	for (size_t i = 0; i < noise.size(); i++)
+		noise[i] = (int)lround(noiseDist(rng));
+	RunResult noiseResult = { 0, 0, 0, 0, 0 };
+	demodulate(noise, bits, bitCounts);
+	decode(bits, bitCounts, true, noiseResult);
+	printf("Frames delivered from %ds of noise with combining: %d\n", _noiseSecs, noiseResult.wrongFrames);
+	return 0;
+}
@@ -0,0 +1,131 @@
+// ResamplerBench
+// Passband ripple and throughput of the input Resampler converting common audio
+// rates to the modem rate - and the storage each conversion needs
+// Ripple is the spread of the gain for tones across the band the modem uses
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o ResamplerBench ResamplerBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   ResamplerBench [-d seconds] [-l lowHz] [-h highHz]
+//     -d  seconds of input for the throughput measurement (default 20)
+//     -l  lowest tone of the passband (default 300)
+//     -h  highest tone of the passband (default 2500)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "SpeakUp.h"
+
+static const int INPUT_RATES[] = { 11025, 16000, 22050, 32000, 44100, 48000, 96000 };
+static const int TONE_STEP_HZ = 50;
+
+static int _durationSecs = 20;
+static int _lowHz = 300;
+static int _highHz = 2500;
+
+// Gain (dB) for a tone - the first output samples (the filter filling) are skipped
+static double toneGainDb(Resampler& resampler, int inputRate, int toneHz)
+{
+	static const double AMPLITUDE = 10000;
+	static const double TONE_SECS = 0.25;
+	resampler.clear();
+	int numInput = (int)(inputRate * TONE_SECS);
+	int skipOutput = SpeakUp::getModemSampleRate() / 20;
+	double sumSq = 0;
+	int numOutput = 0;
+	int16_t outSamples[8];
+	for (int i = 0; i < numInput; i++)
+	{
+		int sampleVal = (int)lround(AMPLITUDE * sin(2 * M_PI * toneHz * i / inputRate));
+		int numOut = resampler.processSample(sampleVal, outSamples);
+		for (int j = 0; j < numOut; j++)
+		{
+			if (numOutput++ < skipOutput)
+				continue;
+			sumSq += (double)outSamples[j] * outSamples[j];
+		}
+	}
+	double rms = sqrt(sumSq / (numOutput - skipOutput));
+	return 20 * log10(rms / (AMPLITUDE / sqrt(2.0)));
+}
+
+// Input samples per second (millions) converted a block at a time
+static double throughput(Resampler& resampler, int inputRate)
+{
+	static const int BLOCK_LEN = 256;
+	std::vector<int16_t> input((size_t)_durationSecs * inputRate);
+	uint32_t noiseSeed = 1;
+	for (size_t i = 0; i < input.size(); i++)
+	{
+		noiseSeed = noiseSeed * 1664525u + 1013904223u;
+		input[i] = (int16_t)((int)(noiseSeed >> 16) % 20001 - 10000);
+	}
+	std::vector<int16_t> output(resampler.maxOutputSamples(BLOCK_LEN));
+	resampler.clear();
+	long long totalOut = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (size_t pos = 0; pos < input.size(); )
+	{
+		int blockLen = (input.size() - pos < (size_t)BLOCK_LEN) ? input.size() - pos : BLOCK_LEN;
+		int numOut = 0;
+		pos += resampler.processBlock(input.data() + pos, blockLen, output.data(), output.size(), numOut);
+		totalOut += numOut;
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	if (totalOut == 0)
+		return 0;
+	return input.size() / secs / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "d:l:h:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd': _durationSecs = atoi(optarg); break;
+			case 'l': _lowHz = atoi(optarg); break;
+			case 'h': _highHz = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-d seconds] [-l lowHz] [-h highHz]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_durationSecs < 1) || (_lowHz < 1) || (_highHz <= _lowHz) || (_highHz >= SpeakUp::getModemSampleRate() / 2))
+	{
+		fprintf(stderr, "Seconds must be at least 1 and the passband within the modem's band\n");
+		return 1;
+	}
+
+	printf("Passband %d-%dHz to %dHz\n", _lowHz, _highHz, SpeakUp::getModemSampleRate());
+	printf("%6s %7s %7s  %-8s %-8s %-8s %s\n", "rate", "coeffs", "history", "min dB", "max dB", "ripple", "Msamples/s");
+	for (int inputRate : INPUT_RATES)
+	{
+		int numCoeffs = 0;
+		int historyLen = 0;
+		Resampler::filterSize(inputRate, SpeakUp::getModemSampleRate(), Resampler::DEFAULT_TAPS_PER_PHASE,
+					numCoeffs, historyLen);
+		Resampler resampler;
+		if (!resampler.setup(inputRate, SpeakUp::getModemSampleRate()))
+		{
+			printf("%6d setup failed\n", inputRate);
+			continue;
+		}
+		double minGain = 1e9;
+		double maxGain = -1e9;
+		for (int toneHz = _lowHz; toneHz <= _highHz; toneHz += TONE_STEP_HZ)
+		{
+			double gainDb = toneGainDb(resampler, inputRate, toneHz);
+			minGain = (gainDb < minGain) ? gainDb : minGain;
+			maxGain = (gainDb > maxGain) ? gainDb : maxGain;
+		}
+		printf("%6d %7d %7d  %-8.2f %-8.2f %-8.2f %.1f\n", inputRate, numCoeffs, historyLen, minGain, maxGain,
+					maxGain - minGain, throughput(resampler, inputRate));
+	}
+	return 0;
+}
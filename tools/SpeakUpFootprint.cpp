@@ -0,0 +1,141 @@
+// SpeakUpFootprint
+// Memory used by each part of SpeakUp in the standard configurations, a check
+// that a configuration with an in-object budget receives messages without the heap
+// and a check that each configuration receives frames of exactly MAX_FRAME_LEN
+// bytes (with and without addressing) and drops longer ones
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SpeakUpFootprint SpeakUpFootprint.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SpeakUpFootprint
+//
+// The sizes are for the host - pointers and alignment make them larger than on
+// the ESP32 (which has 4 byte pointers)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <string>
+#include "SpeakUp.h"
+
+// Count of heap allocations
+static int _heapAllocs = 0;
+
+void* operator new(size_t size)
+{
+	_heapAllocs++;
+	void* pMem = malloc(size);
+	if (!pMem)
+		throw std::bad_alloc();
+	return pMem;
+}
+
+void operator delete(void* pMem) noexcept
+{
+	free(pMem);
+}
+
+void operator delete(void* pMem, size_t) noexcept
+{
+	free(pMem);
+}
+
+template<typename SpeakUpType>
+static void printFootprint(const char* configName)
+{
+	printf("%s\n", configName);
+	for (int part = 0; part < SpeakUpType::FOOTPRINT_NUM_PARTS; part++)
+		printf("  %-18s %7d bytes\n", SpeakUpType::getFootprintName(part), SpeakUpType::getFootprintBytes(part));
+	printf("  %-18s %7d bytes\n\n", "Total", SpeakUpType::getFootprintTotal());
+}
+
+// Send a message from the default configuration to another - returns the
+// number of heap allocations made by the receiver
+template<typename SpeakUpType>
+static int receiveMessage(const char* msg, bool& received)
+{
+	static SpeakUp speakUpTx;
+	static SpeakUpType speakUpRx;
+	speakUpTx.encodeMessageToSamples(msg);
+	int heapAllocsBefore = _heapAllocs;
+	int sampleVal = 0;
+	received = false;
+	while (speakUpTx.encodeGetSample(sampleVal))
+	{
+		speakUpRx.decodeProcessSample(sampleVal / 4);
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (speakUpRx.decodeGetFrame(pFrame, frameLen))
+		{
+			received = true;
+			speakUpRx.decodeClearMessage();
+		}
+	}
+	return _heapAllocs - heapAllocsBefore;
+}
+
+// Check that a configuration receives a frame of MAX_FRAME_LEN bytes and drops one
+// a byte longer
+template<typename SpeakUpType, typename Config>
+static bool checkMaxFrameLen(const char* configName, bool addressing)
+{
+	static SpeakUp speakUpTx;
+	static SpeakUpType speakUpRx;
+	speakUpTx.enableAddressing(addressing);
+	speakUpRx.enableAddressing(addressing);
+	bool ok = true;
+	for (int frameLen = Config::MAX_FRAME_LEN; frameLen <= Config::MAX_FRAME_LEN + 1; frameLen++)
+	{
+		std::string msg;
+		for (int i = 0; i < frameLen; i++)
+			msg += (char)('a' + i % 26);
+		speakUpRx.decodeClearMessage();
+		speakUpTx.encodeMessageToSamples(msg.c_str());
+		int sampleVal = 0;
+		bool received = false;
+		while (speakUpTx.encodeGetSample(sampleVal))
+		{
+			speakUpRx.decodeProcessSample(sampleVal / 4);
+			const uint8_t* pFrame = NULL;
+			int rxFrameLen = 0;
+			if (speakUpRx.decodeGetFrame(pFrame, rxFrameLen))
+			{
+				received = std::string((const char*)pFrame, rxFrameLen) == msg;
+				speakUpRx.decodeClearMessage();
+			}
+		}
+		bool expected = frameLen <= Config::MAX_FRAME_LEN;
+		printf("%s%s %d byte frame %s\n", configName, addressing ? " (addressed)" : "", frameLen,
+					received ? "received" : "dropped");
+		ok = ok && (received == expected);
+	}
+	return ok;
+}
+
+int main()
+{
+	printFootprint<SpeakUp>("SpeakUpDefaultConfig");
+	printFootprint<SpeakUpT<SpeakUpEqualiserConfig>>("SpeakUpEqualiserConfig");
+	printFootprint<SpeakUpT<SpeakUpResamplingConfig>>("SpeakUpResamplingConfig");
+	printFootprint<SpeakUpT<SpeakUpReceiverConfig>>("SpeakUpReceiverConfig");
+	printFootprint<SpeakUpT<SpeakUpCredentialsConfig>>("SpeakUpCredentialsConfig");
+
+	// Reception with the credentials configuration
+	bool received = false;
+	int heapAllocs = receiveMessage<SpeakUpT<SpeakUpCredentialsConfig>>("{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}",
+				received);
+	printf("Credentials message %s with %d heap allocations\n", received ? "received" : "NOT received", heapAllocs);
+	bool ok = received && (heapAllocs == 0);
+
+	// Longest frames
+	for (int addressing = 0; addressing < 2; addressing++)
+	{
+		ok = checkMaxFrameLen<SpeakUp, SpeakUpDefaultConfig>("SpeakUpDefaultConfig", addressing) && ok;
+		ok = checkMaxFrameLen<SpeakUpT<SpeakUpReceiverConfig>, SpeakUpReceiverConfig>("SpeakUpReceiverConfig",
+					addressing) && ok;
+		ok = checkMaxFrameLen<SpeakUpT<SpeakUpCredentialsConfig>, SpeakUpCredentialsConfig>("SpeakUpCredentialsConfig",
+					addressing) && ok;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// SpeakUpMultiBench
+// Throughput of MultiStreamDecoder - decodes the same looped messages on many streams
+// With -w the run is repeated for 1, 2, 4 ... threads and the speed-up over one thread
+// is reported - the exit code is 1 if any thread count decodes a different number of
+// frames
+//
+// Build (from this folder):
+//   g++ -O2 -pthread -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SpeakUpMultiBench SpeakUpMultiBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SpeakUpMultiBench [-s streams] [-t threads] [-w maxThreads] [-d seconds] [-c chunk]
+//     -s  number of streams (default 1000)
+//     -t  worker threads (default 0 - one per core)
+//     -w  sweep thread counts up to this (default 0 - no sweep, use -t)
+//     -d  seconds of audio per stream (default 30)
+//     -c  samples queued per stream for each round of processing (default 800)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include "SpeakUp.h"
+#include "MultiStreamDecoder.h"
+
+// Result of one run
+struct RunResult
+{
+	double msamplesPerSec;
+	double realTimePerStream;
+	int frames;
+	uint32_t steals;
+	int threads;
+};
+
+// Decode the looped audio on every stream for the duration with the given threads
+static RunResult runDecoder(const std::vector<int16_t>& audio, int numStreams, int numThreads,
+			int durationSecs, int chunkLen)
+{
+	std::atomic<int> frameCount(0);
+	MultiStreamDecoder decoder(numStreams, numThreads,
+				[&frameCount](int, const uint8_t*, int) { frameCount++; },
+				chunkLen);
+	fprintf(stderr, "%d streams %d threads arena %zu bytes (%zu per stream)\n", numStreams,
+				decoder.getNumThreads(), decoder.getArenaBytes(), decoder.getArenaBytes() / numStreams);
+
+	// Feed and decode a chunk at a time
+	int loopLen = audio.size();
+	long long totalSamples = (long long)durationSecs * SpeakUp::getModemSampleRate();
+	std::vector<int16_t> chunk(chunkLen);
+	double processSecs = 0;
+	for (long long pos = 0; pos < totalSamples; pos += chunkLen)
+	{
+		for (int streamId = 0; streamId < numStreams; streamId++)
+		{
+			int loopPos = (pos + (long long)streamId * 997) % loopLen;
+			for (int i = 0; i < chunkLen; i++)
+			{
+				chunk[i] = audio[loopPos];
+				if (++loopPos >= loopLen)
+					loopPos = 0;
+			}
+			decoder.pushSamples(streamId, chunk.data(), chunkLen);
+		}
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		decoder.process();
+		processSecs += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	RunResult result;
+	uint64_t samples = decoder.getSamplesProcessed();
+	result.msamplesPerSec = samples / processSecs / 1e6;
+	result.realTimePerStream = samples / processSecs / SpeakUp::getModemSampleRate() / numStreams;
+	result.frames = frameCount;
+	result.steals = decoder.getStealCount();
+	result.threads = decoder.getNumThreads();
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	int numStreams = 1000;
+	int numThreads = 0;
+	int maxSweepThreads = 0;
+	int durationSecs = 30;
+	int chunkLen = 800;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:t:w:d:c:")) != -1)
+	{
+		switch (opt)
+		{
+			case 's': numStreams = atoi(optarg); break;
+			case 't': numThreads = atoi(optarg); break;
+			case 'w': maxSweepThreads = atoi(optarg); break;
+			case 'd': durationSecs = atoi(optarg); break;
+			case 'c': chunkLen = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-s streams] [-t threads] [-w maxThreads] [-d seconds] [-c chunk]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Audio for a message followed by silence - looped on each stream from a different start
+	static SpeakUp speakUp;
+	std::vector<int16_t> audio;
+	speakUp.encodeMessageToSamples("{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}");
+	int sampleVal = 0;
+	while (speakUp.encodeGetSample(sampleVal))
+		audio.push_back(sampleVal / 3);
+	audio.resize(audio.size() + SpeakUp::getModemSampleRate() / 2, 0);
+
+	// Single run
+	if (maxSweepThreads <= 0)
+	{
+		RunResult result = runDecoder(audio, numStreams, numThreads, durationSecs, chunkLen);
+		printf("%.1f Msamples/s (%.0fx real time per stream) frames %d steals %u\n",
+					result.msamplesPerSec, result.realTimePerStream, result.frames, result.steals);
+		return 0;
+	}
+
+	// Sweep - speed-up is against one thread and efficiency is the speed-up per thread
+	// (only meaningful up to the number of cores)
+	printf("%u cores\n", std::thread::hardware_concurrency());
+	printf("threads  Msamples/s  speed-up  efficiency%%  frames  steals\n");
+	RunResult base = {};
+	bool ok = true;
+	for (int threads = 1; threads <= maxSweepThreads; threads *= 2)
+	{
+		RunResult result = runDecoder(audio, numStreams, threads, durationSecs, chunkLen);
+		if (threads == 1)
+			base = result;
+		double speedUp = result.msamplesPerSec / base.msamplesPerSec;
+		printf("%-8d %-11.1f %-9.2f %-12.0f %-7d %u\n", result.threads, result.msamplesPerSec,
+					speedUp, speedUp / result.threads * 100, result.frames, result.steals);
+		if (result.frames != base.frames)
+			ok = false;
+	}
+	if (!ok)
+		printf("FAIL - the frames decoded depend on the number of threads\n");
+	return ok ? 0 : 1;
+}
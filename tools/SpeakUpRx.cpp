@@ -0,0 +1,178 @@
+// SpeakUpRx
+// Decode SpeakUp audio from stdin and print each frame as soon as it completes
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SpeakUpRx SpeakUpRx.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SpeakUpRx [-r sampleRate] [-f s16le|u8|ulaw] [-y] [-s spreadingFactor] [-o q|d] [-q] [-e] [-c] [-k] [-a id[,groups]] [-v] < audio.raw
+//     -r  input sample rate (default 8000 - other rates are resampled)
+//     -f  sample format (default s16le - ulaw is G.711 mu-law)
+//     -y  sync word framing (default HDLC)
+//     -s  chirp spread spectrum with this spreading factor (6-10) in place of FSK
+//     -o  OFDM with QPSK (q) or DBPSK (d) carriers in place of FSK
+//     -q  enable squelch
+//     -e  enable the FSK equaliser (for reverberant rooms at higher symbol rates)
+//     -c  combine repeated transmissions
+//     -k  decode fountain coded carousels (the payload is printed once complete)
+//     -a  addressed frames - receive only those for this device ID, groups (a mask)
+//         or broadcast (see FrameAddress)
+//     -v  print samples processed and the real-time factor to stderr at the end
+//   e.g. arecord -t raw -f S16_LE -c 1 -r 8000 | ./SpeakUpRx
+//
+// Each frame is printed on one line as:
+//   <sample offset> <length> <frame as text (or hex if not printable)>
+// where the sample offset (in input samples) is the sample that completed the frame
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "SpeakUp.h"
+#include "AudioIOHost.h"
+
+// Everything SpeakUp has including the equaliser (enabled with -e) and the input resampler
+typedef SpeakUpT<SpeakUpResamplingConfig> RxSpeakUp;
+
+static void printFrame(long long sampleOffset, const uint8_t* pFrame, int frameLen)
+{
+	bool printable = true;
+	for (int i = 0; i < frameLen; i++)
+	{
+		if ((pFrame[i] < 0x20) || (pFrame[i] > 0x7e))
+		{
+			printable = false;
+			break;
+		}
+	}
+	printf("%lld %d ", sampleOffset, frameLen);
+	if (printable)
+		fwrite(pFrame, 1, frameLen, stdout);
+	else
+		for (int i = 0; i < frameLen; i++)
+			printf("%02x", pFrame[i]);
+	printf("\n");
+	fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+	int sampleRate = 8000;
+	AudioFileFormat format = AUDIO_FORMAT_S16LE;
+	bool syncFraming = false;
+	int spreadingFactor = 0;
+	char ofdmCarriers = 0;
+	bool squelch = false;
+	bool equaliser = false;
+	bool combine = false;
+	bool fountain = false;
+	bool addressing = false;
+	int deviceId = 0;
+	int groupMask = 0;
+	bool verbose = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "r:f:ys:o:qecka:v")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r': sampleRate = atoi(optarg); break;
+			case 'f':
+				if (strcmp(optarg, "u8") == 0)
+					format = AUDIO_FORMAT_U8;
+				else if (strcmp(optarg, "ulaw") == 0)
+					format = AUDIO_FORMAT_ULAW;
+				else if (strcmp(optarg, "s16le") != 0)
+				{
+					fprintf(stderr, "Unknown format %s\n", optarg);
+					return 1;
+				}
+				break;
+			case 'y': syncFraming = true; break;
+			case 's': spreadingFactor = atoi(optarg); break;
+			case 'o': ofdmCarriers = optarg[0]; break;
+			case 'q': squelch = true; break;
+			case 'e': equaliser = true; break;
+			case 'c': combine = true; break;
+			case 'k': fountain = true; break;
+			case 'a':
+				addressing = true;
+				if (sscanf(optarg, "%i,%i", &deviceId, &groupMask) < 1)
+				{
+					fprintf(stderr, "Bad address %s\n", optarg);
+					return 1;
+				}
+				break;
+			case 'v': verbose = true; break;
+			default:
+				fprintf(stderr, "Usage: %s [-r sampleRate] [-f s16le|u8|ulaw] [-y] [-s spreadingFactor] [-o q|d] [-q] [-e] [-c] [-k] [-a id[,groups]] [-v]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Setup
+	static RxSpeakUp speakUp;
+	if (!speakUp.setInputSampleRate(sampleRate))
+	{
+		fprintf(stderr, "Unsupported sample rate %d\n", sampleRate);
+		return 1;
+	}
+	if (syncFraming)
+		speakUp.setFramingMode(RxSpeakUp::FRAMING_SYNC);
+	if ((spreadingFactor != 0) && !speakUp.setModulationMode(RxSpeakUp::MODULATION_CHIRP, spreadingFactor))
+	{
+		fprintf(stderr, "Unsupported spreading factor %d\n", spreadingFactor);
+		return 1;
+	}
+	if (ofdmCarriers == 'q')
+		speakUp.setModulationMode(RxSpeakUp::MODULATION_OFDM_QPSK);
+	else if (ofdmCarriers == 'd')
+		speakUp.setModulationMode(RxSpeakUp::MODULATION_OFDM_DBPSK);
+	else if (ofdmCarriers != 0)
+	{
+		fprintf(stderr, "Unknown OFDM carrier modulation %c\n", ofdmCarriers);
+		return 1;
+	}
+	speakUp.enableSquelch(squelch);
+	speakUp.enableEqualiser(equaliser);
+	speakUp.enableRepeatCombining(combine);
+	speakUp.enableFountainReceive(fountain);
+	speakUp.enableAddressing(addressing, deviceId, groupMask);
+	FileAudioSource audioIn(stdin, sampleRate, format);
+
+	// Decode - frames are checked after each sample so the offset is exact
+	static const int BLOCK_LEN = 256;
+	int16_t samples[BLOCK_LEN];
+	long long sampleOffset = 0;
+	int frameCount = 0;
+	clock_t startClock = clock();
+	while (true)
+	{
+		int numSamples = audioIn.read(samples, BLOCK_LEN);
+		if (numSamples < 0)
+			break;
+		for (int i = 0; i < numSamples; i++)
+		{
+			speakUp.decodeProcessSample(samples[i]);
+			sampleOffset++;
+			const uint8_t* pFrame = NULL;
+			int frameLen = 0;
+			if (speakUp.decodeGetFrame(pFrame, frameLen))
+			{
+				printFrame(sampleOffset, pFrame, frameLen);
+				speakUp.decodeClearMessage();
+				frameCount++;
+			}
+		}
+	}
+
+	// Stats
+	if (verbose)
+	{
+		double cpuSecs = (double)(clock() - startClock) / CLOCKS_PER_SEC;
+		double audioSecs = (double)sampleOffset / sampleRate;
+		fprintf(stderr, "%lld samples (%.1fs of audio) %d frames in %.3fs CPU - %.0fx real time\n",
+				sampleOffset, audioSecs, frameCount, cpuSecs, cpuSecs > 0 ? audioSecs / cpuSecs : 0);
+	}
+	return 0;
+}
@@ -0,0 +1,190 @@
+// SpeakUpTx
+// Modulate each line read from stdin as a SpeakUp message and write the audio to stdout
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SpeakUpTx SpeakUpTx.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SpeakUpTx [-r sampleRate] [-f s16le|u8|ulaw] [-y] [-s spreadingFactor] [-o q|d] [-n repeats] [-g gapMs] [-k packets] [-a address] > audio.raw
+//     -r  output sample rate (default 8000 - other rates are resampled)
+//     -f  sample format (default s16le - ulaw is G.711 mu-law)
+//     -y  sync word framing (default HDLC)
+//     -s  chirp spread spectrum with this spreading factor (6-10) in place of FSK
+//     -o  OFDM with QPSK (q) or DBPSK (d) carriers in place of FSK
+//     -n  number of times each message is sent (default 1)
+//     -g  silence before each message in ms (default 100)
+//     -k  send each message as a fountain coded carousel of this many packets (one
+//         of up to 64 bytes is sent this many times as it is)
+//     -a  send addressed frames to this address (see FrameAddress - e.g. 0xffff
+//         for broadcast)
+//   e.g. echo hello | ./SpeakUpTx | aplay -t raw -f S16_LE -c 1 -r 8000
+//
+// The audio for each message is written (and flushed) as soon as its line is read
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "SpeakUp.h"
+#include "Resampler.h"
+#include "AudioIOHost.h"
+
+// Modem sample rate
+static const int MODEM_SAMPLE_RATE = 8000;
+
+// Sink that resamples from the modem rate
+class ResamplingAudioSink : public AudioSink
+{
+private:
+	AudioSink& _outSink;
+	Resampler _resampler;
+	bool _valid;
+	bool _passthrough;
+	static const int MAX_OUT_PER_SAMPLE = 16;
+
+public:
+	ResamplingAudioSink(AudioSink& outSink) : _outSink(outSink)
+	{
+		_valid = (outSink.getSampleRate() > 0) &&
+					_resampler.setup(MODEM_SAMPLE_RATE, outSink.getSampleRate());
+		_passthrough = _resampler.isPassthrough();
+	}
+
+	bool isValid()
+	{
+		return _valid && (_resampler.maxOutputSamples(1) <= MAX_OUT_PER_SAMPLE);
+	}
+
+	virtual int write(const int16_t* pSamples, int numSamples)
+	{
+		if (_passthrough)
+			return _outSink.write(pSamples, numSamples);
+		int16_t resampled[MAX_OUT_PER_SAMPLE];
+		for (int i = 0; i < numSamples; i++)
+		{
+			int numOut = _resampler.processSample(pSamples[i], resampled);
+			if ((numOut > 0) && (_outSink.write(resampled, numOut) != numOut))
+				return -1;
+		}
+		return numSamples;
+	}
+
+	virtual int getSampleRate()
+	{
+		return MODEM_SAMPLE_RATE;
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	int sampleRate = MODEM_SAMPLE_RATE;
+	AudioFileFormat format = AUDIO_FORMAT_S16LE;
+	bool syncFraming = false;
+	int spreadingFactor = 0;
+	char ofdmCarriers = 0;
+	int repeats = 1;
+	int gapMs = 100;
+	int carouselPackets = 0;
+	bool addressing = false;
+	unsigned int address = FrameAddress::BROADCAST;
+	int opt;
+	while ((opt = getopt(argc, argv, "r:f:ys:o:n:g:k:a:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r': sampleRate = atoi(optarg); break;
+			case 'f':
+				if (strcmp(optarg, "u8") == 0)
+					format = AUDIO_FORMAT_U8;
+				else if (strcmp(optarg, "ulaw") == 0)
+					format = AUDIO_FORMAT_ULAW;
+				else if (strcmp(optarg, "s16le") != 0)
+				{
+					fprintf(stderr, "Unknown format %s\n", optarg);
+					return 1;
+				}
+				break;
+			case 'y': syncFraming = true; break;
+			case 's': spreadingFactor = atoi(optarg); break;
+			case 'o': ofdmCarriers = optarg[0]; break;
+			case 'n': repeats = atoi(optarg); break;
+			case 'g': gapMs = atoi(optarg); break;
+			case 'k': carouselPackets = atoi(optarg); break;
+			case 'a':
+				addressing = true;
+				address = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-r sampleRate] [-f s16le|u8|ulaw] [-y] [-s spreadingFactor] [-o q|d] [-n repeats] [-g gapMs] [-k packets] [-a address]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Setup
+	FileAudioSink audioOut(stdout, sampleRate, format);
+	ResamplingAudioSink modemOut(audioOut);
+	if (!modemOut.isValid())
+	{
+		fprintf(stderr, "Unsupported sample rate %d\n", sampleRate);
+		return 1;
+	}
+	static SpeakUp speakUp;
+	if (syncFraming)
+		speakUp.setFramingMode(SpeakUp::FRAMING_SYNC);
+	speakUp.enableAddressing(addressing);
+	if ((spreadingFactor != 0) && !speakUp.setModulationMode(SpeakUp::MODULATION_CHIRP, spreadingFactor))
+	{
+		fprintf(stderr, "Unsupported spreading factor %d\n", spreadingFactor);
+		return 1;
+	}
+	if (ofdmCarriers == 'q')
+		speakUp.setModulationMode(SpeakUp::MODULATION_OFDM_QPSK);
+	else if (ofdmCarriers == 'd')
+		speakUp.setModulationMode(SpeakUp::MODULATION_OFDM_DBPSK);
+	else if (ofdmCarriers != 0)
+	{
+		fprintf(stderr, "Unknown OFDM carrier modulation %c\n", ofdmCarriers);
+		return 1;
+	}
+
+	// Silence between messages
+	static const int BLOCK_LEN = 256;
+	int16_t silence[BLOCK_LEN];
+	memset(silence, 0, sizeof(silence));
+	int gapSamples = gapMs * MODEM_SAMPLE_RATE / 1000;
+
+	// Each line is a message
+	char line[4096];
+	while (fgets(line, sizeof(line), stdin))
+	{
+		line[strcspn(line, "\r\n")] = 0;
+		if (line[0] == 0)
+			continue;
+		for (int rep = 0; rep < repeats; rep++)
+		{
+			for (int i = 0; i < gapSamples; i += BLOCK_LEN)
+				modemOut.write(silence, (gapSamples - i < BLOCK_LEN) ? gapSamples - i : BLOCK_LEN);
+			if (carouselPackets <= 0)
+			{
+				if (!speakUp.encodeMessageToSamples(line, address))
+				{
+					fprintf(stderr, "Message too long for the framing\n");
+					return 1;
+				}
+			}
+			else if (!speakUp.encodeCarouselToSamples((const uint8_t*)line, strlen(line), carouselPackets))
+			{
+				fprintf(stderr, "Message too long for a carousel\n");
+				return 1;
+			}
+			while (speakUp.encodeToSink(modemOut))
+				;
+		}
+		fflush(stdout);
+	}
+
+	// Trailing silence so the receiver sees the end of the last message
+	for (int i = 0; i < gapSamples; i += BLOCK_LEN)
+		modemOut.write(silence, (gapSamples - i < BLOCK_LEN) ? gapSamples - i : BLOCK_LEN);
+	return 0;
+}
@@ -0,0 +1,180 @@
+// SpectrumMonitorBench
+// CPU cost of SpectrumMonitor relative to FSKDemod at a range of analysis intervals,
+// the time it adds to SpeakUp decoding and its statistics for a SpeakUp message in noise
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SpectrumMonitorBench SpectrumMonitorBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SpectrumMonitorBench [-d seconds] [-b budgetPercent]
+//     -d  seconds of audio (default 300)
+//     -b  time the monitor at the default analysis interval may add to SpeakUp
+//         decoding as a percentage (default 15) - the exit code is 1 if exceeded
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "SpeakUp.h"
+
+static int _durationSecs = 300;
+static int _budgetPercent = 15;
+
+// Time per sample (ns) of processing the audio with a function - the quickest of
+// TIMING_PASSES passes so other load on the host doesn't count
+static const int TIMING_PASSES = 7;
+template<typename ProcessFn>
+static double timeProcessing(const std::vector<int>& audio, ProcessFn processFn)
+{
+	double bestSecs = 0;
+	for (int pass = 0; pass < TIMING_PASSES; pass++)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < audio.size(); i++)
+			processFn(audio[i]);
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		if ((pass == 0) || (secs < bestSecs))
+			bestSecs = secs;
+	}
+	return bestSecs * 1e9 / audio.size();
+}
+
+// Time per sample (ns) of SpeakUp decoding for one pass
+static double timeSpeakUpPass(SpeakUp& speakUp, const std::vector<int>& audio)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < audio.size(); i++)
+	{
+		speakUp.decodeProcessSample(audio[i]);
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (speakUp.decodeGetFrame(pFrame, frameLen))
+			speakUp.decodeClearMessage();
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return secs * 1e9 / audio.size();
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "d:b:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd': _durationSecs = atoi(optarg); break;
+			case 'b': _budgetPercent = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-d seconds] [-b budgetPercent]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Looped message (at 1/4 of full scale) with gaps and noise
+	static SpeakUp speakUp;
+	std::vector<int> message;
+	speakUp.encodeMessageToSamples("{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}");
+	int sampleVal = 0;
+	while (speakUp.encodeGetSample(sampleVal))
+		message.push_back(sampleVal / 4);
+	message.resize(message.size() + SpeakUp::getModemSampleRate(), 0);
+	std::vector<int> audio(_durationSecs * SpeakUp::getModemSampleRate());
+	std::mt19937 rng(1234);
+	std::normal_distribution<double> noise(0, 300);
+	for (size_t i = 0; i < audio.size(); i++)
+		audio[i] = message[i % message.size()] + (int)lround(noise(rng));
+
+	// Demodulator for reference
+	FSKDemod fskDemod(64);
+	SpeakUp::setupDemod(fskDemod);
+	double demodNs = timeProcessing(audio, [&fskDemod](int sampleVal) {
+		fskDemod.processSample(sampleVal);
+		uint32_t rxBits = 0;
+		fskDemod.getRxBits(rxBits, 32);
+	});
+	printf("FSKDemod                  %6.1f ns/sample\n", demodNs);
+
+	// Monitor alone at each interval
+	for (int interval = 1; interval <= 32; interval *= 2)
+	{
+		SpectrumMonitor monitor;
+		monitor.setup(SpeakUp::getModemSampleRate(), interval);
+		monitor.addBand(750, 1250);
+		monitor.addBand(1750, 2250);
+		double monitorNs = timeProcessing(audio, [&monitor](int sampleVal) {
+			monitor.processSample(sampleVal);
+		});
+		bool isDefault = (interval == SpectrumMonitor::DEFAULT_ANALYSIS_INTERVAL);
+		printf("SpectrumMonitor interval %2d %6.1f ns/sample %5.1f%% of FSKDemod  blocks %d%s\n", interval,
+					monitorNs, monitorNs * 100 / demodNs, monitor.getBlocksAnalysed() / TIMING_PASSES,
+					isDefault ? "  (default)" : "");
+	}
+
+	// Time added to SpeakUp decoding by enabling the monitor - this is what the budget
+	// is for as alone in a loop the monitor's countdown between blocks costs more than
+	// it does alongside the demodulator
+	// Passes alternate between the settings (so load on the host affects them all)
+	// and the quickest for each is used
+	bool withinBudget = true;
+	static const int SPEAKUP_INTERVALS[] = { 0, 4, 8, 16, 32 };
+	static const int NUM_SPEAKUP_INTERVALS = sizeof(SPEAKUP_INTERVALS) / sizeof(SPEAKUP_INTERVALS[0]);
+	static SpeakUp speakUps[NUM_SPEAKUP_INTERVALS];
+	double bestNs[NUM_SPEAKUP_INTERVALS];
+	for (int i = 0; i < NUM_SPEAKUP_INTERVALS; i++)
+		speakUps[i].enableSpectrumMonitor(SPEAKUP_INTERVALS[i] > 0, SPEAKUP_INTERVALS[i]);
+	for (int pass = 0; pass < TIMING_PASSES; pass++)
+	{
+		for (int i = 0; i < NUM_SPEAKUP_INTERVALS; i++)
+		{
+			double ns = timeSpeakUpPass(speakUps[i], audio);
+			if ((pass == 0) || (ns < bestNs[i]))
+				bestNs[i] = ns;
+		}
+	}
+	double speakUpNs = bestNs[0];
+	printf("\nSpeakUp decode           %6.1f ns/sample\n", speakUpNs);
+	for (int i = 1; i < NUM_SPEAKUP_INTERVALS; i++)
+	{
+		double addedNs = bestNs[i] - speakUpNs;
+		double percent = addedNs * 100 / speakUpNs;
+		bool isDefault = (SPEAKUP_INTERVALS[i] == SpectrumMonitor::DEFAULT_ANALYSIS_INTERVAL);
+		printf("  with monitor interval %2d %+6.1f ns/sample %+5.1f%%%s\n", SPEAKUP_INTERVALS[i], addedNs, percent,
+					isDefault ? "  (default)" : "");
+		if (isDefault && (percent > _budgetPercent))
+			withinBudget = false;
+	}
+
+	// Statistics through SpeakUp
+	speakUp.enableSpectrumMonitor(true);
+	int numFrames = 0;
+	for (size_t i = 0; i < audio.size(); i++)
+	{
+		speakUp.decodeProcessSample(audio[i]);
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (speakUp.decodeGetFrame(pFrame, frameLen))
+		{
+			numFrames++;
+			speakUp.decodeClearMessage();
+		}
+	}
+	printf("\n%d frames received\n", numFrames);
+	SpectrumMonitor& monitor = speakUp.getSpectrumMonitor();
+	const int bands[] = { SpeakUp::SPECTRUM_BAND_LOW_TONE, SpeakUp::SPECTRUM_BAND_HIGH_TONE };
+	for (int bandIdx : bands)
+	{
+		SpectrumMonitor::BandStats stats;
+		monitor.getBandStats(bandIdx, stats);
+		printf("band %d floor %6.1fdB peak %6.1fdB tone %7.1fHz SNR %5.1fdB (%d blocks)\n", bandIdx,
+					stats.noiseFloorDb, stats.peakDb, stats.toneFreqHz, stats.snrDb, stats.toneBlocks);
+	}
+	printf("input peak %d flat tops %d of %d samples\n", monitor.getPeakLevel(),
+				monitor.getFlatTopSamples(), monitor.getSamplesAnalysed());
+
+	if (!withinBudget)
+		printf("\nOver budget of %d%% of SpeakUp decoding\n", _budgetPercent);
+	return withinBudget ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// SquelchBench
+// CPU cost of SpeakUp's receive chain on silence (background noise) with and without
+// the energy squelch, how long the squelch is open, and a check that messages
+// with short preambles are still decoded with it enabled (the lookback buffer
+// must keep the preamble while the squelch opens)
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SquelchBench SquelchBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SquelchBench [-d seconds] [-n frames]
+//     -d  seconds of background noise for the idle cost (default 60)
+//     -n  frames for each preamble length and noise level (default 40)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+
+static const int PREAMBLE_SYMBOLS[] = { 4, 6, 8, 20 };
+static const int NOISE_LEVELS[] = { 100, 1000, 2500 };
+static const int MAX_FRAME_LEN = 258;
+static const char* MESSAGE = "{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}";
+
+static int _durationSecs = 60;
+static int _numFrames = 40;
+
+// Frame at a quarter of full scale with the given preamble
+static void makeFrame(int preambleSymbols, std::vector<int>& frame)
+{
+	FSKMod mod(16);
+	SpeakUp::setupMod(mod);
+	mod.setPreamble(preambleSymbols);
+	MiniHDLC hdlc(NULL, NULL, true, true, MAX_FRAME_LEN);
+	hdlc.startTxFrame((const uint8_t*)MESSAGE, strlen(MESSAGE));
+	mod.setSymbolSource([&hdlc](int& symbol) {
+		uint8_t bit = 0;
+		if (!hdlc.getTxBit(bit))
+			return false;
+		symbol = bit;
+		return true;
+	});
+	mod.startStream();
+	frame.clear();
+	int sampleVal = 0;
+	while (mod.getSample(sampleVal))
+		frame.push_back(sampleVal / 4);
+}
+
+// Gaussian noise with frames (if any) each after a gap
+static void makeAudio(const std::vector<int>& frame, int numFrames, int gapLen, int noiseLevel,
+				std::mt19937& rng, std::vector<int16_t>& audio)
+{
+	std::normal_distribution<double> noise(0, noiseLevel);
+	audio.clear();
+	for (int frameIdx = 0; frameIdx < numFrames; frameIdx++)
+	{
+		audio.resize(audio.size() + gapLen, 0);
+		audio.insert(audio.end(), frame.begin(), frame.end());
+	}
+	audio.resize(audio.size() + gapLen, 0);
+	for (size_t i = 0; i < audio.size(); i++)
+		audio[i] = saturateS16(audio[i] + (int)lround(noise(rng)));
+}
+
+// Process audio through SpeakUp - returns the time per sample (ns) and counts
+// the frames decoded and the samples for which the squelch was open
+static double runSpeakUp(const std::vector<int16_t>& audio, bool squelch, int& numDecoded, long& openSamples)
+{
+	static SpeakUp speakUp;
+	speakUp.decodeClearMessage();
+	speakUp.enableSquelch(squelch);
+	numDecoded = 0;
+	openSamples = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int16_t sampleVal : audio)
+	{
+		speakUp.decodeProcessSample(sampleVal);
+		if (speakUp.isSquelchOpen())
+			openSamples++;
+		const uint8_t* pFrame = NULL;
+		int frameLen = 0;
+		if (speakUp.decodeGetFrame(pFrame, frameLen))
+		{
+			if (std::string((const char*)pFrame, frameLen) == MESSAGE)
+				numDecoded++;
+			speakUp.decodeClearMessage();
+		}
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return secs * 1e9 / audio.size();
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "d:n:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd': _durationSecs = atoi(optarg); break;
+			case 'n': _numFrames = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-d seconds] [-n frames]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_durationSecs < 1) || (_numFrames < 1))
+	{
+		fprintf(stderr, "Seconds and frames must be at least 1\n");
+		return 1;
+	}
+
+	// Idle cost
+	std::mt19937 rng(1);
+	std::vector<int> frame;
+	std::vector<int16_t> audio;
+	int numDecoded = 0;
+	long openSamples = 0;
+	printf("Idle (%ds of noise) - ns/sample without / with squelch and time open\n", _durationSecs);
+	for (int noiseLevel : NOISE_LEVELS)
+	{
+		makeAudio(frame, 0, _durationSecs * SpeakUp::getModemSampleRate(), noiseLevel, rng, audio);
+		double plainNs = runSpeakUp(audio, false, numDecoded, openSamples);
+		double squelchNs = runSpeakUp(audio, true, numDecoded, openSamples);
+		printf("  noise %5d  %6.1f / %-6.1f open %.2f%%\n", noiseLevel, plainNs, squelchNs,
+					openSamples * 100.0 / audio.size());
+	}
+
+	// Decoding
+	printf("Frames decoded (of %d) without / with squelch\n", _numFrames);
+	printf("%-9s", "preamble");
+	for (int noiseLevel : NOISE_LEVELS)
+		printf("  noise %-5d ", noiseLevel);
+	printf("\n");
+	int gapLen = SpeakUp::getModemSampleRate();
+	for (int preambleSymbols : PREAMBLE_SYMBOLS)
+	{
+		makeFrame(preambleSymbols, frame);
+		printf("%-9d", preambleSymbols);
+		for (int noiseLevel : NOISE_LEVELS)
+		{
+			makeAudio(frame, _numFrames, gapLen, noiseLevel, rng, audio);
+			int plainDecoded = 0;
+			int squelchDecoded = 0;
+			runSpeakUp(audio, false, plainDecoded, openSamples);
+			runSpeakUp(audio, true, squelchDecoded, openSamples);
+			printf("  %3d / %-3d    ", plainDecoded, squelchDecoded);
+		}
+		printf("\n");
+	}
+	return 0;
+}
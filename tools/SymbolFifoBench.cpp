@@ -0,0 +1,233 @@
+// SymbolFifoBench
+// Bulk transfer throughput of SymbolFifo (symbols packed into 32 bit words) against a
+// byte per symbol FIFO (as FSKMod and FSKDemod used) and a fuzz test of SymbolFifo
+// against a reference queue for every symbol size with owned and external storage
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SymbolFifoBench SymbolFifoBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SymbolFifoBench [-l fifoLen] [-i iterations] [-f fuzzOps]
+//     -l  FIFO length in symbols (default 4000 - the SpeakUp receive FIFO)
+//     -i  times the FIFO is filled and emptied for the throughput (default 2000)
+//     -f  random operations for each fuzz case (default 1000000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+#include "SymbolFifo.h"
+
+static int _fifoLen = 4000;
+static int _iterations = 2000;
+static long _fuzzOps = 1000000;
+
+// Byte per symbol FIFO as FSKDemod had before SymbolFifo
+class ByteFifo
+{
+public:
+	RingBufferPosn _posn;
+	std::vector<uint8_t> _buf;
+	ByteFifo(int len) : _posn(len)
+	{
+		_buf.resize(len);
+	}
+	bool put(int symbol)
+	{
+		if (!_posn.canPut())
+			return false;
+		_buf[_posn.posToPut()] = symbol;
+		_posn.hasPut();
+		return true;
+	}
+	bool get(int& symbol)
+	{
+		if (!_posn.canGet())
+			return false;
+		symbol = _buf[_posn.posToGet()];
+		_posn.hasGot();
+		return true;
+	}
+};
+
+// Time per bit (ns) of filling and emptying a FIFO with a function that transfers a
+// FIFO's worth of bits (whole words) and returns a checksum
+template<typename TransferFn>
+static double timeTransfer(TransferFn transferFn, uint32_t& checksum)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < _iterations; i++)
+		checksum += transferFn(i);
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return secs * 1e9 / ((double)_iterations * (_fifoLen / 32 * 32));
+}
+
+// Random operations on a FIFO and a reference queue - returns false on a mismatch
+static bool fuzz(int bitsPerSymbol, bool externalStorage, uint32_t seed)
+{
+	std::vector<uint32_t> storage(SymbolFifo::storageWordsFor(_fifoLen, bitsPerSymbol));
+	SymbolFifo fifo(_fifoLen, bitsPerSymbol, externalStorage ? storage.data() : NULL);
+	std::deque<int> reference;
+	std::mt19937 rng(seed);
+	int storeBits = 32 >> SymbolFifo::wordShiftFor(bitsPerSymbol);
+	uint32_t storeMask = (1u << storeBits) - 1;
+	int symbolsPerWord = fifo.symbolsPerWord();
+	int capacity = (int)storage.size() * symbolsPerWord - 1;
+	for (long op = 0; op < _fuzzOps; op++)
+	{
+		// Runs of puts or gets so the FIFO fills and empties
+		bool putting = ((op >> 13) & 1) == 0;
+		int action = rng() % 8;
+		if ((action == 0) && putting)
+		{
+			uint32_t word = rng();
+			bool ok = fifo.putWord(word);
+			if (ok != (capacity - (int)reference.size() >= symbolsPerWord))
+				return false;
+			if (ok)
+				for (int i = 0; i < symbolsPerWord; i++)
+					reference.push_back((word >> (i * storeBits)) & storeMask);
+		}
+		else if (action == 0)
+		{
+			uint32_t word = 0;
+			bool ok = fifo.getWord(word);
+			if (ok != ((int)reference.size() >= symbolsPerWord))
+				return false;
+			for (int i = 0; ok && (i < symbolsPerWord); i++)
+			{
+				if (((word >> (i * storeBits)) & storeMask) != (uint32_t)reference.front())
+					return false;
+				reference.pop_front();
+			}
+		}
+		else if ((action == 1) && !putting)
+		{
+			uint32_t packed = 0;
+			int maxSymbols = 1 + rng() % 40;
+			int numGot = fifo.getSymbols(packed, maxSymbols);
+			int expected = (int)reference.size();
+			expected = (expected > maxSymbols) ? maxSymbols : expected;
+			expected = (expected > symbolsPerWord) ? symbolsPerWord : expected;
+			if (numGot != expected)
+				return false;
+			for (int i = 0; i < numGot; i++)
+			{
+				if (((packed >> (i * storeBits)) & storeMask) != (uint32_t)reference.front())
+					return false;
+				reference.pop_front();
+			}
+			if ((numGot * storeBits < 32) && ((packed >> (numGot * storeBits)) != 0))
+				return false;
+		}
+		else if ((action == 2) && (rng() % 5000 == 0))
+		{
+			fifo.clear();
+			reference.clear();
+		}
+		else if (putting)
+		{
+			int symbol = rng() & ((1 << bitsPerSymbol) - 1);
+			bool ok = fifo.put(symbol);
+			if (ok != ((int)reference.size() < capacity))
+				return false;
+			if (ok)
+				reference.push_back(symbol);
+		}
+		else
+		{
+			int symbol = 0;
+			bool ok = fifo.get(symbol);
+			if (ok != !reference.empty())
+				return false;
+			if (ok)
+			{
+				if (symbol != reference.front())
+					return false;
+				reference.pop_front();
+			}
+		}
+		if (fifo.count() != reference.size())
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "l:i:f:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'l': _fifoLen = atoi(optarg); break;
+			case 'i': _iterations = atoi(optarg); break;
+			case 'f': _fuzzOps = atol(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-l fifoLen] [-i iterations] [-f fuzzOps]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_fifoLen < 64) || (_iterations < 1) || (_fuzzOps < 1))
+	{
+		fprintf(stderr, "The FIFO must hold at least 64 symbols and iterations and operations must be at least 1\n");
+		return 1;
+	}
+
+	// Memory
+	ByteFifo byteFifo(_fifoLen + 1);
+	SymbolFifo packedFifo(_fifoLen, 1);
+	printf("%d bit FIFO: byte per symbol %d bytes, packed %d bytes\n", _fifoLen, _fifoLen + 1,
+				SymbolFifo::storageWordsFor(_fifoLen, 1) * 4);
+
+	// Throughput - each transfer fills the FIFO then empties it
+	int numWords = _fifoLen / 32;
+	uint32_t checksum = 0;
+	double byteNs = timeTransfer([&byteFifo, numWords](int iteration) {
+		uint32_t sum = 0;
+		for (int i = 0; i < numWords * 32; i++)
+			byteFifo.put((iteration + i) & 1);
+		int symbol = 0;
+		while (byteFifo.get(symbol))
+			sum += symbol;
+		return sum;
+	}, checksum);
+	double singleNs = timeTransfer([&packedFifo, numWords](int iteration) {
+		uint32_t sum = 0;
+		for (int i = 0; i < numWords * 32; i++)
+			packedFifo.put((iteration + i) & 1);
+		int symbol = 0;
+		while (packedFifo.get(symbol))
+			sum += symbol;
+		return sum;
+	}, checksum);
+	double wordNs = timeTransfer([&packedFifo, numWords](int iteration) {
+		uint32_t sum = 0;
+		for (int i = 0; i < numWords; i++)
+			packedFifo.putWord(iteration & 1 ? 0xaaaaaaaa : 0x55555555);
+		uint32_t word = 0;
+		while (packedFifo.getWord(word))
+			sum += __builtin_popcount(word);
+		return sum;
+	}, checksum);
+	printf("Transfer: byte per symbol %.2f ns/bit, packed one symbol at a time %.2f ns/bit,"
+				" packed a word at a time %.2f ns/bit (checksum %u)\n", byteNs, singleNs, wordNs, checksum);
+
+	// Fuzz
+	bool allOk = true;
+	printf("Fuzz (%ld operations):", _fuzzOps);
+	for (int bitsPerSymbol = 1; bitsPerSymbol <= 4; bitsPerSymbol++)
+	{
+		for (int external = 0; external <= 1; external++)
+		{
+			bool ok = fuzz(bitsPerSymbol, external, bitsPerSymbol * 2 + external);
+			printf(" %d bit %s %s", bitsPerSymbol, external ? "external" : "owned", ok ? "ok" : "FAILED");
+			allOk = allOk && ok;
+		}
+	}
+	printf("\n");
+	return allOk ? 0 : 1;
+}
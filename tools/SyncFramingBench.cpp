@@ -0,0 +1,167 @@
+// SyncFramingBench
+// Sync word framing (SyncFramer) against bitwise HDLC for the same messages - the
+// air time (samples generated by SpeakUp including the preamble), the time the
+// framer takes to receive a frame from its bits and a check that each message is
+// decoded from the audio in both modes
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SyncFramingBench SyncFramingBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SyncFramingBench [-i iterations]
+//     -i  times each frame is received for the framer timing (default 20000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "SpeakUp.h"
+#include "SyncFramer.h"
+
+static const int MAX_FRAME_LEN = 258;
+
+static int _iterations = 20000;
+
+struct TestMessage
+{
+	const char* pName;
+	std::string text;
+};
+
+// Samples SpeakUp generates for a message (0 if it can't be framed) and whether
+// a receiver in the same mode decodes it
+static int airSamples(bool syncFraming, const std::string& msg, bool& decoded)
+{
+	static SpeakUp speakUpTx;
+	static SpeakUp speakUpRx;
+	SpeakUp::FramingMode framingMode = syncFraming ? SpeakUp::FRAMING_SYNC : SpeakUp::FRAMING_HDLC;
+	speakUpTx.setFramingMode(framingMode);
+	speakUpRx.setFramingMode(framingMode);
+	speakUpRx.decodeClearMessage();
+	decoded = false;
+	if (!speakUpTx.encodeMessageToSamples(msg.c_str()))
+		return 0;
+	int numSamples = 0;
+	int sampleVal = 0;
+	while (speakUpTx.encodeGetSample(sampleVal))
+	{
+		speakUpRx.decodeProcessSample(sampleVal / 3);
+		numSamples++;
+	}
+	for (int i = 0; i < SpeakUp::getModemSampleRate() / 5; i++)
+		speakUpRx.decodeProcessSample(0);
+	const uint8_t* pFrame = NULL;
+	int frameLen = 0;
+	if (speakUpRx.decodeGetFrame(pFrame, frameLen))
+		decoded = std::string((const char*)pFrame, frameLen) == msg;
+	return numSamples;
+}
+
+// Bits of a frame packed 32 to a word as a demodulator gives them
+template<typename Framer>
+static int frameBits(Framer& framer, std::vector<uint32_t>& bits)
+{
+	bits.clear();
+	int numBits = 0;
+	uint8_t bit = 0;
+	while (framer.getTxBit(bit))
+	{
+		if (numBits % 32 == 0)
+			bits.push_back(0);
+		bits.back() |= (uint32_t)bit << (numBits % 32);
+		numBits++;
+	}
+	return numBits;
+}
+
+// Time (us) for a framer to receive a frame from its bits - returns -1 if any
+// frame isn't delivered
+template<typename Framer>
+static double timeReceive(Framer& framer, const std::vector<uint32_t>& bits, int numBits, int& numDelivered)
+{
+	numDelivered = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < _iterations; i++)
+	{
+		for (int pos = 0; pos < numBits; pos += 32)
+			framer.handleBits(bits[pos / 32], (numBits - pos < 32) ? numBits - pos : 32);
+	}
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return (numDelivered == _iterations) ? secs * 1e6 / _iterations : -1;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "i:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'i': _iterations = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-i iterations]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (_iterations < 1)
+	{
+		fprintf(stderr, "Iterations must be at least 1\n");
+		return 1;
+	}
+
+	// Messages - the credentials, runs of ones (HDLC's worst case for stuffing), random
+	// bytes (no zeros as messages are strings) and one too long for sync framing
+	std::mt19937 rng(1);
+	std::string randomText(200, ' ');
+	for (char& ch : randomText)
+		ch = 1 + rng() % 255;
+	std::vector<TestMessage> messages = {
+		{ "credentials", "{\"s\":\"MyNetwork\",\"p\":\"secretpass\"}" },
+		{ "64 x 0xff", std::string(64, '\xff') },
+		{ "200 x 0xff", std::string(200, '\xff') },
+		{ "200 random", randomText },
+		{ "300 x 'a'", std::string(300, 'a') }
+	};
+
+	printf("%-12s %-6s  %-19s %-19s %s\n", "message", "bytes", "samples HDLC/sync", "framer us HDLC/sync", "decoded");
+	for (const TestMessage& message : messages)
+	{
+		const std::string& msg = message.text;
+		bool hdlcDecoded = false;
+		bool syncDecoded = false;
+		int hdlcSamples = airSamples(false, msg, hdlcDecoded);
+		int syncSamples = airSamples(true, msg, syncDecoded);
+
+		// Framer cost
+		int numDelivered = 0;
+		std::vector<uint32_t> bits;
+		MiniHDLC hdlc(NULL, [&numDelivered](const uint8_t*, int) {
+					numDelivered++;
+				}, true, true, MAX_FRAME_LEN + 64);
+		hdlc.startTxFrame((const uint8_t*)msg.data(), msg.size());
+		int hdlcBits = frameBits(hdlc, bits);
+		double hdlcUs = timeReceive(hdlc, bits, hdlcBits, numDelivered);
+		double syncUs = -1;
+		SyncFramer syncFramer([&numDelivered](const uint8_t*, int) {
+					numDelivered++;
+				});
+		if (syncFramer.startTxFrame((const uint8_t*)msg.data(), msg.size()))
+		{
+			int syncBits = frameBits(syncFramer, bits);
+			syncUs = timeReceive(syncFramer, bits, syncBits, numDelivered);
+		}
+
+		char samplesText[32];
+		char usText[32];
+		snprintf(samplesText, sizeof(samplesText), "%d/%d", hdlcSamples, syncSamples);
+		snprintf(usText, sizeof(usText), "%.2f/%.2f", hdlcUs, syncUs);
+		printf("%-12s %-6d  %-19s %-19s %s/%s\n", message.pName, (int)msg.size(), samplesText, usText,
+					hdlcDecoded ? "yes" : "no", syncDecoded ? "yes" : "no");
+	}
+	printf("Framer times of -1 are frames that couldn't be sent or weren't all received\n");
+	return 0;
+}
@@ -0,0 +1,211 @@
+// SyndromeBench
+// CRC syndrome error correction in MiniHDLC - for a range of frame lengths the
+// frames repaired after injected single and double bit errors, the rate at which
+// frames of random bytes are falsely accepted (delivered) with correction off,
+// single bit and double bit (which MiniHDLC only tries up to MAX_DOUBLE_BIT_FRAME_LEN),
+// and the extra time taken for each failed frame
+//
+// Build (from this folder):
+//   g++ -O2 -I../device/SpeakUpWiFiEsp32/lib/SpeakUp -o SyndromeBench SyndromeBench.cpp ../device/SpeakUpWiFiEsp32/lib/SpeakUp/*.cpp
+//
+// Usage:
+//   SyndromeBench [-n frames] [-r randomFrames]
+//     -n  frames with injected errors for each length (default 20000)
+//     -r  random frames for each length and mode (default 20000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "MiniHDLC.h"
+
+// Frame lengths (bytes including the CRC)
+static const int FRAME_LENS[] = { 8, 16, 32, 64, 117, 256 };
+static const int MAX_FRAME_LEN = 1024;
+
+// HDLC framing (as in MiniHDLC)
+static const uint8_t FRAME_BOUNDARY_OCTET = 0x7E;
+static const uint8_t CONTROL_ESCAPE_OCTET = 0x7D;
+static const uint8_t INVERT_OCTET = 0x20;
+
+static int _numFrames = 20000;
+static int _numRandomFrames = 20000;
+
+enum CorrectionMode
+{
+	CORRECT_OFF,
+	CORRECT_SINGLE,
+	CORRECT_DOUBLE
+};
+
+static const char* MODE_NAMES[] = { "off", "single", "double" };
+
+// Receiver with the given correction that counts the frames delivered and those
+// that match the expected payload
+class Receiver
+{
+public:
+	MiniHDLC hdlc;
+	const uint8_t* pExpected;
+	int expectedLen;
+	int delivered;
+	int matched;
+	Receiver(CorrectionMode mode)
+		: hdlc(NULL, [this](const uint8_t* pFrame, int frameLen) {
+					delivered++;
+					if (pExpected && (frameLen == expectedLen) && (memcmp(pFrame, pExpected, frameLen) == 0))
+						matched++;
+				}, true, false, MAX_FRAME_LEN + 1)
+	{
+		pExpected = NULL;
+		expectedLen = 0;
+		delivered = 0;
+		matched = 0;
+		if (mode != CORRECT_OFF)
+			hdlc.enableErrorCorrection(MAX_FRAME_LEN, mode == CORRECT_DOUBLE);
+	}
+
+	// Send a frame (including the CRC) byte-wise with escapes
+	void receive(const uint8_t* pFrame, int frameLen)
+	{
+		hdlc.handleChar(FRAME_BOUNDARY_OCTET);
+		for (int i = 0; i < frameLen; i++)
+		{
+			uint8_t ch = pFrame[i];
+			if ((ch == FRAME_BOUNDARY_OCTET) || (ch == CONTROL_ESCAPE_OCTET))
+			{
+				hdlc.handleChar(CONTROL_ESCAPE_OCTET);
+				ch ^= INVERT_OCTET;
+			}
+			hdlc.handleChar(ch);
+		}
+		hdlc.handleChar(FRAME_BOUNDARY_OCTET);
+	}
+};
+
+// Random payload with the CRC appended (big endian as SpeakUp sends it)
+static void makeFrame(std::mt19937& rng, int frameLen, std::vector<uint8_t>& frame)
+{
+	frame.resize(frameLen);
+	uint16_t fcs = MiniHDLC::CRC16_CCITT_INIT_VAL;
+	for (int i = 0; i < frameLen - 2; i++)
+	{
+		frame[i] = rng();
+		fcs = MiniHDLC::crcUpdateCCITT(fcs, frame[i]);
+	}
+	frame[frameLen - 2] = fcs >> 8;
+	frame[frameLen - 1] = fcs & 0xff;
+}
+
+// Frames with the given number of bit errors at distinct random positions - returns
+// the frames repaired and counts those delivered wrongly
+static int repairRate(CorrectionMode mode, int frameLen, int numErrors, std::mt19937& rng, int& wrongCount)
+{
+	Receiver receiver(mode);
+	std::vector<uint8_t> frame;
+	std::vector<uint8_t> payload;
+	int numBits = frameLen * 8;
+	for (int frameIdx = 0; frameIdx < _numFrames; frameIdx++)
+	{
+		makeFrame(rng, frameLen, frame);
+		payload.assign(frame.begin(), frame.end() - 2);
+		receiver.pExpected = payload.data();
+		receiver.expectedLen = frameLen - 2;
+		int firstPos = rng() % numBits;
+		int secondPos = firstPos;
+		while (secondPos == firstPos)
+			secondPos = rng() % numBits;
+		frame[firstPos / 8] ^= 1 << (firstPos % 8);
+		if (numErrors > 1)
+			frame[secondPos / 8] ^= 1 << (secondPos % 8);
+		receiver.receive(frame.data(), frameLen);
+	}
+	wrongCount = receiver.delivered - receiver.matched;
+	return receiver.matched;
+}
+
+// Frames of random bytes (a random CRC) - returns the number delivered and the time
+// taken for each frame (us)
+static int randomFrames(CorrectionMode mode, int frameLen, uint32_t seed, double& usPerFrame)
+{
+	Receiver receiver(mode);
+	std::mt19937 rng(seed);
+	std::vector<std::vector<uint8_t>> frames(_numRandomFrames, std::vector<uint8_t>(frameLen));
+	for (std::vector<uint8_t>& frame : frames)
+		for (uint8_t& byte : frame)
+			byte = rng();
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (const std::vector<uint8_t>& frame : frames)
+		receiver.receive(frame.data(), frameLen);
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	usPerFrame = secs * 1e6 / _numRandomFrames;
+	return receiver.delivered;
+}
+
+int main(int argc, char* argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "n:r:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': _numFrames = atoi(optarg); break;
+			case 'r': _numRandomFrames = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n frames] [-r randomFrames]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((_numFrames < 1) || (_numRandomFrames < 1))
+	{
+		fprintf(stderr, "Frames must be at least 1\n");
+		return 1;
+	}
+
+	// Repair of injected errors
+	std::mt19937 rng(1);
+	printf("Frames repaired (of %d) - wrongly delivered in brackets\n", _numFrames);
+	printf("%-7s %-16s %-16s %s\n", "length", "1 bit (single)", "1 bit (double)", "2 bits (double)");
+	for (int frameLen : FRAME_LENS)
+	{
+		int singleWrong = 0;
+		int singleFixed = repairRate(CORRECT_SINGLE, frameLen, 1, rng, singleWrong);
+		int doubleOneWrong = 0;
+		int doubleOneFixed = repairRate(CORRECT_DOUBLE, frameLen, 1, rng, doubleOneWrong);
+		int doubleWrong = 0;
+		int doubleFixed = repairRate(CORRECT_DOUBLE, frameLen, 2, rng, doubleWrong);
+		char singleText[32];
+		char doubleOneText[32];
+		snprintf(singleText, sizeof(singleText), "%d (%d)", singleFixed, singleWrong);
+		snprintf(doubleOneText, sizeof(doubleOneText), "%d (%d)", doubleOneFixed, doubleOneWrong);
+		printf("%-7d %-16s %-16s %d (%d)\n", frameLen, singleText, doubleOneText, doubleFixed, doubleWrong);
+	}
+
+	// False acceptance and cost on random frames
+	printf("Random frames (%d) - accepted %% and us/frame extra over no correction\n", _numRandomFrames);
+	printf("%-7s", "length");
+	for (const char* pName : MODE_NAMES)
+		printf(" %-18s", pName);
+	printf("\n");
+	for (int frameLen : FRAME_LENS)
+	{
+		printf("%-7d", frameLen);
+		double offUs = 0;
+		for (int mode = CORRECT_OFF; mode <= CORRECT_DOUBLE; mode++)
+		{
+			double usPerFrame = 0;
+			int accepted = randomFrames((CorrectionMode)mode, frameLen, frameLen, usPerFrame);
+			if (mode == CORRECT_OFF)
+				offUs = usPerFrame;
+			char text[32];
+			snprintf(text, sizeof(text), "%.3f%% %+.2fus", accepted * 100.0 / _numRandomFrames,
+						usPerFrame - offUs);
+			printf(" %-18s", text);
+		}
+		printf("\n");
+	}
+	return 0;
+}
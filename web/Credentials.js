@@ -0,0 +1,62 @@
+// Credentials
+// Compact binary (TLV) encoding of WiFi credentials
+// Matches CredentialParser on the device
+
+class Credentials {
+
+    constructor() {
+        this.FORMAT_VERSION = 0x01;
+        this.TYPE_SSID = 0x01;
+        this.TYPE_PASSWORD = 0x02;
+        this.TYPE_BSSID = 0x03;
+        this.TYPE_CHANNEL = 0x04;
+        this.TYPE_SECURITY = 0x05;
+        this.PACKED_FLAG = 0x80;
+        this.SIX_BIT_ALPHABET = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_";
+    }
+
+    // Encode to an array of bytes
+    // Options are bssid (string "aa:bb:cc:dd:ee:ff"), channel and security (numbers)
+    encode(ssid, password, options = {}) {
+        let outBytes = [this.FORMAT_VERSION];
+        this.encodeText(outBytes, this.TYPE_SSID, ssid);
+        if (password.length > 0)
+            this.encodeText(outBytes, this.TYPE_PASSWORD, password);
+        if (options.bssid) {
+            const bssidBytes = options.bssid.split(":").map(x => parseInt(x, 16) & 0xff);
+            if (bssidBytes.length === 6)
+                outBytes.push(this.TYPE_BSSID, 6, ...bssidBytes);
+        }
+        if (options.channel)
+            outBytes.push(this.TYPE_CHANNEL, 1, options.channel & 0xff);
+        if (options.security !== undefined)
+            outBytes.push(this.TYPE_SECURITY, 1, options.security & 0xff);
+        return outBytes;
+    }
+
+    encodeText(outBytes, type, text) {
+        // Pack 6 bits per character (first in the LSBs) if all are in the alphabet
+        const sixBitVals = Array.from(text).map(c => this.SIX_BIT_ALPHABET.indexOf(c));
+        if ((text.length > 0) && sixBitVals.every(v => v >= 0)) {
+            outBytes.push(type | this.PACKED_FLAG, text.length);
+            let bitAccum = 0;
+            let bitsInAccum = 0;
+            for (const v of sixBitVals) {
+                bitAccum |= v << bitsInAccum;
+                bitsInAccum += 6;
+                while (bitsInAccum >= 8) {
+                    outBytes.push(bitAccum & 0xff);
+                    bitAccum >>= 8;
+                    bitsInAccum -= 8;
+                }
+            }
+            if (bitsInAccum > 0)
+                outBytes.push(bitAccum & 0xff);
+            return;
+        }
+
+        // Otherwise UTF-8 bytes
+        const textBytes = Array.from(new TextEncoder().encode(text));
+        outBytes.push(type, textBytes.length, ...textBytes);
+    }
+}
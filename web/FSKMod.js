@@ -19,6 +19,8 @@ class FSKMod {
 
         // Modulation settings
         const samplesPerSymbol = this.sampleRate / this.symbolRate;
+        // The credentials receiver has no sync detector so it needs the full preamble for
+        // clock recovery to lock (see tools/PreambleBench)
         const preambleSymbols = 20;
         const postambleSymbols = 5;
         const size = (preambleSymbols + postambleSymbols + bitStreamArray.length) * samplesPerSymbol;
@@ -32,19 +32,23 @@ class HDLC {
     }
 
     encodeBitwise(inStr) {
+        return this.encodeBitwiseBytes(this.toUTF8Bytes(inStr));
+    }
+
+    encodeBitwiseBytes(inBytes) {
         this.bitBuffer = []
-        const utf8Bytes = this.toUTF8Bytes(inStr);
 
-        // Iterate the string converting into a bit stream
+        // Iterate the bytes converting into a bit stream
         let fcs = this.CRC16_CCITT_INIT_VAL;
 
         // Initial boundary
         this.sendChar(this.FRAME_BOUNDARY_OCTET);
+        this.bitwiseSendOnesCount = 0;
 
         // Loop over frame
-        for (let i = 0; i < inStr.length; i++) {
+        for (let i = 0; i < inBytes.length; i++) {
             // Handle escapes
-            let data = utf8Bytes[i];
+            let data = inBytes[i];
             fcs = this.crcUpdateCCITT(fcs, data);
             this.sendEscaped(data);
         }
@@ -95,7 +99,7 @@ class HDLC {
                 if (this.bitwiseSendOnesCount === 5) {
                     // Stuff a 0 to avoid 6 consecutive 1s
                     this.bitBuffer.push(0);
-                    this._bitwiseSendOnesCount = 0;
+                    this.bitwiseSendOnesCount = 0;
                 }
             }
             else {